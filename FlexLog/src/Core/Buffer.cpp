@@ -0,0 +1,65 @@
+#include "Buffer.h"
+
+#include <algorithm>
+#include <new>
+
+FlexLog::Buffer::Buffer(Buffer&& other) noexcept :
+    m_size(other.m_size),
+    m_capacity(other.m_capacity)
+{
+    if (other.IsInline())
+    {
+        std::memcpy(m_inlineBuffer, other.m_inlineBuffer, m_size);
+        m_data = m_inlineBuffer;
+    }
+    else
+    {
+        // Take ownership of the heap block
+        m_data = other.m_data;
+    }
+
+    other.m_data = other.m_inlineBuffer;
+    other.m_size = 0;
+    other.m_capacity = INLINE_CAPACITY;
+}
+
+FlexLog::Buffer::~Buffer()
+{
+    if (!IsInline())
+        delete[] m_data;
+}
+
+FlexLog::Buffer& FlexLog::Buffer::operator=(Buffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->~Buffer();
+        new (this) Buffer(std::move(other));
+    }
+    return *this;
+}
+
+void FlexLog::Buffer::Erase(size_t pos, size_t count)
+{
+    if (pos >= m_size)
+        return;
+
+    count = std::min(count, m_size - pos);
+    std::memmove(m_data + pos, m_data + pos + count, m_size - pos - count);
+    m_size -= count;
+}
+
+void FlexLog::Buffer::Grow(size_t required)
+{
+    // Geometric growth keeps amortized appends O(1)
+    const size_t capacity = std::max(required, m_capacity * 2);
+
+    char* data = new char[capacity];
+    std::memcpy(data, m_data, m_size);
+
+    if (!IsInline())
+        delete[] m_data;
+
+    m_data = data;
+    m_capacity = capacity;
+}
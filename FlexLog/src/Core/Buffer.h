@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace FlexLog
+{
+    /**
+    * @brief Growable, reusable character buffer that formatters append into.
+    *
+    * Small records stay in the inline storage; larger ones grow a single heap
+    * block that is kept across Clear() calls, so a buffer owned by a sink worker
+    * stops allocating once it has seen its largest record.
+    */
+    class Buffer
+    {
+    public:
+        static constexpr size_t INLINE_CAPACITY = 512;
+
+        Buffer() = default;
+        Buffer(Buffer&& other) noexcept;
+        Buffer(const Buffer&) = delete;
+        ~Buffer();
+
+        Buffer& operator=(Buffer&& other) noexcept;
+        Buffer& operator=(const Buffer&) = delete;
+
+        void Append(const char* data, size_t size)
+        {
+            if (size == 0)
+                return;
+
+            std::memcpy(Extend(size), data, size);
+        }
+
+        void Append(std::string_view str) { Append(str.data(), str.size()); }
+
+        void Append(size_t count, char c)
+        {
+            if (count > 0)
+                std::memset(Extend(count), c, count);
+        }
+
+        void PushBack(char c)
+        {
+            if (m_size == m_capacity)
+                Grow(m_size + 1);
+
+            m_data[m_size++] = c;
+        }
+
+        // Reserves size bytes at the end and returns a pointer to them for direct writes
+        char* Extend(size_t size)
+        {
+            if (m_size + size > m_capacity)
+                Grow(m_size + size);
+
+            char* dst = m_data + m_size;
+            m_size += size;
+            return dst;
+        }
+
+        void Reserve(size_t capacity)
+        {
+            if (capacity > m_capacity)
+                Grow(capacity);
+        }
+
+        // Shrinks the logical size; capacity is never released
+        void Truncate(size_t size)
+        {
+            if (size < m_size)
+                m_size = size;
+        }
+
+        void Erase(size_t pos, size_t count);
+
+        void Clear() { m_size = 0; }
+
+        char* Data() { return m_data; }
+        const char* Data() const { return m_data; }
+        size_t Size() const { return m_size; }
+        size_t Capacity() const { return m_capacity; }
+        bool IsEmpty() const { return m_size == 0; }
+        char Back() const { return m_data[m_size - 1]; }
+
+        std::string_view View() const { return std::string_view(m_data, m_size); }
+        std::string_view View(size_t offset) const { return std::string_view(m_data + offset, m_size - offset); }
+        std::string ToString() const { return std::string(m_data, m_size); }
+
+    private:
+        void Grow(size_t required);
+
+        bool IsInline() const { return m_data == m_inlineBuffer; }
+
+        char m_inlineBuffer[INLINE_CAPACITY];
+        char* m_data = m_inlineBuffer;
+        size_t m_size = 0;
+        size_t m_capacity = INLINE_CAPACITY;
+    };
+
+    namespace Internal
+    {
+        class BufferStreamBuf : public std::streambuf
+        {
+        public:
+            explicit BufferStreamBuf(Buffer& buffer) : m_buffer(buffer) {}
+
+        protected:
+            int_type overflow(int_type ch) override
+            {
+                if (!traits_type::eq_int_type(ch, traits_type::eof()))
+                    m_buffer.PushBack(traits_type::to_char_type(ch));
+                return traits_type::not_eof(ch);
+            }
+
+            std::streamsize xsputn(const char_type* s, std::streamsize count) override
+            {
+                m_buffer.Append(s, static_cast<size_t>(count));
+                return count;
+            }
+
+        private:
+            Buffer& m_buffer;
+        };
+    }
+
+    /**
+    * @brief std::ostream adaptor that writes straight into a Buffer.
+    *
+    * Lets stream-based formatting code append to a caller-owned buffer without
+    * going through an intermediate std::stringstream.
+    */
+    class BufferStream : public std::ostream
+    {
+    public:
+        explicit BufferStream(Buffer& buffer) : std::ostream(nullptr), m_streamBuf(buffer) { rdbuf(&m_streamBuf); }
+
+    private:
+        Internal::BufferStreamBuf m_streamBuf;
+    };
+}
@@ -0,0 +1,171 @@
+#include "Deflater.h"
+
+#include <climits>
+#include <cstring>
+
+#include <zlib/zlib.h>
+
+namespace FlexLog::Internal
+{
+    constexpr int DEFLATE_WINDOW_BITS = 15;
+    constexpr int DEFLATE_GZIP_WRAPPER = 16;    // Added to the window bits to select the gzip container
+    constexpr int DEFLATE_MEMORY_LEVEL = 8;
+    constexpr size_t DEFLATE_STREAM_CHUNK = 64 * 1024;    // Output room added per deflate() call when streaming
+}
+
+FlexLog::Deflater::Deflater() : m_stream(std::make_unique<z_stream_s>())
+{
+    std::memset(m_stream.get(), 0, sizeof(z_stream_s));
+}
+
+FlexLog::Deflater::~Deflater()
+{
+    if (m_initialized)
+        deflateEnd(m_stream.get());
+}
+
+bool FlexLog::Deflater::Compress(std::string_view data, Buffer& out, CompressionFormat format, int level)
+{
+    if (data.size() > UINT_MAX || !Prepare(format, level))
+        return false;
+
+    const size_t offset = out.Size();
+    const size_t bound = deflateBound(m_stream.get(), static_cast<uLong>(data.size()));
+
+    out.Extend(bound);
+    return Deflate(data.data(), data.size(), out, offset, bound) != 0;
+}
+
+bool FlexLog::Deflater::CompressInPlace(Buffer& out, size_t start, CompressionFormat format, int level)
+{
+    const size_t size = out.Size() - start;
+    if (size > UINT_MAX || !Prepare(format, level))
+        return false;
+
+    // Compressed bytes go after the record, then slide down over it
+    const size_t offset = out.Size();
+    const size_t bound = deflateBound(m_stream.get(), static_cast<uLong>(size));
+
+    out.Extend(bound);
+    const size_t compressedSize = Deflate(out.Data() + start, size, out, offset, bound);
+
+    if (compressedSize == 0)
+    {
+        out.Truncate(offset);
+        return false;
+    }
+
+    std::memmove(out.Data() + start, out.Data() + offset, compressedSize);
+    out.Truncate(start + compressedSize);
+    return true;
+}
+
+bool FlexLog::Deflater::Begin(CompressionFormat format, int level)
+{
+    // Drops whatever an abandoned stream left behind
+    if (m_initialized)
+        deflateReset(m_stream.get());
+
+    return Prepare(format, level);
+}
+
+bool FlexLog::Deflater::Append(std::string_view data, Buffer& out)
+{
+    if (!m_initialized || data.size() > UINT_MAX)
+        return false;
+
+    return Pump(data.data(), data.size(), out, Z_NO_FLUSH);
+}
+
+bool FlexLog::Deflater::Finish(Buffer& out)
+{
+    if (!m_initialized)
+        return false;
+
+    const bool finished = Pump(nullptr, 0, out, Z_FINISH);
+    deflateReset(m_stream.get());
+    return finished;
+}
+
+FlexLog::Deflater& FlexLog::Deflater::GetThreadDeflater()
+{
+    thread_local Deflater deflater;
+    return deflater;
+}
+
+bool FlexLog::Deflater::Prepare(CompressionFormat format, int level)
+{
+    if (m_initialized && format != m_format)
+    {
+        deflateEnd(m_stream.get());
+        m_initialized = false;
+    }
+
+    if (!m_initialized)
+    {
+        const int windowBits = Internal::DEFLATE_WINDOW_BITS + (format == CompressionFormat::Gzip ? Internal::DEFLATE_GZIP_WRAPPER : 0);
+        if (deflateInit2(m_stream.get(), level, Z_DEFLATED, windowBits, Internal::DEFLATE_MEMORY_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+            return false;
+
+        m_initialized = true;
+        m_format = format;
+        m_level = level;
+        return true;
+    }
+
+    // The stream is reset after every record, so the level can change without flushing anything
+    if (level != m_level)
+    {
+        if (deflateParams(m_stream.get(), level, Z_DEFAULT_STRATEGY) != Z_OK)
+            return false;
+
+        m_level = level;
+    }
+
+    return true;
+}
+
+size_t FlexLog::Deflater::Deflate(const char* data, size_t size, Buffer& out, size_t offset, size_t capacity)
+{
+    m_stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    m_stream->avail_in = static_cast<uInt>(size);
+    m_stream->next_out = reinterpret_cast<Bytef*>(out.Data() + offset);
+    m_stream->avail_out = static_cast<uInt>(capacity);
+
+    // deflateBound guarantees one call finishes the stream
+    const int result = deflate(m_stream.get(), Z_FINISH);
+    const size_t compressedSize = result == Z_STREAM_END ? static_cast<size_t>(m_stream->total_out) : 0;
+
+    deflateReset(m_stream.get());
+    out.Truncate(offset + compressedSize);
+    return compressedSize;
+}
+
+bool FlexLog::Deflater::Pump(const char* data, size_t size, Buffer& out, int flush)
+{
+    m_stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    m_stream->avail_in = static_cast<uInt>(size);
+
+    while (true)
+    {
+        const size_t offset = out.Size();
+        out.Extend(Internal::DEFLATE_STREAM_CHUNK);
+
+        m_stream->next_out = reinterpret_cast<Bytef*>(out.Data() + offset);
+        m_stream->avail_out = static_cast<uInt>(Internal::DEFLATE_STREAM_CHUNK);
+
+        const int result = deflate(m_stream.get(), flush);
+        const uInt room = m_stream->avail_out;
+        out.Truncate(offset + Internal::DEFLATE_STREAM_CHUNK - room);
+
+        if (result == Z_STREAM_END)
+            return true;
+
+        if (result != Z_OK && result != Z_BUF_ERROR)
+            return false;
+
+        // Room to spare means zlib took all the input and, unless finishing, has nothing more to write yet
+        if (room != 0)
+            return flush != Z_FINISH && m_stream->avail_in == 0;
+    }
+}
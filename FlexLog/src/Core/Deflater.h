@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+#include "Common.h"
+#include "Core/Buffer.h"
+
+struct z_stream_s;
+
+namespace FlexLog
+{
+    // Container around a deflate stream; both are accepted by Graylog and most HTTP collectors
+    enum class CompressionFormat
+    {
+        Gzip,   // RFC 1952: gzip header and CRC-32 trailer
+        Zlib    // RFC 1950: two byte header and Adler-32 trailer
+    };
+
+    /**
+    * @brief Reusable zlib deflate stream that compresses records into a Buffer.
+    *
+    * deflateInit allocates around 256 KB of window and hash tables, so the stream
+    * is kept and only reset between records. GetThreadDeflater() hands each worker
+    * thread its own; the stream is initialized again only when the format or
+    * level asked for changes.
+    */
+    class Deflater
+    {
+    public:
+        static constexpr int DEFAULT_LEVEL = -1;    // zlib's default, currently 6
+
+        Deflater();
+        ~Deflater();
+
+        Deflater(const Deflater&) = delete;
+        Deflater& operator=(const Deflater&) = delete;
+
+        // Appends data compressed as one complete stream; returns false and leaves out as it was on failure
+        bool Compress(std::string_view data, Buffer& out, CompressionFormat format, int level = DEFAULT_LEVEL);
+
+        // Replaces out's bytes from start onwards with their compressed form, without a second buffer
+        bool CompressInPlace(Buffer& out, size_t start, CompressionFormat format, int level = DEFAULT_LEVEL);
+
+        // Compresses a stream too large for one call: Begin, Append each piece, then Finish. Output is appended to
+        // out as it is produced, so out can be drained between calls.
+        bool Begin(CompressionFormat format, int level = DEFAULT_LEVEL);
+        bool Append(std::string_view data, Buffer& out);
+        bool Finish(Buffer& out);
+
+        // The calling thread's deflater, created on first use
+        static Deflater& GetThreadDeflater();
+
+    private:
+        bool Prepare(CompressionFormat format, int level);
+
+        // Deflates data into capacity bytes of out reserved at offset, then trims out to the compressed
+        // size; returns that size, or 0 on failure
+        size_t Deflate(const char* data, size_t size, Buffer& out, size_t offset, size_t capacity);
+
+        // Feeds data to the stream with the given zlib flush mode, growing out until zlib has nothing left to write
+        bool Pump(const char* data, size_t size, Buffer& out, int flush);
+
+        std::unique_ptr<z_stream_s> m_stream;
+        CompressionFormat m_format = CompressionFormat::Gzip;
+        int m_level = DEFAULT_LEVEL;
+        bool m_initialized = false;
+    };
+}
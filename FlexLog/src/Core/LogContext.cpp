@@ -0,0 +1,35 @@
+#include "LogContext.h"
+
+thread_local FlexLog::ContextFramePtr FlexLog::LogContext::s_current;
+
+FlexLog::ContextFrame::ContextFrame(const ContextFrame* parent, const StructuredData& fields)
+{
+    if (parent)
+        m_fields = parent->m_fields;
+
+    m_fields.Merge(fields);
+}
+
+const FlexLog::StructuredData& FlexLog::ContextFrame::GetFields() const
+{
+    if (!m_fields.HasDeferred())
+        return m_fields;
+
+    std::call_once(m_resolveOnce, [this]()
+    {
+        m_resolved = m_fields;
+        m_resolved.ResolveDeferred();
+    });
+
+    return m_resolved;
+}
+
+FlexLog::LogContext::Scope::Scope(const StructuredData& fields) : m_previous(s_current)
+{
+    s_current = std::make_shared<const ContextFrame>(m_previous.get(), fields);
+}
+
+FlexLog::LogContext::Scope::~Scope()
+{
+    s_current = std::move(m_previous);
+}
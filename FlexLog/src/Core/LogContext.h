@@ -0,0 +1,80 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include "Common.h"
+#include "Format/Structured/Field.h"
+#include "Format/Structured/StructuredData.h"
+
+namespace FlexLog
+{
+    /**
+    * @brief Immutable snapshot of the context fields active on a thread.
+    *
+    * A frame holds its parent's fields merged with its own, so reading the
+    * context never walks a chain. Frames are shared by reference: a message
+    * keeps a pointer to the frame that was current when it was created.
+    * Deferred fields are resolved the first time the fields are read, which
+    * is on the worker formatting a message, and only once per frame.
+    */
+    class ContextFrame
+    {
+    public:
+        ContextFrame(const ContextFrame* parent, const StructuredData& fields);
+
+        const StructuredData& GetFields() const;
+
+    private:
+        StructuredData m_fields;    // Never changed once constructed; child frames copy it from any thread
+
+        mutable std::once_flag m_resolveOnce;
+        mutable StructuredData m_resolved;  // m_fields with its deferred fields resolved
+    };
+
+    using ContextFramePtr = std::shared_ptr<const ContextFrame>;
+
+    /**
+    * @brief Thread-local stack of logging context (MDC).
+    *
+    * Push fields for the lifetime of a Scope and every message logged from the
+    * thread in the meantime carries them, at the cost of one reference count.
+    */
+    class LogContext
+    {
+    public:
+        class Scope
+        {
+        public:
+            explicit Scope(const StructuredData& fields);
+
+            template<typename... Ts> requires (sizeof...(Ts) > 0)
+            explicit Scope(const Field<Ts>&... fields) : Scope(ToStructuredData(fields...)) {}
+
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            template<typename... Ts>
+            static StructuredData ToStructuredData(const Field<Ts>&... fields)
+            {
+                StructuredData data;
+                (data.Add(fields.key, fields.value), ...);
+                return data;
+            }
+
+            ContextFramePtr m_previous;
+        };
+
+        static const ContextFramePtr& Current() { return s_current; }
+
+        // Drops every frame on the calling thread, e.g. when a pooled thread picks up unrelated work
+        static void Clear() { s_current.reset(); }
+
+    private:
+        static thread_local ContextFramePtr s_current;
+    };
+}
@@ -199,6 +199,8 @@ void FlexLog::MessagePool::ResetMessage(Message* message)
     message->level = Level::Info;
     message->logger = nullptr;
     message->structuredData.Clear();
+    message->fields.Clear();
+    message->context.reset();
 
     // Use memory_order_release for the state to ensure all the above resets
     // are visible to the next thread that acquires this message
@@ -0,0 +1,33 @@
+#include "NumberFormat.h"
+
+void FlexLog::Internal::AppendDouble(Buffer& out, double value, int precision)
+{
+    const size_t start = out.Size();
+
+    if (precision < 0)
+    {
+        char* dst = out.Extend(MAX_SHORTEST_DOUBLE_CHARS);
+        const auto result = std::to_chars(dst, dst + MAX_SHORTEST_DOUBLE_CHARS, value);
+        out.Truncate(start + static_cast<size_t>(result.ptr - dst));
+        return;
+    }
+
+    // Sized for the worst case up front, so the conversion can't run out of room
+    const size_t capacity = MAX_FIXED_DOUBLE_INTEGER_CHARS + 1 + static_cast<size_t>(precision);
+    char* dst = out.Extend(capacity);
+    const auto result = std::to_chars(dst, dst + capacity, value, std::chars_format::fixed, precision);
+    out.Truncate(start + static_cast<size_t>(result.ptr - dst));
+}
+
+FlexLog::NumberText::NumberText(double value, int precision)
+{
+    std::to_chars_result result{};
+
+    if (precision >= 0)
+        result = std::to_chars(m_text, m_text + sizeof(m_text), value, std::chars_format::fixed, precision);
+
+    if (precision < 0 || result.ec != std::errc())
+        result = std::to_chars(m_text, m_text + sizeof(m_text), value);
+
+    m_size = static_cast<uint8_t>(result.ptr - m_text);
+}
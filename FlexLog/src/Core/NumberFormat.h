@@ -0,0 +1,69 @@
+#pragma once
+
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Core/Buffer.h"
+
+namespace FlexLog
+{
+    // Precision that selects the shortest digits which read back as the same double
+    constexpr int SHORTEST_PRECISION = -1;
+
+    namespace Internal
+    {
+        // Longest decimal integer: 20 digits of UINT64_MAX, or 19 digits and a sign
+        constexpr size_t MAX_INTEGER_CHARS = 20;
+
+        // Longest shortest-round-trip double, such as -2.2250738585072014e-308
+        constexpr size_t MAX_SHORTEST_DOUBLE_CHARS = 24;
+
+        // Longest fixed-point double before its fraction: sign and 309 integer digits
+        constexpr size_t MAX_FIXED_DOUBLE_INTEGER_CHARS = 310;
+
+        // Writes value in decimal straight into out, with no locale and no intermediate copy
+        template<std::integral T>
+        void AppendInteger(Buffer& out, T value)
+        {
+            const size_t start = out.Size();
+            char* dst = out.Extend(MAX_INTEGER_CHARS);
+            const auto result = std::to_chars(dst, dst + MAX_INTEGER_CHARS, value);
+            out.Truncate(start + static_cast<size_t>(result.ptr - dst));
+        }
+
+        // Writes value in fixed-point with precision fraction digits, or in the shortest form that
+        // round-trips when precision is SHORTEST_PRECISION (or any negative value). NaN and
+        // infinities come out as "nan" and "inf"; callers with no such representation check first.
+        void AppendDouble(Buffer& out, double value, int precision);
+    }
+
+    /**
+    * @brief Decimal text of a number, rendered on the stack without allocating.
+    *
+    * For the few places that still assemble text outside a Buffer, such as
+    * std::string keys and std::ostream output; formatters writing into a
+    * Buffer call Internal::AppendInteger and Internal::AppendDouble instead.
+    */
+    class NumberText
+    {
+    public:
+        template<std::integral T>
+        explicit NumberText(T value)
+        {
+            const auto result = std::to_chars(m_text, m_text + sizeof(m_text), value);
+            m_size = static_cast<uint8_t>(result.ptr - m_text);
+        }
+
+        // Fixed-point precisions too long for the inline text fall back to the shortest form
+        NumberText(double value, int precision);
+
+        std::string_view View() const { return std::string_view(m_text, m_size); }
+
+    private:
+        char m_text[64];
+        uint8_t m_size;
+    };
+}
@@ -0,0 +1,107 @@
+#include "ProcessInfo.h"
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+
+#include "Core/Buffer.h"
+#include "Core/NumberFormat.h"
+#include "Format/Structured/JsonWriter.h"
+
+#ifdef FLOG_PLATFORM_WINDOWS
+    #include <Windows.h>
+#elif defined(FLOG_PLATFORM_POSIX)
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+namespace FlexLog::Internal
+{
+    std::atomic<const ProcessInfo::Snapshot*> s_processSnapshot{nullptr};
+    std::atomic<bool> s_processSnapshotStale{false};
+    std::mutex s_processSnapshotMutex;
+
+    std::string ReadProcessName()
+    {
+#ifdef FLOG_PLATFORM_WINDOWS
+        char processName[MAX_PATH] = {0};
+        GetModuleFileNameA(NULL, processName, MAX_PATH);
+        return std::filesystem::path(processName).filename().string();
+#else
+        char processName[1024] = {0};
+
+        FILE* cmdFile = fopen("/proc/self/cmdline", "r");
+        if (cmdFile)
+        {
+            size_t read = fread(processName, 1, sizeof(processName) - 1, cmdFile);
+            fclose(cmdFile);
+
+            if (read > 0)
+            {
+                processName[read] = '\0';
+                return std::filesystem::path(processName).filename().string();
+            }
+        }
+
+        return "unknown";
+#endif
+    }
+
+    ProcessInfo::Snapshot* ReadProcessSnapshot()
+    {
+        auto* snapshot = new ProcessInfo::Snapshot();
+
+#ifdef FLOG_PLATFORM_WINDOWS
+        snapshot->pid = GetCurrentProcessId();
+#else
+        snapshot->pid = static_cast<uint64_t>(getpid());
+#endif
+        snapshot->pidText = std::string(NumberText(snapshot->pid).View());
+        snapshot->pidJson = "\"" + snapshot->pidText + "\"";
+        snapshot->name = ReadProcessName();
+
+        Buffer json;
+        json.PushBack('"');
+        EscapeJson(json, snapshot->name);
+        json.PushBack('"');
+        snapshot->nameJson = json.ToString();
+
+        return snapshot;
+    }
+}
+
+const FlexLog::ProcessInfo::Snapshot& FlexLog::ProcessInfo::Get()
+{
+    const Snapshot* snapshot = Internal::s_processSnapshot.load(std::memory_order_acquire);
+    if (snapshot && !Internal::s_processSnapshotStale.load(std::memory_order_relaxed))
+        return *snapshot;
+
+    std::lock_guard<std::mutex> lock(Internal::s_processSnapshotMutex);
+
+    snapshot = Internal::s_processSnapshot.load(std::memory_order_acquire);
+    if (snapshot && !Internal::s_processSnapshotStale.load(std::memory_order_relaxed))
+        return *snapshot;
+
+#ifdef FLOG_PLATFORM_POSIX
+    // Taking the mutex across fork() means a child never inherits it locked. A child keeps the
+    // parent's snapshot until it next asks, since the handler only marks the snapshot stale.
+    if (!snapshot)
+    {
+        pthread_atfork(
+            []() { Internal::s_processSnapshotMutex.lock(); },
+            []() { Internal::s_processSnapshotMutex.unlock(); },
+            []()
+            {
+                Internal::s_processSnapshotStale.store(true, std::memory_order_relaxed);
+                Internal::s_processSnapshotMutex.unlock();
+            });
+    }
+#endif
+
+    // The replaced snapshot is leaked on purpose: records being formatted may still point into it
+    snapshot = Internal::ReadProcessSnapshot();
+    Internal::s_processSnapshotStale.store(false, std::memory_order_relaxed);
+    Internal::s_processSnapshot.store(snapshot, std::memory_order_release);
+    return *snapshot;
+}
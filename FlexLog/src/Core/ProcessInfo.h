@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Common.h"
+
+namespace FlexLog
+{
+    /**
+    * @brief Process ID and name, read once and read again in a child after fork().
+    *
+    * Each value is kept as plain text and pre-rendered as a JSON value, so
+    * structured formatters copy it into a record as is. A snapshot stays
+    * valid for the life of the process, even once a fork has replaced it.
+    */
+    class ProcessInfo
+    {
+    public:
+        struct Snapshot
+        {
+            uint64_t pid = 0;
+            std::string pidText;    // Decimal
+            std::string pidJson;    // Quoted decimal
+            std::string name;       // Executable name without its directory
+            std::string nameJson;   // Quoted and escaped
+        };
+
+        static const Snapshot& Get();
+    };
+}
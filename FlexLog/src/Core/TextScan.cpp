@@ -0,0 +1,627 @@
+#include "TextScan.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+#include "Platform.h"
+
+#if defined(FLOG_ARCH_X64) || (defined(FLOG_ARCH_X86) && (defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)))
+    #define FLOG_TEXT_SCAN_X86
+
+    #include <immintrin.h>
+
+    #if defined(FLOG_COMPILER_MSVC)
+        #include <intrin.h>
+        #define FLOG_TARGET_AVX2
+    #else
+        #define FLOG_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+namespace
+{
+    using ScanFunction = size_t(*)(const char*, size_t);
+
+    // ASCII bytes in a row after which FindInvalidUtf8 hands the scan back to the vector kernel
+    constexpr size_t UTF8_ASCII_RESCAN = 16;
+
+    // Defined here so the FindInvalidUtf8 loop can inline it
+    size_t Utf8SequenceLength(const char* data, size_t size)
+    {
+        if (size == 0)
+            return 0;
+
+        const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+        const unsigned char lead = bytes[0];
+
+        if (lead < 0x80)
+            return 1;
+
+        // Lead bytes C0/C1 and F5+ can only start overlong or out of range sequences
+        size_t length;
+        unsigned char minSecond = 0x80;
+        unsigned char maxSecond = 0xBF;
+
+        if (lead >= 0xC2 && lead <= 0xDF)
+        {
+            length = 2;
+        }
+        else if (lead >= 0xE0 && lead <= 0xEF)
+        {
+            length = 3;
+            if (lead == 0xE0)
+                minSecond = 0xA0; // Overlong
+            else if (lead == 0xED)
+                maxSecond = 0x9F; // UTF-16 surrogates
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4)
+        {
+            length = 4;
+            if (lead == 0xF0)
+                minSecond = 0x90; // Overlong
+            else if (lead == 0xF4)
+                maxSecond = 0x8F; // Above U+10FFFF
+        }
+        else
+        {
+            return 0;
+        }
+
+        if (size < length || bytes[1] < minSecond || bytes[1] > maxSecond)
+            return 0;
+
+        for (size_t i = 2; i < length; ++i)
+        {
+            if ((bytes[i] & 0xC0) != 0x80)
+                return 0;
+        }
+
+        return length;
+    }
+
+    enum CharClass : uint8_t
+    {
+        JSON_ESCAPE   = 1 << 0,
+        XML_ESCAPE    = 1 << 1,
+        NON_PRINTABLE = 1 << 2,
+        NON_ASCII     = 1 << 3,
+        CDATA_BREAK   = 1 << 4
+    };
+
+    constexpr std::array<uint8_t, 256> CHAR_CLASSES = []
+    {
+        std::array<uint8_t, 256> table{};
+
+        for (int c = 0; c < 0x20; ++c)
+            table[c] = JSON_ESCAPE | XML_ESCAPE | NON_PRINTABLE | CDATA_BREAK;
+
+        for (int c = 0x80; c < 0x100; ++c)
+            table[c] = NON_PRINTABLE | NON_ASCII;
+
+        table[0x7F] |= NON_PRINTABLE;
+        table['"'] |= JSON_ESCAPE | XML_ESCAPE;
+        table['\\'] |= JSON_ESCAPE;
+        table['<'] |= XML_ESCAPE;
+        table['>'] |= XML_ESCAPE;
+        table['&'] |= XML_ESCAPE;
+        table['\''] |= XML_ESCAPE;
+        table[']'] |= CDATA_BREAK;
+
+        return table;
+    }();
+
+    size_t ScanScalar(const char* data, size_t size, uint8_t charClass)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (CHAR_CLASSES[static_cast<unsigned char>(data[i])] & charClass)
+                return i;
+        }
+        return size;
+    }
+
+    size_t FindJsonEscapeScalar(const char* data, size_t size) { return ScanScalar(data, size, JSON_ESCAPE); }
+    size_t FindXmlEscapeScalar(const char* data, size_t size) { return ScanScalar(data, size, XML_ESCAPE); }
+    size_t FindNonPrintableScalar(const char* data, size_t size) { return ScanScalar(data, size, NON_PRINTABLE); }
+    size_t FindNonAsciiScalar(const char* data, size_t size) { return ScanScalar(data, size, NON_ASCII); }
+    size_t FindCDataBreakScalar(const char* data, size_t size) { return ScanScalar(data, size, CDATA_BREAK); }
+
+    // Skips ASCII with findNonAscii and decodes each multi-byte sequence in turn
+    template<ScanFunction findNonAscii>
+    size_t FindInvalidUtf8Decoding(const char* data, size_t size)
+    {
+        size_t i = 0;
+        while (i < size)
+        {
+            // ASCII runs are skipped a vector at a time; only multi-byte sequences are decoded
+            i += findNonAscii(data + i, size - i);
+
+            // Text that isn't ASCII stays here, so the spaces and punctuation between its characters
+            // don't cost a trip back through the kernel; a long enough ASCII run goes back to it
+            size_t asciiRun = 0;
+            while (i < size && asciiRun < UTF8_ASCII_RESCAN)
+            {
+                if (static_cast<unsigned char>(data[i]) < 0x80)
+                {
+                    ++i;
+                    ++asciiRun;
+                    continue;
+                }
+
+                const size_t length = Utf8SequenceLength(data + i, size - i);
+                if (length == 0)
+                    return i;
+
+                i += length;
+                asciiRun = 0;
+            }
+        }
+
+        return size;
+    }
+
+    size_t FindInvalidUtf8Scalar(const char* data, size_t size) { return FindInvalidUtf8Decoding<FindNonAsciiScalar>(data, size); }
+
+#if defined(FLOG_TEXT_SCAN_X86)
+    // Each kernel tests a full vector per iteration and hands the tail to the scalar loop.
+    // Control characters are matched as max(v, 0x1F) == 0x1F, i.e. v <= 0x1F unsigned.
+
+    inline __m128i ControlMaskSse2(__m128i v)
+    {
+        const __m128i controlMax = _mm_set1_epi8(0x1F);
+        return _mm_cmpeq_epi8(_mm_max_epu8(v, controlMax), controlMax);
+    }
+
+    size_t FindJsonEscapeSse2(const char* data, size_t size)
+    {
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i mask = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+            mask = _mm_or_si128(mask, ControlMaskSse2(v));
+
+            const unsigned bits = static_cast<unsigned>(_mm_movemask_epi8(mask));
+            if (bits != 0)
+                return i + std::countr_zero(bits);
+        }
+
+        return i + FindJsonEscapeScalar(data + i, size - i);
+    }
+
+    size_t FindXmlEscapeSse2(const char* data, size_t size)
+    {
+        const __m128i lt = _mm_set1_epi8('<');
+        const __m128i gt = _mm_set1_epi8('>');
+        const __m128i amp = _mm_set1_epi8('&');
+        const __m128i apos = _mm_set1_epi8('\'');
+        const __m128i quote = _mm_set1_epi8('"');
+
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i mask = _mm_or_si128(_mm_cmpeq_epi8(v, lt), _mm_cmpeq_epi8(v, gt));
+            mask = _mm_or_si128(mask, _mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, apos)));
+            mask = _mm_or_si128(mask, _mm_or_si128(_mm_cmpeq_epi8(v, quote), ControlMaskSse2(v)));
+
+            const unsigned bits = static_cast<unsigned>(_mm_movemask_epi8(mask));
+            if (bits != 0)
+                return i + std::countr_zero(bits);
+        }
+
+        return i + FindXmlEscapeScalar(data + i, size - i);
+    }
+
+    size_t FindCDataBreakSse2(const char* data, size_t size)
+    {
+        const __m128i bracket = _mm_set1_epi8(']');
+
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i mask = _mm_or_si128(_mm_cmpeq_epi8(v, bracket), ControlMaskSse2(v));
+
+            const unsigned bits = static_cast<unsigned>(_mm_movemask_epi8(mask));
+            if (bits != 0)
+                return i + std::countr_zero(bits);
+        }
+
+        return i + FindCDataBreakScalar(data + i, size - i);
+    }
+
+    size_t FindNonPrintableSse2(const char* data, size_t size)
+    {
+        const __m128i del = _mm_set1_epi8(0x7F);
+
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i mask = _mm_or_si128(ControlMaskSse2(v), _mm_cmpeq_epi8(v, del));
+
+            // The sign bit of each byte already flags everything >= 0x80
+            const unsigned bits = static_cast<unsigned>(_mm_movemask_epi8(mask) | _mm_movemask_epi8(v));
+            if (bits != 0)
+                return i + std::countr_zero(bits);
+        }
+
+        return i + FindNonPrintableScalar(data + i, size - i);
+    }
+
+    size_t FindNonAsciiSse2(const char* data, size_t size)
+    {
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+
+            const unsigned bits = static_cast<unsigned>(_mm_movemask_epi8(v));
+            if (bits != 0)
+                return i + std::countr_zero(bits);
+        }
+
+        return i + FindNonAsciiScalar(data + i, size - i);
+    }
+
+    FLOG_TARGET_AVX2 inline __m256i ControlMaskAvx2(__m256i v)
+    {
+        const __m256i controlMax = _mm256_set1_epi8(0x1F);
+        return _mm256_cmpeq_epi8(_mm256_max_epu8(v, controlMax), controlMax);
+    }
+
+    FLOG_TARGET_AVX2 size_t FindJsonEscapeAvx2(const char* data, size_t size)
+    {
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i mask = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash));
+            mask = _mm256_or_si256(mask, ControlMaskAvx2(v));
+
+            const unsigned bits = static_cast<unsigned>(_mm256_movemask_epi8(mask));
+            if (bits != 0)
+                return i + std::countr_zero(bits);
+        }
+
+        return i + FindJsonEscapeSse2(data + i, size - i);
+    }
+
+    FLOG_TARGET_AVX2 size_t FindXmlEscapeAvx2(const char* data, size_t size)
+    {
+        const __m256i lt = _mm256_set1_epi8('<');
+        const __m256i gt = _mm256_set1_epi8('>');
+        const __m256i amp = _mm256_set1_epi8('&');
+        const __m256i apos = _mm256_set1_epi8('\'');
+        const __m256i quote = _mm256_set1_epi8('"');
+
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i mask = _mm256_or_si256(_mm256_cmpeq_epi8(v, lt), _mm256_cmpeq_epi8(v, gt));
+            mask = _mm256_or_si256(mask, _mm256_or_si256(_mm256_cmpeq_epi8(v, amp), _mm256_cmpeq_epi8(v, apos)));
+            mask = _mm256_or_si256(mask, _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), ControlMaskAvx2(v)));
+
+            const unsigned bits = static_cast<unsigned>(_mm256_movemask_epi8(mask));
+            if (bits != 0)
+                return i + std::countr_zero(bits);
+        }
+
+        return i + FindXmlEscapeSse2(data + i, size - i);
+    }
+
+    FLOG_TARGET_AVX2 size_t FindCDataBreakAvx2(const char* data, size_t size)
+    {
+        const __m256i bracket = _mm256_set1_epi8(']');
+
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            const __m256i mask = _mm256_or_si256(_mm256_cmpeq_epi8(v, bracket), ControlMaskAvx2(v));
+
+            const unsigned bits = static_cast<unsigned>(_mm256_movemask_epi8(mask));
+            if (bits != 0)
+                return i + std::countr_zero(bits);
+        }
+
+        return i + FindCDataBreakSse2(data + i, size - i);
+    }
+
+    FLOG_TARGET_AVX2 size_t FindNonPrintableAvx2(const char* data, size_t size)
+    {
+        const __m256i del = _mm256_set1_epi8(0x7F);
+
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            const __m256i mask = _mm256_or_si256(ControlMaskAvx2(v), _mm256_cmpeq_epi8(v, del));
+
+            const unsigned bits = static_cast<unsigned>(_mm256_movemask_epi8(mask) | _mm256_movemask_epi8(v));
+            if (bits != 0)
+                return i + std::countr_zero(bits);
+        }
+
+        return i + FindNonPrintableSse2(data + i, size - i);
+    }
+
+    size_t FindInvalidUtf8Sse2(const char* data, size_t size) { return FindInvalidUtf8Decoding<FindNonAsciiSse2>(data, size); }
+
+    // AVX2 validates UTF-8 without decoding it, after Keiser and Lemire, "Validating UTF-8 In Less Than One
+    // Instruction Per Byte". Each byte is classified together with the one before it through three nibble
+    // lookups; every bit of the result names an error the pair can show, so an invalid pair is one whose
+    // three lookups share a bit. Bytes two and three back then tell where a continuation must follow.
+    enum Utf8Error : uint8_t
+    {
+        TOO_SHORT      = 1 << 0,  // Lead byte followed by a lead or ASCII byte
+        TOO_LONG       = 1 << 1,  // ASCII followed by a continuation
+        OVERLONG_3     = 1 << 2,  // E0 80..9F
+        TOO_LARGE      = 1 << 3,  // F4 90..BF, or F5+
+        SURROGATE      = 1 << 4,  // ED A0..BF
+        OVERLONG_2     = 1 << 5,  // C0 or C1
+        TOO_LARGE_1000 = 1 << 6,  // F5+ followed by a continuation
+        OVERLONG_4     = 1 << 6,  // F0 80..8F
+        TWO_CONTS      = 1 << 7   // Continuation followed by a continuation
+    };
+
+    constexpr uint8_t UTF8_CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+    // Indexed by the high nibble of the first byte
+    alignas(16) constexpr uint8_t UTF8_BYTE_1_HIGH[16] = {
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+    };
+
+    // Indexed by the low nibble of the first byte
+    alignas(16) constexpr uint8_t UTF8_BYTE_1_LOW[16] = {
+        UTF8_CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        UTF8_CARRY | OVERLONG_2,
+        UTF8_CARRY,
+        UTF8_CARRY,
+        UTF8_CARRY | TOO_LARGE,
+        UTF8_CARRY | TOO_LARGE | TOO_LARGE_1000,
+        UTF8_CARRY | TOO_LARGE | TOO_LARGE_1000,
+        UTF8_CARRY | TOO_LARGE | TOO_LARGE_1000,
+        UTF8_CARRY | TOO_LARGE | TOO_LARGE_1000,
+        UTF8_CARRY | TOO_LARGE | TOO_LARGE_1000,
+        UTF8_CARRY | TOO_LARGE | TOO_LARGE_1000,
+        UTF8_CARRY | TOO_LARGE | TOO_LARGE_1000,
+        UTF8_CARRY | TOO_LARGE | TOO_LARGE_1000,
+        UTF8_CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        UTF8_CARRY | TOO_LARGE | TOO_LARGE_1000,
+        UTF8_CARRY | TOO_LARGE | TOO_LARGE_1000
+    };
+
+    // Indexed by the high nibble of the second byte
+    alignas(16) constexpr uint8_t UTF8_BYTE_2_HIGH[16] = {
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+    };
+
+    FLOG_TARGET_AVX2 inline __m256i NibbleLookupAvx2(const uint8_t (&table)[16], __m256i nibbles)
+    {
+        const __m256i lookup = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+        return _mm256_shuffle_epi8(lookup, nibbles);
+    }
+
+    // The bytes N places back, the first N taken from the end of the previous vector
+    template<int N>
+    FLOG_TARGET_AVX2 inline __m256i PreviousBytesAvx2(__m256i input, __m256i previous)
+    {
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - N);
+    }
+
+    FLOG_TARGET_AVX2 inline __m256i Utf8ErrorsAvx2(__m256i input, __m256i previous)
+    {
+        const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+
+        const __m256i prev1 = PreviousBytesAvx2<1>(input, previous);
+        const __m256i byte1High = NibbleLookupAvx2(UTF8_BYTE_1_HIGH, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), lowNibble));
+        const __m256i byte1Low = NibbleLookupAvx2(UTF8_BYTE_1_LOW, _mm256_and_si256(prev1, lowNibble));
+        const __m256i byte2High = NibbleLookupAvx2(UTF8_BYTE_2_HIGH, _mm256_and_si256(_mm256_srli_epi16(input, 4), lowNibble));
+        const __m256i pairErrors = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+        // A continuation after a continuation sets TWO_CONTS. Two or three bytes after a three or four byte
+        // lead that is expected and the two cancel out; either one without the other is an error.
+        const __m256i third = _mm256_subs_epu8(PreviousBytesAvx2<2>(input, previous), _mm256_set1_epi8(0xE0 - 0x80));
+        const __m256i fourth = _mm256_subs_epu8(PreviousBytesAvx2<3>(input, previous), _mm256_set1_epi8(0xF0 - 0x80));
+        const __m256i expected = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+
+        return _mm256_xor_si256(expected, pairErrors);
+    }
+
+    // Non-zero where a lead byte in the last three places needs more bytes than the vector has left
+    FLOG_TARGET_AVX2 inline __m256i Utf8IncompleteAvx2(__m256i input)
+    {
+        const __m256i limits = _mm256_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+        return _mm256_subs_epu8(input, limits);
+    }
+
+    FLOG_TARGET_AVX2 size_t FindInvalidUtf8Avx2(const char* data, size_t size)
+    {
+        __m256i previous = _mm256_setzero_si256();
+        __m256i incomplete = _mm256_setzero_si256();
+
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+
+            __m256i errors;
+            if (_mm256_movemask_epi8(v) == 0)
+            {
+                // ASCII is only wrong here if the last vector ended inside a sequence
+                errors = incomplete;
+                incomplete = _mm256_setzero_si256();
+            }
+            else
+            {
+                errors = Utf8ErrorsAvx2(v, previous);
+                incomplete = Utf8IncompleteAvx2(v);
+            }
+
+            if (!_mm256_testz_si256(errors, errors))
+                break;
+
+            previous = v;
+        }
+
+        // Everything before the sequence running into i is valid. Decoding from its lead byte finds the
+        // error the vectors saw, or checks the tail they left over.
+        size_t start = i;
+        while (start > 0 && i - start < 4)
+        {
+            --start;
+            if ((static_cast<unsigned char>(data[start]) & 0xC0) != 0x80)
+                break;
+        }
+
+        return start + FindInvalidUtf8Sse2(data + start, size - start);
+    }
+#endif
+
+    struct ScanKernels
+    {
+        FlexLog::SimdLevel level;
+        ScanFunction findJsonEscape;
+        ScanFunction findXmlEscape;
+        ScanFunction findNonPrintable;
+        ScanFunction findInvalidUtf8;
+        ScanFunction findCDataBreak;
+    };
+
+    constexpr ScanKernels SCALAR_KERNELS = { FlexLog::SimdLevel::Scalar, FindJsonEscapeScalar, FindXmlEscapeScalar, FindNonPrintableScalar, FindInvalidUtf8Scalar, FindCDataBreakScalar };
+
+#if defined(FLOG_TEXT_SCAN_X86)
+    constexpr ScanKernels SSE2_KERNELS = { FlexLog::SimdLevel::SSE2, FindJsonEscapeSse2, FindXmlEscapeSse2, FindNonPrintableSse2, FindInvalidUtf8Sse2, FindCDataBreakSse2 };
+    constexpr ScanKernels AVX2_KERNELS = { FlexLog::SimdLevel::AVX2, FindJsonEscapeAvx2, FindXmlEscapeAvx2, FindNonPrintableAvx2, FindInvalidUtf8Avx2, FindCDataBreakAvx2 };
+#endif
+
+    FlexLog::SimdLevel DetectSimdLevel()
+    {
+#if defined(FLOG_TEXT_SCAN_X86)
+    #if defined(FLOG_COMPILER_MSVC)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return FlexLog::SimdLevel::SSE2;
+
+        // AVX2 needs both the CPU bit and the OS saving YMM state (OSXSAVE + XCR0 bits 1 and 2)
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+            return FlexLog::SimdLevel::SSE2;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0 ? FlexLog::SimdLevel::AVX2 : FlexLog::SimdLevel::SSE2;
+    #else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? FlexLog::SimdLevel::AVX2 : FlexLog::SimdLevel::SSE2;
+    #endif
+#else
+        return FlexLog::SimdLevel::Scalar;
+#endif
+    }
+
+    const ScanKernels* SelectKernels(FlexLog::SimdLevel level)
+    {
+#if defined(FLOG_TEXT_SCAN_X86)
+        switch (level)
+        {
+            case FlexLog::SimdLevel::AVX2: return &AVX2_KERNELS;
+            case FlexLog::SimdLevel::SSE2: return &SSE2_KERNELS;
+            default:                       break;
+        }
+#else
+        (void)level;
+#endif
+        return &SCALAR_KERNELS;
+    }
+
+    FlexLog::SimdLevel GetDetectedLevel()
+    {
+        static const FlexLog::SimdLevel s_detectedLevel = DetectSimdLevel();
+        return s_detectedLevel;
+    }
+
+    std::atomic<const ScanKernels*> s_kernels{nullptr};
+
+    const ScanKernels& GetKernels()
+    {
+        const ScanKernels* kernels = s_kernels.load(std::memory_order_acquire);
+        if (kernels == nullptr)
+        {
+            // Racing initializers all pick the same table, so a plain store is enough
+            kernels = SelectKernels(GetDetectedLevel());
+            s_kernels.store(kernels, std::memory_order_release);
+        }
+        return *kernels;
+    }
+}
+
+FlexLog::SimdLevel FlexLog::Internal::GetSimdLevel()
+{
+    return GetKernels().level;
+}
+
+void FlexLog::Internal::SetSimdLevel(SimdLevel level)
+{
+    const SimdLevel detected = GetDetectedLevel();
+    if (static_cast<int>(level) > static_cast<int>(detected))
+        level = detected;
+
+    s_kernels.store(SelectKernels(level), std::memory_order_release);
+}
+
+size_t FlexLog::Internal::FindJsonEscape(const char* data, size_t size)
+{
+    return GetKernels().findJsonEscape(data, size);
+}
+
+size_t FlexLog::Internal::FindXmlEscape(const char* data, size_t size)
+{
+    return GetKernels().findXmlEscape(data, size);
+}
+
+size_t FlexLog::Internal::FindCDataBreak(const char* data, size_t size)
+{
+    return GetKernels().findCDataBreak(data, size);
+}
+
+size_t FlexLog::Internal::FindNonPrintable(const char* data, size_t size)
+{
+    return GetKernels().findNonPrintable(data, size);
+}
+
+size_t FlexLog::Internal::FindInvalidUtf8(const char* data, size_t size)
+{
+    return GetKernels().findInvalidUtf8(data, size);
+}
+
+size_t FlexLog::Internal::GetUtf8SequenceLength(const char* data, size_t size)
+{
+    return Utf8SequenceLength(data, size);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace FlexLog
+{
+    enum class SimdLevel
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    namespace Internal
+    {
+        // Instruction set picked for the text scanning kernels, detected once at first use
+        SimdLevel GetSimdLevel();
+
+        // Overrides the detected level (clamped to what the CPU supports); used to exercise fallbacks
+        void SetSimdLevel(SimdLevel level);
+
+        // Offset of the first byte JSON needs escaped ('"', '\\' or a control character), or size
+        size_t FindJsonEscape(const char* data, size_t size);
+
+        // Offset of the first byte that may need an XML entity ('<', '>', '&', '\'', '"' or a
+        // control character), or size. Tabs and line breaks are reported too; callers copy them as is.
+        size_t FindXmlEscape(const char* data, size_t size);
+
+        // Offset of the first byte that can't be copied into a CDATA section as is: ']', which may
+        // start the "]]>" terminator, or a control character, or size. Tabs and line breaks are
+        // reported too; callers copy them as is.
+        size_t FindCDataBreak(const char* data, size_t size);
+
+        // Offset of the first byte that is not printable ASCII (control characters, DEL and
+        // anything >= 0x80), or size
+        size_t FindNonPrintable(const char* data, size_t size);
+
+        // Offset of the first byte that starts an invalid or truncated UTF-8 sequence, or size
+        size_t FindInvalidUtf8(const char* data, size_t size);
+
+        // Length of the well-formed UTF-8 sequence starting at data, or 0 if it is invalid
+        size_t GetUtf8SequenceLength(const char* data, size_t size);
+
+        // U+FFFD, written in place of bytes that can't be carried through as they are
+        constexpr std::string_view UTF8_REPLACEMENT_CHARACTER = "\xEF\xBF\xBD";
+
+        inline size_t FindJsonEscape(std::string_view str) { return FindJsonEscape(str.data(), str.size()); }
+        inline size_t FindXmlEscape(std::string_view str) { return FindXmlEscape(str.data(), str.size()); }
+        inline size_t FindCDataBreak(std::string_view str) { return FindCDataBreak(str.data(), str.size()); }
+        inline size_t FindNonPrintable(std::string_view str) { return FindNonPrintable(str.data(), str.size()); }
+        inline size_t FindInvalidUtf8(std::string_view str) { return FindInvalidUtf8(str.data(), str.size()); }
+
+        // Calls writeRun(data, size) for each run of valid UTF-8 in str, appending U+FFFD to out for
+        // every byte that starts an invalid sequence between them. A valid string costs one
+        // validation pass and a single writeRun call.
+        template<typename Out, typename RunFn>
+        void ForEachValidUtf8Run(Out& out, std::string_view str, RunFn&& writeRun)
+        {
+            while (true)
+            {
+                const size_t valid = FindInvalidUtf8(str);
+                writeRun(str.data(), valid);
+
+                if (valid == str.size())
+                    break;
+
+                out.Append(UTF8_REPLACEMENT_CHARACTER);
+                str.remove_prefix(valid + 1);
+            }
+        }
+    }
+}
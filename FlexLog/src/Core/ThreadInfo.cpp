@@ -0,0 +1,100 @@
+#include "ThreadInfo.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "TraceContext.h"
+
+#ifdef FLOG_PLATFORM_WINDOWS
+    #include <Windows.h>
+#elif defined(FLOG_PLATFORM_POSIX)
+    #include <pthread.h>
+    #include <unistd.h>
+    #if defined(FLOG_PLATFORM_LINUX) || defined(FLOG_PLATFORM_ANDROID)
+        #include <sys/syscall.h>
+    #endif
+#endif
+
+thread_local FlexLog::ThreadInfo::Identity FlexLog::ThreadInfo::t_identity;
+
+namespace FlexLog::Internal
+{
+    struct ThreadNameRegistry
+    {
+        std::mutex mutex;
+        std::unordered_set<std::string> names;  // Node-based, so interned names never move
+        std::unordered_map<uint32_t, std::string_view> byIndex;
+    };
+
+    ThreadNameRegistry& GetThreadNameRegistry()
+    {
+        // Never destroyed, so threads still logging during static destruction find their names
+        static ThreadNameRegistry* registry = new ThreadNameRegistry();
+        return *registry;
+    }
+
+    std::atomic<uint32_t> s_nextThreadIndex{1};
+
+    uint64_t QueryThreadId()
+    {
+#ifdef FLOG_PLATFORM_WINDOWS
+        return GetCurrentThreadId();
+#elif defined(FLOG_PLATFORM_LINUX) || defined(FLOG_PLATFORM_ANDROID)
+        return static_cast<uint64_t>(syscall(SYS_gettid));
+#elif defined(FLOG_PLATFORM_APPLE)
+        uint64_t id = 0;
+        pthread_threadid_np(nullptr, &id);
+        return id;
+#else
+        return std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif
+    }
+}
+
+void FlexLog::ThreadInfo::SetCurrentName(std::string_view name)
+{
+    Current();
+
+    Internal::ThreadNameRegistry& registry = Internal::GetThreadNameRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    const std::string_view interned = *registry.names.emplace(name).first;
+    registry.byIndex[t_identity.index] = interned;
+    t_identity.name = interned;
+}
+
+std::string_view FlexLog::ThreadInfo::GetName(uint32_t index)
+{
+    Internal::ThreadNameRegistry& registry = Internal::GetThreadNameRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    const auto it = registry.byIndex.find(index);
+    return it != registry.byIndex.end() ? it->second : std::string_view();
+}
+
+void FlexLog::ThreadInfo::Capture()
+{
+#ifdef FLOG_PLATFORM_POSIX
+    // The thread that forks carries on in the child under a new ID, and with the parent's random state. The
+    // handler clears the cached ID and reseeds the thread's trace ID generator.
+    static const bool s_forkHandlerRegistered = []()
+    {
+        pthread_atfork(nullptr, nullptr, []()
+        {
+            t_identity.id = 0;
+            Internal::ReseedRandom();
+        });
+        return true;
+    }();
+    (void)s_forkHandlerRegistered;
+#endif
+
+    t_identity.id = Internal::QueryThreadId();
+
+    if (t_identity.index == 0)
+        t_identity.index = Internal::s_nextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "Common.h"
+
+namespace FlexLog
+{
+    /**
+    * @brief Identity of the calling thread, as captured into each message.
+    *
+    * The OS thread ID is queried once per thread and cached, and again in a
+    * child process after fork(). The index is a small sequential number a
+    * thread gets the first time it logs. Names set with SetCurrentName() are
+    * interned for the life of the process, so messages refer to them without
+    * copying.
+    */
+    class ThreadInfo
+    {
+    public:
+        struct Identity
+        {
+            uint64_t id = 0;
+            uint32_t index = 0;
+            std::string_view name;
+        };
+
+        // The calling thread's identity; only the first call on a thread queries the OS
+        static const Identity& Current()
+        {
+            if (t_identity.id == 0)
+                Capture();
+            return t_identity;
+        }
+
+        // Names the calling thread in log output
+        static void SetCurrentName(std::string_view name);
+
+        // Name registered for a thread index; empty if the thread never set one
+        static std::string_view GetName(uint32_t index);
+
+    private:
+        static void Capture();
+
+        static thread_local Identity t_identity;
+    };
+}
@@ -0,0 +1,143 @@
+#include "TraceContext.h"
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <random>
+
+#include "ThreadInfo.h"
+
+thread_local FlexLog::TraceIds FlexLog::TraceContext::t_current;
+
+namespace FlexLog::Internal
+{
+    // xoshiro256**: four words of state and a handful of shifts per value
+    class Xoshiro256
+    {
+    public:
+        Xoshiro256() { Seed(); }
+
+        void Seed()
+        {
+            // Expand one seed into the whole state with splitmix64, which never yields all zeros
+            std::random_device device;
+            uint64_t seed = (static_cast<uint64_t>(device()) << 32) ^ device();
+
+            for (uint64_t& word : m_state)
+            {
+                seed += 0x9e3779b97f4a7c15ull;
+                uint64_t z = seed;
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+                word = z ^ (z >> 31);
+            }
+        }
+
+        uint64_t Next()
+        {
+            const uint64_t result = std::rotl(m_state[1] * 5, 7) * 9;
+            const uint64_t t = m_state[1] << 17;
+
+            m_state[2] ^= m_state[0];
+            m_state[3] ^= m_state[1];
+            m_state[1] ^= m_state[2];
+            m_state[0] ^= m_state[3];
+            m_state[2] ^= t;
+            m_state[3] = std::rotl(m_state[3], 45);
+
+            return result;
+        }
+
+    private:
+        uint64_t m_state[4];
+    };
+
+    // Two hex digits for every byte value
+    constexpr std::array<char, 512> HEX_PAIRS = []()
+    {
+        constexpr char digits[] = "0123456789abcdef";
+        std::array<char, 512> pairs{};
+        for (size_t i = 0; i < 256; ++i)
+        {
+            pairs[i * 2] = digits[i >> 4];
+            pairs[i * 2 + 1] = digits[i & 0xf];
+        }
+        return pairs;
+    }();
+
+    bool ParseHexWord(std::string_view hex, uint64_t& value)
+    {
+        const auto result = std::from_chars(hex.data(), hex.data() + hex.size(), value, 16);
+        return result.ec == std::errc() && result.ptr == hex.data() + hex.size();
+    }
+
+    Xoshiro256& GetThreadGenerator()
+    {
+        static thread_local Xoshiro256 t_generator = []()
+        {
+            // Installs ThreadInfo's fork handler, which reseeds the generator of the thread that forks
+            ThreadInfo::Current();
+            return Xoshiro256();
+        }();
+        return t_generator;
+    }
+
+    uint64_t NextRandom()
+    {
+        return GetThreadGenerator().Next();
+    }
+
+    void ReseedRandom()
+    {
+        GetThreadGenerator().Seed();
+    }
+
+    uint64_t NextRandomId()
+    {
+        uint64_t value = NextRandom();
+        while (value == 0)
+            value = NextRandom();
+        return value;
+    }
+
+    void WriteHex(char* dst, uint64_t value)
+    {
+        for (int i = 7; i >= 0; --i)
+        {
+            std::memcpy(dst + i * 2, &HEX_PAIRS[(value & 0xff) * 2], 2);
+            value >>= 8;
+        }
+    }
+
+    void WriteBigEndian(char* dst, uint64_t value)
+    {
+        for (int i = 7; i >= 0; --i)
+        {
+            dst[i] = static_cast<char>(value);
+            value >>= 8;
+        }
+    }
+}
+
+FlexLog::TraceIds FlexLog::TraceIds::FromHex(std::string_view traceId, std::string_view spanId)
+{
+    TraceIds ids;
+
+    if (traceId.size() != 32 || !Internal::ParseHexWord(traceId.substr(0, 16), ids.traceHigh) || !Internal::ParseHexWord(traceId.substr(16), ids.traceLow))
+        ids.traceHigh = ids.traceLow = 0;
+
+    if (spanId.size() != 16 || !Internal::ParseHexWord(spanId, ids.span))
+        ids.span = 0;
+
+    return ids;
+}
+
+FlexLog::TraceIds FlexLog::TraceIds::Generate()
+{
+    TraceIds ids;
+    ids.traceHigh = Internal::NextRandom();
+    ids.traceLow = Internal::NextRandomId();
+    ids.span = Internal::NextRandomId();
+    return ids;
+}
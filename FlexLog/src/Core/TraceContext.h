@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "Common.h"
+
+namespace FlexLog
+{
+    // W3C trace context IDs as machine words; zero words mean "not set"
+    struct TraceIds
+    {
+        uint64_t traceHigh = 0;
+        uint64_t traceLow = 0;
+        uint64_t span = 0;
+
+        bool HasTrace() const { return (traceHigh | traceLow) != 0; }
+        bool HasSpan() const { return span != 0; }
+
+        // Parses 32 and 16 hex digits; an ID that doesn't parse is left unset
+        static TraceIds FromHex(std::string_view traceId, std::string_view spanId);
+
+        // A new trace with a new span, from the thread's generator
+        static TraceIds Generate();
+    };
+
+    /**
+    * @brief Thread-local trace and span IDs, captured into each message.
+    *
+    * Set the IDs of the request being served, typically from an incoming
+    * traceparent header, for the lifetime of a Scope; every message logged
+    * from the thread in the meantime carries them, so its records correlate
+    * with the trace.
+    */
+    class TraceContext
+    {
+    public:
+        class Scope
+        {
+        public:
+            explicit Scope(const TraceIds& ids) : m_previous(t_current) { t_current = ids; }
+            Scope(std::string_view traceId, std::string_view spanId) : Scope(TraceIds::FromHex(traceId, spanId)) {}
+            ~Scope() { t_current = m_previous; }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            TraceIds m_previous;
+        };
+
+        static const TraceIds& Current() { return t_current; }
+
+        static void Set(const TraceIds& ids) { t_current = ids; }
+        static void Clear() { t_current = TraceIds(); }
+
+    private:
+        static thread_local TraceIds t_current;
+    };
+
+    namespace Internal
+    {
+        // Next value from the calling thread's xoshiro256** generator, seeded once per thread
+        uint64_t NextRandom();
+
+        // Seeds the calling thread's generator afresh. ThreadInfo's fork handler calls it, so a child process
+        // doesn't generate the same IDs as its parent.
+        void ReseedRandom();
+
+        // Random value that is never zero, as trace and span IDs must not be
+        uint64_t NextRandomId();
+
+        // Writes value as 16 lowercase hex digits, two at a time from a lookup table
+        void WriteHex(char* dst, uint64_t value);
+
+        // Writes value's 8 bytes, most significant first
+        void WriteBigEndian(char* dst, uint64_t value);
+    }
+}
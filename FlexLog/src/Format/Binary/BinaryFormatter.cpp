@@ -0,0 +1,328 @@
+#include "BinaryFormatter.h"
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "Format/Structured/FieldSet.h"
+
+namespace FlexLog::Internal
+{
+    // Room reserved for the body length; patched and trimmed once the body is written
+    constexpr size_t LENGTH_PREFIX_RESERVE = 5;
+
+    void AppendBinaryValue(Buffer& out, const FieldView& value)
+    {
+        std::visit([&out](const auto& arg)
+        {
+            using T = std::decay_t<decltype(arg)>;
+
+            auto appendType = [&out](BinaryValueType type) { out.PushBack(static_cast<char>(type)); };
+            auto appendDouble = [&out](double number) { out.Append(reinterpret_cast<const char*>(&number), sizeof(number)); };
+
+            if constexpr (std::is_same_v<T, std::nullptr_t>)
+            {
+                appendType(BinaryValueType::Null);
+            }
+            else if constexpr (std::is_same_v<T, std::string_view>)
+            {
+                appendType(BinaryValueType::String);
+                AppendBinaryString(out, arg);
+            }
+            else if constexpr (std::is_same_v<T, int64_t>)
+            {
+                appendType(BinaryValueType::Int64);
+                AppendVarint(out, ZigZagEncode(arg));
+            }
+            else if constexpr (std::is_same_v<T, uint64_t>)
+            {
+                appendType(BinaryValueType::UInt64);
+                AppendVarint(out, arg);
+            }
+            else if constexpr (std::is_same_v<T, double>)
+            {
+                appendType(BinaryValueType::Double);
+                appendDouble(arg);
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                appendType(BinaryValueType::Bool);
+                out.PushBack(arg ? 1 : 0);
+            }
+            else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
+            {
+                appendType(BinaryValueType::Timestamp);
+                AppendVarint(out, ZigZagEncode(ToEpochNanos(arg)));
+            }
+            else if constexpr (std::is_same_v<T, std::span<const std::string>>)
+            {
+                appendType(BinaryValueType::StringArray);
+                AppendVarint(out, arg.size());
+                for (const std::string& item : arg)
+                    AppendBinaryString(out, item);
+            }
+            else if constexpr (std::is_same_v<T, std::span<const int64_t>>)
+            {
+                appendType(BinaryValueType::Int64Array);
+                AppendVarint(out, arg.size());
+                for (int64_t item : arg)
+                    AppendVarint(out, ZigZagEncode(item));
+            }
+            else if constexpr (std::is_same_v<T, std::span<const double>>)
+            {
+                appendType(BinaryValueType::DoubleArray);
+                AppendVarint(out, arg.size());
+                for (double item : arg)
+                    appendDouble(item);
+            }
+            else
+            {
+                appendType(BinaryValueType::BoolArray);
+                AppendVarint(out, arg.size());
+                for (size_t i = 0; i < arg.size(); ++i)
+                    out.PushBack(arg[i] ? 1 : 0);
+            }
+        }, value);
+    }
+
+    void AppendBinarySite(Buffer& out, const SourceLocation& location)
+    {
+        AppendBinaryString(out, location.file_name());
+        AppendBinaryString(out, location.function_name());
+        AppendVarint(out, location.line());
+        AppendVarint(out, location.column());
+    }
+
+    void AppendBinaryEntry(Buffer& out, uint32_t id, std::string_view value)
+    {
+        AppendVarint(out, id);
+        if (id == INLINE_ENTRY)
+            AppendBinaryString(out, value);
+    }
+}
+
+struct FlexLog::BinaryFormatter::Resolution
+{
+    std::vector<std::pair<std::string_view, FieldView>>& fields;
+    std::vector<uint32_t>& keyIds;
+
+    uint32_t generation = 0;
+    int64_t baseNanos = 0;
+    uint32_t loggerId = Internal::INLINE_ENTRY;
+    uint32_t siteId = Internal::INLINE_ENTRY;
+    uint32_t textId = Internal::INLINE_ENTRY;
+};
+
+FlexLog::BinaryFormatter& FlexLog::BinaryFormatter::operator=(const BinaryFormatter& other)
+{
+    if (this != &other)
+        SetOptions(other.GetOptions());
+    return *this;
+}
+
+std::string FlexLog::BinaryFormatter::FormatMessage(const Message& message) const
+{
+    Buffer buffer;
+    FormatTo(message, buffer);
+    return buffer.ToString();
+}
+
+void FlexLog::BinaryFormatter::FormatTo(const Message& message, Buffer& out) const
+{
+    thread_local std::vector<std::pair<std::string_view, FieldView>> t_fields;
+    thread_local std::vector<uint32_t> t_keyIds;
+    thread_local Buffer t_definitions;
+
+    t_fields.clear();
+    FieldSet(message).ForEach([](std::string_view key, const FieldView& value) { t_fields.emplace_back(key, value); });
+    t_keyIds.assign(t_fields.size(), Internal::INLINE_ENTRY);
+    t_definitions.Clear();
+
+    const int64_t nanos = Internal::ToEpochNanos(message.timestamp);
+    Resolution resolution{ t_fields, t_keyIds };
+
+    bool resolved = false;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        resolved = TryResolve(message, nanos, resolution);
+    }
+
+    if (!resolved)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        ResolveAndDefine(message, nanos, resolution, t_definitions);
+    }
+
+    const size_t start = out.Size();
+    out.Extend(Internal::LENGTH_PREFIX_RESERVE);
+    const size_t bodyStart = out.Size();
+
+    Internal::AppendVarint(out, resolution.generation);
+    out.Append(t_definitions.View());
+
+    out.PushBack(static_cast<char>(BinaryTag::Event));
+    Internal::AppendVarint(out, Internal::ZigZagEncode(nanos - resolution.baseNanos));
+    out.PushBack(static_cast<char>(message.level));
+
+    Internal::AppendBinaryEntry(out, resolution.loggerId, message.name);
+
+    Internal::AppendVarint(out, resolution.siteId);
+    if (resolution.siteId == Internal::INLINE_ENTRY)
+        Internal::AppendBinarySite(out, message.sourceLocation);
+
+    Internal::AppendBinaryEntry(out, resolution.textId, message.message);
+
+    Internal::AppendVarint(out, t_fields.size());
+    for (size_t i = 0; i < t_fields.size(); ++i)
+    {
+        Internal::AppendBinaryEntry(out, t_keyIds[i], t_fields[i].first);
+        Internal::AppendBinaryValue(out, t_fields[i].second);
+    }
+
+    char prefix[Internal::MAX_VARINT_LENGTH];
+    const size_t prefixLength = Internal::EncodeVarint(prefix, out.Size() - bodyStart);
+    if (prefixLength > Internal::LENGTH_PREFIX_RESERVE)
+    {
+        // Bodies over 32 GB; never expected, but keep the record well-formed
+        out.Truncate(start);
+        return;
+    }
+
+    std::memcpy(out.Data() + start, prefix, prefixLength);
+    out.Erase(start + prefixLength, Internal::LENGTH_PREFIX_RESERVE - prefixLength);
+}
+
+void FlexLog::BinaryFormatter::Reset() const
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_rollPending = true;
+}
+
+FlexLog::BinaryFormatter::Options FlexLog::BinaryFormatter::GetOptions() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_options;
+}
+
+void FlexLog::BinaryFormatter::SetOptions(const Options& options)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_options = options;
+    m_rollPending = true;
+}
+
+bool FlexLog::BinaryFormatter::TryResolve(const Message& message, int64_t nanos, Resolution& resolution) const
+{
+    if (m_rollPending || nanos - m_baseNanos >= m_options.dictionaryWindow.count() * 1'000'000)
+        return false;
+
+    resolution.generation = m_generation;
+    resolution.baseNanos = m_baseNanos;
+
+    // A miss can only be served inline here if the dictionary is full; otherwise the entry needs defining
+    auto lookup = [this](const auto& dictionary, const auto& key, uint32_t& id)
+    {
+        const auto it = dictionary.find(key);
+        if (it != dictionary.end())
+        {
+            id = it->second;
+            return true;
+        }
+
+        id = Internal::INLINE_ENTRY;
+        return dictionary.size() >= m_options.maxDictionaryEntries;
+    };
+
+    const SourceLocation& location = message.sourceLocation;
+    const Internal::BinarySiteKey site{ location.file_name(), location.function_name(), location.line(), location.column() };
+
+    if (!lookup(m_loggers, message.name, resolution.loggerId) || !lookup(m_sites, site, resolution.siteId))
+        return false;
+
+    resolution.textId = Internal::INLINE_ENTRY;
+    if (ShouldInternText(message.message) && !lookup(m_texts, message.message, resolution.textId))
+        return false;
+
+    for (size_t i = 0; i < resolution.fields.size(); ++i)
+    {
+        if (!lookup(m_keys, resolution.fields[i].first, resolution.keyIds[i]))
+            return false;
+    }
+
+    return true;
+}
+
+void FlexLog::BinaryFormatter::ResolveAndDefine(const Message& message, int64_t nanos, Resolution& resolution, Buffer& out) const
+{
+    if (m_rollPending || nanos - m_baseNanos >= m_options.dictionaryWindow.count() * 1'000'000)
+    {
+        StartGeneration(nanos);
+
+        out.PushBack(static_cast<char>(BinaryTag::Generation));
+        Internal::AppendVarint(out, Internal::ZigZagEncode(m_baseNanos));
+    }
+
+    resolution.generation = m_generation;
+    resolution.baseNanos = m_baseNanos;
+
+    resolution.loggerId = Define(m_loggers, message.name, BinaryTag::Logger, out);
+
+    const SourceLocation& location = message.sourceLocation;
+    const Internal::BinarySiteKey site{ location.file_name(), location.function_name(), location.line(), location.column() };
+
+    const auto it = m_sites.find(site);
+    if (it != m_sites.end())
+    {
+        resolution.siteId = it->second;
+    }
+    else if (m_sites.size() < m_options.maxDictionaryEntries)
+    {
+        resolution.siteId = static_cast<uint32_t>(m_sites.size() + 1);
+        m_sites.emplace(site, resolution.siteId);
+
+        out.PushBack(static_cast<char>(BinaryTag::Site));
+        Internal::AppendVarint(out, resolution.siteId);
+        Internal::AppendBinarySite(out, location);
+    }
+    else
+    {
+        resolution.siteId = Internal::INLINE_ENTRY;
+    }
+
+    resolution.textId = ShouldInternText(message.message)
+        ? Define(m_texts, message.message, BinaryTag::Text, out)
+        : Internal::INLINE_ENTRY;
+
+    for (size_t i = 0; i < resolution.fields.size(); ++i)
+        resolution.keyIds[i] = Define(m_keys, resolution.fields[i].first, BinaryTag::Key, out);
+}
+
+void FlexLog::BinaryFormatter::StartGeneration(int64_t nanos) const
+{
+    ++m_generation;
+    m_baseNanos = nanos;
+    m_rollPending = false;
+
+    m_loggers.clear();
+    m_sites.clear();
+    m_texts.clear();
+    m_keys.clear();
+}
+
+uint32_t FlexLog::BinaryFormatter::Define(StringDictionary& dictionary, std::string_view value, BinaryTag tag, Buffer& out) const
+{
+    const auto it = dictionary.find(value);
+    if (it != dictionary.end())
+        return it->second;
+
+    if (dictionary.size() >= m_options.maxDictionaryEntries)
+        return Internal::INLINE_ENTRY;
+
+    const uint32_t id = static_cast<uint32_t>(dictionary.size() + 1);
+    dictionary.emplace(std::string(value), id);
+
+    out.PushBack(static_cast<char>(tag));
+    Internal::AppendVarint(out, id);
+    Internal::AppendBinaryString(out, value);
+    return id;
+}
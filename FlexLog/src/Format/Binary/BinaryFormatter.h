@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "BinaryProtocol.h"
+#include "Core/Buffer.h"
+#include "Message.h"
+
+namespace FlexLog
+{
+    namespace Internal
+    {
+        struct BinaryStringHash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view str) const { return std::hash<std::string_view>{}(str); }
+        };
+
+        struct BinarySiteKey
+        {
+            const char* file;
+            const char* function;
+            uint32_t line;
+            uint32_t column;
+
+            bool operator==(const BinarySiteKey& other) const = default;
+        };
+
+        struct BinarySiteHash
+        {
+            size_t operator()(const BinarySiteKey& key) const
+            {
+                size_t hash = std::hash<const void*>{}(key.file);
+                hash ^= std::hash<const void*>{}(key.function) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+                hash ^= (static_cast<size_t>(key.line) << 16) ^ key.column;
+                return hash;
+            }
+        };
+    }
+
+    /**
+    * @brief Compact binary encoding of messages, rendered offline by FlexLogDecode.
+    *
+    * Each record is a varint body length followed by the body. Logger names,
+    * call sites, message texts and field keys are replaced by small dictionary
+    * IDs, and an entry's definition is written inline by the first record that
+    * uses it. Timestamps are zigzag varint nanosecond deltas from the base of
+    * the current dictionary generation; typed field values keep their native
+    * binary form. A new generation starts every dictionary window, which
+    * repeats the definitions still in use, so a stream read from the middle
+    * decodes again within one window. FileSink also starts one with every
+    * file it opens, so a rotated file decodes on its own.
+    *
+    * Dictionaries live in the formatter: give each binary sink its own Format
+    * (see Sink::SetFormat), or a sink that skips a record also misses the
+    * definitions it carried.
+    */
+    class BinaryFormatter
+    {
+    public:
+        struct Options
+        {
+            std::chrono::milliseconds dictionaryWindow = std::chrono::seconds(10);
+            size_t maxDictionaryEntries = 4096; // Per generation and kind; further entries are written inline
+            bool internMessages = true;         // Messages arrive rendered, so their text is what repeats
+            size_t maxInternedLength = 256;     // Longer messages are always written inline
+
+            Options& SetDictionaryWindow(std::chrono::milliseconds window) { dictionaryWindow = window; return *this; }
+            Options& SetMaxDictionaryEntries(size_t count) { maxDictionaryEntries = count; return *this; }
+            Options& SetInternMessages(bool enable) { internMessages = enable; return *this; }
+            Options& SetMaxInternedLength(size_t length) { maxInternedLength = length; return *this; }
+        };
+
+        BinaryFormatter() = default;
+        explicit BinaryFormatter(const Options& options) : m_options(options) {}
+
+        // Copies the options only; the copy starts its own stream of generations
+        BinaryFormatter(const BinaryFormatter& other) : m_options(other.GetOptions()) {}
+        BinaryFormatter& operator=(const BinaryFormatter& other);
+
+        std::string FormatMessage(const Message& message) const;
+        void FormatTo(const Message& message, Buffer& out) const;
+
+        // Starts a new generation: the next records define every entry they use again
+        void Reset() const;
+
+        Options GetOptions() const;
+        void SetOptions(const Options& options);
+
+    private:
+        using StringDictionary = std::unordered_map<std::string, uint32_t, Internal::BinaryStringHash, std::equal_to<>>;
+        using SiteDictionary = std::unordered_map<Internal::BinarySiteKey, uint32_t, Internal::BinarySiteHash>;
+
+        struct Resolution;
+
+        bool TryResolve(const Message& message, int64_t nanos, Resolution& resolution) const;
+        void ResolveAndDefine(const Message& message, int64_t nanos, Resolution& resolution, Buffer& out) const;
+        void StartGeneration(int64_t nanos) const;
+        uint32_t Define(StringDictionary& dictionary, std::string_view value, BinaryTag tag, Buffer& out) const;
+
+        bool ShouldInternText(std::string_view text) const { return m_options.internMessages && text.size() <= m_options.maxInternedLength; }
+
+        Options m_options;
+
+        mutable std::shared_mutex m_mutex;
+        mutable uint32_t m_generation = 0;
+        mutable int64_t m_baseNanos = 0;
+        mutable bool m_rollPending = true;
+        mutable StringDictionary m_loggers;
+        mutable SiteDictionary m_sites;
+        mutable StringDictionary m_texts;
+        mutable StringDictionary m_keys;
+    };
+}
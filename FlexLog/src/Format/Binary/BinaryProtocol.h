@@ -0,0 +1,164 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "Core/Buffer.h"
+#include "Format/Structured/Field.h"
+
+namespace FlexLog
+{
+    // Entry tags inside a binary record body. Definitions precede the single event.
+    enum class BinaryTag : uint8_t
+    {
+        Generation = 0x01,  // zigzag(base nanoseconds)
+        Logger = 0x02,      // varint(id) string
+        Site = 0x03,        // varint(id) string(file) string(function) varint(line) varint(column)
+        Text = 0x04,        // varint(id) string
+        Key = 0x05,         // varint(id) string
+        Event = 0x10
+    };
+
+    // Field value types; the scalar ones share FieldType's numbering
+    enum class BinaryValueType : uint8_t
+    {
+        Null = static_cast<uint8_t>(FieldType::Null),
+        String = static_cast<uint8_t>(FieldType::String),
+        Int64 = static_cast<uint8_t>(FieldType::Int64),
+        UInt64 = static_cast<uint8_t>(FieldType::UInt64),
+        Double = static_cast<uint8_t>(FieldType::Double),
+        Bool = static_cast<uint8_t>(FieldType::Bool),
+        Timestamp = static_cast<uint8_t>(FieldType::Timestamp),
+        StringArray,
+        Int64Array,
+        DoubleArray,
+        BoolArray
+    };
+
+    namespace Internal
+    {
+        constexpr size_t MAX_VARINT_LENGTH = 10;
+
+        // Dictionary ID written in place of an entry that was not interned; its value follows inline
+        constexpr uint32_t INLINE_ENTRY = 0;
+
+        inline size_t EncodeVarint(char* dst, uint64_t value)
+        {
+            size_t length = 0;
+            while (value >= 0x80)
+            {
+                dst[length++] = static_cast<char>(static_cast<uint8_t>(value) | 0x80);
+                value >>= 7;
+            }
+            dst[length++] = static_cast<char>(value);
+            return length;
+        }
+
+        inline void AppendVarint(Buffer& out, uint64_t value)
+        {
+            char bytes[MAX_VARINT_LENGTH];
+            out.Append(bytes, EncodeVarint(bytes, value));
+        }
+
+        inline uint64_t ZigZagEncode(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+        inline int64_t ZigZagDecode(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+        inline void AppendBinaryString(Buffer& out, std::string_view str)
+        {
+            AppendVarint(out, str.size());
+            out.Append(str);
+        }
+
+        // Nanoseconds since the epoch, independent of the platform's system_clock tick
+        inline int64_t ToEpochNanos(std::chrono::system_clock::time_point time)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+
+        inline std::chrono::system_clock::time_point FromEpochNanos(int64_t nanos)
+        {
+            return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanos)));
+        }
+
+        /**
+        * @brief Bounds-checked cursor over a binary record.
+        *
+        * Every read fails, rather than running past the end, once the input is
+        * exhausted; callers check Ok() after a group of reads.
+        */
+        class BinaryCursor
+        {
+        public:
+            BinaryCursor(const char* data, size_t size) : m_cursor(data), m_end(data + size) {}
+            explicit BinaryCursor(std::string_view data) : BinaryCursor(data.data(), data.size()) {}
+
+            uint64_t Varint()
+            {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7)
+                {
+                    if (m_cursor == m_end)
+                        break;
+
+                    const uint8_t byte = static_cast<uint8_t>(*m_cursor++);
+                    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0)
+                        return value;
+                }
+
+                m_ok = false;
+                return 0;
+            }
+
+            int64_t ZigZag() { return ZigZagDecode(Varint()); }
+
+            uint8_t Byte()
+            {
+                if (m_cursor == m_end)
+                {
+                    m_ok = false;
+                    return 0;
+                }
+                return static_cast<uint8_t>(*m_cursor++);
+            }
+
+            std::string_view Bytes(uint64_t size)
+            {
+                if (size > Remaining())
+                {
+                    m_ok = false;
+                    m_cursor = m_end;
+                    return {};
+                }
+
+                std::string_view bytes(m_cursor, static_cast<size_t>(size));
+                m_cursor += size;
+                return bytes;
+            }
+
+            std::string_view String() { return Bytes(Varint()); }
+
+            template<typename T>
+            T Raw()
+            {
+                T value{};
+                const std::string_view bytes = Bytes(sizeof(T));
+                if (m_ok)
+                    std::memcpy(&value, bytes.data(), sizeof(T));
+                return value;
+            }
+
+            bool Ok() const { return m_ok; }
+            bool AtEnd() const { return m_cursor == m_end; }
+            size_t Remaining() const { return static_cast<size_t>(m_end - m_cursor); }
+            const char* Position() const { return m_cursor; }
+
+        private:
+            const char* m_cursor;
+            const char* m_end;
+            bool m_ok = true;
+        };
+    }
+}
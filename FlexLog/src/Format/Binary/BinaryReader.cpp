@@ -0,0 +1,292 @@
+#include "BinaryReader.h"
+
+#include <vector>
+
+size_t FlexLog::BinaryReader::Read(std::string_view data, const RecordCallback& callback)
+{
+    Internal::BinaryCursor cursor(data);
+    size_t consumed = 0;
+
+    while (!cursor.AtEnd())
+    {
+        const uint64_t length = cursor.Varint();
+        const std::string_view body = cursor.Bytes(length);
+        if (!cursor.Ok())
+            break;
+
+        if (ReadRecord(body, callback) == DecodeResult::Malformed)
+            ++m_malformedCount;
+
+        consumed = static_cast<size_t>(cursor.Position() - data.data());
+    }
+
+    return consumed;
+}
+
+void FlexLog::BinaryReader::Finish(const RecordCallback& callback)
+{
+    RetryPending(true, callback);
+}
+
+FlexLog::BinaryReader::DecodeResult FlexLog::BinaryReader::ReadRecord(std::string_view body, const RecordCallback& callback)
+{
+    Internal::BinaryCursor cursor(body);
+    const uint32_t generationId = static_cast<uint32_t>(cursor.Varint());
+    bool defined = false;
+
+    while (cursor.Ok() && !cursor.AtEnd())
+    {
+        const BinaryTag tag = static_cast<BinaryTag>(cursor.Byte());
+
+        if (tag == BinaryTag::Event)
+        {
+            // Records held back for one of the definitions above are older, so they go first
+            if (defined && !m_pending.empty())
+                RetryPending(false, callback);
+
+            const std::string_view event(cursor.Position(), cursor.Remaining());
+            const DecodeResult result = DecodeEvent(generationId, event, false, callback);
+
+            if (result == DecodeResult::Pending)
+            {
+                m_pending.push_back({ generationId, std::string(event) });
+
+                if (m_pending.size() > MAX_PENDING_RECORDS)
+                {
+                    if (DecodeEvent(m_pending.front().generation, m_pending.front().event, true, callback) == DecodeResult::Malformed)
+                        ++m_malformedCount;
+                    m_pending.pop_front();
+                }
+            }
+
+            return result;
+        }
+
+        Generation& generation = m_generations[generationId];
+        defined = true;
+
+        switch (tag)
+        {
+            case BinaryTag::Generation:
+            {
+                const int64_t baseNanos = cursor.ZigZag();
+
+                // A second definition of a known generation means the writer restarted
+                if (generation.hasBase)
+                    generation = Generation();
+
+                generation.baseNanos = baseNanos;
+                generation.hasBase = true;
+
+                if (generationId > RETAINED_GENERATIONS)
+                    m_generations.erase(generationId - RETAINED_GENERATIONS);
+                break;
+            }
+            case BinaryTag::Logger:
+            {
+                const uint32_t id = static_cast<uint32_t>(cursor.Varint());
+                generation.loggers[id] = cursor.String();
+                break;
+            }
+            case BinaryTag::Site:
+            {
+                const uint32_t id = static_cast<uint32_t>(cursor.Varint());
+                Site& site = generation.sites[id];
+                site.file = cursor.String();
+                site.function = cursor.String();
+                site.line = static_cast<uint32_t>(cursor.Varint());
+                site.column = static_cast<uint32_t>(cursor.Varint());
+                break;
+            }
+            case BinaryTag::Text:
+            {
+                const uint32_t id = static_cast<uint32_t>(cursor.Varint());
+                generation.texts[id] = cursor.String();
+                break;
+            }
+            case BinaryTag::Key:
+            {
+                const uint32_t id = static_cast<uint32_t>(cursor.Varint());
+                generation.keys[id] = cursor.String();
+                break;
+            }
+            default:
+                return DecodeResult::Malformed;
+        }
+    }
+
+    // Every record ends with an event
+    return DecodeResult::Malformed;
+}
+
+FlexLog::BinaryReader::DecodeResult FlexLog::BinaryReader::DecodeEvent(uint32_t generationId, std::string_view event, bool force, const RecordCallback& callback)
+{
+    const auto found = m_generations.find(generationId);
+    const Generation* generation = found != m_generations.end() ? &found->second : nullptr;
+
+    bool resolved = generation && generation->hasBase;
+    if (!resolved && !force)
+        return DecodeResult::Pending;
+
+    Internal::BinaryCursor cursor(event);
+
+    const int64_t delta = cursor.ZigZag();
+    const uint8_t level = cursor.Byte();
+
+    // Reads an entry ID and looks it up, or reads the value that follows INLINE_ENTRY
+    auto readEntry = [&](const std::unordered_map<uint32_t, std::string>* dictionary) -> std::string_view
+    {
+        const uint64_t id = cursor.Varint();
+        if (id == Internal::INLINE_ENTRY)
+            return cursor.String();
+
+        if (dictionary)
+        {
+            const auto it = dictionary->find(static_cast<uint32_t>(id));
+            if (it != dictionary->end())
+                return it->second;
+        }
+
+        resolved = false;
+        return UNKNOWN_ENTRY;
+    };
+
+    m_message.name = readEntry(generation ? &generation->loggers : nullptr);
+
+    const uint64_t siteId = cursor.Varint();
+    if (siteId == Internal::INLINE_ENTRY)
+    {
+        m_inlineFile = cursor.String();
+        m_inlineFunction = cursor.String();
+        const uint32_t line = static_cast<uint32_t>(cursor.Varint());
+        const uint32_t column = static_cast<uint32_t>(cursor.Varint());
+        m_message.sourceLocation = SourceLocation(m_inlineFile.c_str(), m_inlineFunction.c_str(), line, column);
+    }
+    else
+    {
+        const Site* site = nullptr;
+        if (generation)
+        {
+            const auto it = generation->sites.find(static_cast<uint32_t>(siteId));
+            if (it != generation->sites.end())
+                site = &it->second;
+        }
+
+        if (site)
+        {
+            m_message.sourceLocation = SourceLocation(site->file.c_str(), site->function.c_str(), site->line, site->column);
+        }
+        else
+        {
+            m_message.sourceLocation = SourceLocation(UNKNOWN_ENTRY.data(), UNKNOWN_ENTRY.data(), 0);
+            resolved = false;
+        }
+    }
+
+    m_message.message = readEntry(generation ? &generation->texts : nullptr);
+
+    m_message.fields.Clear();
+    m_message.structuredData.Clear();
+
+    const uint64_t fieldCount = cursor.Varint();
+    for (uint64_t i = 0; i < fieldCount && cursor.Ok(); ++i)
+    {
+        const std::string_view key = readEntry(generation ? &generation->keys : nullptr);
+        const BinaryValueType type = static_cast<BinaryValueType>(cursor.Byte());
+
+        // Every array element takes at least one byte, which bounds counts read from corrupt input
+        auto readCount = [&cursor]() -> size_t
+        {
+            const uint64_t count = cursor.Varint();
+            if (count <= cursor.Remaining())
+                return static_cast<size_t>(count);
+
+            cursor.Bytes(count);  // Fails the cursor
+            return 0;
+        };
+
+        switch (type)
+        {
+            case BinaryValueType::Null:         m_message.fields.Encode(Field<std::nullptr_t>(key, nullptr)); break;
+            case BinaryValueType::String:       m_message.fields.Encode(Field<std::string_view>(key, cursor.String())); break;
+            case BinaryValueType::Int64:        m_message.fields.Encode(Field<int64_t>(key, cursor.ZigZag())); break;
+            case BinaryValueType::UInt64:       m_message.fields.Encode(Field<uint64_t>(key, cursor.Varint())); break;
+            case BinaryValueType::Double:       m_message.fields.Encode(Field<double>(key, cursor.Raw<double>())); break;
+            case BinaryValueType::Bool:         m_message.fields.Encode(Field<bool>(key, cursor.Byte() != 0)); break;
+            case BinaryValueType::Timestamp:
+            {
+                m_message.fields.Encode(Field<std::chrono::system_clock::time_point>(key, Internal::FromEpochNanos(cursor.ZigZag())));
+                break;
+            }
+            case BinaryValueType::StringArray:
+            {
+                std::vector<std::string> values(readCount());
+                for (std::string& value : values)
+                    value = cursor.String();
+                m_message.structuredData.Add(key, values);
+                break;
+            }
+            case BinaryValueType::Int64Array:
+            {
+                std::vector<int64_t> values(readCount());
+                for (int64_t& value : values)
+                    value = cursor.ZigZag();
+                m_message.structuredData.Add(key, values);
+                break;
+            }
+            case BinaryValueType::DoubleArray:
+            {
+                std::vector<double> values(readCount());
+                for (double& value : values)
+                    value = cursor.Raw<double>();
+                m_message.structuredData.Add(key, values);
+                break;
+            }
+            case BinaryValueType::BoolArray:
+            {
+                std::vector<bool> values(readCount());
+                for (size_t j = 0; j < values.size(); ++j)
+                    values[j] = cursor.Byte() != 0;
+                m_message.structuredData.Add(key, values);
+                break;
+            }
+            default:
+                return DecodeResult::Malformed;
+        }
+    }
+
+    if (!cursor.Ok() || !cursor.AtEnd() || level > static_cast<uint8_t>(Level::Off))
+        return DecodeResult::Malformed;
+
+    if (!resolved && !force)
+        return DecodeResult::Pending;
+
+    if (!resolved)
+        ++m_unresolvedCount;
+
+    const int64_t baseNanos = generation && generation->hasBase ? generation->baseNanos : 0;
+    m_message.timestamp = Internal::FromEpochNanos(baseNanos + delta);
+    m_message.level = static_cast<Level>(level);
+
+    ++m_recordCount;
+    callback(m_message);
+    return DecodeResult::Decoded;
+}
+
+void FlexLog::BinaryReader::RetryPending(bool force, const RecordCallback& callback)
+{
+    for (auto it = m_pending.begin(); it != m_pending.end();)
+    {
+        const DecodeResult result = DecodeEvent(it->generation, it->event, force, callback);
+
+        if (result == DecodeResult::Pending)
+        {
+            ++it;
+            continue;
+        }
+
+        if (result == DecodeResult::Malformed)
+            ++m_malformedCount;
+        it = m_pending.erase(it);
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "BinaryProtocol.h"
+#include "Message.h"
+
+namespace FlexLog
+{
+    /**
+    * @brief Decodes a stream written by BinaryFormatter back into messages.
+    *
+    * Dictionary definitions are collected as they are read, so feed a
+    * rotated set of files oldest first through one reader. Workers format
+    * records concurrently, so a record can reach the file just before the
+    * one that defines its entries; such records are held back until the
+    * definition turns up, or until Finish(), where anything still unknown is
+    * rendered as a placeholder.
+    */
+    class BinaryReader
+    {
+    public:
+        using RecordCallback = std::function<void(const Message&)>;
+
+        // Records held back waiting for definitions before the oldest is emitted with placeholders
+        static constexpr size_t MAX_PENDING_RECORDS = 1024;
+
+        // Generations kept behind the newest one, for records that were formatted late
+        static constexpr uint32_t RETAINED_GENERATIONS = 16;
+
+        static constexpr std::string_view UNKNOWN_ENTRY = "<unknown>";
+
+        BinaryReader() = default;
+        BinaryReader(const BinaryReader&) = delete;
+        BinaryReader& operator=(const BinaryReader&) = delete;
+
+        // Decodes every complete record in data and returns the number of bytes consumed;
+        // anything left over is a record cut short, e.g. by a crash mid-write
+        size_t Read(std::string_view data, const RecordCallback& callback);
+
+        // Emits the records still waiting for a definition
+        void Finish(const RecordCallback& callback);
+
+        size_t GetRecordCount() const { return m_recordCount; }
+        size_t GetUnresolvedCount() const { return m_unresolvedCount; }
+        size_t GetMalformedCount() const { return m_malformedCount; }
+
+    private:
+        enum class DecodeResult
+        {
+            Decoded,
+            Pending,
+            Malformed
+        };
+
+        struct Site
+        {
+            std::string file;
+            std::string function;
+            uint32_t line = 0;
+            uint32_t column = 0;
+        };
+
+        struct Generation
+        {
+            int64_t baseNanos = 0;
+            bool hasBase = false;
+            std::unordered_map<uint32_t, std::string> loggers;
+            std::unordered_map<uint32_t, Site> sites;
+            std::unordered_map<uint32_t, std::string> texts;
+            std::unordered_map<uint32_t, std::string> keys;
+        };
+
+        struct PendingRecord
+        {
+            uint32_t generation;
+            std::string event;
+        };
+
+        DecodeResult ReadRecord(std::string_view body, const RecordCallback& callback);
+        DecodeResult DecodeEvent(uint32_t generation, std::string_view event, bool force, const RecordCallback& callback);
+        void RetryPending(bool force, const RecordCallback& callback);
+
+        std::unordered_map<uint32_t, Generation> m_generations;
+        std::deque<PendingRecord> m_pending;
+
+        Message m_message;
+        std::string m_inlineFile;
+        std::string m_inlineFunction;
+
+        size_t m_recordCount = 0;
+        size_t m_unresolvedCount = 0;
+        size_t m_malformedCount = 0;
+    };
+}
@@ -1,18 +1,44 @@
 #include "Format.h"
 
 std::string FlexLog::Format::FormatMessage(const Message& msg) const
+{
+    Buffer buffer;
+    FormatTo(msg, buffer);
+    return buffer.ToString();
+}
+
+void FlexLog::Format::FormatTo(const Message& msg, Buffer& out) const
 {
     switch (m_logFormat)
     {
-        case LogFormat::CloudWatch:     return m_cloudWatchFormatter.FormatMessage(msg);
-        case LogFormat::Elasticsearch:  return m_elasticsearchFormatter.FormatMessage(msg);
-        case LogFormat::GELF:           return m_gelfFormatter.FormatMessage(msg);
-        case LogFormat::JSON:           return m_jsonFormatter.FormatMessage(msg);
-        case LogFormat::Logstash:       return m_logstashFormatter.FormatMessage(msg);
-        case LogFormat::OpenTelemetry:  return m_openTelemetryFormatter.FormatMessage(msg);
-        case LogFormat::Splunk:         return m_splunkFormatter.FormatMessage(msg);
-        case LogFormat::XML:            return m_xmlFormatter.FormatMessage(msg);
+        case LogFormat::CloudWatch:     m_cloudWatchFormatter.Get().FormatTo(msg, out); break;
+        case LogFormat::Elasticsearch:  m_elasticsearchFormatter.Get().FormatTo(msg, out); break;
+        case LogFormat::GELF:           m_gelfFormatter.Get().FormatTo(msg, out); break;
+        case LogFormat::JSON:           m_jsonFormatter.Get().FormatTo(msg, out); break;
+        case LogFormat::Logstash:       m_logstashFormatter.Get().FormatTo(msg, out); break;
+        case LogFormat::MessagePack:    m_messagePackFormatter.Get().FormatTo(msg, out); break;
+        case LogFormat::OpenTelemetry:  m_openTelemetryFormatter.Get().FormatTo(msg, out); break;
+        case LogFormat::Splunk:         m_splunkFormatter.Get().FormatTo(msg, out); break;
+        case LogFormat::XML:            m_xmlFormatter.Get().FormatTo(msg, out); break;
+        case LogFormat::Binary:         m_binaryFormatter.Get().FormatTo(msg, out); break;
         case LogFormat::Pattern:        FLOG_FALLTHROUGH;
-        default:                        return m_patternFormatter.FormatMessage(msg);
+        default:                        m_patternFormatter.FormatTo(msg, out); break;
     }
 }
+
+bool FlexLog::Format::IsBinary() const
+{
+    if (m_logFormat == LogFormat::OpenTelemetry)
+        return m_openTelemetryFormatter.Get().GetOtelOptions().useProtobuf;
+
+    if (m_logFormat == LogFormat::GELF)
+        return m_gelfFormatter.Get().GetGelfOptions().useCompression;
+
+    return IsBinaryFormat(m_logFormat);
+}
+
+void FlexLog::Format::BeginFile() const
+{
+    if (m_logFormat == LogFormat::Binary)
+        m_binaryFormatter.Get().Reset();
+}
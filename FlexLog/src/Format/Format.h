@@ -1,8 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <string>
 
+#include "Binary/BinaryFormatter.h"
 #include "Common.h"
+#include "Core/Buffer.h"
 #include "LogFormat.h"
 #include "Message.h"
 #include "PatternFormatter.h"
@@ -11,64 +15,136 @@
 #include "Structured/GelfFormatter.h"
 #include "Structured/JsonFormatter.h"
 #include "Structured/LogstashFormatter.h"
+#include "Structured/MessagePackFormatter.h"
 #include "Structured/OpenTelemetryFormatter.h"
 #include "Structured/SplunkFormatter.h"
 #include "Structured/XmlFormatter.h"
 
 namespace FlexLog
 {
+    namespace Internal
+    {
+        // Formatter constructed on first use, so formats nobody selects cost neither memory nor startup time
+        template <typename T>
+        class LazyFormatter
+        {
+        public:
+            LazyFormatter() = default;
+            LazyFormatter(const LazyFormatter& other) : m_formatter(other.Clone()) {}
+            ~LazyFormatter() { delete m_formatter.load(std::memory_order_acquire); }
+
+            // Frees the current formatter, so only for a Format no other thread can see. Shared formats are
+            // published as std::shared_ptr<const Format> and replaced, never assigned to.
+            LazyFormatter& operator=(const LazyFormatter& other)
+            {
+                if (this != &other)
+                    delete m_formatter.exchange(other.Clone(), std::memory_order_acq_rel);
+                return *this;
+            }
+
+            T& Get() const
+            {
+                T* formatter = m_formatter.load(std::memory_order_acquire);
+                if (formatter)
+                    return *formatter;
+
+                // Racing first uses each build one; the loser's copy is discarded
+                T* created = new T();
+                if (m_formatter.compare_exchange_strong(formatter, created, std::memory_order_acq_rel))
+                    return *created;
+
+                delete created;
+                return *formatter;
+            }
+
+        private:
+            T* Clone() const
+            {
+                const T* formatter = m_formatter.load(std::memory_order_acquire);
+                return formatter ? new T(*formatter) : nullptr;
+            }
+
+            mutable std::atomic<T*> m_formatter{nullptr};
+        };
+    }
+
     class Format
     {
     public:
         Format() = default;
+        explicit Format(LogFormat logFormat) : m_logFormat(logFormat) {}
         ~Format() = default;
 
+        // Format meant to be bound to sinks with Sink::SetFormat; configure it before binding
+        static std::shared_ptr<Format> Create(LogFormat logFormat = LogFormat::Pattern) { return std::make_shared<Format>(logFormat); }
+
         std::string operator()(const Message& msg) const { return FormatMessage(msg); }
         
         std::string FormatMessage(const Message& msg) const;
 
+        // Append the formatted message to out; records formatted back to back share one contiguous buffer
+        void FormatTo(const Message& msg, Buffer& out) const;
+
         LogFormat GetLogFormat() const          { return m_logFormat; }
         void SetLogFormat(LogFormat logFormat)  { m_logFormat = logFormat; }
 
+        // Whether records aren't lines of text, taking formatter options such as OTLP protobuf into account
+        bool IsBinary() const;
+
+        // Whether records refer to definitions made by earlier records in the same file, as binary dictionary IDs do.
+        // File sinks format these in the order they write them and call BeginFile() whenever they start a new file.
+        bool IsStreamed() const { return m_logFormat == LogFormat::Binary; }
+
+        // Makes the next record define everything it uses again, so a new file decodes without the one before it
+        void BeginFile() const;
+
         PatternFormatter& GetPatternFormatter()                         { return m_patternFormatter; }
         const PatternFormatter& GetPatternFormatter()             const { return m_patternFormatter; }
         
-        CloudWatchFormatter& GetCloudWatchFormatter()                   { return m_cloudWatchFormatter; }
-        const CloudWatchFormatter& GetCloudWatchFormatter()       const { return m_cloudWatchFormatter; }
+        CloudWatchFormatter& GetCloudWatchFormatter()                   { return m_cloudWatchFormatter.Get(); }
+        const CloudWatchFormatter& GetCloudWatchFormatter()       const { return m_cloudWatchFormatter.Get(); }
         
-        ElasticsearchFormatter& GetElasticsearchFormatter()             { return m_elasticsearchFormatter; }
-        const ElasticsearchFormatter& GetElasticsearchFormatter() const { return m_elasticsearchFormatter; }
+        ElasticsearchFormatter& GetElasticsearchFormatter()             { return m_elasticsearchFormatter.Get(); }
+        const ElasticsearchFormatter& GetElasticsearchFormatter() const { return m_elasticsearchFormatter.Get(); }
         
-        GelfFormatter& GetGelfFormatter()                               { return m_gelfFormatter; }
-        const GelfFormatter& GetGelfFormatter()                   const { return m_gelfFormatter; }
+        GelfFormatter& GetGelfFormatter()                               { return m_gelfFormatter.Get(); }
+        const GelfFormatter& GetGelfFormatter()                   const { return m_gelfFormatter.Get(); }
         
-        JsonFormatter& GetJsonFormatter()                               { return m_jsonFormatter; }
-        const JsonFormatter& GetJsonFormatter()                   const { return m_jsonFormatter; }
+        JsonFormatter& GetJsonFormatter()                               { return m_jsonFormatter.Get(); }
+        const JsonFormatter& GetJsonFormatter()                   const { return m_jsonFormatter.Get(); }
         
-        LogstashFormatter& GetLogstashFormatter()                       { return m_logstashFormatter; }
-        const LogstashFormatter& GetLogstashFormatter()           const { return m_logstashFormatter; }
+        LogstashFormatter& GetLogstashFormatter()                       { return m_logstashFormatter.Get(); }
+        const LogstashFormatter& GetLogstashFormatter()           const { return m_logstashFormatter.Get(); }
+
+        MessagePackFormatter& GetMessagePackFormatter()                 { return m_messagePackFormatter.Get(); }
+        const MessagePackFormatter& GetMessagePackFormatter()     const { return m_messagePackFormatter.Get(); }
         
-        OpenTelemetryFormatter& GetOpenTelemetryFormatter()             { return m_openTelemetryFormatter; }
-        const OpenTelemetryFormatter& GetOpenTelemetryFormatter() const { return m_openTelemetryFormatter; }
+        OpenTelemetryFormatter& GetOpenTelemetryFormatter()             { return m_openTelemetryFormatter.Get(); }
+        const OpenTelemetryFormatter& GetOpenTelemetryFormatter() const { return m_openTelemetryFormatter.Get(); }
         
-        SplunkFormatter& GetSplunkFormatter()                           { return m_splunkFormatter; }
-        const SplunkFormatter& GetSplunkFormatter()               const { return m_splunkFormatter; }
+        SplunkFormatter& GetSplunkFormatter()                           { return m_splunkFormatter.Get(); }
+        const SplunkFormatter& GetSplunkFormatter()               const { return m_splunkFormatter.Get(); }
         
-        XmlFormatter& GetXmlFormatter()                                 { return m_xmlFormatter; }
-        const XmlFormatter& GetXmlFormatter()                     const { return m_xmlFormatter; }
+        XmlFormatter& GetXmlFormatter()                                 { return m_xmlFormatter.Get(); }
+        const XmlFormatter& GetXmlFormatter()                     const { return m_xmlFormatter.Get(); }
+
+        BinaryFormatter& GetBinaryFormatter()                           { return m_binaryFormatter.Get(); }
+        const BinaryFormatter& GetBinaryFormatter()               const { return m_binaryFormatter.Get(); }
 
     private:
         LogFormat m_logFormat = LogFormat::Pattern;
 
         PatternFormatter m_patternFormatter;
 
-        CloudWatchFormatter m_cloudWatchFormatter;
-        ElasticsearchFormatter m_elasticsearchFormatter;
-        GelfFormatter m_gelfFormatter;
-        JsonFormatter m_jsonFormatter;
-        LogstashFormatter m_logstashFormatter;
-        OpenTelemetryFormatter m_openTelemetryFormatter;
-        SplunkFormatter m_splunkFormatter;
-        XmlFormatter m_xmlFormatter;
+        Internal::LazyFormatter<CloudWatchFormatter> m_cloudWatchFormatter;
+        Internal::LazyFormatter<ElasticsearchFormatter> m_elasticsearchFormatter;
+        Internal::LazyFormatter<GelfFormatter> m_gelfFormatter;
+        Internal::LazyFormatter<JsonFormatter> m_jsonFormatter;
+        Internal::LazyFormatter<LogstashFormatter> m_logstashFormatter;
+        Internal::LazyFormatter<MessagePackFormatter> m_messagePackFormatter;
+        Internal::LazyFormatter<OpenTelemetryFormatter> m_openTelemetryFormatter;
+        Internal::LazyFormatter<SplunkFormatter> m_splunkFormatter;
+        Internal::LazyFormatter<XmlFormatter> m_xmlFormatter;
+        Internal::LazyFormatter<BinaryFormatter> m_binaryFormatter;
     };
 }
@@ -0,0 +1,157 @@
+#include "FormattedRecord.h"
+
+#include <cstring>
+#include <new>
+
+#include "Format.h"
+
+struct FlexLog::FormattedRecordSet::Scratch
+{
+    std::array<Buffer, MAX_CACHED_FORMATS + 1> buffers;    // One per entry, plus one for formats that aren't cached
+    bool inUse = false;
+};
+
+FlexLog::FormattedRecordRef FlexLog::FormattedRecord::Create(std::string_view text)
+{
+    void* memory = ::operator new(sizeof(FormattedRecord) + text.size());
+    FormattedRecord* record = new (memory) FormattedRecord(text.size());
+
+    if (!text.empty())
+        std::memcpy(record->GetText(), text.data(), text.size());
+
+    return FormattedRecordRef(record);
+}
+
+void FlexLog::FormattedRecord::Release()
+{
+    if (m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        this->~FormattedRecord();
+        ::operator delete(this);
+    }
+}
+
+FlexLog::FormattedRecordRef::FormattedRecordRef(const FormattedRecordRef& other) : m_record(other.m_record)
+{
+    if (m_record)
+        m_record->AddRef();
+}
+
+FlexLog::FormattedRecordRef::FormattedRecordRef(FormattedRecordRef&& other) noexcept : m_record(other.m_record)
+{
+    other.m_record = nullptr;
+}
+
+FlexLog::FormattedRecordRef::~FormattedRecordRef()
+{
+    Reset();
+}
+
+FlexLog::FormattedRecordRef& FlexLog::FormattedRecordRef::operator=(const FormattedRecordRef& other)
+{
+    if (this != &other)
+    {
+        Reset();
+        m_record = other.m_record;
+        if (m_record)
+            m_record->AddRef();
+    }
+    return *this;
+}
+
+FlexLog::FormattedRecordRef& FlexLog::FormattedRecordRef::operator=(FormattedRecordRef&& other) noexcept
+{
+    if (this != &other)
+    {
+        Reset();
+        m_record = other.m_record;
+        other.m_record = nullptr;
+    }
+    return *this;
+}
+
+void FlexLog::FormattedRecordRef::Reset()
+{
+    if (m_record)
+    {
+        m_record->Release();
+        m_record = nullptr;
+    }
+}
+
+FlexLog::FormattedRecordSet::FormattedRecordSet(const Message& msg) : m_message(msg)
+{
+    thread_local Scratch s_scratch;
+
+    if (s_scratch.inUse)
+    {
+        m_ownedScratch = std::make_unique<Scratch>();
+        m_scratch = m_ownedScratch.get();
+    }
+    else
+    {
+        m_scratch = &s_scratch;
+    }
+
+    m_scratch->inUse = true;
+}
+
+FlexLog::FormattedRecordSet::~FormattedRecordSet()
+{
+    m_scratch->inUse = false;
+}
+
+void FlexLog::FormattedRecordSet::Pin(std::shared_ptr<const Format> format)
+{
+    if (!format || m_count == MAX_CACHED_FORMATS || Find(*format))
+        return;
+
+    m_entries[m_count++].format = std::move(format);
+}
+
+std::string_view FlexLog::FormattedRecordSet::Get(const Format& format)
+{
+    Entry* entry = Find(format);
+    if (!entry)
+    {
+        // Not cacheable: rendered for this caller only
+        Buffer& uncached = m_scratch->buffers[MAX_CACHED_FORMATS];
+        uncached.Clear();
+        format.FormatTo(m_message, uncached);
+        return uncached.View();
+    }
+
+    // Each entry renders into the scratch buffer of the same index, whose capacity is kept between messages
+    Buffer& text = m_scratch->buffers[static_cast<size_t>(entry - m_entries.data())];
+    if (!entry->rendered)
+    {
+        text.Clear();
+        format.FormatTo(m_message, text);
+        entry->rendered = true;
+    }
+
+    return text.View();
+}
+
+FlexLog::FormattedRecordRef FlexLog::FormattedRecordSet::Share(const Format& format)
+{
+    Entry* entry = Find(format);
+    if (!entry)
+        return FormattedRecord::Create(Get(format));
+
+    if (!entry->record)
+        entry->record = FormattedRecord::Create(Get(format));
+
+    return entry->record;
+}
+
+FlexLog::FormattedRecordSet::Entry* FlexLog::FormattedRecordSet::Find(const Format& format)
+{
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        if (m_entries[i].format.get() == &format)
+            return &m_entries[i];
+    }
+
+    return nullptr;
+}
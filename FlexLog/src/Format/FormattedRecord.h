@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "Core/Buffer.h"
+#include "Message.h"
+
+namespace FlexLog
+{
+    class Format;
+    class FormattedRecordRef;
+
+    /**
+    * @brief Immutable, reference-counted bytes of one formatted message.
+    *
+    * The header and the text live in a single allocation. A record is never
+    * modified after creation, so any number of sinks and threads can read and
+    * retain it without copying or locking.
+    */
+    class FormattedRecord
+    {
+    public:
+        static FormattedRecordRef Create(std::string_view text);
+
+        FormattedRecord(const FormattedRecord&) = delete;
+        FormattedRecord& operator=(const FormattedRecord&) = delete;
+
+        std::string_view View() const { return std::string_view(GetText(), m_size); }
+        const char* Data() const { return GetText(); }
+        size_t Size() const { return m_size; }
+        bool IsEmpty() const { return m_size == 0; }
+
+    private:
+        explicit FormattedRecord(size_t size) : m_size(size) {}
+
+        const char* GetText() const { return reinterpret_cast<const char*>(this + 1); }
+        char* GetText() { return reinterpret_cast<char*>(this + 1); }
+
+        void AddRef() { m_refCount.fetch_add(1, std::memory_order_relaxed); }
+        void Release();
+
+        std::atomic<uint32_t> m_refCount{1};
+        size_t m_size;
+
+        friend class FormattedRecordRef;
+    };
+
+    class FormattedRecordRef
+    {
+    public:
+        FormattedRecordRef() = default;
+        FormattedRecordRef(const FormattedRecordRef& other);
+        FormattedRecordRef(FormattedRecordRef&& other) noexcept;
+        ~FormattedRecordRef();
+
+        FormattedRecordRef& operator=(const FormattedRecordRef& other);
+        FormattedRecordRef& operator=(FormattedRecordRef&& other) noexcept;
+
+        explicit operator bool() const { return m_record != nullptr; }
+
+        void Reset();
+
+        const FormattedRecord* Get() const { return m_record; }
+        const FormattedRecord* operator->() const { return m_record; }
+        const FormattedRecord& operator*() const { return *m_record; }
+
+        std::string_view View() const { return m_record ? m_record->View() : std::string_view(); }
+
+    private:
+        // Adopts the creation reference
+        explicit FormattedRecordRef(FormattedRecord* record) : m_record(record) {}
+
+        FormattedRecord* m_record = nullptr;
+
+        friend class FormattedRecord;
+    };
+
+    /**
+    * @brief Formats a message at most once per distinct Format during fan-out.
+    *
+    * Logger passes one set to every sink a message goes to, pinning each
+    * sink's format first so its address can't be reused by another format while
+    * it is a cache key. The first sink that asks for a format renders into a
+    * scratch buffer owned by the worker thread; later sinks with the same format
+    * read the same bytes. A ref-counted FormattedRecord is only allocated for
+    * sinks that keep the bytes past Output().
+    */
+    class FormattedRecordSet
+    {
+    public:
+        static constexpr size_t MAX_CACHED_FORMATS = 4;
+
+        explicit FormattedRecordSet(const Message& msg);
+        ~FormattedRecordSet();
+
+        FormattedRecordSet(const FormattedRecordSet&) = delete;
+        FormattedRecordSet& operator=(const FormattedRecordSet&) = delete;
+
+        const Message& GetMessage() const { return m_message; }
+
+        // Keeps format alive until the set is destroyed and makes it cacheable; formats past MAX_CACHED_FORMATS aren't
+        void Pin(std::shared_ptr<const Format> format);
+
+        // The message rendered with format, formatted on first request. Valid until the set is destroyed, or for a
+        // format that wasn't pinned, until the next such call.
+        std::string_view Get(const Format& format);
+
+        // The same bytes as a record that can outlive the set; allocated once per format
+        FormattedRecordRef Share(const Format& format);
+
+    private:
+        struct Scratch;
+
+        struct Entry
+        {
+            std::shared_ptr<const Format> format;
+            bool rendered = false;
+            FormattedRecordRef record;
+        };
+
+        Entry* Find(const Format& format);
+
+        const Message& m_message;
+        std::array<Entry, MAX_CACHED_FORMATS> m_entries;
+        size_t m_count = 0;
+
+        // The worker's scratch buffers, or buffers of its own when the worker's are taken
+        Scratch* m_scratch = nullptr;
+        std::unique_ptr<Scratch> m_ownedScratch;
+    };
+}
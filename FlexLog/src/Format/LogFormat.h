@@ -11,8 +11,17 @@ namespace FlexLog
         GELF,           // Graylog Extended Log Format
         JSON,           // Standard JSON
         Logstash,       // Logstash-compatible JSON
+        MessagePack,    // MessagePack maps
         OpenTelemetry,  // OpenTelemetry format
         Splunk,         // Splunk HEC format
-        XML             // Standard XML
+        XML,            // Standard XML
+
+        Binary          // Compact binary records, rendered offline by FlexLogDecode
     };
+
+    // Formats whose records aren't lines of text, so sinks must not append line endings to them
+    constexpr bool IsBinaryFormat(LogFormat logFormat)
+    {
+        return logFormat == LogFormat::Binary || logFormat == LogFormat::MessagePack;
+    }
 }
@@ -1,92 +1,49 @@
 #include "PatternFormatter.h"
 
 #include <algorithm>
-#include <filesystem>
-#include <iomanip>
-#include <sstream>
 #include <chrono>
 
+#include "Core/NumberFormat.h"
+#include "TimestampCache.h"
+
 namespace FlexLog::Internal
 {
-    // StringBuilder with pre-allocated buffer
-    class StackStringBuilder
-    {
-    public:
-        StackStringBuilder(char* buffer, size_t capacity) : m_buffer(buffer), m_capacity(capacity), m_size(0) {}
-
-        void Append(std::string_view str)
-        {
-            const size_t remaining = m_capacity - m_size;
-            const size_t copySize = std::min(remaining, str.size());
-            std::memcpy(m_buffer + m_size, str.data(), copySize);
-            m_size += copySize;
-        }
-
-        std::string_view View() const { return std::string_view(m_buffer, m_size); }
-        size_t Size() const { return m_size; }
-
-    private:
-        char* m_buffer;
-        size_t m_capacity;
-        size_t m_size;
-    };
-
-    struct TimestampFormatter { static void FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view timeFormat); };
-    struct LevelFormatter     { static void FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view timeFormat); };
-    struct NameFormatter      { static void FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view timeFormat); };
-    struct MessageFormatter   { static void FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view timeFormat); };
-    struct SourceFormatter    { static void FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view timeFormat); };
-    struct FunctionFormatter  { static void FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view timeFormat); };
-    struct LineFormatter      { static void FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view timeFormat); };
-
-    void TimestampFormatter::FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view timeFormat)
+    void TimestampFormatter::FormatTo(Buffer& out, const Message& msg, std::string_view timeFormat)
     {
-        auto time = std::chrono::system_clock::to_time_t(msg.timestamp);
-
-        std::tm tm_buf{};
-#if defined(FLOG_PLATFORM_WINDOWS)
-        localtime_s(&tm_buf, &time);
-#else
-        localtime_r(&time, &tm_buf);
-#endif
-
-        char buffer[64];
-        const auto len = std::strftime(buffer, sizeof(buffer), timeFormat.data(), &tm_buf);
-        builder.Append(std::string_view(buffer, len));
+        TimestampCache::FormatTo(out, msg.timestamp, timeFormat);
     }
 
-    void LevelFormatter::FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view)
+    void LevelFormatter::FormatTo(Buffer& out, const Message& msg, std::string_view)
     {
         std::string_view levelStr = LevelToString(static_cast<Level>(msg.level));
-        builder.Append(levelStr);
+        out.Append(levelStr);
     }
 
-    void NameFormatter::FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view)
+    void NameFormatter::FormatTo(Buffer& out, const Message& msg, std::string_view)
     {
-        builder.Append(msg.name);
+        out.Append(msg.name);
     }
 
-    void MessageFormatter::FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view)
+    void MessageFormatter::FormatTo(Buffer& out, const Message& msg, std::string_view)
     {
-        builder.Append(msg.message);
+        out.Append(msg.message);
     }
 
-    void SourceFormatter::FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view)
+    void SourceFormatter::FormatTo(Buffer& out, const Message& msg, std::string_view)
     {
-        std::string filename = std::filesystem::path(msg.sourceLocation.file_name()).filename().string();
-        builder.Append(filename);
+        std::string_view file = msg.sourceLocation.file_name();
+        const size_t separator = file.find_last_of("/\\");
+        out.Append(separator == std::string_view::npos ? file : file.substr(separator + 1));
     }
 
-    void FunctionFormatter::FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view)
+    void FunctionFormatter::FormatTo(Buffer& out, const Message& msg, std::string_view)
     {
-        builder.Append(msg.sourceLocation.function_name());
+        out.Append(msg.sourceLocation.function_name());
     }
 
-    void LineFormatter::FormatTo(StackStringBuilder& builder, const Message& msg, std::string_view)
+    void LineFormatter::FormatTo(Buffer& out, const Message& msg, std::string_view)
     {
-        char buffer[16];
-        int len = snprintf(buffer, sizeof(buffer), "%u", msg.sourceLocation.line());
-        builder.Append(std::string_view(buffer, len));
+        AppendInteger(out, msg.sourceLocation.line());
     }
 }
 
@@ -132,32 +89,23 @@ FlexLog::PatternFormatter::PatternFormatter(std::string_view pattern) : m_patter
 }
 
 std::string FlexLog::PatternFormatter::FormatMessage(const Message& msg) const
+{
+    Buffer buffer;
+    FormatTo(msg, buffer);
+    return buffer.ToString();
+}
+
+void FlexLog::PatternFormatter::FormatTo(const Message& msg, Buffer& out) const
 {
     // If we have a compile-time formatter, use it
     if (m_formatFunc)
-        return m_formatFunc(msg, m_formatInfo.timeFormat);
-
-    // Otherwise, use runtime formatting
-    std::string result;
-    result.reserve(256); // Reserve a reasonable size
-
-    for (const auto& fragment : m_fragments)
     {
-        if (fragment.type == TokenType::Literal)
-        {
-            result += fragment.data;
-        }
-        else if (fragment.type == TokenType::Custom && fragment.customFormatter)
-        {
-            result += fragment.customFormatter(msg);
-        }
-        else
-        {
-            result += FormatToken(fragment.type, fragment.data, msg);
-        }
+        m_formatFunc(msg, m_formatInfo.timeFormat, out);
+        return;
     }
 
-    return result;
+    // Otherwise, run the compiled pattern
+    m_program.Execute(msg, m_formatInfo.timeFormat, out);
 }
 
 void FlexLog::PatternFormatter::SetPattern(std::string_view pattern)
@@ -180,6 +128,16 @@ void FlexLog::PatternFormatter::SetPattern(std::string_view pattern)
     }
 }
 
+void FlexLog::PatternFormatter::SetPattern(std::string_view pattern, FormatFunction formatFunc)
+{
+    m_pattern = std::string(pattern);
+    m_formatInfo.pattern = m_pattern;
+
+    // Keep a runtime program as well, registering a custom formatter falls back to it
+    m_formatFunc = formatFunc;
+    ParsePattern();
+}
+
 void FlexLog::PatternFormatter::RegisterCustomFormatter(std::string_view token, CustomFormatter formatter)
 {
     if (formatter)
@@ -197,169 +155,195 @@ void FlexLog::PatternFormatter::RegisterCustomFormatter(std::string_view token,
 
 void FlexLog::PatternFormatter::ParsePattern()
 {
-    m_fragments.clear();
-    m_fragments.reserve(m_formatInfo.fragmentCapacity);
+    m_program.Compile(m_pattern, m_customFormatters, m_formatInfo.instructionCapacity);
+}
+
+void FlexLog::PatternProgram::Compile(std::string_view pattern, const std::unordered_map<std::string, CustomFormatter>& customFormatters, size_t capacityHint)
+{
+    m_instructions.clear();
+    m_literals.clear();
+    m_customFormatters.clear();
+
+    m_instructions.reserve(capacityHint);
+    m_literals.reserve(pattern.size());
 
     size_t pos = 0;
     size_t lastPos = 0;
 
-    while ((pos = m_pattern.find('{', lastPos)) != std::string::npos)
+    while ((pos = pattern.find('{', lastPos)) != std::string_view::npos)
     {
-        // Add literal text before the token
-        if (pos > lastPos)
-        {
-            Fragment literal;
-            literal.type = TokenType::Literal;
-            literal.data = m_pattern.substr(lastPos, pos - lastPos);
-            m_fragments.push_back(std::move(literal));
-        }
-
-        size_t endPos = m_pattern.find('}', pos);
-        if (endPos == std::string::npos)
+        // An unclosed brace leaves the rest of the pattern as literal text
+        size_t endPos = pattern.find('}', pos);
+        if (endPos == std::string_view::npos)
             break;
 
-        std::string tokenStr = m_pattern.substr(pos, endPos - pos + 1);
-        TokenType type = Token::GetType(tokenStr);
+        // Literal text before the token
+        EmitLiteral(pattern.substr(lastPos, pos - lastPos));
 
-        Fragment token;
-        token.type = type;
+        const std::string_view tokenStr = pattern.substr(pos, endPos - pos + 1);
+        const TokenType type = Token::GetType(tokenStr);
 
         if (type == TokenType::Custom)
         {
             // Extract the custom token name (everything between {custom: and })
-            std::string customTokenName = tokenStr.substr(8, tokenStr.size() - 9);
-            token.data = customTokenName;
-
-            // Find the custom formatter if registered
-            auto it = m_customFormatters.find(customTokenName);
-            if (it != m_customFormatters.end())
-                token.customFormatter = it->second;
+            const std::string customTokenName(tokenStr.substr(8, tokenStr.size() - 9));
+
+            auto it = customFormatters.find(customTokenName);
+            if (it != customFormatters.end() && it->second)
+            {
+                Emit(TokenType::Custom, static_cast<uint32_t>(m_customFormatters.size()));
+                m_customFormatters.push_back(it->second);
+            }
+            else
+            {
+                // Unregistered tokens are resolved once here instead of on every message
+                EmitLiteral("[unknown custom token: ");
+                EmitLiteral(customTokenName);
+                EmitLiteral("]");
+            }
         }
         else if (type == TokenType::Literal)
         {
             // If we didn't recognize the token, treat it as literal text
-            token.data = tokenStr;
+            EmitLiteral(tokenStr);
+        }
+        else
+        {
+            Emit(type);
         }
 
-        m_fragments.push_back(std::move(token));
         lastPos = endPos + 1;
     }
 
-    // Add any remaining literal text
-    if (lastPos < m_pattern.length())
+    // Any remaining literal text
+    if (lastPos < pattern.length())
+        EmitLiteral(pattern.substr(lastPos));
+}
+
+void FlexLog::PatternProgram::Execute(const Message& msg, std::string_view timeFormat, Buffer& out) const
+{
+    const char* literals = m_literals.data();
+
+    for (const Instruction& instruction : m_instructions)
     {
-        Fragment literal;
-        literal.type = TokenType::Literal;
-        literal.data = m_pattern.substr(lastPos);
-        m_fragments.push_back(std::move(literal));
+        switch (instruction.op)
+        {
+        case TokenType::Literal:    out.Append(literals + instruction.offset, instruction.length); break;
+        case TokenType::Timestamp:  Internal::TimestampFormatter::FormatTo(out, msg, timeFormat); break;
+        case TokenType::Level:      Internal::LevelFormatter::FormatTo(out, msg, {}); break;
+        case TokenType::Name:       Internal::NameFormatter::FormatTo(out, msg, {}); break;
+        case TokenType::Message:    Internal::MessageFormatter::FormatTo(out, msg, {}); break;
+        case TokenType::Source:     Internal::SourceFormatter::FormatTo(out, msg, {}); break;
+        case TokenType::Function:   Internal::FunctionFormatter::FormatTo(out, msg, {}); break;
+        case TokenType::Line:       Internal::LineFormatter::FormatTo(out, msg, {}); break;
+        case TokenType::Custom:     out.Append(m_customFormatters[instruction.offset](msg)); break;
+        }
     }
 }
 
-std::string FlexLog::PatternFormatter::FormatToken(TokenType type, const std::string& tokenData, const Message& msg) const
+void FlexLog::PatternProgram::EmitLiteral(std::string_view text)
 {
-    switch (type)
-    {
-    case TokenType::Timestamp:
+    if (text.empty())
+        return;
+
+    // Extend the previous literal when the blob is contiguous with it
+    if (!m_instructions.empty() && m_instructions.back().op == TokenType::Literal &&
+        m_instructions.back().offset + m_instructions.back().length == m_literals.size())
     {
-        auto time = std::chrono::system_clock::to_time_t(msg.timestamp);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time), m_formatInfo.timeFormat.data());
-        return ss.str();
+        m_instructions.back().length += static_cast<uint32_t>(text.size());
     }
-    case TokenType::Level:      return std::string(LevelToString(static_cast<Level>(msg.level)));
-    case TokenType::Name:       return std::string(msg.name);
-    case TokenType::Message:    return std::string(msg.message);
-    case TokenType::Source:     return std::filesystem::path(msg.sourceLocation.file_name()).filename().string();
-    case TokenType::Function:   return msg.sourceLocation.function_name();
-    case TokenType::Line:       return std::to_string(msg.sourceLocation.line());
-    case TokenType::Custom:
+    else
     {
-        auto it = m_customFormatters.find(tokenData);
-        if (it != m_customFormatters.end() && it->second)
-            return it->second(msg);
-        return "[unknown custom token: " + tokenData + "]";
-    }
-    case TokenType::Literal: 
-    default:                    return tokenData;
+        m_instructions.push_back({ TokenType::Literal, static_cast<uint32_t>(m_literals.size()), static_cast<uint32_t>(text.size()) });
     }
+
+    m_literals.append(text);
+}
+
+void FlexLog::PatternProgram::Emit(TokenType op, uint32_t offset)
+{
+    m_instructions.push_back({ op, offset, 0 });
 }
 
-std::string FlexLog::PatternFormatter::FormatWithDefaultPattern(const Message& msg, std::string_view timeFormat)
+void FlexLog::PatternFormatter::FormatWithDefaultPattern(const Message& msg, std::string_view timeFormat, Buffer& out)
 {
     // Format: "[{timestamp}] [{level}] [{name} @ {function}] - {message}"
-    constexpr size_t BUFFER_SIZE = 1024;
-    char buffer[BUFFER_SIZE];
-    Internal::StackStringBuilder builder(buffer, BUFFER_SIZE);
-
-    builder.Append("[");
-    Internal::TimestampFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append("] [");
-    Internal::LevelFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append("] [");
-    Internal::NameFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append(" @ ");
-    Internal::FunctionFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append("] - ");
-    Internal::MessageFormatter::FormatTo(builder, msg, timeFormat);
-
-    return std::string(builder.View());
+    out.Append("[");
+    Internal::TimestampFormatter::FormatTo(out, msg, timeFormat);
+    out.Append("] [");
+    Internal::LevelFormatter::FormatTo(out, msg, timeFormat);
+    out.Append("] [");
+    Internal::NameFormatter::FormatTo(out, msg, timeFormat);
+    out.Append(" @ ");
+    Internal::FunctionFormatter::FormatTo(out, msg, timeFormat);
+    out.Append("] - ");
+    Internal::MessageFormatter::FormatTo(out, msg, timeFormat);
 }
 
-std::string FlexLog::PatternFormatter::FormatWithSimplePattern(const Message& msg, std::string_view timeFormat)
+void FlexLog::PatternFormatter::FormatWithSimplePattern(const Message& msg, std::string_view timeFormat, Buffer& out)
 {
     // Format: "[{timestamp}] [{level}] [{name}] - {message}"
-    constexpr size_t BUFFER_SIZE = 1024;
-    char buffer[BUFFER_SIZE];
-    Internal::StackStringBuilder builder(buffer, BUFFER_SIZE);
-
-    builder.Append("[");
-    Internal::TimestampFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append("] [");
-    Internal::LevelFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append("] [");
-    Internal::NameFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append("] - ");
-    Internal::MessageFormatter::FormatTo(builder, msg, timeFormat);
-
-    return std::string(builder.View());
+    out.Append("[");
+    Internal::TimestampFormatter::FormatTo(out, msg, timeFormat);
+    out.Append("] [");
+    Internal::LevelFormatter::FormatTo(out, msg, timeFormat);
+    out.Append("] [");
+    Internal::NameFormatter::FormatTo(out, msg, timeFormat);
+    out.Append("] - ");
+    Internal::MessageFormatter::FormatTo(out, msg, timeFormat);
 }
 
-std::string FlexLog::PatternFormatter::FormatWithDetailedPattern(const Message& msg, std::string_view timeFormat)
+void FlexLog::PatternFormatter::FormatWithDetailedPattern(const Message& msg, std::string_view timeFormat, Buffer& out)
 {
     // Format: "[{timestamp}] [{level}] [{name} @ {function}] [{source}:{line}] - {message}"
-    constexpr size_t BUFFER_SIZE = 1024;
-    char buffer[BUFFER_SIZE];
-    Internal::StackStringBuilder builder(buffer, BUFFER_SIZE);
-
-    builder.Append("[");
-    Internal::TimestampFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append("] [");
-    Internal::LevelFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append("] [");
-    Internal::NameFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append(" @ ");
-    Internal::FunctionFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append("] [");
-    Internal::SourceFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append(":");
-    Internal::LineFormatter::FormatTo(builder, msg, timeFormat);
-    builder.Append("] - ");
-    Internal::MessageFormatter::FormatTo(builder, msg, timeFormat);
-
-    return std::string(builder.View());
+    out.Append("[");
+    Internal::TimestampFormatter::FormatTo(out, msg, timeFormat);
+    out.Append("] [");
+    Internal::LevelFormatter::FormatTo(out, msg, timeFormat);
+    out.Append("] [");
+    Internal::NameFormatter::FormatTo(out, msg, timeFormat);
+    out.Append(" @ ");
+    Internal::FunctionFormatter::FormatTo(out, msg, timeFormat);
+    out.Append("] [");
+    Internal::SourceFormatter::FormatTo(out, msg, timeFormat);
+    out.Append(":");
+    Internal::LineFormatter::FormatTo(out, msg, timeFormat);
+    out.Append("] - ");
+    Internal::MessageFormatter::FormatTo(out, msg, timeFormat);
 }
 
 std::string FlexLog::DefaultFormatter::Format(const Message& msg, std::string_view timeFormat) const
 {
-    return PatternFormatter::FormatWithDefaultPattern(msg, timeFormat);
+    Buffer buffer;
+    PatternFormatter::FormatWithDefaultPattern(msg, timeFormat, buffer);
+    return buffer.ToString();
+}
+
+void FlexLog::DefaultFormatter::FormatTo(const Message& msg, Buffer& out, std::string_view timeFormat) const
+{
+    PatternFormatter::FormatWithDefaultPattern(msg, timeFormat, out);
 }
 
 std::string FlexLog::SimpleFormatter::Format(const Message& msg, std::string_view timeFormat) const
 {
-    return PatternFormatter::FormatWithSimplePattern(msg, timeFormat);
+    Buffer buffer;
+    PatternFormatter::FormatWithSimplePattern(msg, timeFormat, buffer);
+    return buffer.ToString();
+}
+
+void FlexLog::SimpleFormatter::FormatTo(const Message& msg, Buffer& out, std::string_view timeFormat) const
+{
+    PatternFormatter::FormatWithSimplePattern(msg, timeFormat, out);
 }
 
 std::string FlexLog::DetailedFormatter::Format(const Message& msg, std::string_view timeFormat) const
 {
-    return PatternFormatter::FormatWithDetailedPattern(msg, timeFormat);
+    Buffer buffer;
+    PatternFormatter::FormatWithDetailedPattern(msg, timeFormat, buffer);
+    return buffer.ToString();
+}
+
+void FlexLog::DetailedFormatter::FormatTo(const Message& msg, Buffer& out, std::string_view timeFormat) const
+{
+    PatternFormatter::FormatWithDetailedPattern(msg, timeFormat, out);
 }
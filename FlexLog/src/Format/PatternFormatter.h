@@ -7,6 +7,7 @@
 #include <functional>
 
 #include "Common.h"
+#include "Core/Buffer.h"
 #include "Level.h"
 #include "Message.h"
 
@@ -42,7 +43,7 @@ namespace FlexLog
     {
         std::string pattern;
         std::string timeFormat = "%H:%M:%S";
-        size_t fragmentCapacity = 32;
+        size_t instructionCapacity = 32;
     };
 
     namespace FormatPatterns
@@ -54,11 +55,48 @@ namespace FlexLog
 
     using CustomFormatter = std::function<std::string(const Message&)>;
 
-    struct Fragment 
+    namespace Internal
     {
-        TokenType type;
-        std::string data;
-        CustomFormatter customFormatter;
+        // Token emitters shared by runtime programs, the built-in patterns and StaticPatternFormatter
+        struct TimestampFormatter { static void FormatTo(Buffer& out, const Message& msg, std::string_view timeFormat); };
+        struct LevelFormatter     { static void FormatTo(Buffer& out, const Message& msg, std::string_view timeFormat); };
+        struct NameFormatter      { static void FormatTo(Buffer& out, const Message& msg, std::string_view timeFormat); };
+        struct MessageFormatter   { static void FormatTo(Buffer& out, const Message& msg, std::string_view timeFormat); };
+        struct SourceFormatter    { static void FormatTo(Buffer& out, const Message& msg, std::string_view timeFormat); };
+        struct FunctionFormatter  { static void FormatTo(Buffer& out, const Message& msg, std::string_view timeFormat); };
+        struct LineFormatter      { static void FormatTo(Buffer& out, const Message& msg, std::string_view timeFormat); };
+    }
+
+    /**
+    * @brief A pattern compiled into a flat instruction stream.
+    *
+    * All literal text lives in one contiguous blob and adjacent literals are
+    * merged, so running a program is a single pass of appends into the output
+    * buffer with no per-token allocation or lookup.
+    */
+    class PatternProgram
+    {
+    public:
+        struct Instruction
+        {
+            TokenType op;
+            uint32_t offset; // Literal: start in the literal blob; Custom: formatter index
+            uint32_t length; // Literal: byte count
+        };
+
+        void Compile(std::string_view pattern, const std::unordered_map<std::string, CustomFormatter>& customFormatters, size_t capacityHint = 0);
+        void Execute(const Message& msg, std::string_view timeFormat, Buffer& out) const;
+
+        const std::vector<Instruction>& GetInstructions() const { return m_instructions; }
+        std::string_view GetLiterals() const { return m_literals; }
+
+    private:
+        void EmitLiteral(std::string_view text);
+        void Emit(TokenType op, uint32_t offset = 0);
+
+        std::vector<Instruction> m_instructions;
+        std::string m_literals;
+        std::vector<CustomFormatter> m_customFormatters;
     };
 
     class PatternFormatter
@@ -68,6 +106,9 @@ namespace FlexLog
 
         std::string FormatMessage(const Message& message) const;
 
+        // Append the formatted message to a caller-owned buffer
+        void FormatTo(const Message& message, Buffer& out) const;
+
         const std::string& GetPattern() const { return m_pattern; }
         void SetPattern(std::string_view pattern);
 
@@ -77,19 +118,22 @@ namespace FlexLog
 
         void RegisterCustomFormatter(std::string_view token, CustomFormatter formatter);
 
+        using FormatFunction = void(*)(const Message&, std::string_view, Buffer&);
+
+        // Use a pattern with a precompiled format function (see StaticPatternFormatter::BindTo)
+        void SetPattern(std::string_view pattern, FormatFunction formatFunc);
+
     private:
         void ParsePattern();
-        std::string FormatToken(TokenType type, const std::string& tokenData, const Message& msg) const;
 
-        using FormatFunction = std::string(*)(const Message&, std::string_view);
-        static std::string FormatWithDefaultPattern(const Message& msg, std::string_view timeFormat);
-        static std::string FormatWithSimplePattern(const Message& msg, std::string_view timeFormat);
-        static std::string FormatWithDetailedPattern(const Message& msg, std::string_view timeFormat);
+        static void FormatWithDefaultPattern(const Message& msg, std::string_view timeFormat, Buffer& out);
+        static void FormatWithSimplePattern(const Message& msg, std::string_view timeFormat, Buffer& out);
+        static void FormatWithDetailedPattern(const Message& msg, std::string_view timeFormat, Buffer& out);
 
         std::string m_pattern;
         FormatInfo m_formatInfo;
         FormatFunction m_formatFunc = nullptr;
-        std::vector<Fragment> m_fragments;
+        PatternProgram m_program;
         std::unordered_map<std::string, CustomFormatter> m_customFormatters;
 
         friend class DefaultFormatter;
@@ -101,17 +145,20 @@ namespace FlexLog
     {
     public:
         std::string Format(const Message& msg, std::string_view timeFormat = "%H:%M:%S") const;
+        void FormatTo(const Message& msg, Buffer& out, std::string_view timeFormat = "%H:%M:%S") const;
     };
 
     class SimpleFormatter
     {
     public:
         std::string Format(const Message& msg, std::string_view timeFormat = "%H:%M:%S") const;
+        void FormatTo(const Message& msg, Buffer& out, std::string_view timeFormat = "%H:%M:%S") const;
     };
 
     class DetailedFormatter
     {
     public:
         std::string Format(const Message& msg, std::string_view timeFormat = "%H:%M:%S") const;
+        void FormatTo(const Message& msg, Buffer& out, std::string_view timeFormat = "%H:%M:%S") const;
     };
 }
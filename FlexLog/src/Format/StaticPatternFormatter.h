@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "Core/Buffer.h"
+#include "Format/PatternFormatter.h"
+#include "Format/TimestampCache.h"
+#include "Message.h"
+
+namespace FlexLog
+{
+    // String literal usable as a template argument, e.g. StaticPatternFormatter<"{level}: {message}">
+    template <size_t N>
+    struct FixedPattern
+    {
+        char data[N]{};
+
+        consteval FixedPattern(const char (&str)[N]) { std::copy_n(str, N, data); }
+
+        constexpr std::string_view View() const { return std::string_view(data, N - 1); }
+    };
+
+    namespace Internal
+    {
+        struct StaticInstruction
+        {
+            TokenType op = TokenType::Literal;
+            size_t offset = 0;
+            size_t length = 0;
+        };
+
+        template <size_t Capacity>
+        struct StaticProgram
+        {
+            std::array<StaticInstruction, Capacity> instructions{};
+            size_t count = 0;
+            size_t literalLength = 0;
+        };
+
+        // Upper bounds for tokens whose output size does not depend on message data
+        inline constexpr size_t MAX_LEVEL_LENGTH = 5;
+        inline constexpr size_t MAX_LINE_LENGTH = 10;
+
+        consteval TokenType GetStaticTokenType(std::string_view token)
+        {
+            if (token == Token::TIMESTAMP) return TokenType::Timestamp;
+            if (token == Token::LEVEL)     return TokenType::Level;
+            if (token == Token::NAME)      return TokenType::Name;
+            if (token == Token::MESSAGE)   return TokenType::Message;
+            if (token == Token::SOURCE)    return TokenType::Source;
+            if (token == Token::FUNCTION)  return TokenType::Function;
+            if (token == Token::LINE)      return TokenType::Line;
+
+            // Custom tokens need a runtime registry, everything else is a typo
+            return TokenType::Custom;
+        }
+
+        // Walks the pattern the same way PatternProgram::Compile does; visitor(op, offset, length)
+        template <typename Visitor>
+        consteval void WalkStaticPattern(std::string_view pattern, Visitor&& visitor)
+        {
+            size_t pos = 0;
+            size_t lastPos = 0;
+
+            while ((pos = pattern.find('{', lastPos)) != std::string_view::npos)
+            {
+                const size_t endPos = pattern.find('}', pos);
+                if (endPos == std::string_view::npos)
+                    break;
+
+                if (pos > lastPos)
+                    visitor(TokenType::Literal, lastPos, pos - lastPos);
+
+                visitor(GetStaticTokenType(pattern.substr(pos, endPos - pos + 1)), pos, endPos - pos + 1);
+                lastPos = endPos + 1;
+            }
+
+            if (lastPos < pattern.size())
+                visitor(TokenType::Literal, lastPos, pattern.size() - lastPos);
+        }
+
+        consteval bool HasUnknownTokens(std::string_view pattern)
+        {
+            bool unknown = false;
+            WalkStaticPattern(pattern, [&](TokenType op, size_t, size_t) { unknown |= op == TokenType::Custom; });
+            return unknown;
+        }
+
+        consteval size_t CountStaticInstructions(std::string_view pattern)
+        {
+            size_t count = 0;
+            WalkStaticPattern(pattern, [&](TokenType, size_t, size_t) { ++count; });
+            return count;
+        }
+
+        template <size_t Capacity>
+        consteval StaticProgram<Capacity> CompileStaticPattern(std::string_view pattern)
+        {
+            StaticProgram<Capacity> program;
+
+            WalkStaticPattern(pattern, [&](TokenType op, size_t offset, size_t length)
+            {
+                if (op == TokenType::Literal)
+                    program.literalLength += length;
+                else
+                    length = 0;
+
+                program.instructions[program.count++] = { op, offset, length };
+            });
+
+            return program;
+        }
+
+        template <size_t Capacity>
+        consteval size_t GetMaxStaticLength(const StaticProgram<Capacity>& program)
+        {
+            size_t length = program.literalLength;
+
+            for (size_t i = 0; i < program.count; ++i)
+            {
+                switch (program.instructions[i].op)
+                {
+                case TokenType::Timestamp:  length += TimestampCache::MAX_RENDERED_LENGTH; break;
+                case TokenType::Level:      length += MAX_LEVEL_LENGTH; break;
+                case TokenType::Line:       length += MAX_LINE_LENGTH; break;
+                default:                    break;
+                }
+            }
+
+            return length;
+        }
+    }
+
+    /**
+    * @brief Pattern formatter specialized at compile time for a fixed pattern.
+    *
+    * The pattern is parsed by the compiler: unknown and custom tokens are
+    * rejected, the formatting function is unrolled into straight-line appends
+    * with constant-length literals, and the buffer is reserved once from the
+    * maximum static length plus the sizes of the message fields used.
+    */
+    template <FixedPattern Pattern>
+    class StaticPatternFormatter
+    {
+    public:
+        static constexpr std::string_view PATTERN = Pattern.View();
+
+        static_assert(!Internal::HasUnknownTokens(PATTERN), "StaticPatternFormatter: pattern contains an unknown or custom token");
+
+        explicit StaticPatternFormatter(std::string_view timeFormat = "%H:%M:%S") : m_timeFormat(timeFormat) {}
+
+        std::string FormatMessage(const Message& msg) const
+        {
+            Buffer buffer;
+            FormatWith(msg, m_timeFormat, buffer);
+            return buffer.ToString();
+        }
+
+        void FormatTo(const Message& msg, Buffer& out) const { FormatWith(msg, m_timeFormat, out); }
+
+        const std::string& GetTimeFormat() const { return m_timeFormat; }
+        void SetTimeFormat(std::string_view timeFormat) { m_timeFormat = timeFormat; }
+
+        // Matches PatternFormatter::FormatFunction
+        static void FormatWith(const Message& msg, std::string_view timeFormat, Buffer& out)
+        {
+            out.Reserve(out.Size() + GetDynamicLength(msg, std::make_index_sequence<PROGRAM.count>()));
+            FormatInstructions(msg, timeFormat, out, std::make_index_sequence<PROGRAM.count>());
+        }
+
+        // Installs the specialized function as the fast path of a runtime formatter
+        static void BindTo(PatternFormatter& formatter) { formatter.SetPattern(PATTERN, &FormatWith); }
+
+    private:
+        static constexpr auto PROGRAM = Internal::CompileStaticPattern<Internal::CountStaticInstructions(PATTERN)>(PATTERN);
+
+    public:
+        // Literal bytes plus the upper bound of every token that does not depend on message data
+        static constexpr size_t MAX_STATIC_LENGTH = Internal::GetMaxStaticLength(PROGRAM);
+        static constexpr size_t LITERAL_LENGTH = PROGRAM.literalLength;
+
+    private:
+        template <size_t I>
+        static size_t GetFieldLength(const Message& msg)
+        {
+            constexpr TokenType op = PROGRAM.instructions[I].op;
+
+            if constexpr (op == TokenType::Name)
+                return msg.name.size();
+            else if constexpr (op == TokenType::Message)
+                return msg.message.size();
+            else if constexpr (op == TokenType::Source)
+                return std::char_traits<char>::length(msg.sourceLocation.file_name());
+            else if constexpr (op == TokenType::Function)
+                return std::char_traits<char>::length(msg.sourceLocation.function_name());
+            else
+                return 0;
+        }
+
+        template <size_t... I>
+        static size_t GetDynamicLength(const Message& msg, std::index_sequence<I...>)
+        {
+            return MAX_STATIC_LENGTH + (size_t(0) + ... + GetFieldLength<I>(msg));
+        }
+
+        template <size_t I>
+        static void FormatInstruction(const Message& msg, std::string_view timeFormat, Buffer& out)
+        {
+            constexpr Internal::StaticInstruction instruction = PROGRAM.instructions[I];
+
+            if constexpr (instruction.op == TokenType::Literal)
+                out.Append(Pattern.data + instruction.offset, instruction.length);
+            else if constexpr (instruction.op == TokenType::Timestamp)
+                Internal::TimestampFormatter::FormatTo(out, msg, timeFormat);
+            else if constexpr (instruction.op == TokenType::Level)
+                out.Append(LevelToString(msg.level));
+            else if constexpr (instruction.op == TokenType::Name)
+                out.Append(msg.name);
+            else if constexpr (instruction.op == TokenType::Message)
+                out.Append(msg.message);
+            else if constexpr (instruction.op == TokenType::Source)
+                Internal::SourceFormatter::FormatTo(out, msg, timeFormat);
+            else if constexpr (instruction.op == TokenType::Function)
+                out.Append(msg.sourceLocation.function_name());
+            else if constexpr (instruction.op == TokenType::Line)
+                Internal::LineFormatter::FormatTo(out, msg, timeFormat);
+        }
+
+        template <size_t... I>
+        static void FormatInstructions(const Message& msg, std::string_view timeFormat, Buffer& out, std::index_sequence<I...>)
+        {
+            (FormatInstruction<I>(msg, timeFormat, out), ...);
+        }
+
+        std::string m_timeFormat;
+    };
+}
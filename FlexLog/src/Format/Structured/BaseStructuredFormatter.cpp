@@ -2,8 +2,12 @@
 
 #include <chrono>
 #include <filesystem>
-#include <iomanip>
-#include <sstream>
+
+#include "Core/NumberFormat.h"
+#include "Core/ProcessInfo.h"
+#include "Core/ThreadInfo.h"
+#include "Format/TimestampCache.h"
+#include "Level.h"
 
 FlexLog::BaseStructuredFormatter::BaseStructuredFormatter(const CommonFormatterOptions& options) : m_options(options)
 {
@@ -14,7 +18,14 @@ FlexLog::BaseStructuredFormatter::BaseStructuredFormatter(const CommonFormatterO
 
 std::string FlexLog::BaseStructuredFormatter::FormatMessage(const Message& message) const
 {
-    return FormatMessageImpl(message);
+    Buffer buffer;
+    FormatMessageImpl(message, buffer);
+    return buffer.ToString();
+}
+
+void FlexLog::BaseStructuredFormatter::FormatTo(const Message& message, Buffer& out) const
+{
+    FormatMessageImpl(message, out);
 }
 
 #ifdef FLOG_PLATFORM_WINDOWS
@@ -33,109 +44,145 @@ void FlexLog::BaseStructuredFormatter::SetOptions(const CommonFormatterOptions&
     // Initialize hostname if empty
     if (m_options.hostname.empty())
         m_options.hostname = GetHostname();
+
+    RebuildLayout();
 }
 
 std::string FlexLog::BaseStructuredFormatter::FormatTimestamp(const std::chrono::system_clock::time_point& timestamp) const
 {
-    auto time_t_now = std::chrono::system_clock::to_time_t(timestamp);
-    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(
-        timestamp.time_since_epoch() % std::chrono::seconds(1));
-
-    std::stringstream ss;
-
-    // Handle special case for ISO8601 with microseconds
-    if (m_options.timeFormat == "%FT%T.%fZ")
-    {
-        ss << std::put_time(std::gmtime(&time_t_now), "%FT%T");
-        ss << '.' << std::setfill('0') << std::setw(6) << microseconds.count() << 'Z';
-    }
-    else
-    {
-        std::string format = m_options.timeFormat;
-
-        // Replace %f with microseconds if present
-        size_t pos = format.find("%f");
-        if (pos != std::string::npos)
-        {
-            std::string microsStr = std::to_string(microseconds.count());
-            microsStr = std::string(6 - microsStr.length(), '0') + microsStr;
-            format.replace(pos, 2, microsStr);
-        }
-
-        ss << std::put_time(std::gmtime(&time_t_now), format.c_str());
-    }
+    Buffer buffer;
+    FormatTimestampTo(buffer, timestamp);
+    return buffer.ToString();
+}
 
-    return ss.str();
+void FlexLog::BaseStructuredFormatter::FormatTimestampTo(Buffer& out, const std::chrono::system_clock::time_point& timestamp) const
+{
+    // Structured timestamps are UTC; %f and friends are patched in by the cache
+    TimestampCache::FormatTo(out, timestamp, m_options.timeFormat, TimeZone::Utc);
 }
 
-std::string FlexLog::BaseStructuredFormatter::FormatSourceLocation(const std::source_location& location) const
+std::string FlexLog::BaseStructuredFormatter::FormatSourceLocation(const SourceLocation& location) const
 {
-    std::stringstream ss;
-    ss << std::filesystem::path(location.file_name()).filename().string()
-        << ":" << location.line()
-        << " [" << location.function_name() << "]";
-    return ss.str();
+    std::string result = std::filesystem::path(location.file_name()).filename().string();
+    result += ':';
+    result += NumberText(location.line()).View();
+    result += " [";
+    result += location.function_name();
+    result += ']';
+    return result;
 }
 
-std::string FlexLog::BaseStructuredFormatter::GetProcessId() const
+std::string FlexLog::BaseStructuredFormatter::GetHostname() const
 {
+    // Queried once per process rather than by every formatter instance
+    static const std::string hostname = []() -> std::string
+    {
+        char buffer[256];
 #ifdef FLOG_PLATFORM_WINDOWS
-    return std::to_string(GetCurrentProcessId());
+        DWORD size = sizeof(buffer);
+        if (GetComputerNameA(buffer, &size))
+            return std::string(buffer, size);
 #else
-    return std::to_string(getpid());
+        if (gethostname(buffer, sizeof(buffer)) == 0)
+            return std::string(buffer);
 #endif
+        return "unknown";
+    }();
+
+    return hostname;
 }
 
-std::string FlexLog::BaseStructuredFormatter::GetProcessName() const
+void FlexLog::BaseStructuredFormatter::WriteJsonFields(JsonWriter& writer, const FieldSet& fields, std::string_view keyPrefix) const
 {
-#ifdef FLOG_PLATFORM_WINDOWS
-    char processName[MAX_PATH] = {0};
-    GetModuleFileNameA(NULL, processName, MAX_PATH);
-    return std::filesystem::path(processName).filename().string();
-#else
-    char processName[1024] = {0};
-    sprintf(processName, "/proc/%d/cmdline", getpid());
-
-    FILE* cmdFile = fopen(processName, "r");
-    if (cmdFile)
+    fields.ForEach([&](std::string_view key, const FieldView& value)
     {
-        size_t read = fread(processName, 1, sizeof(processName) - 1, cmdFile);
-        fclose(cmdFile);
+        if (!m_options.includeNullValues && std::holds_alternative<std::nullptr_t>(value))
+            return;
 
-        if (read > 0)
-        {
-            processName[read] = '\0';
-            return std::filesystem::path(processName).filename().string();
-        }
-    }
+        writer.Key(keyPrefix, key);
+        writer.Value(value, [this](JsonWriter& w, const auto& timestamp) { WriteJsonTimestamp(w, timestamp); });
+    }, m_options.sortKeys);
+}
 
-    return "unknown";
-#endif
+void FlexLog::BaseStructuredFormatter::WriteJsonTimestamp(JsonWriter& writer, const std::chrono::system_clock::time_point& timestamp) const
+{
+    WriteTimestampString(writer, timestamp);
 }
 
-std::string FlexLog::BaseStructuredFormatter::GetThreadId() const
+void FlexLog::BaseStructuredFormatter::WriteTimestampString(JsonWriter& writer, const std::chrono::system_clock::time_point& timestamp) const
 {
-    std::ostringstream ss;
-    ss << std::this_thread::get_id();
-    return ss.str();
+    // Rendered into inline storage, so no std::string is built per record
+    Buffer text;
+    FormatTimestampTo(text, timestamp);
+    writer.String(text.View());
 }
 
-std::string FlexLog::BaseStructuredFormatter::GetHostname() const
+void FlexLog::BaseStructuredFormatter::RebuildLayout()
 {
-    char hostname[256];
-#ifdef FLOG_PLATFORM_WINDOWS
-    DWORD size = sizeof(hostname);
-    if (GetComputerNameA(hostname, &size))
-        return std::string(hostname, size);
-#else
-    if (gethostname(hostname, sizeof(hostname)) == 0)
-        return std::string(hostname);
-#endif
-    return "unknown";
+    LayoutBuilder builder(m_options.prettyPrint, m_options.indentSize);
+    CompileLayout(builder);
+    m_layout = builder.Build();
+}
+
+void FlexLog::BaseStructuredFormatter::WriteLayout(JsonWriter& writer, const Message& message) const
+{
+    const FieldSet fields(message);
+
+    m_layout.Run(writer, [&](LayoutSlot slot, std::string_view renderedKey)
+    {
+        WriteLayoutField(writer, message, fields, slot, renderedKey);
+    });
+}
+
+void FlexLog::BaseStructuredFormatter::WriteLayoutField(JsonWriter& writer, const Message& message, const FieldSet& fields, LayoutSlot slot, std::string_view renderedKey) const
+{
+    switch (slot.field)
+    {
+    case LayoutField::Timestamp:        WriteTimestampString(writer, message.timestamp); break;
+    case LayoutField::Message:          writer.String(message.message); break;
+    case LayoutField::Logger:           writer.String(message.name); break;
+    case LayoutField::Level:            writer.String(LevelToString(message.level)); break;
+    case LayoutField::LevelValue:       writer.Int(static_cast<int>(message.level)); break;
+    case LayoutField::SourceFile:       writer.String(GetSourceFileName(message.sourceLocation)); break;
+    case LayoutField::SourceLine:       writer.UInt(message.sourceLocation.line()); break;
+    case LayoutField::SourceFunction:   writer.String(message.sourceLocation.function_name()); break;
+    case LayoutField::ThreadId:         writer.String(NumberText(message.threadId).View()); break;
+    case LayoutField::ProcessId:        writer.Raw(ProcessInfo::Get().pidJson); break;
+    case LayoutField::ProcessIdNumber:  writer.Raw(ProcessInfo::Get().pidText); break;
+    case LayoutField::ProcessName:      writer.Raw(ProcessInfo::Get().nameJson); break;
+
+    case LayoutField::ThreadName:
+        if (message.threadName.empty())
+            break;
+
+        writer.KeyFragment(renderedKey);
+        writer.String(message.threadName);
+        break;
+
+    case LayoutField::Fields:
+        if (fields.IsEmpty())
+            break;
+
+        if (renderedKey.empty())
+        {
+            WriteJsonFields(writer, fields);
+            break;
+        }
+
+        writer.KeyFragment(renderedKey);
+        writer.BeginObject();
+        WriteJsonFields(writer, fields);
+        writer.EndObject();
+        break;
+
+    default:
+        break;
+    }
 }
 
-void FlexLog::BaseStructuredFormatter::WriteIndent(std::ostream& os, int level) const
+std::string_view FlexLog::BaseStructuredFormatter::GetSourceFileName(const SourceLocation& location)
 {
-    if (m_options.prettyPrint)
-        os << std::string(level * m_options.indentSize, ' ');
+    std::string_view file = location.file_name();
+    const size_t separator = file.find_last_of("/\\");
+    return separator == std::string_view::npos ? file : file.substr(separator + 1);
 }
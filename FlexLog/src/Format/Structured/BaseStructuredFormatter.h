@@ -1,5 +1,8 @@
 #pragma once
 
+#include "FieldSet.h"
+#include "JsonWriter.h"
+#include "LayoutPlan.h"
 #include "StructuredFormatter.h"
 
 #include <chrono>
@@ -118,6 +121,7 @@ namespace FlexLog
 
         // Format a regular message (structured or not)
         std::string FormatMessage(const Message& message) const override;
+        void FormatTo(const Message& message, Buffer& out) const override;
 
         // Format only the structured data portion
         std::string FormatStructuredData(const StructuredData& data) const override;
@@ -131,20 +135,42 @@ namespace FlexLog
         void SetOptions(const CommonFormatterOptions& options);
 
     protected:
-        virtual std::string FormatTimestamp(const std::chrono::system_clock::time_point& timestamp) const;
-        virtual std::string FormatSourceLocation(const std::source_location& location) const;
-        virtual std::string GetProcessId() const;
-        virtual std::string GetProcessName() const;
-        virtual std::string GetThreadId() const;
+        std::string FormatTimestamp(const std::chrono::system_clock::time_point& timestamp) const;
+        virtual void FormatTimestampTo(Buffer& out, const std::chrono::system_clock::time_point& timestamp) const;
+        virtual std::string FormatSourceLocation(const SourceLocation& location) const;
         virtual std::string GetHostname() const;
 
-        void WriteIndent(std::ostream& os, int level) const;
+        JsonWriter MakeJsonWriter(Buffer& out) const { return JsonWriter(out, m_options.prettyPrint, m_options.indentSize); }
 
-        virtual void EscapeString(std::ostream& os, std::string_view str) const = 0;
+        // Writes fields as members of the writer's current object, honoring includeNullValues and sortKeys
+        void WriteJsonFields(JsonWriter& writer, const FieldSet& fields, std::string_view keyPrefix = {}) const;
 
-        virtual std::string FormatMessageImpl(const Message& message) const = 0;
-        virtual std::string FormatStructuredDataImpl(const StructuredData& data) const = 0;
+        // How WriteJsonFields renders time point values; a quoted FormatTimestamp() by default
+        virtual void WriteJsonTimestamp(JsonWriter& writer, const std::chrono::system_clock::time_point& timestamp) const;
+
+        // Writes FormatTimestampTo() output as a JSON string
+        void WriteTimestampString(JsonWriter& writer, const std::chrono::system_clock::time_point& timestamp) const;
+
+        // File name without its directory, viewing into the source location's static string
+        static std::string_view GetSourceFileName(const SourceLocation& location);
+
+        // Recompiles m_layout, and whatever else a formatter precomputes, from the current options.
+        // SetOptions calls it, derived constructors call it last.
+        virtual void RebuildLayout();
+
+        // Describes the record layout; formatters that don't use a plan leave it empty
+        virtual void CompileLayout(LayoutBuilder&) const {}
+
+        // Writes m_layout for message, calling WriteLayoutField for the dynamic parts
+        void WriteLayout(JsonWriter& writer, const Message& message) const;
+
+        // Writes a per-message field of the layout; formatters extend it for their LayoutField::Custom slots
+        virtual void WriteLayoutField(JsonWriter& writer, const Message& message, const FieldSet& fields, LayoutSlot slot, std::string_view renderedKey) const;
+
+        virtual void FormatMessageImpl(const Message& message, Buffer& out) const = 0;
+        virtual std::string FormatStructuredDataImpl(const FieldSet& fields) const = 0;
 
         CommonFormatterOptions m_options;
+        LayoutPlan m_layout;
     };
 }
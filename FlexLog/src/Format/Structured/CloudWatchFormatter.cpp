@@ -1,10 +1,9 @@
 #include "CloudWatchFormatter.h"
 
-#include <sstream>
-#include <iomanip>
-#include <filesystem>
+#include <algorithm>
 #include <chrono>
 
+#include "Format/TimestampCache.h"
 #include "Level.h"
 
 FlexLog::CloudWatchFormatter::CloudWatchFormatter(const Options& options) :
@@ -16,6 +15,8 @@ FlexLog::CloudWatchFormatter::CloudWatchFormatter(const Options& options) :
 
     if (m_cwOptions.logStreamName.empty())
         m_cwOptions.logStreamName = m_options.hostname;
+
+    RebuildLayout();
 }
 
 std::string_view FlexLog::CloudWatchFormatter::GetContentType() const
@@ -28,328 +29,173 @@ std::unique_ptr<FlexLog::StructuredFormatter> FlexLog::CloudWatchFormatter::Clon
     return std::make_unique<CloudWatchFormatter>(m_cwOptions);
 }
 
-void FlexLog::CloudWatchFormatter::EscapeString(std::ostream& os, std::string_view str) const
+size_t FlexLog::CloudWatchFormatter::FormatBatch(std::span<const Message*> messages, Buffer& out) const
 {
-    for (char c : str)
-    {
-        switch (c)
-        {
-            case '"':  os << "\\\""; break;
-            case '\\': os << "\\\\"; break;
-            case '\b': os << "\\b"; break;
-            case '\f': os << "\\f"; break;
-            case '\n': os << "\\n"; break;
-            case '\r': os << "\\r"; break;
-            case '\t': os << "\\t"; break;
-            default:
-                if (static_cast<unsigned char>(c) < 32)
-                {
-                    // Control characters
-                    os << "\\u"
-                        << std::hex << std::setw(4) << std::setfill('0')
-                        << static_cast<int>(c)
-                        << std::dec;
-                }
-                else
-                {
-                    os << c;
-                }
-                break;
-        }
-    }
-}
+    std::stable_sort(messages.begin(), messages.end(),
+        [](const Message* a, const Message* b) { return a->timestamp < b->timestamp; });
 
-std::string FlexLog::CloudWatchFormatter::FormatMessageImpl(const Message& message) const
-{
-    return FormatForCloudWatch(message);
-}
+    JsonWriter writer(out, false, 0, ":");
+    writer.BeginObject();
+    writer.Member("logGroupName", m_cwOptions.logGroupName);
+    writer.Member("logStreamName", m_cwOptions.logStreamName);
+    writer.Key("logEvents");
+    writer.BeginArray();
 
-std::string FlexLog::CloudWatchFormatter::FormatStructuredDataImpl(const StructuredData& data) const
-{
-    if (data.IsEmpty())
-        return "{}";
-
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
+    Buffer record;
+    size_t batchBytes = 0;
+    size_t count = 0;
 
-    ss << "{" << nl;
+    for (const Message* message : messages)
+    {
+        if (count == MAX_BATCH_EVENTS || (count > 0 && message->timestamp - messages.front()->timestamp >= MAX_BATCH_SPAN))
+            break;
 
-    const auto& fields = data.GetFields();
+        record.Clear();
+        JsonWriter recordWriter = MakeJsonWriter(record);
+        WriteLayout(recordWriter, *message);
 
-    // Sort keys if needed
-    std::vector<std::string> keys;
-    keys.reserve(fields.size());
+        // Cut on a UTF-8 sequence boundary, so the event is at least still valid text
+        if (record.Size() + EVENT_OVERHEAD > MAX_EVENT_BYTES)
+        {
+            size_t size = MAX_EVENT_BYTES - EVENT_OVERHEAD;
+            while (size > 0 && (static_cast<unsigned char>(record.Data()[size]) & 0xc0) == 0x80)
+                --size;
+            record.Truncate(size);
+        }
 
-    for (const auto& [key, _] : fields)
-    {
-        keys.push_back(key);
-    }
+        if (batchBytes + record.Size() + EVENT_OVERHEAD > MAX_BATCH_BYTES)
+            break;
 
-    if (m_options.sortKeys)
-        std::sort(keys.begin(), keys.end());
+        batchBytes += record.Size() + EVENT_OVERHEAD;
+        ++count;
 
-    // Format fields
-    for (size_t i = 0; i < keys.size(); ++i)
-    {
-        const auto& key = keys[i];
-        const auto& value = fields.at(key);
+        writer.BeginObject();
+        writer.Member("timestamp", std::chrono::duration_cast<std::chrono::milliseconds>(message->timestamp.time_since_epoch()).count());
+        writer.Member("message", record.View());
+        writer.EndObject();
+    }
 
-        if (!m_options.includeNullValues && std::holds_alternative<std::nullptr_t>(value))
-            continue;
+    writer.EndArray();
+    writer.EndObject();
+    return count;
+}
 
-        WriteIndent(ss, 1);
-        ss << "\"" << key << "\": ";
+void FlexLog::CloudWatchFormatter::FormatMessageImpl(const Message& message, Buffer& out) const
+{
+    JsonWriter writer = MakeJsonWriter(out);
+    WriteLayout(writer, message);
+}
 
-        std::visit([&](auto&& arg)
-        {
-            using T = std::decay_t<decltype(arg)>;
-
-            if constexpr (std::is_same_v<T, std::nullptr_t>)
-            {
-                ss << "null";
-            }
-            else if constexpr (std::is_same_v<T, std::string>)
-            {
-                ss << "\"";
-                EscapeString(ss, arg);
-                ss << "\"";
-            }
-            else if constexpr (std::is_same_v<T, int64_t> || 
-                std::is_same_v<T, uint64_t>)
-            {
-                ss << arg;
-            }
-            else if constexpr (std::is_same_v<T, double>)
-            {
-                ss << std::fixed << arg;
-            }
-            else if constexpr (std::is_same_v<T, bool>)
-            {
-                ss << (arg ? "true" : "false");
-            }
-            else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
-            {
-                ss << "\"" << GetIsoTimestamp(arg) << "\"";
-            }
-            else if constexpr (std::is_same_v<T, std::vector<std::string>> || 
-                std::is_same_v<T, std::vector<int64_t>>                    ||
-                std::is_same_v<T, std::vector<double>>                     ||
-                std::is_same_v<T, std::vector<bool>>)
-            {
-                ss << "[" << nl;
-
-                for (size_t j = 0; j < arg.size(); ++j)
-                {
-                    WriteIndent(ss, 2);
-
-                    if constexpr (std::is_same_v<T, std::vector<std::string>>)
-                    {
-                        ss << "\"";
-                        EscapeString(ss, arg[j]);
-                        ss << "\"";
-                    }
-                    else if constexpr (std::is_same_v<T, std::vector<bool>>)
-                    {
-                        ss << (arg[j] ? "true" : "false");
-                    }
-                    else
-                    {
-                        ss << arg[j];
-                    }
-
-                    if (j < arg.size() - 1)
-                        ss << ",";
-
-                    ss << nl;
-                }
-
-                WriteIndent(ss, 1);
-                ss << "]";
-            }
-        }, value);
-
-        if (i < keys.size() - 1)
-            ss << ",";
-
-        ss << nl;
-    }
+std::string FlexLog::CloudWatchFormatter::FormatStructuredDataImpl(const FieldSet& fields) const
+{
+    Buffer buffer;
+    JsonWriter writer = MakeJsonWriter(buffer);
 
-    ss << "}";
+    writer.BeginObject();
+    WriteJsonFields(writer, fields);
+    writer.EndObject();
 
-    return ss.str();
+    return buffer.ToString();
 }
 
-std::string FlexLog::CloudWatchFormatter::FormatForCloudWatch(const Message& message) const
+void FlexLog::CloudWatchFormatter::WriteJsonTimestamp(JsonWriter& writer, const std::chrono::system_clock::time_point& timestamp) const
 {
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
+    Buffer text;
+    TimestampCache::FormatTo(text, timestamp, ISO_TIMESTAMP_FORMAT, TimeZone::Utc);
+    writer.String(text.View());
+}
 
+void FlexLog::CloudWatchFormatter::CompileLayout(LayoutBuilder& builder) const
+{
     // AWS CloudWatch Logs Insights format
-    ss << "{" << nl;
+    builder.BeginObject();
 
     // Timestamp - CloudWatch expects ISO8601 format
     if (m_options.includeTimestamp)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"timestamp\": \"" << GetIsoTimestamp(message.timestamp) << "\"," << nl;
-    }
+        builder.Value("timestamp", LayoutField::Timestamp);
 
     // AWS CloudWatch metadata
-    WriteIndent(ss, 1);
-    ss << "\"logGroup\": \"" << m_cwOptions.logGroupName << "\"," << nl;
-
-    WriteIndent(ss, 1);
-    ss << "\"logStream\": \"" << m_cwOptions.logStreamName << "\"," << nl;
+    builder.Member("logGroup", m_cwOptions.logGroupName);
+    builder.Member("logStream", m_cwOptions.logStreamName);
 
     // Include plain text message if requested
     if (m_cwOptions.includePlainTextMessage && m_options.includeMessage)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"message\": \"";
-        EscapeString(ss, message.message);
-        ss << "\"," << nl;
-    }
+        builder.Value("message", LayoutField::Message);
 
     // Host information
-    WriteIndent(ss, 1);
-    ss << "\"host\": \"" << m_options.hostname << "\"," << nl;
+    builder.Member("host", m_options.hostname);
 
     // Log level
     if (m_options.includeLevel)
     {
-        WriteIndent(ss, 1);
-        ss << "\"level\": \"" << LevelToString(message.level) << "\"," << nl;
-        WriteIndent(ss, 1);
-        ss << "\"levelValue\": " << static_cast<int>(message.level) << "," << nl;
+        builder.Value("level", LayoutField::Level);
+        builder.Value("levelValue", LayoutField::LevelValue);
     }
 
     // Logger name
     if (m_options.includeLogger)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"logger\": \"";
-        EscapeString(ss, message.name);
-        ss << "\"," << nl;
-    }
+        builder.Value("logger", LayoutField::Logger);
 
     // Application information
-    WriteIndent(ss, 1);
-    ss << "\"app\": \"" << m_options.applicationName << "\"," << nl;
-
-    WriteIndent(ss, 1);
-    ss << "\"env\": \"" << m_options.environment << "\"," << nl;
+    builder.Member("app", m_options.applicationName);
+    builder.Member("env", m_options.environment);
 
     // Source location information
     if (m_options.includeSourceLocation)
     {
-        WriteIndent(ss, 1);
-        ss << "\"location\": {" << nl;
-
-        WriteIndent(ss, 2);
-        ss << "\"file\": \"" 
-            << std::filesystem::path(message.sourceLocation.file_name()).filename().string() 
-            << "\"," << nl;
-
-        WriteIndent(ss, 2);
-        ss << "\"line\": " << message.sourceLocation.line() << "," << nl;
-
-        WriteIndent(ss, 2);
-        ss << "\"function\": \"" << message.sourceLocation.function_name() << "\"" << nl;
-
-        WriteIndent(ss, 1);
-        ss << "}," << nl;
+        builder.BeginObject("location");
+        builder.Value("file", LayoutField::SourceFile);
+        builder.Value("line", LayoutField::SourceLine);
+        builder.Value("function", LayoutField::SourceFunction);
+        builder.EndObject();
     }
 
-    // Process and thread info
+    // Process info
     if (m_options.includeProcessInfo)
     {
-        WriteIndent(ss, 1);
-        ss << "\"process\": {" << nl;
-
-        WriteIndent(ss, 2);
-        ss << "\"id\": \"" << GetProcessId() << "\"," << nl;
-
-        WriteIndent(ss, 2);
-        ss << "\"name\": \"" << GetProcessName() << "\"" << nl;
-
-        WriteIndent(ss, 1);
-        ss << "}," << nl;
+        builder.BeginObject("process");
+        builder.Value("id", LayoutField::ProcessId);
+        builder.Value("name", LayoutField::ProcessName);
+        builder.EndObject();
     }
 
     if (m_options.includeThreadId)
     {
-        WriteIndent(ss, 1);
-        ss << "\"threadId\": \"" << GetThreadId() << "\"," << nl;
+        builder.Value("threadId", LayoutField::ThreadId);
+        builder.Dynamic(LayoutField::ThreadName, "threadName");
     }
 
     // Tags
-    if (!m_options.tags.empty())
-    {
-        WriteIndent(ss, 1);
-        ss << "\"tags\": [" << nl;
-
-        for (size_t i = 0; i < m_options.tags.size(); ++i)
-        {
-            WriteIndent(ss, 2);
-            ss << "\"" << m_options.tags[i] << "\"";
-
-            if (i < m_options.tags.size() - 1)
-                ss << ",";
-
-            ss << nl;
-        }
-
-        WriteIndent(ss, 1);
-        ss << "]," << nl;
-    }
+    builder.StringArray("tags", m_options.tags);
 
     // Structured data
-    if (!message.structuredData.IsEmpty())
-    {
-        WriteIndent(ss, 1);
-        ss << "\"data\": " << FormatStructuredDataImpl(message.structuredData) << "," << nl;
-    }
+    builder.Dynamic(LayoutField::Fields, "data");
 
     // User data
-    for (auto it = m_options.userData.begin(); it != m_options.userData.end(); ++it)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"" << it->first << "\": \"" << it->second << "\"";
-
-        if (std::next(it) != m_options.userData.end())
-            ss << ",";
-
-        ss << nl;
-    }
+    for (const auto& [key, value] : m_options.userData)
+        builder.Member(key, value);
 
     // Metadata - CloudWatch format often includes metadata
-    WriteIndent(ss, 1);
-    ss << "\"@metadata\": {" << nl;
-    WriteIndent(ss, 2);
-    ss << "\"service\": \"flex_log-logger\"," << nl;
-    WriteIndent(ss, 2);
-    ss << "\"version\": \"1.0\"" << nl;
-    WriteIndent(ss, 1);
-    ss << "}" << nl;
+    builder.BeginObject("@metadata");
+    builder.Member("service", "flex_log-logger");
+    builder.Member("version", "1.0");
+    builder.EndObject();
 
     // Close the main object
-    ss << "}";
+    builder.EndObject();
+}
 
-    return ss.str();
+void FlexLog::CloudWatchFormatter::WriteLayoutField(JsonWriter& writer, const Message& message, const FieldSet& fields, LayoutSlot slot, std::string_view renderedKey) const
+{
+    if (slot.field == LayoutField::Timestamp)
+        WriteJsonTimestamp(writer, message.timestamp);
+    else
+        BaseStructuredFormatter::WriteLayoutField(writer, message, fields, slot, renderedKey);
 }
 
 std::string FlexLog::CloudWatchFormatter::GetIsoTimestamp(const std::chrono::system_clock::time_point& timestamp) const
 {
     // Create ISO 8601 timestamp with milliseconds
     // Format: YYYY-MM-DDThh:mm:ss.sssZ
-    auto time_t_now = std::chrono::system_clock::to_time_t(timestamp);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()) % 1000;
-
-    std::stringstream ss;
-    ss << std::put_time(std::gmtime(&time_t_now), "%FT%T");
-    ss << '.' << std::setfill('0') << std::setw(3) << ms.count() << 'Z';
-
-    return ss.str();
+    return TimestampCache::Format(timestamp, ISO_TIMESTAMP_FORMAT, TimeZone::Utc);
 }
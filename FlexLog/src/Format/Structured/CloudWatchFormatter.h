@@ -1,6 +1,8 @@
 #pragma once
 
 #include "BaseStructuredFormatter.h"
+#include <chrono>
+#include <span>
 #include <string>
 
 namespace FlexLog
@@ -8,6 +10,15 @@ namespace FlexLog
     class CloudWatchFormatter : public BaseStructuredFormatter
     {
     public:
+        static constexpr std::string_view ISO_TIMESTAMP_FORMAT = "%FT%T.%3fZ";
+
+        // PutLogEvents limits. Each event counts its message's UTF-8 bytes plus EVENT_OVERHEAD bytes.
+        static constexpr size_t MAX_BATCH_BYTES = 1048576;
+        static constexpr size_t MAX_BATCH_EVENTS = 10000;
+        static constexpr size_t MAX_EVENT_BYTES = 262144;
+        static constexpr size_t EVENT_OVERHEAD = 26;
+        static constexpr std::chrono::hours MAX_BATCH_SPAN{24};
+
         struct Options : public CommonFormatterOptions
         {
             // CloudWatch-specific options
@@ -39,13 +50,20 @@ namespace FlexLog
         std::string_view GetContentType() const override;
         std::unique_ptr<StructuredFormatter> Clone() const override;
 
+        // Writes one PutLogEvents request body, each record becoming an event's message. messages is
+        // sorted by timestamp in place, as CloudWatch rejects unordered batches, and the longest prefix
+        // that fits the request limits is written. Returns how many were written; send the rest in
+        // further batches. A record too large for one event is cut short.
+        size_t FormatBatch(std::span<const Message*> messages, Buffer& out) const;
+
     protected:
-        void EscapeString(std::ostream& os, std::string_view str) const override;
-        std::string FormatMessageImpl(const Message& message) const override;
-        std::string FormatStructuredDataImpl(const StructuredData& data) const override;
+        void FormatMessageImpl(const Message& message, Buffer& out) const override;
+        std::string FormatStructuredDataImpl(const FieldSet& fields) const override;
+        void WriteJsonTimestamp(JsonWriter& writer, const std::chrono::system_clock::time_point& timestamp) const override;
 
-        // Format in AWS CloudWatch Logs format
-        std::string FormatForCloudWatch(const Message& message) const;
+        // Layout in AWS CloudWatch Logs format
+        void CompileLayout(LayoutBuilder& builder) const override;
+        void WriteLayoutField(JsonWriter& writer, const Message& message, const FieldSet& fields, LayoutSlot slot, std::string_view renderedKey) const override;
 
         // Utility to get ISO 8601 timestamp with milliseconds
         std::string GetIsoTimestamp(const std::chrono::system_clock::time_point& timestamp) const;
@@ -1,12 +1,25 @@
 #include "ElasticsearchFormatter.h"
 
-#include <sstream>
-#include <iomanip>
-#include <filesystem>
-#include <thread>
+#include <atomic>
+#include <chrono>
+#include <climits>
 
+#include "Format/TimestampCache.h"
 #include "Level.h"
-#include "Platform.h"
+
+namespace FlexLog::Internal
+{
+    struct BulkActionCache
+    {
+        uint64_t generation = 0;
+        int64_t day = INT64_MIN;
+        std::string line;
+    };
+
+    thread_local BulkActionCache t_bulkActionCache;
+
+    std::atomic<uint64_t> s_nextIndexGeneration{1};
+}
 
 FlexLog::ElasticsearchFormatter::ElasticsearchFormatter(const Options& options) :
     BaseStructuredFormatter(options),
@@ -14,6 +27,8 @@ FlexLog::ElasticsearchFormatter::ElasticsearchFormatter(const Options& options)
 {
     if (m_options.hostname.empty())
         m_options.hostname = GetHostname();
+
+    RebuildLayout();
 }
 
 std::string_view FlexLog::ElasticsearchFormatter::GetContentType() const
@@ -26,461 +41,216 @@ std::unique_ptr<FlexLog::StructuredFormatter> FlexLog::ElasticsearchFormatter::C
     return std::make_unique<ElasticsearchFormatter>(m_elasticOptions);
 }
 
-void FlexLog::ElasticsearchFormatter::EscapeString(std::ostream& os, std::string_view str) const
+void FlexLog::ElasticsearchFormatter::FormatBatch(std::span<const Message* const> messages, Buffer& out) const
 {
-    for (char c : str)
-    {
-        switch (c)
-        {
-            case '"':  os << "\\\""; break;
-            case '\\': os << "\\\\"; break;
-            case '\b': os << "\\b";  break;
-            case '\f': os << "\\f";  break;
-            case '\n': os << "\\n";  break;
-            case '\r': os << "\\r";  break;
-            case '\t': os << "\\t";  break;
-            default:
-                if (static_cast<unsigned char>(c) < 32)
-                {
-                    // Control characters
-                    os << "\\u" 
-                        << std::hex << std::setw(4) << std::setfill('0') 
-                        << static_cast<int>(c)
-                        << std::dec;
-                }
-                else
-                {
-                    os << c;
-                }
-                break;
-        }
-    }
+    for (const Message* message : messages)
+        FormatBulkLine(*message, out);
 }
 
-std::string FlexLog::ElasticsearchFormatter::FormatMessageImpl(const Message& message) const
+void FlexLog::ElasticsearchFormatter::FormatMessageImpl(const Message& message, Buffer& out) const
 {
     if (m_elasticOptions.useBulkFormat)
-        return FormatBulkLine(message);
+    {
+        FormatBulkLine(message, out);
+        return;
+    }
 
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
+    JsonWriter writer = MakeJsonWriter(out);
+    WriteLayout(writer, message);
+}
 
-    ss << "{" << nl;
+void FlexLog::ElasticsearchFormatter::CompileLayout(LayoutBuilder& builder) const
+{
+    builder.BeginObject();
 
     // Timestamp (required by Elasticsearch)
     if (m_options.includeTimestamp)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"@timestamp\": \"" << FormatTimestamp(message.timestamp) << "\"," << nl;
-    }
+        builder.Value("@timestamp", LayoutField::Timestamp);
 
     // Message content
     if (m_options.includeMessage)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"message\": \"";
-        EscapeString(ss, message.message);
-        ss << "\"," << nl;
-    }
+        builder.Value("message", LayoutField::Message);
 
     // Logger name
     if (m_options.includeLogger)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"logger_name\": \"";
-        EscapeString(ss, message.name);
-        ss << "\"," << nl;
-    }
+        builder.Value("logger_name", LayoutField::Logger);
 
     // Log level
     if (m_options.includeLevel)
     {
-        WriteIndent(ss, 1);
-        ss << "\"level\": \"" << LevelToString(message.level) << "\"," << nl;
-        WriteIndent(ss, 1);
-        ss << "\"level_value\": " << static_cast<int>(message.level) << "," << nl;
+        builder.Value("level", LayoutField::Level);
+        builder.Value("level_value", LayoutField::LevelValue);
     }
 
     // Service information
-    WriteIndent(ss, 1);
-    ss << "\"application\": \"" << m_options.applicationName << "\"," << nl;
-    WriteIndent(ss, 1);
-    ss << "\"environment\": \"" << m_options.environment << "\"," << nl;
+    builder.Member("application", m_options.applicationName);
+    builder.Member("environment", m_options.environment);
 
     if (!m_options.serviceName.empty())
     {
-        WriteIndent(ss, 1);
-        ss << "\"service\": {" << nl;
-        WriteIndent(ss, 2);
-        ss << "\"name\": \"" << m_options.serviceName << "\"," << nl;
-        WriteIndent(ss, 2);
-        ss << "\"version\": \"" << m_options.serviceVersion << "\"" << nl;
-        WriteIndent(ss, 1);
-        ss << "}," << nl;
+        builder.BeginObject("service");
+        builder.Member("name", m_options.serviceName);
+        builder.Member("version", m_options.serviceVersion);
+        builder.EndObject();
     }
 
     // Host information
-    WriteIndent(ss, 1);
-    ss << "\"host\": \"" << m_options.hostname << "\"," << nl;
+    builder.Member("host", m_options.hostname);
 
     // Source location
     if (m_options.includeSourceLocation)
     {
-        WriteIndent(ss, 1);
-        ss << "\"log\": {" << nl;
-        WriteIndent(ss, 2);
-        ss << "\"origin\": {" << nl;
-        WriteIndent(ss, 3);
-        ss << "\"file\": \"" 
-            << std::filesystem::path(message.sourceLocation.file_name()).filename().string() 
-            << "\"," << nl;
-        WriteIndent(ss, 3);
-        ss << "\"function\": \"" << message.sourceLocation.function_name() << "\"," << nl;
-        WriteIndent(ss, 3);
-        ss << "\"line\": " << message.sourceLocation.line() << nl;
-        WriteIndent(ss, 2);
-        ss << "}" << nl;
-        WriteIndent(ss, 1);
-        ss << "}," << nl;
+        builder.BeginObject("log");
+        builder.BeginObject("origin");
+        builder.Value("file", LayoutField::SourceFile);
+        builder.Value("function", LayoutField::SourceFunction);
+        builder.Value("line", LayoutField::SourceLine);
+        builder.EndObject();
+        builder.EndObject();
     }
 
-    // Process and thread info
+    // Process info
     if (m_options.includeProcessInfo)
     {
-        WriteIndent(ss, 1);
-        ss << "\"process\": {" << nl;
-        WriteIndent(ss, 2);
-        ss << "\"pid\": " << GetProcessId() << "," << nl;
-        WriteIndent(ss, 2);
-        ss << "\"name\": \"" << GetProcessName() << "\"" << nl;
-        WriteIndent(ss, 1);
-        ss << "}," << nl;
+        builder.BeginObject("process");
+        builder.Value("pid", LayoutField::ProcessIdNumber);
+        builder.Value("name", LayoutField::ProcessName);
+        builder.EndObject();
     }
 
     if (m_options.includeThreadId)
     {
-        WriteIndent(ss, 1);
-        ss << "\"thread\": {" << nl;
-        WriteIndent(ss, 2);
-        ss << "\"id\": \"" << GetThreadId() << "\"" << nl;
-        WriteIndent(ss, 1);
-        ss << "}," << nl;
+        builder.BeginObject("thread");
+        builder.Value("id", LayoutField::ThreadId);
+        builder.Dynamic(LayoutField::ThreadName, "name");
+        builder.EndObject();
     }
 
     // Tags if any
-    if (!m_options.tags.empty())
-    {
-        WriteIndent(ss, 1);
-        ss << "\"tags\": [" << nl;
-        for (size_t i = 0; i < m_options.tags.size(); ++i)
-        {
-            WriteIndent(ss, 2);
-            ss << "\"" << m_options.tags[i] << "\"";
-            if (i < m_options.tags.size() - 1)
-                ss << ",";
-            ss << nl;
-        }
-        WriteIndent(ss, 1);
-        ss << "]," << nl;
-    }
+    builder.StringArray("tags", m_options.tags);
 
     // Structured data
-    if (!message.structuredData.IsEmpty())
-    {
-        WriteIndent(ss, 1);
-        ss << "\"data\": " << FormatStructuredDataImpl(message.structuredData) << "," << nl;
-    }
+    builder.Dynamic(LayoutField::Fields, "data");
 
     // User data
-    for (auto it = m_options.userData.begin(); it != m_options.userData.end(); ++it)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"" << it->first << "\": \"" << it->second << "\"";
-
-        if (std::next(it) != m_options.userData.end())
-            ss << ",";
-
-        ss << nl;
-    }
-
-    // Close the JSON object
-    ss << "}";
+    for (const auto& [key, value] : m_options.userData)
+        builder.Member(key, value);
 
-    return ss.str();
+    builder.EndObject();
 }
 
-std::string FlexLog::ElasticsearchFormatter::FormatStructuredDataImpl(const StructuredData& data) const
+std::string FlexLog::ElasticsearchFormatter::FormatStructuredDataImpl(const FieldSet& fields) const
 {
-    if (data.IsEmpty())
-        return "{}";
-
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
-
-    ss << "{" << nl;
+    Buffer buffer;
+    JsonWriter writer = MakeJsonWriter(buffer);
 
-    const auto& fields = data.GetFields();
+    writer.BeginObject();
+    WriteJsonFields(writer, fields);
+    writer.EndObject();
 
-    // Sort keys if needed
-    std::vector<std::string> keys;
-    keys.reserve(fields.size());
+    return buffer.ToString();
+}
 
-    for (const auto& [key, _] : fields)
-    {
-        keys.push_back(key);
-    }
+void FlexLog::ElasticsearchFormatter::RebuildLayout()
+{
+    BaseStructuredFormatter::RebuildLayout();
 
-    if (m_options.sortKeys)
-    {
-        std::sort(keys.begin(), keys.end());
-    }
+    std::string indexName = m_elasticOptions.indexNameTemplate;
 
-    // Format fields
-    for (size_t i = 0; i < keys.size(); ++i)
-    {
-        const auto& key = keys[i];
-        const auto& value = fields.at(key);
-
-        if (!m_options.includeNullValues && std::holds_alternative<std::nullptr_t>(value))
-            continue;
-
-        WriteIndent(ss, 2);
-        ss << "\"" << key << "\": ";
-
-        std::visit([&](auto&& arg)
-        {
-            using T = std::decay_t<decltype(arg)>;
-
-            if constexpr (std::is_same_v<T, std::nullptr_t>)
-            {
-                ss << "null";
-            }
-            else if constexpr (std::is_same_v<T, std::string>)
-            {
-                ss << "\"";
-                EscapeString(ss, arg);
-                ss << "\"";
-            }
-            else if constexpr (std::is_same_v<T, int64_t> || 
-                std::is_same_v<T, uint64_t>)
-            {
-                ss << arg;
-            }
-            else if constexpr (std::is_same_v<T, double>)
-            {
-                ss << std::fixed << arg;
-            }
-            else if constexpr (std::is_same_v<T, bool>)
-            {
-                ss << (arg ? "true" : "false");
-            }
-            else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
-            {
-                ss << "\"" << FormatTimestamp(arg) << "\"";
-            }
-            else if constexpr (std::is_same_v<T, std::vector<std::string>> || 
-                std::is_same_v<T, std::vector<int64_t>> ||
-                std::is_same_v<T, std::vector<double>> ||
-                std::is_same_v<T, std::vector<bool>>)
-            {
-                ss << "[" << nl;
-
-                for (size_t j = 0; j < arg.size(); ++j)
-                {
-                    WriteIndent(ss, 3);
-
-                    if constexpr (std::is_same_v<T, std::vector<std::string>>)
-                    {
-                        ss << "\"";
-                        EscapeString(ss, arg[j]);
-                        ss << "\"";
-                    }
-                    else if constexpr (std::is_same_v<T, std::vector<bool>>)
-                    {
-                        ss << (arg[j] ? "true" : "false");
-                    }
-                    else
-                    {
-                        ss << arg[j];
-                    }
-
-                    if (j < arg.size() - 1)
-                        ss << ",";
-
-                    ss << nl;
-                }
-
-                WriteIndent(ss, 2);
-                ss << "]";
-            }
-        }, value);
-
-        if (i < keys.size() - 1)
-            ss << ",";
-
-        ss << nl;
-    }
+    // Replace {application} placeholder
+    const size_t appPos = indexName.find("{application}");
+    if (appPos != std::string::npos)
+        indexName.replace(appPos, 13, m_options.applicationName);
 
-    WriteIndent(ss, 1);
-    ss << "}";
+    // Split around the {date} placeholder, filled in per record
+    const size_t datePos = indexName.find("{date}");
+    m_indexHasDate = datePos != std::string::npos;
+    m_indexPrefix = indexName.substr(0, datePos);
+    m_indexSuffix = m_indexHasDate ? indexName.substr(datePos + 6) : std::string();
 
-    return ss.str();
+    m_indexGeneration = Internal::s_nextIndexGeneration.fetch_add(1, std::memory_order_relaxed);
 }
 
-std::string FlexLog::ElasticsearchFormatter::GenerateIndexName() const
+std::string_view FlexLog::ElasticsearchFormatter::GetBulkActionLine(std::chrono::system_clock::time_point timestamp) const
 {
-    std::string result = m_elasticOptions.indexNameTemplate;
+    Internal::BulkActionCache& cache = Internal::t_bulkActionCache;
+
+    // Every record maps to the same index when the template has no date
+    const int64_t day = m_indexHasDate ? std::chrono::floor<std::chrono::days>(timestamp).time_since_epoch().count() : 0;
+    if (cache.generation == m_indexGeneration && cache.day == day)
+        return cache.line;
+
+    Buffer indexName;
+    indexName.Append(m_indexPrefix);
+    if (m_indexHasDate)
+        TimestampCache::FormatTo(indexName, timestamp, "%Y.%m.%d", TimeZone::Utc);
+    indexName.Append(m_indexSuffix);
+
+    Buffer line;
+    JsonWriter action(line, false, 0, ":");
+    action.BeginObject();
+    action.Key("index");
+    action.BeginObject();
+    action.Member("_index", indexName.View());
 
-    // Replace {application} placeholder
-    size_t appPos = result.find("{application}");
-    if (appPos != std::string::npos)
-        result.replace(appPos, 13, m_options.applicationName);
+    if (!m_elasticOptions.docType.empty())
+        action.Member("_type", m_elasticOptions.docType);
 
-    // Replace {date} placeholder
-    size_t datePos = result.find("{date}");
-    if (datePos != std::string::npos)
-    {
-        auto now = std::chrono::system_clock::now();
-        auto time_t_now = std::chrono::system_clock::to_time_t(now);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time_t_now), "%Y.%m.%d");
-        result.replace(datePos, 6, ss.str());
-    }
+    action.EndObject();
+    action.EndObject();
+    line.PushBack('\n');
 
-    return result;
+    cache.generation = m_indexGeneration;
+    cache.day = day;
+    cache.line = line.View();
+    return cache.line;
 }
 
-std::string FlexLog::ElasticsearchFormatter::FormatBulkLine(const Message& message) const
+void FlexLog::ElasticsearchFormatter::FormatBulkLine(const Message& message, Buffer& out) const
 {
     // The Elasticsearch bulk API requires two lines per document:
     // 1. Action and metadata
     // 2. Document source
-
-    std::stringstream ss;
+    // Both are always compact, as NDJSON forbids newlines inside a line
 
     // 1. Action line
-    ss << "{\"index\":{\"_index\":\"" << GenerateIndexName() << "\"";
+    out.Append(GetBulkActionLine(message.timestamp));
 
-    if (!m_elasticOptions.docType.empty())
-    {
-        ss << ",\"_type\":\"" << m_elasticOptions.docType << "\"";
-    }
-
-    ss << "}}\n";
+    // 2. Document source
+    JsonWriter writer(out, false, 0, ":");
 
-    // 2. Document source (without pretty printing)
-    ss << "{";
+    writer.BeginObject();
 
     // Timestamp (required by Elasticsearch)
-    ss << "\"@timestamp\":\"" << FormatTimestamp(message.timestamp) << "\",";
+    writer.Key("@timestamp");
+    WriteTimestampString(writer, message.timestamp);
 
     // Message content
-    ss << "\"message\":\"";
-    EscapeString(ss, message.message);
-    ss << "\",";
+    writer.Member("message", message.message);
 
     // Logger name
-    ss << "\"logger_name\":\"";
-    EscapeString(ss, message.name);
-    ss << "\",";
+    writer.Member("logger_name", message.name);
 
     // Log level
-    ss << "\"level\":\"" << LevelToString(message.level) << "\",";
-    ss << "\"level_value\":" << static_cast<int>(message.level) << ",";
+    writer.Member("level", LevelToString(message.level));
+    writer.Member("level_value", static_cast<int>(message.level));
 
     // Other fields
-    ss << "\"application\":\"" << m_options.applicationName << "\",";
-    ss << "\"environment\":\"" << m_options.environment << "\",";
-    ss << "\"host\":\"" << m_options.hostname << "\"";
+    writer.Member("application", m_options.applicationName);
+    writer.Member("environment", m_options.environment);
+    writer.Member("host", m_options.hostname);
 
     // Add structured data if present
-    if (!message.structuredData.IsEmpty())
+    const FieldSet fields(message);
+    if (!fields.IsEmpty())
     {
-        ss << ",\"data\":";
-
-        // For bulk format, use compact JSON without indentation
-        CommonFormatterOptions tmpOptions = m_options;
-        tmpOptions.prettyPrint = false;
-
-        std::stringstream dataStr;
-        for (const auto& [key, value] : message.structuredData.GetFields())
-        {
-            if (dataStr.tellp() > 0)
-                dataStr << ",";
-
-            dataStr << "\"" << key << "\":";
-
-            std::visit([&](auto&& arg)
-            {
-                using T = std::decay_t<decltype(arg)>;
-
-                if constexpr (std::is_same_v<T, std::nullptr_t>)
-                {
-                    dataStr << "null";
-                }
-                else if constexpr (std::is_same_v<T, std::string>)
-                {
-                    dataStr << "\"";
-                    EscapeString(dataStr, arg);
-                    dataStr << "\"";
-                }
-                else if constexpr (std::is_same_v<T, int64_t> || 
-                    std::is_same_v<T, uint64_t>)
-                {
-                    dataStr << arg;
-                }
-                else if constexpr (std::is_same_v<T, double>)
-                {
-                    dataStr << std::fixed << arg;
-                }
-                else if constexpr (std::is_same_v<T, bool>)
-                {
-                    dataStr << (arg ? "true" : "false");
-                }
-                else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
-                {
-                    dataStr << "\"" << FormatTimestamp(arg) << "\"";
-                }
-                else if constexpr (std::is_same_v<T, std::vector<std::string>> || 
-                    std::is_same_v<T, std::vector<int64_t>>                    ||
-                    std::is_same_v<T, std::vector<double>>                     ||
-                    std::is_same_v<T, std::vector<bool>>)
-                {
-                    dataStr << "[";
-
-                    for (size_t i = 0; i < arg.size(); ++i)
-                    {
-                        if (i > 0)
-                            dataStr << ",";
-
-                        if constexpr (std::is_same_v<T, std::vector<std::string>>)
-                        {
-                            dataStr << "\"";
-                            EscapeString(dataStr, arg[i]);
-                            dataStr << "\"";
-                        }
-                        else if constexpr (std::is_same_v<T, std::vector<bool>>)
-                        {
-                            dataStr << (arg[i] ? "true" : "false");
-                        }
-                        else
-                        {
-                            dataStr << arg[i];
-                        }
-                    }
-
-                    dataStr << "]";
-                }
-            }, value);
-        }
-
-        ss << "{" << dataStr.str() << "}";
+        writer.Key("data");
+        writer.BeginObject();
+        WriteJsonFields(writer, fields);
+        writer.EndObject();
     }
 
     // Close the document
-    ss << "}\n";
-
-    return ss.str();
+    writer.EndObject();
+    out.PushBack('\n');
 }
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "BaseStructuredFormatter.h"
+#include <chrono>
+#include <span>
+#include <string>
 
 namespace FlexLog
 {
@@ -37,14 +40,28 @@ namespace FlexLog
         std::string_view GetContentType() const override;
         std::unique_ptr<StructuredFormatter> Clone() const override;
 
+        // Writes one NDJSON _bulk request body, an action line and a compact document per record.
+        // The {date} in the index name is the record's UTC day, so a batch may span daily indices.
+        void FormatBatch(std::span<const Message* const> messages, Buffer& out) const;
+
     protected:
-        void EscapeString(std::ostream& os, std::string_view str) const override;
-        std::string FormatMessageImpl(const Message& message) const override;
-        std::string FormatStructuredDataImpl(const StructuredData& data) const override;
+        void FormatMessageImpl(const Message& message, Buffer& out) const override;
+        void CompileLayout(LayoutBuilder& builder) const override;
+        std::string FormatStructuredDataImpl(const FieldSet& fields) const override;
+
+        void RebuildLayout() override;
 
-        std::string GenerateIndexName() const;
-        std::string FormatBulkLine(const Message& message) const;
+        // Action line naming the index for timestamp's day; rendered once per day and thread, then reused
+        std::string_view GetBulkActionLine(std::chrono::system_clock::time_point timestamp) const;
+        void FormatBulkLine(const Message& message, Buffer& out) const;
 
         Options m_elasticOptions;
+
+    private:
+        // The index name template split around {date}, with {application} already substituted
+        std::string m_indexPrefix;
+        std::string m_indexSuffix;
+        bool m_indexHasDate = false;
+        uint64_t m_indexGeneration = 0;     // Identifies the split template in the per-thread action line cache
     };
 }
@@ -0,0 +1,82 @@
+#include "Field.h"
+
+FlexLog::FieldView FlexLog::MakeFieldView(const StructuredData::FieldValue& value)
+{
+    return std::visit([](const auto& arg) -> FieldView
+    {
+        using T = std::decay_t<decltype(arg)>;
+
+        if constexpr (std::is_same_v<T, std::string>)
+            return std::string_view(arg);
+        else if constexpr (std::is_same_v<T, std::vector<std::string>> ||
+            std::is_same_v<T, std::vector<int64_t>> ||
+            std::is_same_v<T, std::vector<double>>)
+            return std::span(arg);
+        else if constexpr (std::is_same_v<T, std::vector<bool>>)
+            return BoolSpan(arg);
+        else if constexpr (std::is_same_v<T, StructuredData::DeferredValue>)
+            return nullptr;  // Not resolved yet
+        else
+            return arg;
+    }, value);
+}
+
+FlexLog::FieldPayload::FieldPayload(FieldPayload&& other) noexcept :
+    m_heapBuffer(other.m_heapBuffer),
+    m_size(other.m_size),
+    m_count(other.m_count)
+{
+    if (!m_heapBuffer)
+        std::memcpy(m_inlineBuffer, other.m_inlineBuffer, m_size);
+
+    other.m_heapBuffer = nullptr;
+    other.m_size = 0;
+    other.m_count = 0;
+}
+
+FlexLog::FieldPayload::~FieldPayload()
+{
+    delete[] m_heapBuffer;
+}
+
+FlexLog::FieldPayload& FlexLog::FieldPayload::operator=(FieldPayload&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->~FieldPayload();
+        new (this) FieldPayload(std::move(other));
+    }
+    return *this;
+}
+
+void FlexLog::FieldPayload::Clear()
+{
+    delete[] m_heapBuffer;
+    m_heapBuffer = nullptr;
+    m_size = 0;
+    m_count = 0;
+}
+
+char* FlexLog::FieldPayload::Allocate(size_t size)
+{
+    const size_t required = m_size + size;
+
+    if (!m_heapBuffer && required > INLINE_CAPACITY)
+    {
+        // Spill to the heap, carrying over anything already encoded inline
+        char* heap = new char[required];
+        std::memcpy(heap, m_inlineBuffer, m_size);
+        m_heapBuffer = heap;
+    }
+    else if (m_heapBuffer)
+    {
+        char* heap = new char[required];
+        std::memcpy(heap, m_heapBuffer, m_size);
+        delete[] m_heapBuffer;
+        m_heapBuffer = heap;
+    }
+
+    char* dst = (m_heapBuffer ? m_heapBuffer : m_inlineBuffer) + m_size;
+    m_size = static_cast<uint32_t>(required);
+    return dst;
+}
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "Common.h"
+#include "StructuredData.h"
+
+namespace FlexLog
+{
+    enum class FieldType : uint8_t
+    {
+        Null,
+        String,
+        Int64,
+        UInt64,
+        Double,
+        Bool,
+        Timestamp
+    };
+
+    namespace Internal
+    {
+        template<typename>
+        inline constexpr bool UnsupportedFieldType = false;
+
+        template<typename V>
+        constexpr auto DeduceFieldStorage()
+        {
+            using T = std::decay_t<V>;
+
+            if constexpr (std::is_same_v<T, bool>)
+                return bool{};
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+                return int64_t{};
+            else if constexpr (std::is_integral_v<T>)
+                return uint64_t{};
+            else if constexpr (std::is_floating_point_v<T>)
+                return double{};
+            else if constexpr (std::is_null_pointer_v<T>)
+                return nullptr;
+            else if constexpr (std::is_convertible_v<T, std::chrono::system_clock::time_point>)
+                return std::chrono::system_clock::time_point{};
+            else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+                return std::string_view{};
+            else
+                static_assert(UnsupportedFieldType<T>, "Field value must be a string, number, bool, nullptr or system_clock time point");
+        }
+    }
+
+    template<typename V>
+    using FieldStorageType = decltype(Internal::DeduceFieldStorage<V>());
+
+    /**
+    * @brief A typed key/value pair passed alongside a log message.
+    *
+    * Fields are encoded straight into the message's binary payload, so the
+    * hot path never builds a StructuredData map. String keys and values are
+    * held by view: a Field must not outlive the arguments it was built from.
+    */
+    template<typename T>
+    struct Field
+    {
+        constexpr Field(std::string_view fieldKey, T fieldValue) : key(fieldKey), value(fieldValue) {}
+
+        std::string_view key;
+        T value;
+    };
+
+    template<typename V>
+    Field(std::string_view, const V&) -> Field<FieldStorageType<V>>;
+
+    template<typename T>
+    inline constexpr bool IsField = false;
+
+    template<typename T>
+    inline constexpr bool IsField<Field<T>> = true;
+
+    // std::vector<bool> is bit-packed, so it gets a thin indexable view instead of a span
+    class BoolSpan
+    {
+    public:
+        explicit BoolSpan(const std::vector<bool>& values) : m_values(&values) {}
+
+        size_t size() const { return m_values->size(); }
+        bool empty() const { return m_values->empty(); }
+        bool operator[](size_t index) const { return (*m_values)[index]; }
+
+        auto begin() const { return m_values->begin(); }
+        auto end() const { return m_values->end(); }
+
+    private:
+        const std::vector<bool>* m_values;
+    };
+
+    // Non-owning view over a single field value, whether it came from a
+    // StructuredData map or from a message's encoded field payload
+    using FieldView = std::variant
+    <
+        std::nullptr_t,
+        std::string_view,
+        int64_t,
+        uint64_t,
+        double,
+        bool,
+        std::chrono::system_clock::time_point,
+        std::span<const std::string>,
+        std::span<const int64_t>,
+        std::span<const double>,
+        BoolSpan
+    >;
+
+    FieldView MakeFieldView(const StructuredData::FieldValue& value);
+
+    /**
+    * @brief Compact binary encoding of the typed fields attached to a message.
+    *
+    * Each entry is laid out as [type:u8][keyLength:u16][key][value] where
+    * fixed-width values are stored as raw bytes and strings carry a u32 length
+    * prefix. Small payloads live inline; larger ones spill to a single heap block.
+    */
+    class FieldPayload
+    {
+    public:
+        FieldPayload() = default;
+        FieldPayload(FieldPayload&& other) noexcept;
+        FieldPayload(const FieldPayload&) = delete;
+        ~FieldPayload();
+
+        FieldPayload& operator=(FieldPayload&& other) noexcept;
+        FieldPayload& operator=(const FieldPayload&) = delete;
+
+        template<typename... Ts>
+        void Encode(const Field<Ts>&... fields);
+
+        template<typename Fn>
+        void ForEach(Fn&& fn) const;
+
+        bool IsEmpty() const { return m_count == 0; }
+        size_t Count() const { return m_count; }
+        std::span<const char> Bytes() const { return { Data(), m_size }; }
+
+        void Clear();
+
+    private:
+        static constexpr size_t INLINE_CAPACITY = 128;
+        static constexpr size_t HEADER_SIZE = sizeof(uint8_t) + sizeof(uint16_t);
+        static constexpr size_t MAX_KEY_LENGTH = UINT16_MAX;
+
+        template<typename T>
+        static constexpr FieldType TypeOf();
+
+        template<typename T>
+        static size_t EncodedSize(const Field<T>& field);
+
+        template<typename T>
+        static char* Write(char* dst, const Field<T>& field);
+
+        static char* WriteRaw(char* dst, const void* src, size_t size)
+        {
+            std::memcpy(dst, src, size);
+            return dst + size;
+        }
+
+        char* Allocate(size_t size);
+        const char* Data() const { return m_heapBuffer ? m_heapBuffer : m_inlineBuffer; }
+
+        alignas(8) char m_inlineBuffer[INLINE_CAPACITY];
+        char* m_heapBuffer = nullptr;
+        uint32_t m_size = 0;
+        uint32_t m_count = 0;
+    };
+
+    template<typename T>
+    constexpr FieldType FieldPayload::TypeOf()
+    {
+        if constexpr (std::is_same_v<T, std::nullptr_t>)
+            return FieldType::Null;
+        else if constexpr (std::is_same_v<T, std::string_view>)
+            return FieldType::String;
+        else if constexpr (std::is_same_v<T, int64_t>)
+            return FieldType::Int64;
+        else if constexpr (std::is_same_v<T, uint64_t>)
+            return FieldType::UInt64;
+        else if constexpr (std::is_same_v<T, double>)
+            return FieldType::Double;
+        else if constexpr (std::is_same_v<T, bool>)
+            return FieldType::Bool;
+        else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
+            return FieldType::Timestamp;
+        else
+            static_assert(Internal::UnsupportedFieldType<T>, "Field<T> must use a storage type: deduce it from the value or use FieldStorageType");
+    }
+
+    template<typename T>
+    size_t FieldPayload::EncodedSize(const Field<T>& field)
+    {
+        size_t size = HEADER_SIZE + std::min(field.key.size(), MAX_KEY_LENGTH);
+
+        if constexpr (std::is_same_v<T, std::string_view>)
+            size += sizeof(uint32_t) + field.value.size();
+        else if constexpr (std::is_same_v<T, bool>)
+            size += sizeof(uint8_t);
+        else if constexpr (!std::is_same_v<T, std::nullptr_t>)
+            size += sizeof(int64_t);
+
+        return size;
+    }
+
+    template<typename T>
+    char* FieldPayload::Write(char* dst, const Field<T>& field)
+    {
+        const uint8_t type = static_cast<uint8_t>(TypeOf<T>());
+        const uint16_t keyLength = static_cast<uint16_t>(std::min(field.key.size(), MAX_KEY_LENGTH));
+
+        dst = WriteRaw(dst, &type, sizeof(type));
+        dst = WriteRaw(dst, &keyLength, sizeof(keyLength));
+        dst = WriteRaw(dst, field.key.data(), keyLength);
+
+        if constexpr (std::is_same_v<T, std::string_view>)
+        {
+            const uint32_t length = static_cast<uint32_t>(field.value.size());
+            dst = WriteRaw(dst, &length, sizeof(length));
+            dst = WriteRaw(dst, field.value.data(), length);
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            const uint8_t flag = field.value ? 1 : 0;
+            dst = WriteRaw(dst, &flag, sizeof(flag));
+        }
+        else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
+        {
+            const int64_t ticks = field.value.time_since_epoch().count();
+            dst = WriteRaw(dst, &ticks, sizeof(ticks));
+        }
+        else if constexpr (!std::is_same_v<T, std::nullptr_t>)
+        {
+            dst = WriteRaw(dst, &field.value, sizeof(field.value));
+        }
+
+        return dst;
+    }
+
+    template<typename... Ts>
+    void FieldPayload::Encode(const Field<Ts>&... fields)
+    {
+        // Size everything up front so the payload is written with a single allocation at most
+        const size_t size = (EncodedSize(fields) + ... + 0);
+        char* dst = Allocate(size);
+        ((dst = Write(dst, fields)), ...);
+        m_count += static_cast<uint32_t>(sizeof...(Ts));
+    }
+
+    template<typename Fn>
+    void FieldPayload::ForEach(Fn&& fn) const
+    {
+        const char* cursor = Data();
+        const char* end = cursor + m_size;
+
+        auto read = [&cursor](void* dst, size_t size)
+        {
+            std::memcpy(dst, cursor, size);
+            cursor += size;
+        };
+
+        while (cursor < end)
+        {
+            uint8_t type = 0;
+            uint16_t keyLength = 0;
+            read(&type, sizeof(type));
+            read(&keyLength, sizeof(keyLength));
+
+            std::string_view key(cursor, keyLength);
+            cursor += keyLength;
+
+            switch (static_cast<FieldType>(type))
+            {
+            case FieldType::Null:
+            {
+                fn(key, FieldView(nullptr));
+                break;
+            }
+            case FieldType::String:
+            {
+                uint32_t length = 0;
+                read(&length, sizeof(length));
+                fn(key, FieldView(std::string_view(cursor, length)));
+                cursor += length;
+                break;
+            }
+            case FieldType::Int64:
+            {
+                int64_t value = 0;
+                read(&value, sizeof(value));
+                fn(key, FieldView(value));
+                break;
+            }
+            case FieldType::UInt64:
+            {
+                uint64_t value = 0;
+                read(&value, sizeof(value));
+                fn(key, FieldView(value));
+                break;
+            }
+            case FieldType::Double:
+            {
+                double value = 0.0;
+                read(&value, sizeof(value));
+                fn(key, FieldView(value));
+                break;
+            }
+            case FieldType::Bool:
+            {
+                uint8_t flag = 0;
+                read(&flag, sizeof(flag));
+                fn(key, FieldView(flag != 0));
+                break;
+            }
+            case FieldType::Timestamp:
+            {
+                int64_t ticks = 0;
+                read(&ticks, sizeof(ticks));
+                fn(key, FieldView(std::chrono::system_clock::time_point(std::chrono::system_clock::duration(ticks))));
+                break;
+            }
+            default:
+                return;
+            }
+        }
+    }
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Field.h"
+#include "Message.h"
+#include "StructuredData.h"
+
+namespace FlexLog
+{
+    /**
+    * @brief Read-only view over every field attached to a message.
+    *
+    * Formatters walk the thread context, the StructuredData map and the
+    * encoded field payload through one interface, so typed fields are decoded
+    * in place and context is merged at format time rather than being copied
+    * into an intermediate map. Message fields take precedence over context
+    * fields with the same key.
+    */
+    class FieldSet
+    {
+    public:
+        FieldSet(const StructuredData& data) : m_data(&data) {}
+        FieldSet(const Message& message) :
+            m_data(&message.structuredData),
+            m_payload(&message.fields),
+            m_context(message.context ? &message.context->GetFields() : nullptr)
+        {}
+
+        bool IsEmpty() const { return m_data->IsEmpty() && (!m_payload || m_payload->IsEmpty()) && (!m_context || m_context->IsEmpty()); }
+
+        // Upper bound; context fields shadowed by message fields are counted too
+        size_t Size() const
+        {
+            return m_data->GetFields().size() + (m_payload ? m_payload->Count() : 0) + (m_context ? m_context->GetFields().size() : 0);
+        }
+
+        // Invokes fn(std::string_view key, const FieldView& value) for every field
+        template<typename Fn>
+        void ForEach(Fn&& fn, bool sortKeys = false) const;
+
+    private:
+        // Payload keys, decoded and sorted once per ForEach so each context key costs a binary search
+        class PayloadKeys
+        {
+        public:
+            explicit PayloadKeys(const FieldPayload* payload);
+
+            bool Contains(std::string_view key) const { return std::binary_search(m_keys.begin(), m_keys.end(), key); }
+
+        private:
+            static constexpr size_t INLINE_KEYS = 16;
+
+            std::array<std::string_view, INLINE_KEYS> m_inline;
+            std::vector<std::string_view> m_overflow;
+            std::span<std::string_view> m_keys;
+        };
+
+        bool IsShadowed(std::string_view key, const PayloadKeys& payloadKeys) const;
+
+        const StructuredData* m_data = nullptr;
+        const FieldPayload* m_payload = nullptr;
+        const StructuredData* m_context = nullptr;
+    };
+
+    inline FieldSet::PayloadKeys::PayloadKeys(const FieldPayload* payload)
+    {
+        if (!payload || payload->IsEmpty())
+            return;
+
+        std::string_view* keys = m_inline.data();
+        if (payload->Count() > INLINE_KEYS)
+        {
+            m_overflow.resize(payload->Count());
+            keys = m_overflow.data();
+        }
+
+        size_t count = 0;
+        payload->ForEach([&](std::string_view key, const FieldView&) { keys[count++] = key; });
+
+        m_keys = std::span<std::string_view>(keys, count);
+        std::sort(m_keys.begin(), m_keys.end());
+    }
+
+    inline bool FieldSet::IsShadowed(std::string_view key, const PayloadKeys& payloadKeys) const
+    {
+        if (!m_data->IsEmpty() && m_data->HasField(key))
+            return true;
+
+        return payloadKeys.Contains(key);
+    }
+
+    template<typename Fn>
+    void FieldSet::ForEach(Fn&& fn, bool sortKeys) const
+    {
+        const PayloadKeys payloadKeys(m_context && !m_context->IsEmpty() ? m_payload : nullptr);
+
+        if (!sortKeys)
+        {
+            if (m_context)
+            {
+                for (const auto& [key, value] : m_context->GetFields())
+                {
+                    if (!IsShadowed(key, payloadKeys))
+                        fn(std::string_view(key), MakeFieldView(value));
+                }
+            }
+
+            for (const auto& [key, value] : m_data->GetFields())
+                fn(std::string_view(key), MakeFieldView(value));
+
+            if (m_payload)
+                m_payload->ForEach(fn);
+            return;
+        }
+
+        std::vector<std::pair<std::string_view, FieldView>> entries;
+        entries.reserve(Size());
+
+        if (m_context)
+        {
+            for (const auto& [key, value] : m_context->GetFields())
+            {
+                if (!IsShadowed(key, payloadKeys))
+                    entries.emplace_back(key, MakeFieldView(value));
+            }
+        }
+
+        for (const auto& [key, value] : m_data->GetFields())
+            entries.emplace_back(key, MakeFieldView(value));
+
+        if (m_payload)
+            m_payload->ForEach([&](std::string_view key, const FieldView& value) { entries.emplace_back(key, value); });
+
+        std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        for (const auto& [key, value] : entries)
+            fn(key, value);
+    }
+}
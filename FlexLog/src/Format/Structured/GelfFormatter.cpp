@@ -1,10 +1,7 @@
 #include "GelfFormatter.h"
 
-#include <sstream>
-#include <iomanip>
-#include <filesystem>
 #include <chrono>
-#include <cmath>
+#include <cstring>
 
 #include "Level.h"
 #include "Platform.h"
@@ -15,6 +12,8 @@ FlexLog::GelfFormatter::GelfFormatter(const Options& options) :
 {
     if (m_options.hostname.empty())
         m_options.hostname = GetHostname();
+
+    RebuildLayout();
 }
 
 std::string_view FlexLog::GelfFormatter::GetContentType() const
@@ -27,398 +26,183 @@ std::unique_ptr<FlexLog::StructuredFormatter> FlexLog::GelfFormatter::Clone() co
     return std::make_unique<GelfFormatter>(m_gelfOptions);
 }
 
-void FlexLog::GelfFormatter::EscapeString(std::ostream& os, std::string_view str) const
+void FlexLog::GelfFormatter::FormatMessageImpl(const Message& message, Buffer& out) const
 {
-    for (char c : str)
-    {
-        switch (c)
-        {
-            case '"':  os << "\\\""; break;
-            case '\\': os << "\\\\"; break;
-            case '\b': os << "\\b";  break;
-            case '\f': os << "\\f";  break;
-            case '\n': os << "\\n";  break;
-            case '\r': os << "\\r";  break;
-            case '\t': os << "\\t";  break;
-            default:
-                if (static_cast<unsigned char>(c) < 32)
-                {
-                    // Control characters
-                    os << "\\u"
-                        << std::hex << std::setw(4) << std::setfill('0')
-                        << static_cast<int>(c)
-                        << std::dec;
-                }
-                else
-                {
-                    os << c;
-                }
-                break;
-        }
-    }
+    const size_t start = out.Size();
+    JsonWriter writer = MakeJsonWriter(out);
+    WriteLayout(writer, message);
+
+    // Compress if requested, replacing the record in place
+    if (m_gelfOptions.useCompression)
+        CompressGelfMessage(out, start);
 }
 
-std::string FlexLog::GelfFormatter::FormatMessageImpl(const Message& message) const
+std::string FlexLog::GelfFormatter::FormatStructuredDataImpl(const FieldSet& fields) const
 {
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
-
-    // Format as GELF JSON
-    ss << "{" << nl;
-
-    // Required GELF fields
-    WriteIndent(ss, 1);
-    ss << "\"version\": \"" << m_gelfOptions.version << "\"," << nl;
+    Buffer buffer;
+    JsonWriter writer = MakeJsonWriter(buffer);
 
-    WriteIndent(ss, 1);
-    ss << "\"host\": \"" << m_options.hostname << "\"," << nl;
+    // Format fields with _ prefix as required by GELF
+    writer.BeginObject();
+    WriteAdditionalFields(writer, fields);
+    writer.EndObject();
 
-    // Short message is required - use the first line or truncate if needed
-    WriteIndent(ss, 1);
-    ss << "\"short_message\": \"";
+    return buffer.ToString();
+}
 
-    std::string shortMessage = std::string(message.message);
-    size_t newlinePos = shortMessage.find('\n');
-    if (newlinePos != std::string::npos)
-        shortMessage = shortMessage.substr(0, newlinePos);
+void FlexLog::GelfFormatter::WriteJsonTimestamp(JsonWriter& writer, const std::chrono::system_clock::time_point& timestamp) const
+{
+    // Convert to UNIX timestamp with millisecond precision
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()).count();
+    writer.Double(ms / 1000.0, 3);
+}
 
-    // GELF spec recommends short_message <= 250 chars
-    if (shortMessage.length() > 250)
-        shortMessage = shortMessage.substr(0, 247) + "...";
+void FlexLog::GelfFormatter::CompileLayout(LayoutBuilder& builder) const
+{
+    // Format as GELF JSON
+    builder.BeginObject();
 
-    EscapeString(ss, shortMessage);
-    ss << "\"," << nl;
+    // Required GELF fields
+    builder.Member("version", m_gelfOptions.version);
+    builder.Member("host", m_options.hostname);
 
-    // Full message if it differs from short message
-    if (message.message.length() != shortMessage.length())
-    {
-        WriteIndent(ss, 1);
-        ss << "\"full_message\": \"";
-        EscapeString(ss, message.message);
-        ss << "\"," << nl;
-    }
+    // short_message, plus full_message when it had to be shortened
+    builder.Dynamic(SHORT_MESSAGE_FIELD);
 
     // Timestamp in UNIX epoch with millisecond precision
     if (m_options.includeTimestamp)
-    {
-        WriteIndent(ss, 1);
-        auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(message.timestamp.time_since_epoch()).count() / 1000.0;
-        ss << "\"timestamp\": " << std::fixed << std::setprecision(3) << timestamp << "," << nl;
-    }
+        builder.Value("timestamp", LayoutField::Timestamp);
 
     // Level (convert to syslog scale)
     if (m_options.includeLevel)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"level\": " << ConvertLevelToSyslogSeverity(message.level) << "," << nl;
-    }
+        builder.Value("level", SYSLOG_LEVEL_FIELD);
 
     // Facility (optional in GELF)
     if (m_gelfOptions.useFacility)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"facility\": \"" << m_gelfOptions.facility << "\"," << nl;
-    }
+        builder.Member("facility", m_gelfOptions.facility);
 
     // Additional fields - must be prefixed with _ for GELF compatibility
 
     // Logger name
     if (m_options.includeLogger)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"_logger\": \"";
-        EscapeString(ss, message.name);
-        ss << "\"," << nl;
-    }
+        builder.Value("_logger", LayoutField::Logger);
 
     // Application info
-    WriteIndent(ss, 1);
-    ss << "\"_application\": \"" << m_options.applicationName << "\"," << nl;
-
-    WriteIndent(ss, 1);
-    ss << "\"_environment\": \"" << m_options.environment << "\"," << nl;
+    builder.Member("_application", m_options.applicationName);
+    builder.Member("_environment", m_options.environment);
 
     // Source location
     if (m_options.includeSourceLocation)
     {
-        WriteIndent(ss, 1);
-        ss << "\"_file\": \"" 
-            << std::filesystem::path(message.sourceLocation.file_name()).filename().string() 
-            << "\"," << nl;
-
-        WriteIndent(ss, 1);
-        ss << "\"_line\": " << message.sourceLocation.line() << "," << nl;
-
-        WriteIndent(ss, 1);
-        ss << "\"_function\": \"" << message.sourceLocation.function_name() << "\"," << nl;
+        builder.Value("_file", LayoutField::SourceFile);
+        builder.Value("_line", LayoutField::SourceLine);
+        builder.Value("_function", LayoutField::SourceFunction);
     }
 
     // Process info
     if (m_options.includeProcessInfo)
     {
-        WriteIndent(ss, 1);
-        ss << "\"_process_id\": \"" << GetProcessId() << "\"," << nl;
-
-        WriteIndent(ss, 1);
-        ss << "\"_process_name\": \"" << GetProcessName() << "\"," << nl;
+        builder.Value("_process_id", LayoutField::ProcessId);
+        builder.Value("_process_name", LayoutField::ProcessName);
     }
 
     // Thread ID
     if (m_options.includeThreadId)
     {
-        WriteIndent(ss, 1);
-        ss << "\"_thread_id\": \"" << GetThreadId() << "\"," << nl;
+        builder.Value("_thread_id", LayoutField::ThreadId);
+        builder.Dynamic(LayoutField::ThreadName, "_thread_name");
     }
 
     // Tags
-    if (!m_options.tags.empty())
-    {
-        WriteIndent(ss, 1);
-        ss << "\"_tags\": [" << nl;
+    builder.StringArray("_tags", m_options.tags);
 
-        for (size_t i = 0; i < m_options.tags.size(); ++i)
-        {
-            WriteIndent(ss, 2);
-            ss << "\"" << m_options.tags[i] << "\"";
-
-            if (i < m_options.tags.size() - 1)
-                ss << ",";
+    // Structured data fields
+    builder.Dynamic(LayoutField::Fields);
 
-            ss << nl;
-        }
+    for (const auto& [key, value] : m_options.userData)
+        builder.Member("_" + key, value);
 
-        WriteIndent(ss, 1);
-        ss << "]," << nl;
-    }
+    // Close the JSON object
+    builder.EndObject();
+}
 
-    // Structured data fields
-    if (!message.structuredData.IsEmpty())
+void FlexLog::GelfFormatter::WriteLayoutField(JsonWriter& writer, const Message& message, const FieldSet& fields, LayoutSlot slot, std::string_view renderedKey) const
+{
+    if (slot == SHORT_MESSAGE_FIELD)
     {
-        const auto& fields = message.structuredData.GetFields();
-
-        // Convert to _ prefixed fields as required by GELF
-        for (const auto& [key, value] : fields)
+        // Short message is required - use the first line or truncate if needed
+        std::string_view shortMessage = message.message;
+        size_t newlinePos = shortMessage.find('\n');
+        if (newlinePos != std::string_view::npos)
+            shortMessage = shortMessage.substr(0, newlinePos);
+
+        // GELF spec recommends short_message <= 250 chars
+        char truncated[MAX_SHORT_MESSAGE_LENGTH];
+        if (shortMessage.length() > MAX_SHORT_MESSAGE_LENGTH)
         {
-            std::string prefixedKey = "_" + key;
+            std::memcpy(truncated, shortMessage.data(), MAX_SHORT_MESSAGE_LENGTH - 3);
+            std::memcpy(truncated + MAX_SHORT_MESSAGE_LENGTH - 3, "...", 3);
+            shortMessage = std::string_view(truncated, MAX_SHORT_MESSAGE_LENGTH);
+        }
 
-            WriteIndent(ss, 1);
-            ss << "\"" << prefixedKey << "\": ";
+        writer.Member("short_message", shortMessage);
 
-            std::visit([&](auto&& arg)
-            {
-                using T = std::decay_t<decltype(arg)>;
-
-                if constexpr (std::is_same_v<T, std::nullptr_t>)
-                {
-                    ss << "null";
-                }
-                else if constexpr (std::is_same_v<T, std::string>)
-                {
-                    ss << "\"";
-                    EscapeString(ss, arg);
-                    ss << "\"";
-                }
-                else if constexpr (std::is_same_v<T, int64_t> || 
-                    std::is_same_v<T, uint64_t>)
-                {
-                    ss << arg;
-                }
-                else if constexpr (std::is_same_v<T, double>)
-                {
-                    ss << std::fixed << arg;
-                }
-                else if constexpr (std::is_same_v<T, bool>)
-                {
-                    ss << (arg ? "true" : "false");
-                }
-                else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
-                {
-                    // Convert to UNIX timestamp with millisecond precision
-                    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                        arg.time_since_epoch()).count();
-                    ss << std::fixed << std::setprecision(3) << (ms / 1000.0);
-                }
-                else if constexpr (std::is_same_v<T, std::vector<std::string>> || 
-                    std::is_same_v<T, std::vector<int64_t>>                    ||
-                    std::is_same_v<T, std::vector<double>>                     ||
-                    std::is_same_v<T, std::vector<bool>>)
-                {
-                    // Arrays need to be stringified for GELF
-                    ss << "\"[";
-
-                    for (size_t i = 0; i < arg.size(); ++i)
-                    {
-                        if (i > 0)
-                            ss << ", ";
-
-                        if constexpr (std::is_same_v<T, std::vector<std::string>>)
-                        {
-                            // Need to escape quotes within the string
-                            std::stringstream tmp;
-                            tmp << "\\\"";
-                            EscapeString(tmp, arg[i]);
-                            tmp << "\\\"";
-                            ss << tmp.str();
-                        }
-                        else if constexpr (std::is_same_v<T, std::vector<bool>>)
-                        {
-                            ss << (arg[i] ? "true" : "false");
-                        }
-                        else
-                        {
-                            ss << arg[i];
-                        }
-                    }
-
-                    ss << "]\"";
-                }
-            }, value);
-
-            ss << "," << nl;
-        }
+        // Full message if it differs from short message
+        if (message.message.length() != shortMessage.length())
+            writer.Member("full_message", message.message);
     }
-
-    for (auto it = m_options.userData.begin(); it != m_options.userData.end(); ++it)
+    else if (slot == SYSLOG_LEVEL_FIELD)
     {
-        std::string prefixedKey = "_" + it->first;
-
-        WriteIndent(ss, 1);
-        ss << "\"" << prefixedKey << "\": \"" << it->second << "\"";
-
-        if (std::next(it) != m_options.userData.end())
-            ss << ",";
-
-        ss << nl;
+        writer.Int(ConvertLevelToSyslogSeverity(message.level));
     }
-
-    // Close the JSON object
-    ss << "}";
-
-    std::string result = ss.str();
-
-    // Compress if requested
-    if (m_gelfOptions.useCompression)
-        return CompressGelfMessage(result);
-
-    return result;
-}
-
-std::string FlexLog::GelfFormatter::FormatStructuredDataImpl(const StructuredData& data) const
-{
-    if (data.IsEmpty())
-        return "{}";
-
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
-
-    ss << "{" << nl;
-
-    const auto& fields = data.GetFields();
-
-    // Sort keys if needed
-    std::vector<std::string> keys;
-    keys.reserve(fields.size());
-
-    for (const auto& [key, _] : fields)
+    else if (slot.field == LayoutField::Timestamp)
+    {
+        WriteJsonTimestamp(writer, message.timestamp);
+    }
+    else if (slot.field == LayoutField::Fields)
     {
-        keys.push_back(key);
+        if (!fields.IsEmpty())
+            WriteAdditionalFields(writer, fields);
     }
+    else
+    {
+        BaseStructuredFormatter::WriteLayoutField(writer, message, fields, slot, renderedKey);
+    }
+}
 
-    if (m_options.sortKeys)
-        std::sort(keys.begin(), keys.end());
+void FlexLog::GelfFormatter::WriteAdditionalFields(JsonWriter& writer, const FieldSet& fields) const
+{
+    const auto writeTimestamp = [this](JsonWriter& w, const auto& timestamp) { WriteJsonTimestamp(w, timestamp); };
 
-    // Format fields with _ prefix as required by GELF
-    for (size_t i = 0; i < keys.size(); ++i)
+    fields.ForEach([&](std::string_view key, const FieldView& value)
     {
-        const auto& key = keys[i];
-        const auto& value = fields.at(key);
-
         if (!m_options.includeNullValues && std::holds_alternative<std::nullptr_t>(value))
-            continue;
+            return;
 
-        std::string prefixedKey = "_" + key;
+        writer.Key("_", key);
 
-        WriteIndent(ss, 1);
-        ss << "\"" << prefixedKey << "\": ";
-
-        std::visit([&](auto&& arg)
+        std::visit([&](const auto& arg)
         {
             using T = std::decay_t<decltype(arg)>;
 
-            if constexpr (std::is_same_v<T, std::nullptr_t>)
-            {
-                ss << "null";
-            }
-            else if constexpr (std::is_same_v<T, std::string>)
-            {
-                ss << "\"";
-                EscapeString(ss, arg);
-                ss << "\"";
-            }
-            else if constexpr (std::is_same_v<T, int64_t> || 
-                std::is_same_v<T, uint64_t>)
+            if constexpr (std::is_same_v<T, std::span<const std::string>> || 
+                std::is_same_v<T, std::span<const int64_t>>                    ||
+                std::is_same_v<T, std::span<const double>>                     ||
+                std::is_same_v<T, BoolSpan>)
             {
-                ss << arg;
+                // Arrays need to be stringified for GELF
+                Buffer array;
+                JsonWriter arrayWriter(array);
+                arrayWriter.SetPrecision(writer.GetPrecision());
+                arrayWriter.Value(value, writeTimestamp);
+                writer.String(array.View());
             }
-            else if constexpr (std::is_same_v<T, double>)
+            else
             {
-                ss << std::fixed << arg;
-            }
-            else if constexpr (std::is_same_v<T, bool>)
-            {
-                ss << (arg ? "true" : "false");
-            }
-            else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
-            {
-                auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    arg.time_since_epoch()).count();
-                ss << std::fixed << std::setprecision(3) << (ms / 1000.0);
-            }
-            else if constexpr (std::is_same_v<T, std::vector<std::string>> || 
-                std::is_same_v<T, std::vector<int64_t>> ||
-                std::is_same_v<T, std::vector<double>> ||
-                std::is_same_v<T, std::vector<bool>>)
-            {
-                ss << "\"[";
-
-                for (size_t j = 0; j < arg.size(); ++j)
-                {
-                    if (j > 0)
-                        ss << ", ";
-
-                    if constexpr (std::is_same_v<T, std::vector<std::string>>)
-                    {
-                        std::stringstream tmp;
-                        tmp << "\\\"";
-                        EscapeString(tmp, arg[j]);
-                        tmp << "\\\"";
-                        ss << tmp.str();
-                    }
-                    else if constexpr (std::is_same_v<T, std::vector<bool>>)
-                    {
-                        ss << (arg[j] ? "true" : "false");
-                    }
-                    else
-                    {
-                        ss << arg[j];
-                    }
-                }
-
-                ss << "]\"";
+                writer.Value(value, writeTimestamp);
             }
         }, value);
-
-        if (i < keys.size() - 1)
-            ss << ",";
-
-        ss << nl;
-    }
-
-    ss << "}";
-
-    return ss.str();
+    }, m_options.sortKeys);
 }
 
 int FlexLog::GelfFormatter::ConvertLevelToSyslogSeverity(Level level) const
@@ -438,9 +222,9 @@ int FlexLog::GelfFormatter::ConvertLevelToSyslogSeverity(Level level) const
     }
 }
 
-std::string FlexLog::GelfFormatter::CompressGelfMessage(const std::string& message) const
+void FlexLog::GelfFormatter::CompressGelfMessage(Buffer& out, size_t start) const
 {
-    // TODO: use zlib to compress
-    // For now, we'll just return the original message
-    return message;
+    // Graylog tells compressed payloads from JSON by their first bytes, so a record that
+    // failed to compress is still accepted as is
+    Deflater::GetThreadDeflater().CompressInPlace(out, start, m_gelfOptions.compressionFormat, m_gelfOptions.compressionLevel);
 }
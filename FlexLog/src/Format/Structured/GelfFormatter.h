@@ -3,6 +3,7 @@
 #include <string>
 
 #include "BaseStructuredFormatter.h"
+#include "Core/Deflater.h"
 
 namespace FlexLog
 {
@@ -11,11 +12,15 @@ namespace FlexLog
     class GelfFormatter : public BaseStructuredFormatter
     {
     public:
+        static constexpr size_t MAX_SHORT_MESSAGE_LENGTH = 250;
+
         struct Options : public CommonFormatterOptions
         {
             // GELF-specific options
             std::string version = "1.1";  // GELF spec version (usually "1.1")
             bool useCompression = false;  // Whether to compress the output
+            CompressionFormat compressionFormat = CompressionFormat::Gzip;
+            int compressionLevel = Deflater::DEFAULT_LEVEL;
             bool useFacility = true;      // Whether to include facility field
             std::string facility = "flex_log-logger";  // Facility identifier
 
@@ -31,6 +36,13 @@ namespace FlexLog
                 return *this;
             }
 
+            Options& SetCompressionFormat(CompressionFormat format, int level = Deflater::DEFAULT_LEVEL)
+            {
+                compressionFormat = format;
+                compressionLevel = level;
+                return *this;
+            }
+
             Options& SetFacility(bool use, std::string_view fac = "flex_log-logger")
             {
                 useFacility = use;
@@ -42,19 +54,36 @@ namespace FlexLog
         explicit GelfFormatter(const Options& options = Options());
 
         std::string_view GetContentType() const override;
+
+        const Options& GetGelfOptions() const { return m_gelfOptions; }
         std::unique_ptr<StructuredFormatter> Clone() const override;
 
     protected:
-        void EscapeString(std::ostream& os, std::string_view str) const override;
-        std::string FormatMessageImpl(const Message& message) const override;
-        std::string FormatStructuredDataImpl(const StructuredData& data) const override;
+        void FormatMessageImpl(const Message& message, Buffer& out) const override;
+        void CompileLayout(LayoutBuilder& builder) const override;
+        void WriteLayoutField(JsonWriter& writer, const Message& message, const FieldSet& fields, LayoutSlot slot, std::string_view renderedKey) const override;
+        std::string FormatStructuredDataImpl(const FieldSet& fields) const override;
+        void WriteJsonTimestamp(JsonWriter& writer, const std::chrono::system_clock::time_point& timestamp) const override;
+
+        // Writes fields as _ prefixed GELF additional fields
+        void WriteAdditionalFields(JsonWriter& writer, const FieldSet& fields) const;
 
         // Converts level to GELF/Syslog severity (0-7)
         int ConvertLevelToSyslogSeverity(Level level) const;
 
-        // Implements GELF compression if needed
-        std::string CompressGelfMessage(const std::string& message) const;
+        // Compresses the record written from start onwards in place, with the calling thread's deflater
+        void CompressGelfMessage(Buffer& out, size_t start) const;
 
         Options m_gelfOptions;
+
+    private:
+        enum class GelfField : uint8_t
+        {
+            ShortMessage,
+            SyslogLevel
+        };
+
+        static constexpr LayoutSlot SHORT_MESSAGE_FIELD = MakeFormatterField(GelfField::ShortMessage);
+        static constexpr LayoutSlot SYSLOG_LEVEL_FIELD = MakeFormatterField(GelfField::SyslogLevel);
     };
 }
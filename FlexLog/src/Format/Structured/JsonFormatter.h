@@ -13,7 +13,7 @@ namespace FlexLog
             // JSON-specific options
             bool useFlatStructure = false;  // Whether to flatten nested structures
             bool useIsoTimestamps = true;   // Use ISO-8601 timestamps
-            int precision = 6;              // Decimal precision for floating point numbers
+            int precision = 6;              // Fraction digits for floating point numbers, or SHORTEST_PRECISION
 
             Options& SetFlatStructure(bool flat)
             {
@@ -40,13 +40,12 @@ namespace FlexLog
         std::unique_ptr<StructuredFormatter> Clone() const override;
 
     protected:
-        void EscapeString(std::ostream& os, std::string_view str) const override;
-        std::string FormatMessageImpl(const Message& message) const override;
-        std::string FormatStructuredDataImpl(const StructuredData& data) const override;
+        void FormatMessageImpl(const Message& message, Buffer& out) const override;
+        void CompileLayout(LayoutBuilder& builder) const override;
+        std::string FormatStructuredDataImpl(const FieldSet& fields) const override;
+        void WriteJsonTimestamp(JsonWriter& writer, const std::chrono::system_clock::time_point& timestamp) const override;
 
     private:
-        void WriteValue(std::ostream& os, const StructuredData::FieldValue& value) const;
-        std::string FormatTimestampAsJson(const std::chrono::system_clock::time_point& timestamp) const;
 
         Options m_jsonOptions;
     };
@@ -0,0 +1,209 @@
+#include "JsonWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "Core/NumberFormat.h"
+#include "Core/TextScan.h"
+
+namespace FlexLog::Internal
+{
+    // 0 = copy as is, otherwise the character that follows the backslash ('u' for \u00XX)
+    constexpr std::array<char, 256> JSON_ESCAPES = []
+    {
+        std::array<char, 256> table{};
+
+        for (int c = 0; c < 0x20; ++c)
+            table[c] = 'u';
+
+        table['"'] = '"';
+        table['\\'] = '\\';
+        table['\b'] = 'b';
+        table['\f'] = 'f';
+        table['\n'] = 'n';
+        table['\r'] = 'r';
+        table['\t'] = 't';
+
+        return table;
+    }();
+
+    constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+    // EscapeJson() for text already known to be valid UTF-8
+    void EscapeValidJson(Buffer& out, const char* data, size_t size)
+    {
+        size_t i = 0;
+
+        while (i < size)
+        {
+            // Copy the clean run found by the vector scan in one go
+            const size_t run = FindJsonEscape(data + i, size - i);
+            out.Append(data + i, run);
+            i += run;
+
+            if (i == size)
+                break;
+
+            const unsigned char c = static_cast<unsigned char>(data[i++]);
+            const char escape = JSON_ESCAPES[c];
+
+            if (escape == 'u')
+            {
+                char* dst = out.Extend(6);
+                std::memcpy(dst, "\\u00", 4);
+                dst[4] = HEX_DIGITS[c >> 4];
+                dst[5] = HEX_DIGITS[c & 0x0F];
+            }
+            else
+            {
+                char* dst = out.Extend(2);
+                dst[0] = '\\';
+                dst[1] = escape;
+            }
+        }
+    }
+
+    void EscapeJson(Buffer& out, std::string_view str)
+    {
+        ForEachValidUtf8Run(out, str, [&out](const char* data, size_t size) { EscapeValidJson(out, data, size); });
+    }
+}
+
+void FlexLog::JsonWriter::Key(std::string_view prefix, std::string_view key)
+{
+    BeginValue();
+
+    m_out.PushBack('"');
+    Internal::EscapeJson(m_out, prefix);
+    Internal::EscapeJson(m_out, key);
+    m_out.PushBack('"');
+    m_out.Append(m_keySeparator);
+
+    m_afterKey = true;
+}
+
+void FlexLog::JsonWriter::String(std::string_view value)
+{
+    BeginValue();
+
+    m_out.PushBack('"');
+    Internal::EscapeJson(m_out, value);
+    m_out.PushBack('"');
+}
+
+void FlexLog::JsonWriter::Int(int64_t value)
+{
+    BeginValue();
+    Internal::AppendInteger(m_out, value);
+}
+
+void FlexLog::JsonWriter::UInt(uint64_t value)
+{
+    BeginValue();
+    Internal::AppendInteger(m_out, value);
+}
+
+void FlexLog::JsonWriter::Double(double value, int precision)
+{
+    // JSON has no representation for NaN or infinity
+    if (!std::isfinite(value))
+    {
+        Null();
+        return;
+    }
+
+    BeginValue();
+    Internal::AppendDouble(m_out, value, precision);
+}
+
+void FlexLog::JsonWriter::Bool(bool value)
+{
+    BeginValue();
+    m_out.Append(value ? std::string_view("true") : std::string_view("false"));
+}
+
+void FlexLog::JsonWriter::Null()
+{
+    BeginValue();
+    m_out.Append("null");
+}
+
+void FlexLog::JsonWriter::Raw(std::string_view json)
+{
+    BeginValue();
+    m_out.Append(json);
+}
+
+void FlexLog::JsonWriter::BeginFragment(int depth)
+{
+    m_depth = depth;
+    if (m_depth > 0 && m_depth <= MAX_DEPTH)
+        m_hasElements[m_depth - 1] = true;
+    m_afterKey = true;
+}
+
+void FlexLog::JsonWriter::Fragment(std::string_view rendered)
+{
+    BeginValue();
+    m_out.Append(rendered);
+}
+
+void FlexLog::JsonWriter::KeyFragment(std::string_view rendered)
+{
+    BeginValue();
+    m_out.Append(rendered);
+    m_afterKey = true;
+}
+
+void FlexLog::JsonWriter::BeginValue()
+{
+    if (m_afterKey)
+    {
+        m_afterKey = false;
+        return;
+    }
+
+    if (m_depth == 0)
+        return;
+
+    bool& hasElements = m_hasElements[std::min(m_depth, MAX_DEPTH) - 1];
+    if (hasElements)
+        m_out.PushBack(',');
+    hasElements = true;
+
+    NewLine(m_depth);
+}
+
+void FlexLog::JsonWriter::BeginContainer(char open)
+{
+    BeginValue();
+    m_out.PushBack(open);
+
+    ++m_depth;
+    if (m_depth <= MAX_DEPTH)
+        m_hasElements[m_depth - 1] = false;
+}
+
+void FlexLog::JsonWriter::EndContainer(char close)
+{
+    if (m_depth == 0)
+        return;
+
+    const bool hasElements = m_hasElements[std::min(m_depth, MAX_DEPTH) - 1];
+    --m_depth;
+
+    if (hasElements)
+        NewLine(m_depth);
+
+    m_out.PushBack(close);
+}
+
+void FlexLog::JsonWriter::NewLine(int depth)
+{
+    if (!m_prettyPrint)
+        return;
+
+    m_out.PushBack('\n');
+    m_out.Append(static_cast<size_t>(depth * m_indentSize), ' ');
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+#include "Common.h"
+#include "Core/Buffer.h"
+#include "Core/NumberFormat.h"
+#include "Field.h"
+
+namespace FlexLog
+{
+    namespace Internal
+    {
+        // Appends str with JSON string escaping applied (no surrounding quotes). Bytes that aren't
+        // valid UTF-8 become U+FFFD, so a bad string can't make the whole document unparsable.
+        void EscapeJson(Buffer& out, std::string_view str);
+    }
+
+    /**
+    * @brief Streaming JSON writer that appends straight into a Buffer.
+    *
+    * The writer tracks nesting itself, so commas, key separators and pretty
+    * print indentation are emitted as values are written rather than patched
+    * up afterwards. Numbers go through std::to_chars and strings through a
+    * table-driven escaper; nothing is allocated beyond the buffer's own growth.
+    */
+    class JsonWriter
+    {
+    public:
+        static constexpr int MAX_DEPTH = 32;
+        static constexpr int DEFAULT_PRECISION = 6;
+        static constexpr int SHORTEST_PRECISION = FlexLog::SHORTEST_PRECISION;
+
+        explicit JsonWriter(Buffer& out, bool prettyPrint = false, int indentSize = 2, std::string_view keySeparator = ": ") :
+            m_out(out),
+            m_keySeparator(keySeparator),
+            m_indentSize(prettyPrint ? indentSize : 0),
+            m_prettyPrint(prettyPrint)
+        {}
+
+        void BeginObject() { BeginContainer('{'); }
+        void EndObject() { EndContainer('}'); }
+        void BeginArray() { BeginContainer('['); }
+        void EndArray() { EndContainer(']'); }
+
+        void Key(std::string_view key) { Key({}, key); }
+        void Key(std::string_view prefix, std::string_view key);
+
+        void String(std::string_view value);
+        void Int(int64_t value);
+        void UInt(uint64_t value);
+        void Double(double value) { Double(value, m_precision); }
+        void Double(double value, int precision);
+        void Bool(bool value);
+        void Null();
+
+        // Writes a value that is already valid JSON, such as a pre-rendered number
+        void Raw(std::string_view json);
+
+        // Continues at depth as if a key had just been written, so nothing is emitted before the next value.
+        // Used to pre-render members that Fragment() later splices into another writer at the same depth.
+        void BeginFragment(int depth);
+
+        // Appends members pre-rendered after BeginFragment(), emitting the separator in front of them
+        void Fragment(std::string_view rendered);
+
+        // Appends a key pre-rendered after BeginFragment(); a value must follow
+        void KeyFragment(std::string_view rendered);
+
+        template<typename T>
+        void Member(std::string_view key, const T& value);
+
+        // Writes a field value; time points are handed to writeTimestamp(JsonWriter&, time_point)
+        template<typename TimestampFn>
+        void Value(const FieldView& value, TimestampFn&& writeTimestamp);
+
+        // Fixed-point digits used by Double(double); SHORTEST_PRECISION writes the shortest round-trip form
+        void SetPrecision(int precision) { m_precision = precision; }
+        int GetPrecision() const { return m_precision; }
+
+        Buffer& GetBuffer() { return m_out; }
+
+    private:
+        void BeginValue();
+        void BeginContainer(char open);
+        void EndContainer(char close);
+        void NewLine(int depth);
+
+        Buffer& m_out;
+        std::string_view m_keySeparator;
+        int m_indentSize;
+        int m_precision = DEFAULT_PRECISION;
+        int m_depth = 0;
+        bool m_prettyPrint;
+        bool m_afterKey = false;
+        bool m_hasElements[MAX_DEPTH] = {};
+    };
+
+    template<typename T>
+    void JsonWriter::Member(std::string_view key, const T& value)
+    {
+        Key(key);
+
+        if constexpr (std::is_same_v<T, bool>)
+            Bool(value);
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            Int(value);
+        else if constexpr (std::is_integral_v<T>)
+            UInt(value);
+        else if constexpr (std::is_floating_point_v<T>)
+            Double(value);
+        else if constexpr (std::is_null_pointer_v<T>)
+            Null();
+        else
+            String(value);
+    }
+
+    template<typename TimestampFn>
+    void JsonWriter::Value(const FieldView& value, TimestampFn&& writeTimestamp)
+    {
+        std::visit([&](const auto& arg)
+        {
+            using T = std::decay_t<decltype(arg)>;
+
+            if constexpr (std::is_same_v<T, std::nullptr_t>)
+            {
+                Null();
+            }
+            else if constexpr (std::is_same_v<T, std::string_view>)
+            {
+                String(arg);
+            }
+            else if constexpr (std::is_same_v<T, int64_t>)
+            {
+                Int(arg);
+            }
+            else if constexpr (std::is_same_v<T, uint64_t>)
+            {
+                UInt(arg);
+            }
+            else if constexpr (std::is_same_v<T, double>)
+            {
+                Double(arg);
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                Bool(arg);
+            }
+            else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
+            {
+                writeTimestamp(*this, arg);
+            }
+            else
+            {
+                BeginArray();
+
+                for (size_t i = 0; i < arg.size(); ++i)
+                {
+                    if constexpr (std::is_same_v<T, std::span<const std::string>>)
+                        String(arg[i]);
+                    else if constexpr (std::is_same_v<T, std::span<const int64_t>>)
+                        Int(arg[i]);
+                    else if constexpr (std::is_same_v<T, std::span<const double>>)
+                        Double(arg[i]);
+                    else
+                        Bool(arg[i]);
+                }
+
+                EndArray();
+            }
+        }, value);
+    }
+}
@@ -0,0 +1,109 @@
+#include "LayoutPlan.h"
+
+FlexLog::LayoutBuilder::LayoutBuilder(bool prettyPrint, int indentSize) :
+    m_writer(m_scratch, prettyPrint, indentSize)
+{
+}
+
+void FlexLog::LayoutBuilder::BeginObject(std::string_view key)
+{
+    AddStep(LayoutPlan::StepKind::BeginObject, LayoutField::Timestamp, key);
+    ++m_depth;
+}
+
+void FlexLog::LayoutBuilder::EndObject()
+{
+    AddStep(LayoutPlan::StepKind::EndObject, LayoutField::Timestamp, {});
+    --m_depth;
+}
+
+void FlexLog::LayoutBuilder::BeginArray(std::string_view key)
+{
+    AddStep(LayoutPlan::StepKind::BeginArray, LayoutField::Timestamp, key);
+    ++m_depth;
+}
+
+void FlexLog::LayoutBuilder::EndArray()
+{
+    AddStep(LayoutPlan::StepKind::EndArray, LayoutField::Timestamp, {});
+    --m_depth;
+}
+
+void FlexLog::LayoutBuilder::RawMember(std::string_view key, std::string_view json)
+{
+    JsonWriter& writer = BeginMembers();
+    writer.Key(key);
+    writer.Raw(json);
+}
+
+void FlexLog::LayoutBuilder::StringArray(std::string_view key, const std::vector<std::string>& values)
+{
+    if (values.empty())
+        return;
+
+    JsonWriter& writer = BeginMembers();
+    writer.Key(key);
+    writer.BeginArray();
+    for (const auto& value : values)
+        writer.String(value);
+    writer.EndArray();
+}
+
+void FlexLog::LayoutBuilder::Value(std::string_view key, LayoutSlot slot)
+{
+    AddStep(LayoutPlan::StepKind::Value, slot, key);
+}
+
+void FlexLog::LayoutBuilder::Dynamic(LayoutSlot slot, std::string_view key)
+{
+    AddStep(LayoutPlan::StepKind::Dynamic, slot, key);
+}
+
+FlexLog::LayoutPlan FlexLog::LayoutBuilder::Build()
+{
+    EndMembers();
+    return std::move(m_plan);
+}
+
+FlexLog::JsonWriter& FlexLog::LayoutBuilder::BeginMembers()
+{
+    if (!m_inMembers)
+    {
+        m_scratch.Clear();
+        m_writer.BeginFragment(m_depth);
+        m_inMembers = true;
+    }
+
+    return m_writer;
+}
+
+void FlexLog::LayoutBuilder::EndMembers()
+{
+    if (!m_inMembers)
+        return;
+
+    m_inMembers = false;
+
+    if (m_scratch.IsEmpty())
+        return;
+
+    m_plan.m_steps.push_back({ LayoutPlan::StepKind::Members, LayoutField::Timestamp,
+        static_cast<uint32_t>(m_plan.m_bytes.size()), static_cast<uint32_t>(m_scratch.Size()) });
+    m_plan.m_bytes.append(m_scratch.View());
+}
+
+void FlexLog::LayoutBuilder::AddStep(LayoutPlan::StepKind kind, LayoutSlot slot, std::string_view key)
+{
+    EndMembers();
+
+    // Keys are rendered the way the writer would: quoted, escaped and followed by the separator
+    m_scratch.Clear();
+    if (!key.empty())
+    {
+        m_writer.BeginFragment(m_depth);
+        m_writer.Key(key);
+    }
+
+    m_plan.m_steps.push_back({ kind, slot, static_cast<uint32_t>(m_plan.m_bytes.size()), static_cast<uint32_t>(m_scratch.Size()) });
+    m_plan.m_bytes.append(m_scratch.View());
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "Core/Buffer.h"
+#include "JsonWriter.h"
+
+namespace FlexLog
+{
+    // Per-message values a layout leaves to the formatter
+    enum class LayoutField : uint8_t
+    {
+        Timestamp,
+        Message,
+        Logger,
+        Level,
+        LevelValue,
+        SourceFile,
+        SourceLine,
+        SourceFunction,
+        ThreadId,
+        ThreadName,         // Written under the step's key only if the producer thread was named
+        ProcessId,
+        ProcessIdNumber,    // Process ID as a JSON number rather than a string
+        ProcessName,
+        Fields,             // Structured data: nested under the step's key when non-empty, or flattened without one
+        Custom              // Known only to one formatter; LayoutSlot::custom says which
+    };
+
+    // A per-message value in a layout; custom holds a value of the formatter's own enum when field is Custom
+    struct LayoutSlot
+    {
+        constexpr LayoutSlot(LayoutField slotField) : field(slotField) {}
+
+        constexpr bool operator==(const LayoutSlot&) const = default;
+
+        LayoutField field;
+        uint8_t custom = 0;
+    };
+
+    // Slot for a value of a formatter's own field enum
+    template<typename E> requires std::is_enum_v<E>
+    constexpr LayoutSlot MakeFormatterField(E id)
+    {
+        LayoutSlot slot(LayoutField::Custom);
+        slot.custom = static_cast<uint8_t>(id);
+        return slot;
+    }
+
+    /**
+    * @brief A structured record layout compiled from formatter options.
+    *
+    * Constant members (application, host, tags, user data and the like) are
+    * rendered once, escaped and separated, and stored as byte runs; keys of
+    * per-message values are pre-rendered too. Running a plan replays those
+    * runs into a JsonWriter and calls back only for the dynamic values.
+    */
+    class LayoutPlan
+    {
+    public:
+        enum class StepKind : uint8_t
+        {
+            Members,        // Pre-rendered constant members or array elements
+            BeginObject,    // Optional pre-rendered key, then '{'
+            EndObject,
+            BeginArray,     // Optional pre-rendered key, then '['
+            EndArray,
+            Value,          // Pre-rendered key, then the field's value
+            Dynamic         // Zero or more members written by the formatter, which gets the pre-rendered key
+        };
+
+        struct Step
+        {
+            StepKind kind;
+            LayoutSlot slot;
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        // emit(LayoutSlot slot, std::string_view renderedKey) writes the dynamic parts
+        template <typename Emit>
+        void Run(JsonWriter& writer, Emit&& emit) const;
+
+        const std::vector<Step>& GetSteps() const { return m_steps; }
+        bool IsEmpty() const { return m_steps.empty(); }
+
+    private:
+        std::string_view GetBytes(const Step& step) const { return std::string_view(m_bytes.data() + step.offset, step.length); }
+
+        std::vector<Step> m_steps;
+        std::string m_bytes;
+
+        friend class LayoutBuilder;
+    };
+
+    /**
+    * @brief Records a layout the same way a JsonWriter would write it.
+    *
+    * Constant values are rendered immediately; consecutive constant members
+    * are merged into one byte run.
+    */
+    class LayoutBuilder
+    {
+    public:
+        LayoutBuilder(bool prettyPrint, int indentSize);
+
+        LayoutBuilder(const LayoutBuilder&) = delete;
+        LayoutBuilder& operator=(const LayoutBuilder&) = delete;
+
+        void BeginObject(std::string_view key = {});
+        void EndObject();
+        void BeginArray(std::string_view key = {});
+        void EndArray();
+
+        // Constant member, rendered now
+        template <typename T>
+        void Member(std::string_view key, const T& value);
+
+        // Constant member whose value is already valid JSON
+        void RawMember(std::string_view key, std::string_view json);
+
+        // Constant content written by write(JsonWriter&) at the current position, rendered now
+        template <typename Fn>
+        void Static(Fn&& write);
+
+        // Constant array of strings; skipped when empty
+        void StringArray(std::string_view key, const std::vector<std::string>& values);
+
+        // Member with a constant key and a per-message value
+        void Value(std::string_view key, LayoutSlot slot);
+
+        // Members the formatter writes per message, possibly none; key is rendered for it to use
+        void Dynamic(LayoutSlot slot, std::string_view key = {});
+
+        LayoutPlan Build();
+
+    private:
+        // Starts (or continues) a run of constant members at the current depth
+        JsonWriter& BeginMembers();
+        void EndMembers();
+
+        void AddStep(LayoutPlan::StepKind kind, LayoutSlot slot, std::string_view key);
+
+        Buffer m_scratch;
+        JsonWriter m_writer;
+        LayoutPlan m_plan;
+        int m_depth = 0;
+        bool m_inMembers = false;
+    };
+
+    template <typename Emit>
+    void LayoutPlan::Run(JsonWriter& writer, Emit&& emit) const
+    {
+        for (const Step& step : m_steps)
+        {
+            switch (step.kind)
+            {
+            case StepKind::Members:
+                writer.Fragment(GetBytes(step));
+                break;
+
+            case StepKind::BeginObject:
+            case StepKind::BeginArray:
+                if (step.length > 0)
+                    writer.KeyFragment(GetBytes(step));
+
+                if (step.kind == StepKind::BeginObject)
+                    writer.BeginObject();
+                else
+                    writer.BeginArray();
+                break;
+
+            case StepKind::EndObject:
+                writer.EndObject();
+                break;
+
+            case StepKind::EndArray:
+                writer.EndArray();
+                break;
+
+            case StepKind::Value:
+                writer.KeyFragment(GetBytes(step));
+                emit(step.slot, std::string_view());
+                break;
+
+            case StepKind::Dynamic:
+                emit(step.slot, GetBytes(step));
+                break;
+            }
+        }
+    }
+
+    template <typename T>
+    void LayoutBuilder::Member(std::string_view key, const T& value)
+    {
+        BeginMembers().Member(key, value);
+    }
+
+    template <typename Fn>
+    void LayoutBuilder::Static(Fn&& write)
+    {
+        write(BeginMembers());
+    }
+}
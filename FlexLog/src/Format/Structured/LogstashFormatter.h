@@ -32,9 +32,9 @@ namespace FlexLog
         std::unique_ptr<StructuredFormatter> Clone() const override;
 
     protected:
-        void EscapeString(std::ostream& os, std::string_view str) const override;
-        std::string FormatMessageImpl(const Message& message) const override;
-        std::string FormatStructuredDataImpl(const StructuredData& data) const override;
+        void FormatMessageImpl(const Message& message, Buffer& out) const override;
+        void CompileLayout(LayoutBuilder& builder) const override;
+        std::string FormatStructuredDataImpl(const FieldSet& fields) const override;
 
         Options m_logstashOptions;
     };
@@ -0,0 +1,197 @@
+#include "MessagePackFormatter.h"
+
+#include "Core/NumberFormat.h"
+#include "Core/ProcessInfo.h"
+#include "Core/ThreadInfo.h"
+#include "Level.h"
+
+FlexLog::MessagePackFormatter::MessagePackFormatter(const Options& options) :
+    BaseStructuredFormatter(options),
+    m_msgpackOptions(options)
+{
+    RebuildLayout();
+}
+
+std::string_view FlexLog::MessagePackFormatter::GetContentType() const
+{
+    return "application/msgpack";
+}
+
+std::unique_ptr<FlexLog::StructuredFormatter> FlexLog::MessagePackFormatter::Clone() const
+{
+    return std::make_unique<MessagePackFormatter>(m_msgpackOptions);
+}
+
+void FlexLog::MessagePackFormatter::FormatMessageImpl(const Message& message, Buffer& out) const
+{
+    MessagePackWriter writer(out);
+    const size_t root = writer.BeginMap();
+    uint32_t count = m_staticCount;
+
+    if (m_options.includeTimestamp)
+    {
+        writer.String("timestamp");
+        WriteTimestamp(writer, message.timestamp);
+        ++count;
+    }
+
+    if (m_options.includeMessage)
+    {
+        writer.Member("message", message.message);
+        ++count;
+    }
+
+    if (m_options.includeLogger)
+    {
+        writer.Member("logger", message.name);
+        ++count;
+    }
+
+    if (m_options.includeLevel)
+    {
+        writer.Member("level", LevelToString(message.level));
+        writer.Member("level_value", static_cast<int64_t>(message.level));
+        count += 2;
+    }
+
+    if (m_options.includeSourceLocation)
+    {
+        if (m_msgpackOptions.useFlatStructure)
+        {
+            count += 3;
+        }
+        else
+        {
+            writer.String("location");
+            writer.MapHeader(3);
+            ++count;
+        }
+
+        writer.Member("file", GetSourceFileName(message.sourceLocation));
+        writer.Member("line", static_cast<uint64_t>(message.sourceLocation.line()));
+        writer.Member("function", std::string_view(message.sourceLocation.function_name()));
+    }
+
+    // Written per message so a forked child reports its own process
+    if (m_options.includeProcessInfo)
+    {
+        const ProcessInfo::Snapshot& process = ProcessInfo::Get();
+
+        if (m_msgpackOptions.useFlatStructure)
+        {
+            writer.Member("process_id", process.pidText);
+            writer.Member("process_name", process.name);
+            count += 2;
+        }
+        else
+        {
+            writer.String("process");
+            writer.MapHeader(2);
+            writer.Member("id", process.pidText);
+            writer.Member("name", process.name);
+            ++count;
+        }
+    }
+
+    if (m_options.includeThreadId)
+    {
+        writer.Member("thread_id", NumberText(message.threadId).View());
+        ++count;
+
+        if (!message.threadName.empty())
+        {
+            writer.Member("thread_name", message.threadName);
+            ++count;
+        }
+    }
+
+    const FieldSet fields(message);
+    if (!fields.IsEmpty())
+    {
+        if (m_msgpackOptions.useFlatStructure)
+        {
+            count += WriteFields(writer, fields);
+        }
+        else
+        {
+            writer.String("data");
+            const size_t data = writer.BeginMap();
+            writer.EndMap(data, WriteFields(writer, fields));
+            ++count;
+        }
+    }
+
+    out.Append(m_staticMembers);
+    writer.EndMap(root, count);
+}
+
+std::string FlexLog::MessagePackFormatter::FormatStructuredDataImpl(const FieldSet& fields) const
+{
+    Buffer buffer;
+    MessagePackWriter writer(buffer);
+
+    const size_t map = writer.BeginMap();
+    writer.EndMap(map, WriteFields(writer, fields));
+
+    return buffer.ToString();
+}
+
+void FlexLog::MessagePackFormatter::RebuildLayout()
+{
+    BaseStructuredFormatter::RebuildLayout();
+
+    Buffer buffer;
+    MessagePackWriter writer(buffer);
+    uint32_t count = 3;
+
+    // Application information
+    writer.Member("application", m_options.applicationName);
+    writer.Member("environment", m_options.environment);
+    writer.Member("host", m_options.hostname);
+
+    if (!m_options.tags.empty())
+    {
+        writer.String("tags");
+        writer.ArrayHeader(static_cast<uint32_t>(m_options.tags.size()));
+        for (const std::string& tag : m_options.tags)
+            writer.String(tag);
+        ++count;
+    }
+
+    for (const auto& [key, value] : m_options.userData)
+        writer.Member(key, value);
+    count += static_cast<uint32_t>(m_options.userData.size());
+
+    m_staticMembers = buffer.ToString();
+    m_staticCount = count;
+}
+
+void FlexLog::MessagePackFormatter::WriteTimestamp(MessagePackWriter& writer, const std::chrono::system_clock::time_point& timestamp) const
+{
+    if (m_msgpackOptions.useTimestampExtension)
+    {
+        writer.Timestamp(timestamp);
+        return;
+    }
+
+    Buffer text;
+    FormatTimestampTo(text, timestamp);
+    writer.String(text.View());
+}
+
+uint32_t FlexLog::MessagePackFormatter::WriteFields(MessagePackWriter& writer, const FieldSet& fields) const
+{
+    uint32_t count = 0;
+
+    fields.ForEach([&](std::string_view key, const FieldView& value)
+    {
+        if (!m_options.includeNullValues && std::holds_alternative<std::nullptr_t>(value))
+            return;
+
+        writer.String(key);
+        writer.Value(value, [this](MessagePackWriter& w, const auto& timestamp) { WriteTimestamp(w, timestamp); });
+        ++count;
+    }, m_options.sortKeys);
+
+    return count;
+}
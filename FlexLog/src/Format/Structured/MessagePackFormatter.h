@@ -0,0 +1,61 @@
+#pragma once
+
+#include "BaseStructuredFormatter.h"
+#include "MessagePackWriter.h"
+#include <string>
+
+namespace FlexLog
+{
+    /**
+    * @brief Structured output as MessagePack.
+    *
+    * Records carry the members JsonFormatter writes, as one map per message.
+    * Field values keep their native types: integers and doubles as numbers,
+    * vectors as arrays of their element type and time points as timestamp
+    * extensions. Members that don't change between messages are encoded once,
+    * when the options are set.
+    */
+    class MessagePackFormatter : public BaseStructuredFormatter
+    {
+    public:
+        struct Options : public CommonFormatterOptions
+        {
+            bool useFlatStructure = false;      // Write location and fields at the root rather than in nested maps
+            bool useTimestampExtension = true;  // Timestamp extension type rather than timeFormat strings
+
+            Options& SetFlatStructure(bool flat)
+            {
+                useFlatStructure = flat;
+                return *this;
+            }
+
+            Options& SetTimestampExtension(bool enable)
+            {
+                useTimestampExtension = enable;
+                return *this;
+            }
+        };
+
+        explicit MessagePackFormatter(const Options& options = Options());
+
+        std::string_view GetContentType() const override;
+        std::unique_ptr<StructuredFormatter> Clone() const override;
+
+    protected:
+        void FormatMessageImpl(const Message& message, Buffer& out) const override;
+        std::string FormatStructuredDataImpl(const FieldSet& fields) const override;
+        void RebuildLayout() override;
+
+    private:
+        void WriteTimestamp(MessagePackWriter& writer, const std::chrono::system_clock::time_point& timestamp) const;
+
+        // Writes fields as members of the current map, honoring includeNullValues and sortKeys; returns how many were written
+        uint32_t WriteFields(MessagePackWriter& writer, const FieldSet& fields) const;
+
+        Options m_msgpackOptions;
+
+        // Pre-encoded members that are the same for every message
+        std::string m_staticMembers;
+        uint32_t m_staticCount = 0;
+    };
+}
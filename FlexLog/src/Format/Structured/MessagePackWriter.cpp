@@ -0,0 +1,211 @@
+#include "MessagePackWriter.h"
+
+#include <bit>
+#include <cstring>
+
+namespace FlexLog::Internal
+{
+    // BeginMap() reserves a map16 header, the largest form short of map32
+    constexpr size_t RESERVED_MAP_HEADER = 3;
+
+    constexpr int64_t NANOS_PER_SECOND = 1'000'000'000;
+}
+
+void FlexLog::MessagePackWriter::MapHeader(uint32_t count)
+{
+    ContainerHeader(0x80, 0xde, 0xdf, count);
+}
+
+void FlexLog::MessagePackWriter::ArrayHeader(uint32_t count)
+{
+    ContainerHeader(0x90, 0xdc, 0xdd, count);
+}
+
+size_t FlexLog::MessagePackWriter::BeginMap()
+{
+    const size_t mark = m_out.Size();
+    m_out.Extend(Internal::RESERVED_MAP_HEADER);
+    return mark;
+}
+
+void FlexLog::MessagePackWriter::EndMap(size_t mark, uint32_t count)
+{
+    char* header = m_out.Data() + mark;
+
+    if (count <= 15)
+    {
+        header[0] = static_cast<char>(0x80 | count);
+        m_out.Erase(mark + 1, Internal::RESERVED_MAP_HEADER - 1);
+    }
+    else if (count <= UINT16_MAX)
+    {
+        header[0] = '\xde';
+        header[1] = static_cast<char>(count >> 8);
+        header[2] = static_cast<char>(count);
+    }
+    else
+    {
+        // map32 needs two more bytes than were reserved
+        const size_t bodyStart = mark + Internal::RESERVED_MAP_HEADER;
+        const size_t bodySize = m_out.Size() - bodyStart;
+        m_out.Extend(2);
+
+        header = m_out.Data() + mark;
+        std::memmove(header + 5, header + Internal::RESERVED_MAP_HEADER, bodySize);
+        header[0] = '\xdf';
+        for (int i = 0; i < 4; ++i)
+            header[1 + i] = static_cast<char>(count >> (8 * (3 - i)));
+    }
+}
+
+void FlexLog::MessagePackWriter::String(std::string_view value)
+{
+    const size_t size = value.size();
+
+    if (size <= 31)
+    {
+        m_out.PushBack(static_cast<char>(0xa0 | size));
+    }
+    else if (size <= UINT8_MAX)
+    {
+        m_out.PushBack('\xd9');
+        BigEndian(static_cast<uint8_t>(size));
+    }
+    else if (size <= UINT16_MAX)
+    {
+        m_out.PushBack('\xda');
+        BigEndian(static_cast<uint16_t>(size));
+    }
+    else
+    {
+        m_out.PushBack('\xdb');
+        BigEndian(static_cast<uint32_t>(size));
+    }
+
+    m_out.Append(value);
+}
+
+void FlexLog::MessagePackWriter::Int(int64_t value)
+{
+    if (value >= 0)
+    {
+        UInt(static_cast<uint64_t>(value));
+        return;
+    }
+
+    if (value >= -32)
+    {
+        m_out.PushBack(static_cast<char>(value));
+    }
+    else if (value >= INT8_MIN)
+    {
+        m_out.PushBack('\xd0');
+        BigEndian(static_cast<int8_t>(value));
+    }
+    else if (value >= INT16_MIN)
+    {
+        m_out.PushBack('\xd1');
+        BigEndian(static_cast<int16_t>(value));
+    }
+    else if (value >= INT32_MIN)
+    {
+        m_out.PushBack('\xd2');
+        BigEndian(static_cast<int32_t>(value));
+    }
+    else
+    {
+        m_out.PushBack('\xd3');
+        BigEndian(value);
+    }
+}
+
+void FlexLog::MessagePackWriter::UInt(uint64_t value)
+{
+    if (value <= 0x7f)
+    {
+        m_out.PushBack(static_cast<char>(value));
+    }
+    else if (value <= UINT8_MAX)
+    {
+        m_out.PushBack('\xcc');
+        BigEndian(static_cast<uint8_t>(value));
+    }
+    else if (value <= UINT16_MAX)
+    {
+        m_out.PushBack('\xcd');
+        BigEndian(static_cast<uint16_t>(value));
+    }
+    else if (value <= UINT32_MAX)
+    {
+        m_out.PushBack('\xce');
+        BigEndian(static_cast<uint32_t>(value));
+    }
+    else
+    {
+        m_out.PushBack('\xcf');
+        BigEndian(value);
+    }
+}
+
+void FlexLog::MessagePackWriter::Double(double value)
+{
+    m_out.PushBack('\xcb');
+    BigEndian(std::bit_cast<uint64_t>(value));
+}
+
+void FlexLog::MessagePackWriter::Timestamp(std::chrono::system_clock::time_point value)
+{
+    const int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(value.time_since_epoch()).count();
+
+    // Floor division, so instants before the epoch keep a non-negative nanosecond part
+    int64_t seconds = nanos / Internal::NANOS_PER_SECOND;
+    int64_t fraction = nanos % Internal::NANOS_PER_SECOND;
+    if (fraction < 0)
+    {
+        --seconds;
+        fraction += Internal::NANOS_PER_SECOND;
+    }
+
+    if (seconds >= 0 && (seconds >> 34) == 0)
+    {
+        if (fraction == 0 && seconds <= UINT32_MAX)
+        {
+            // timestamp 32: fixext 4
+            m_out.PushBack('\xd6');
+            m_out.PushBack(static_cast<char>(TIMESTAMP_EXTENSION));
+            BigEndian(static_cast<uint32_t>(seconds));
+            return;
+        }
+
+        // timestamp 64: fixext 8, 30-bit nanoseconds over 34-bit seconds
+        m_out.PushBack('\xd7');
+        m_out.PushBack(static_cast<char>(TIMESTAMP_EXTENSION));
+        BigEndian((static_cast<uint64_t>(fraction) << 34) | static_cast<uint64_t>(seconds));
+        return;
+    }
+
+    // timestamp 96: ext 8 carrying 32-bit nanoseconds and signed 64-bit seconds
+    m_out.PushBack('\xc7');
+    m_out.PushBack(12);
+    m_out.PushBack(static_cast<char>(TIMESTAMP_EXTENSION));
+    BigEndian(static_cast<uint32_t>(fraction));
+    BigEndian(seconds);
+}
+
+void FlexLog::MessagePackWriter::ContainerHeader(uint8_t fixBase, uint8_t type16, uint8_t type32, uint32_t count)
+{
+    if (count <= 15)
+    {
+        m_out.PushBack(static_cast<char>(fixBase | count));
+    }
+    else if (count <= UINT16_MAX)
+    {
+        m_out.PushBack(static_cast<char>(type16));
+        BigEndian(static_cast<uint16_t>(count));
+    }
+    else
+    {
+        m_out.PushBack(static_cast<char>(type32));
+        BigEndian(count);
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+#include "Common.h"
+#include "Core/Buffer.h"
+#include "Field.h"
+
+namespace FlexLog
+{
+    /**
+    * @brief Streaming MessagePack writer that appends straight into a Buffer.
+    *
+    * Every value takes the smallest encoding the format allows. Strings are
+    * copied as is, without escaping. Maps whose size isn't known up front are
+    * opened with BeginMap() and their header is patched by EndMap().
+    */
+    class MessagePackWriter
+    {
+    public:
+        // Extension type the MessagePack spec reserves for timestamps
+        static constexpr int8_t TIMESTAMP_EXTENSION = -1;
+
+        explicit MessagePackWriter(Buffer& out) : m_out(out) {}
+
+        void MapHeader(uint32_t count);
+        void ArrayHeader(uint32_t count);
+
+        // Opens a map of unknown size; pass the mark and the final count to EndMap()
+        size_t BeginMap();
+        void EndMap(size_t mark, uint32_t count);
+
+        void String(std::string_view value);
+        void Int(int64_t value);
+        void UInt(uint64_t value);
+        void Double(double value);
+        void Bool(bool value) { m_out.PushBack(value ? '\xc3' : '\xc2'); }
+        void Nil() { m_out.PushBack('\xc0'); }
+
+        // Timestamp extension, in its 32, 64 or 96-bit form depending on range and precision
+        void Timestamp(std::chrono::system_clock::time_point value);
+
+        template<typename T>
+        void Member(std::string_view key, const T& value);
+
+        // Writes a field value; time points are handed to writeTimestamp(MessagePackWriter&, time_point)
+        template<typename TimestampFn>
+        void Value(const FieldView& value, TimestampFn&& writeTimestamp);
+
+        Buffer& GetBuffer() { return m_out; }
+
+    private:
+        template<typename T>
+        void BigEndian(T value)
+        {
+            char* dst = m_out.Extend(sizeof(T));
+            for (size_t i = 0; i < sizeof(T); ++i)
+                dst[i] = static_cast<char>(static_cast<uint64_t>(value) >> (8 * (sizeof(T) - 1 - i)));
+        }
+
+        // fixmap/fixarray for up to 15 entries, then the 16 and 32-bit forms
+        void ContainerHeader(uint8_t fixBase, uint8_t type16, uint8_t type32, uint32_t count);
+
+        Buffer& m_out;
+    };
+
+    template<typename T>
+    void MessagePackWriter::Member(std::string_view key, const T& value)
+    {
+        String(key);
+
+        if constexpr (std::is_same_v<T, bool>)
+            Bool(value);
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            Int(value);
+        else if constexpr (std::is_integral_v<T>)
+            UInt(value);
+        else if constexpr (std::is_floating_point_v<T>)
+            Double(value);
+        else if constexpr (std::is_null_pointer_v<T>)
+            Nil();
+        else
+            String(value);
+    }
+
+    template<typename TimestampFn>
+    void MessagePackWriter::Value(const FieldView& value, TimestampFn&& writeTimestamp)
+    {
+        std::visit([&](const auto& arg)
+        {
+            using T = std::decay_t<decltype(arg)>;
+
+            if constexpr (std::is_same_v<T, std::nullptr_t>)
+            {
+                Nil();
+            }
+            else if constexpr (std::is_same_v<T, std::string_view>)
+            {
+                String(arg);
+            }
+            else if constexpr (std::is_same_v<T, int64_t>)
+            {
+                Int(arg);
+            }
+            else if constexpr (std::is_same_v<T, uint64_t>)
+            {
+                UInt(arg);
+            }
+            else if constexpr (std::is_same_v<T, double>)
+            {
+                Double(arg);
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                Bool(arg);
+            }
+            else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
+            {
+                writeTimestamp(*this, arg);
+            }
+            else
+            {
+                ArrayHeader(static_cast<uint32_t>(arg.size()));
+
+                for (size_t i = 0; i < arg.size(); ++i)
+                {
+                    if constexpr (std::is_same_v<T, std::span<const std::string>>)
+                        String(arg[i]);
+                    else if constexpr (std::is_same_v<T, std::span<const int64_t>>)
+                        Int(arg[i]);
+                    else if constexpr (std::is_same_v<T, std::span<const double>>)
+                        Double(arg[i]);
+                    else
+                        Bool(arg[i]);
+                }
+            }
+        }, value);
+    }
+}
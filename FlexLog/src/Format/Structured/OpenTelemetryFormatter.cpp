@@ -1,24 +1,89 @@
 #include "OpenTelemetryFormatter.h"
 
-#include <sstream>
-#include <iomanip>
-#include <filesystem>
 #include <chrono>
-#include <random>
+#include <cstring>
 
+#include "Core/NumberFormat.h"
+#include "Core/ProcessInfo.h"
+#include "Core/ThreadInfo.h"
+#include "Format/TimestampCache.h"
 #include "Level.h"
 
+namespace FlexLog::Internal
+{
+    // Field numbers from opentelemetry/proto/logs/v1/logs.proto and its common and resource protos
+    namespace Otlp
+    {
+        constexpr uint32_t LOGS_DATA_RESOURCE_LOGS = 1;
+
+        constexpr uint32_t RESOURCE_LOGS_RESOURCE = 1;
+        constexpr uint32_t RESOURCE_LOGS_SCOPE_LOGS = 2;
+        constexpr uint32_t RESOURCE_LOGS_SCHEMA_URL = 3;
+        constexpr uint32_t RESOURCE_ATTRIBUTES = 1;
+
+        constexpr uint32_t SCOPE_LOGS_SCOPE = 1;
+        constexpr uint32_t SCOPE_LOGS_LOG_RECORDS = 2;
+        constexpr uint32_t SCOPE_NAME = 1;
+        constexpr uint32_t SCOPE_VERSION = 2;
+
+        constexpr uint32_t LOG_RECORD_TIME_UNIX_NANO = 1;
+        constexpr uint32_t LOG_RECORD_SEVERITY_NUMBER = 2;
+        constexpr uint32_t LOG_RECORD_SEVERITY_TEXT = 3;
+        constexpr uint32_t LOG_RECORD_BODY = 5;
+        constexpr uint32_t LOG_RECORD_ATTRIBUTES = 6;
+        constexpr uint32_t LOG_RECORD_TRACE_ID = 9;
+        constexpr uint32_t LOG_RECORD_SPAN_ID = 10;
+        constexpr uint32_t LOG_RECORD_OBSERVED_TIME_UNIX_NANO = 11;
+
+        constexpr uint32_t KEY_VALUE_KEY = 1;
+        constexpr uint32_t KEY_VALUE_VALUE = 2;
+
+        constexpr uint32_t ANY_VALUE_STRING = 1;
+        constexpr uint32_t ANY_VALUE_BOOL = 2;
+        constexpr uint32_t ANY_VALUE_INT = 3;
+        constexpr uint32_t ANY_VALUE_DOUBLE = 4;
+        constexpr uint32_t ANY_VALUE_ARRAY = 5;
+        constexpr uint32_t ARRAY_VALUE_VALUES = 1;
+    }
+
+    // Writes a KeyValue whose AnyValue members are written by writeValue(ProtobufWriter&)
+    template<typename WriteValue>
+    void WriteOtlpAttribute(ProtobufWriter& writer, uint32_t field, std::string_view key, WriteValue&& writeValue)
+    {
+        const size_t attribute = writer.BeginMessage(field);
+        writer.String(Otlp::KEY_VALUE_KEY, key);
+
+        const size_t value = writer.BeginMessage(Otlp::KEY_VALUE_VALUE);
+        writeValue(writer);
+        writer.EndMessage(value);
+
+        writer.EndMessage(attribute);
+    }
+
+    void WriteOtlpStringAttribute(ProtobufWriter& writer, uint32_t field, std::string_view key, std::string_view value)
+    {
+        WriteOtlpAttribute(writer, field, key, [value](ProtobufWriter& w) { w.String(Otlp::ANY_VALUE_STRING, value); });
+    }
+
+    void WriteOtlpIntAttribute(ProtobufWriter& writer, uint32_t field, std::string_view key, int64_t value)
+    {
+        WriteOtlpAttribute(writer, field, key, [value](ProtobufWriter& w) { w.Int(Otlp::ANY_VALUE_INT, value); });
+    }
+}
+
 FlexLog::OpenTelemetryFormatter::OpenTelemetryFormatter(const Options& options) :
     BaseStructuredFormatter(options),
     m_otelOptions(options)
 {
     if (m_options.hostname.empty())
         m_options.hostname = GetHostname();
+
+    RebuildLayout();
 }
 
 std::string_view FlexLog::OpenTelemetryFormatter::GetContentType() const
 {
-    return "application/json";
+    return m_otelOptions.useProtobuf ? "application/x-protobuf" : "application/json";
 }
 
 std::unique_ptr<FlexLog::StructuredFormatter> FlexLog::OpenTelemetryFormatter::Clone() const
@@ -26,486 +91,603 @@ std::unique_ptr<FlexLog::StructuredFormatter> FlexLog::OpenTelemetryFormatter::C
     return std::make_unique<OpenTelemetryFormatter>(m_otelOptions);
 }
 
-void FlexLog::OpenTelemetryFormatter::EscapeString(std::ostream& os, std::string_view str) const
+void FlexLog::OpenTelemetryFormatter::FormatBatch(std::span<const Message* const> messages, Buffer& out) const
 {
-    for (char c : str)
+    if (!m_otelOptions.useProtobuf)
     {
-        switch (c)
+        for (const Message* message : messages)
         {
-            case '"':  os << "\\\""; break;
-            case '\\': os << "\\\\"; break;
-            case '\b': os << "\\b";  break;
-            case '\f': os << "\\f";  break;
-            case '\n': os << "\\n";  break;
-            case '\r': os << "\\r";  break;
-            case '\t': os << "\\t";  break;
-            default:
-                if (static_cast<unsigned char>(c) < 32)
-                {
-                    // Control characters
-                    os << "\\u"
-                        << std::hex << std::setw(4) << std::setfill('0')
-                        << static_cast<int>(c)
-                        << std::dec;
-                }
-                else
-                {
-                    os << c;
-                }
-                break;
+            JsonWriter writer = MakeJsonWriter(out);
+            WriteLayout(writer, *message);
+            out.PushBack('\n');
         }
+        return;
     }
+
+    if (messages.empty())
+        return;
+
+    // Concatenated LogsData messages parse as one, so single records can be appended back to back too
+    ProtobufWriter writer(out);
+    const size_t resourceLogs = writer.BeginMessage(Internal::Otlp::LOGS_DATA_RESOURCE_LOGS);
+    writer.Raw(m_protobufResource);
+
+    const size_t scopeLogs = writer.BeginMessage(Internal::Otlp::RESOURCE_LOGS_SCOPE_LOGS);
+    writer.Raw(m_protobufScope);
+
+    for (const Message* message : messages)
+        WriteProtobufRecord(writer, *message);
+
+    writer.EndMessage(scopeLogs);
+    writer.Raw(m_protobufSchemaUrl);
+    writer.EndMessage(resourceLogs);
 }
 
-std::string FlexLog::OpenTelemetryFormatter::FormatMessageImpl(const Message& message) const
+void FlexLog::OpenTelemetryFormatter::FormatMessageImpl(const Message& message, Buffer& out) const
 {
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
+    if (m_otelOptions.useProtobuf)
+    {
+        const Message* single = &message;
+        FormatBatch(std::span<const Message* const>(&single, 1), out);
+        return;
+    }
 
-    // Format as OpenTelemetry JSON
-    ss << "{" << nl;
+    JsonWriter writer = MakeJsonWriter(out);
+    WriteLayout(writer, message);
+}
 
-    // OpenTelemetry resource context
-    WriteIndent(ss, 1);
-    ss << "\"resource\": {" << nl;
-    WriteIndent(ss, 2);
-    ss << "\"attributes\": {" << nl;
+void FlexLog::OpenTelemetryFormatter::RebuildLayout()
+{
+    BaseStructuredFormatter::RebuildLayout();
 
-    // Resource attributes - standard OpenTelemetry resource attributes
-    WriteIndent(ss, 3);
-    ss << "\"service.name\": \"" << m_options.serviceName << "\"," << nl;
+    namespace Otlp = Internal::Otlp;
 
-    WriteIndent(ss, 3);
-    ss << "\"service.namespace\": \"" << m_options.applicationName << "\"," << nl;
+    Buffer buffer;
+    ProtobufWriter writer(buffer);
+
+    const size_t resource = writer.BeginMessage(Otlp::RESOURCE_LOGS_RESOURCE);
+    Internal::WriteOtlpStringAttribute(writer, Otlp::RESOURCE_ATTRIBUTES, "service.name", m_options.serviceName);
+    Internal::WriteOtlpStringAttribute(writer, Otlp::RESOURCE_ATTRIBUTES, "service.namespace", m_options.applicationName);
 
     if (!m_options.serviceVersion.empty())
-    {
-        WriteIndent(ss, 3);
-        ss << "\"service.version\": \"" << m_options.serviceVersion << "\"," << nl;
-    }
+        Internal::WriteOtlpStringAttribute(writer, Otlp::RESOURCE_ATTRIBUTES, "service.version", m_options.serviceVersion);
+
+    Internal::WriteOtlpStringAttribute(writer, Otlp::RESOURCE_ATTRIBUTES, "service.instance.id", m_options.hostname);
+    Internal::WriteOtlpStringAttribute(writer, Otlp::RESOURCE_ATTRIBUTES, "deployment.environment", m_options.environment);
+
+    for (const auto& [key, value] : m_options.userData)
+        Internal::WriteOtlpStringAttribute(writer, Otlp::RESOURCE_ATTRIBUTES, key, value);
+
+    writer.EndMessage(resource);
+    m_protobufResource = buffer.ToString();
+
+    buffer.Clear();
+    if (!m_otelOptions.schemaUrl.empty())
+        writer.String(Otlp::RESOURCE_LOGS_SCHEMA_URL, m_otelOptions.schemaUrl);
+    m_protobufSchemaUrl = buffer.ToString();
+
+    buffer.Clear();
+    const size_t scope = writer.BeginMessage(Otlp::SCOPE_LOGS_SCOPE);
+    writer.String(Otlp::SCOPE_NAME, m_otelOptions.instrumentationScope);
+    writer.String(Otlp::SCOPE_VERSION, m_otelOptions.instrumentationVersion);
+    writer.EndMessage(scope);
+    m_protobufScope = buffer.ToString();
+
+    m_configuredIds = TraceIds::FromHex(m_otelOptions.traceId, m_otelOptions.spanId);
+}
 
-    WriteIndent(ss, 3);
-    ss << "\"service.instance.id\": \"" << m_options.hostname << "\"," << nl;
+void FlexLog::OpenTelemetryFormatter::CompileLayout(LayoutBuilder& builder) const
+{
+    // Format as OpenTelemetry JSON
+    builder.BeginObject();
+
+    // OpenTelemetry resource context, constant for the life of the formatter
+    builder.BeginObject("resource");
+    builder.BeginObject("attributes");
+
+    // Resource attributes - standard OpenTelemetry resource attributes
+    builder.Member("service.name", m_options.serviceName);
+    builder.Member("service.namespace", m_options.applicationName);
+
+    if (!m_options.serviceVersion.empty())
+        builder.Member("service.version", m_options.serviceVersion);
 
-    WriteIndent(ss, 3);
-    ss << "\"deployment.environment\": \"" << m_options.environment << "\"";
+    builder.Member("service.instance.id", m_options.hostname);
+    builder.Member("deployment.environment", m_options.environment);
 
     // Add additional resource attributes from options
-    if (!m_options.userData.empty())
-    {
-        for (const auto& [key, value] : m_options.userData)
-        {
-            ss << "," << nl;
-            WriteIndent(ss, 3);
-            ss << "\"" << key << "\": \"" << value << "\"";
-        }
-    }
+    for (const auto& [key, value] : m_options.userData)
+        builder.Member(key, value);
 
-    ss << nl;
-    WriteIndent(ss, 2);
-    ss << "}," << nl;
+    builder.EndObject();
 
     // Schema URL
-    WriteIndent(ss, 2);
-    ss << "\"schema_url\": \"" << m_otelOptions.schemaUrl << "\"" << nl;
-
-    WriteIndent(ss, 1);
-    ss << "}," << nl;
+    builder.Member("schema_url", m_otelOptions.schemaUrl);
+    builder.EndObject();
 
     // OpenTelemetry scope context
-    WriteIndent(ss, 1);
-    ss << "\"scope\": {" << nl;
-    WriteIndent(ss, 2);
-    ss << "\"name\": \"" << m_otelOptions.instrumentationScope << "\"," << nl;
-    WriteIndent(ss, 2);
-    ss << "\"version\": \"" << m_otelOptions.instrumentationVersion << "\"" << nl;
-    WriteIndent(ss, 1);
-    ss << "}," << nl;
+    builder.BeginObject("scope");
+    builder.Member("name", m_otelOptions.instrumentationScope);
+    builder.Member("version", m_otelOptions.instrumentationVersion);
+    builder.EndObject();
 
     // The actual log record
-    WriteIndent(ss, 1);
-    ss << "\"logs\": [{" << nl;
+    builder.BeginArray("logs");
+    builder.BeginObject();
 
     // Timestamp - nanoseconds since epoch
     if (m_options.includeTimestamp)
-    {
-        WriteIndent(ss, 2);
-        auto timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            message.timestamp.time_since_epoch()).count();
-        ss << "\"time_unix_nano\": " << timeNs << "," << nl;
-    }
+        builder.Value("time_unix_nano", TIME_UNIX_NANO_FIELD);
 
     // Observed timestamp - when the log was processed (typically now)
-    WriteIndent(ss, 2);
-    auto nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
-    ss << "\"observed_time_unix_nano\": " << nowNs << "," << nl;
+    builder.Value("observed_time_unix_nano", OBSERVED_TIME_UNIX_NANO_FIELD);
 
     // Severity number - OpenTelemetry defines a standard scale
     if (m_options.includeLevel && m_otelOptions.useOtelSeverityFormat)
     {
-        WriteIndent(ss, 2);
-        ss << "\"severity_number\": " << ConvertLevelToOtelSeverity(message.level) << "," << nl;
-        WriteIndent(ss, 2);
-        ss << "\"severity_text\": \"" << GetOtelSeverityText(message.level) << "\"," << nl;
+        builder.Value("severity_number", SEVERITY_NUMBER_FIELD);
+        builder.Value("severity_text", SEVERITY_TEXT_FIELD);
     }
     else if (m_options.includeLevel)
     {
-        WriteIndent(ss, 2);
-        ss << "\"severity_text\": \"" << LevelToString(message.level) << "\"," << nl;
+        builder.Value("severity_text", LayoutField::Level);
     }
 
     // Body - the log message content
     if (m_options.includeMessage)
     {
-        WriteIndent(ss, 2);
-        ss << "\"body\": {" << nl;
-        WriteIndent(ss, 3);
-        ss << "\"string_value\": \"";
-        EscapeString(ss, message.message);
-        ss << "\"" << nl;
-        WriteIndent(ss, 2);
-        ss << "}," << nl;
+        builder.BeginObject("body");
+        builder.Value("string_value", LayoutField::Message);
+        builder.EndObject();
     }
 
-    // Trace context if enabled
+    // Trace context if enabled, from the message's TraceContext when it was logged inside one
     if (m_otelOptions.includeTraceContext)
     {
-        std::string traceId = !m_otelOptions.traceId.empty() ? m_otelOptions.traceId : GenerateTraceId();
-        std::string spanId = !m_otelOptions.spanId.empty() ? m_otelOptions.spanId : GenerateSpanId();
-
-        WriteIndent(ss, 2);
-        ss << "\"trace_id\": \"" << traceId << "\"," << nl;
-        WriteIndent(ss, 2);
-        ss << "\"span_id\": \"" << spanId << "\"," << nl;
+        builder.Value("trace_id", TRACE_ID_FIELD);
+        builder.Value("span_id", SPAN_ID_FIELD);
     }
 
     // Attributes - these are key-value pairs for the log record
-    WriteIndent(ss, 2);
-    ss << "\"attributes\": [" << nl;
-
-    std::vector<std::pair<std::string, std::string>> attributes;
+    builder.BeginArray("attributes");
 
     // Logger name
     if (m_options.includeLogger)
-        attributes.emplace_back("logger.name", message.name);
+        builder.Dynamic(LOGGER_ATTRIBUTE_FIELD);
 
     // Source location
     if (m_options.includeSourceLocation)
-    {
-        attributes.emplace_back("code.filepath", std::filesystem::path(message.sourceLocation.file_name()).filename().string());
-        attributes.emplace_back("code.lineno", std::to_string(message.sourceLocation.line()));
-        attributes.emplace_back("code.function", message.sourceLocation.function_name());
-    }
+        builder.Dynamic(SOURCE_ATTRIBUTES_FIELD);
 
     // Process info
     if (m_options.includeProcessInfo)
-    {
-        attributes.emplace_back("process.pid", GetProcessId());
-        attributes.emplace_back("process.executable.name", GetProcessName());
-    }
+        builder.Dynamic(PROCESS_ATTRIBUTES_FIELD);
 
     // Thread ID
     if (m_options.includeThreadId)
-    {
-        attributes.emplace_back("thread.id", GetThreadId());
-    }
+        builder.Dynamic(THREAD_ATTRIBUTE_FIELD);
 
     // Add structured data fields as attributes
-    if (!message.structuredData.IsEmpty())
-    {
-        const auto& fields = message.structuredData.GetFields();
+    builder.Dynamic(LayoutField::Fields);
 
-        for (const auto& [key, value] : fields)
-        {
-            std::string stringValue;
+    builder.EndArray();
 
-            std::visit([&](auto&& arg) {
-                using T = std::decay_t<decltype(arg)>;
+    builder.EndObject();
+    builder.EndArray();
 
-                if constexpr (std::is_same_v<T, std::nullptr_t>)
-                {
-                    // Skip null values or add as special case
-                    return;
-                }
-                else if constexpr (std::is_same_v<T, std::string>)
-                {
-                    stringValue = arg;
-                }
-                else if constexpr (std::is_same_v<T, int64_t> || 
-                    std::is_same_v<T, uint64_t>)
-                {
-                    stringValue = std::to_string(arg);
-                }
-                else if constexpr (std::is_same_v<T, double>)
-                {
-                    stringValue = std::to_string(arg);
-                }
-                else if constexpr (std::is_same_v<T, bool>)
-                {
-                    stringValue = arg ? "true" : "false";
-                }
-                else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
-                {
-                    auto time_t_value = std::chrono::system_clock::to_time_t(arg);
-                    std::stringstream ts;
-                    ts << std::put_time(std::gmtime(&time_t_value), "%FT%T.000Z");
-                    stringValue = ts.str();
-                }
-                else if constexpr (std::is_same_v<T, std::vector<std::string>> || 
-                    std::is_same_v<T, std::vector<int64_t>> ||
-                    std::is_same_v<T, std::vector<double>> ||
-                    std::is_same_v<T, std::vector<bool>>)
-                {
-                    // For vector types, serialize to a string representation
-                    std::stringstream vs;
-                    vs << "[";
-
-                    for (size_t i = 0; i < arg.size(); ++i)
-                    {
-                        if (i > 0)
-                            vs << ", ";
-
-                        if constexpr (std::is_same_v<T, std::vector<std::string>>)
-                            vs << "\"" << arg[i] << "\"";
-                        else
-                            vs << arg[i];
-                    }
-
-                    vs << "]";
-                    stringValue = vs.str();
-                }
-                }, value);
+    // Close the main object
+    builder.EndObject();
+}
+
+void FlexLog::OpenTelemetryFormatter::WriteLayoutField(JsonWriter& writer, const Message& message, const FieldSet& fields, LayoutSlot slot, std::string_view renderedKey) const
+{
+    if (slot.field == LayoutField::Fields)
+    {
+        if (fields.IsEmpty())
+            return;
+
+        Buffer stringValue;
+
+        fields.ForEach([&](std::string_view key, const FieldView& value)
+        {
+            stringValue.Clear();
+            AppendAttributeString(stringValue, value);
 
             // Only add attribute if we have a value
-            if (!stringValue.empty())
-            {
-                attributes.emplace_back(key, stringValue);
-            }
-        }
+            if (!stringValue.IsEmpty())
+                WriteStringAttribute(writer, key, stringValue.View());
+        });
+        return;
     }
 
-    // Output all collected attributes
-    for (size_t i = 0; i < attributes.size(); ++i)
-    {
-        const auto& [key, value] = attributes[i];
-
-        WriteIndent(ss, 3);
-        ss << "{" << nl;
-        WriteIndent(ss, 4);
-        ss << "\"key\": \"" << key << "\"," << nl;
-        WriteIndent(ss, 4);
-        ss << "\"value\": {" << nl;
-        WriteIndent(ss, 5);
-        ss << "\"string_value\": \"";
-        EscapeString(ss, value);
-        ss << "\"" << nl;
-        WriteIndent(ss, 4);
-        ss << "}" << nl;
-        WriteIndent(ss, 3);
-        ss << "}";
-
-        if (i < attributes.size() - 1)
-            ss << ",";
-
-        ss << nl;
+    if (slot.field != LayoutField::Custom)
+    {
+        BaseStructuredFormatter::WriteLayoutField(writer, message, fields, slot, renderedKey);
+        return;
     }
 
-    WriteIndent(ss, 2);
-    ss << "]" << nl;
+    switch (static_cast<OtelField>(slot.custom))
+    {
+    case OtelField::TimeUnixNano:
+        writer.Int(std::chrono::duration_cast<std::chrono::nanoseconds>(message.timestamp.time_since_epoch()).count());
+        break;
 
-    WriteIndent(ss, 1);
-    ss << "}]" << nl;
+    case OtelField::ObservedTimeUnixNano:
+        writer.Int(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+        break;
 
-    // Close the main object
-    ss << "}";
+    case OtelField::SeverityNumber:
+        writer.Int(ConvertLevelToOtelSeverity(message.level));
+        break;
 
-    return ss.str();
-}
+    case OtelField::SeverityText:
+        writer.String(GetOtelSeverityText(message.level));
+        break;
 
-std::string FlexLog::OpenTelemetryFormatter::FormatStructuredDataImpl(const StructuredData& data) const
-{
-    // Format as OpenTelemetry attributes
-    if (data.IsEmpty())
-        return "[]";
+    case OtelField::TraceId:
+    {
+        // Configured IDs go out exactly as they were given, hex or not
+        if (!message.trace.HasTrace() && !m_otelOptions.traceId.empty())
+        {
+            writer.String(m_otelOptions.traceId);
+            break;
+        }
+
+        uint64_t high = 0;
+        uint64_t low = 0;
+        ResolveTraceId(message, high, low);
+
+        char hex[32];
+        Internal::WriteHex(hex, high);
+        Internal::WriteHex(hex + 16, low);
+        writer.String(std::string_view(hex, sizeof(hex)));
+        break;
+    }
+
+    case OtelField::SpanId:
+    {
+        if (!message.trace.HasSpan() && !m_otelOptions.spanId.empty())
+        {
+            writer.String(m_otelOptions.spanId);
+            break;
+        }
 
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
+        char hex[16];
+        Internal::WriteHex(hex, ResolveSpanId(message));
+        writer.String(std::string_view(hex, sizeof(hex)));
+        break;
+    }
 
-    ss << "[" << nl;
+    case OtelField::LoggerAttribute:
+        WriteStringAttribute(writer, "logger.name", message.name);
+        break;
 
-    const auto& fields = data.GetFields();
+    case OtelField::SourceAttributes:
+    {
+        const NumberText line(message.sourceLocation.line());
 
-    // Sort keys if needed
-    std::vector<std::string> keys;
-    keys.reserve(fields.size());
+        WriteStringAttribute(writer, "code.filepath", GetSourceFileName(message.sourceLocation));
+        WriteStringAttribute(writer, "code.lineno", line.View());
+        WriteStringAttribute(writer, "code.function", message.sourceLocation.function_name());
+        break;
+    }
 
-    for (const auto& [key, _] : fields)
+    case OtelField::ProcessAttributes:
     {
-        keys.push_back(key);
+        const ProcessInfo::Snapshot& process = ProcessInfo::Get();
+        WriteStringAttribute(writer, "process.pid", process.pidText);
+        WriteStringAttribute(writer, "process.executable.name", process.name);
+        break;
+    }
+
+    case OtelField::ThreadAttribute:
+        WriteStringAttribute(writer, "thread.id", NumberText(message.threadId).View());
+
+        if (!message.threadName.empty())
+            WriteStringAttribute(writer, "thread.name", message.threadName);
+        break;
+
     }
+}
 
-    if (m_options.sortKeys)
-        std::sort(keys.begin(), keys.end());
+std::string FlexLog::OpenTelemetryFormatter::FormatStructuredDataImpl(const FieldSet& fields) const
+{
+    Buffer buffer;
+    JsonWriter writer = MakeJsonWriter(buffer);
 
     // Format fields as OpenTelemetry attributes
-    for (size_t i = 0; i < keys.size(); ++i)
-    {
-        const auto& key = keys[i];
-        const auto& value = fields.at(key);
+    writer.BeginArray();
 
+    fields.ForEach([&](std::string_view key, const FieldView& value)
+    {
         if (!m_options.includeNullValues && std::holds_alternative<std::nullptr_t>(value))
-            continue;
+            return;
 
-        WriteIndent(ss, 1);
-        ss << "{" << nl;
-        WriteIndent(ss, 2);
-        ss << "\"key\": \"" << key << "\"," << nl;
-        WriteIndent(ss, 2);
-        ss << "\"value\": ";
+        writer.BeginObject();
+        writer.Member("key", key);
+        writer.Key("value");
+        writer.BeginObject();
 
-        std::visit([&](auto&& arg)
+        std::visit([&](const auto& arg)
         {
             using T = std::decay_t<decltype(arg)>;
 
             if constexpr (std::is_same_v<T, std::nullptr_t>)
             {
-                ss << "{" << nl;
-                WriteIndent(ss, 3);
-                ss << "\"string_value\": \"null\"" << nl;
-                WriteIndent(ss, 2);
-                ss << "}";
-            }
-            else if constexpr (std::is_same_v<T, std::string>)
-            {
-                ss << "{" << nl;
-                WriteIndent(ss, 3);
-                ss << "\"string_value\": \"";
-                EscapeString(ss, arg);
-                ss << "\"" << nl;
-                WriteIndent(ss, 2);
-                ss << "}";
+                writer.Member("string_value", "null");
             }
-            else if constexpr (std::is_same_v<T, int64_t>)
+            else if constexpr (std::is_same_v<T, std::string_view>)
             {
-                ss << "{" << nl;
-                WriteIndent(ss, 3);
-                ss << "\"int_value\": " << arg << nl;
-                WriteIndent(ss, 2);
-                ss << "}";
+                writer.Member("string_value", arg);
             }
-            else if constexpr (std::is_same_v<T, uint64_t>)
+            else if constexpr (std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t>)
             {
-                ss << "{" << nl;
-                WriteIndent(ss, 3);
-                ss << "\"int_value\": " << arg << nl;
-                WriteIndent(ss, 2);
-                ss << "}";
+                writer.Member("int_value", arg);
             }
             else if constexpr (std::is_same_v<T, double>)
             {
-                ss << "{" << nl;
-                WriteIndent(ss, 3);
-                ss << "\"double_value\": " << std::fixed << arg << nl;
-                WriteIndent(ss, 2);
-                ss << "}";
+                writer.Member("double_value", arg);
             }
             else if constexpr (std::is_same_v<T, bool>)
             {
-                ss << "{" << nl;
-                WriteIndent(ss, 3);
-                ss << "\"bool_value\": " << (arg ? "true" : "false") << nl;
-                WriteIndent(ss, 2);
-                ss << "}";
+                writer.Member("bool_value", arg);
             }
             else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
             {
-                ss << "{" << nl;
-                WriteIndent(ss, 3);
-                ss << "\"string_value\": \"" << FormatTimestamp(arg) << "\"" << nl;
-                WriteIndent(ss, 2);
-                ss << "}";
+                writer.Key("string_value");
+                WriteTimestampString(writer, arg);
             }
-            else if constexpr (std::is_same_v<T, std::vector<std::string>> || 
-                std::is_same_v<T, std::vector<int64_t>> ||
-                std::is_same_v<T, std::vector<double>> ||
-                std::is_same_v<T, std::vector<bool>>)
+            else
             {
-                ss << "{" << nl;
-                WriteIndent(ss, 3);
-                ss << "\"array_value\": {" << nl;
-                WriteIndent(ss, 4);
-                ss << "\"values\": [" << nl;
+                writer.Key("array_value");
+                writer.BeginObject();
+                writer.Key("values");
+                writer.BeginArray();
 
-                for (size_t j = 0; j < arg.size(); ++j)
+                for (size_t i = 0; i < arg.size(); ++i)
                 {
-                    WriteIndent(ss, 5);
-
-                    if constexpr (std::is_same_v<T, std::vector<std::string>>)
-                    {
-                        ss << "{" << nl;
-                        WriteIndent(ss, 6);
-                        ss << "\"string_value\": \"";
-                        EscapeString(ss, arg[j]);
-                        ss << "\"" << nl;
-                        WriteIndent(ss, 5);
-                        ss << "}";
-                    }
-                    else if constexpr (std::is_same_v<T, std::vector<int64_t>>)
-                    {
-                        ss << "{" << nl;
-                        WriteIndent(ss, 6);
-                        ss << "\"int_value\": " << arg[j] << nl;
-                        WriteIndent(ss, 5);
-                        ss << "}";
-                    }
-                    else if constexpr (std::is_same_v<T, std::vector<double>>)
-                    {
-                        ss << "{" << nl;
-                        WriteIndent(ss, 6);
-                        ss << "\"double_value\": " << std::fixed << arg[j] << nl;
-                        WriteIndent(ss, 5);
-                        ss << "}";
-                    }
-                    else if constexpr (std::is_same_v<T, std::vector<bool>>)
-                    {
-                        ss << "{" << nl;
-                        WriteIndent(ss, 6);
-                        ss << "\"bool_value\": " << (arg[j] ? "true" : "false") << nl;
-                        WriteIndent(ss, 5);
-                        ss << "}";
-                    }
-
-                    if (j < arg.size() - 1)
-                        ss << ",";
-
-                    ss << nl;
+                    writer.BeginObject();
+
+                    if constexpr (std::is_same_v<T, std::span<const std::string>>)
+                        writer.Member("string_value", arg[i]);
+                    else if constexpr (std::is_same_v<T, std::span<const int64_t>>)
+                        writer.Member("int_value", arg[i]);
+                    else if constexpr (std::is_same_v<T, std::span<const double>>)
+                        writer.Member("double_value", arg[i]);
+                    else
+                        writer.Member("bool_value", static_cast<bool>(arg[i]));
+
+                    writer.EndObject();
                 }
 
-                WriteIndent(ss, 4);
-                ss << "]" << nl;
-                WriteIndent(ss, 3);
-                ss << "}" << nl;
-                WriteIndent(ss, 2);
-                ss << "}";
+                writer.EndArray();
+                writer.EndObject();
             }
         }, value);
 
-        ss << nl;
-        WriteIndent(ss, 1);
-        ss << "}";
+        writer.EndObject();
+        writer.EndObject();
+    }, m_options.sortKeys);
+
+    writer.EndArray();
 
-        if (i < keys.size() - 1)
-            ss << ",";
+    return buffer.ToString();
+}
+
+void FlexLog::OpenTelemetryFormatter::WriteStringAttribute(JsonWriter& writer, std::string_view key, std::string_view value)
+{
+    writer.BeginObject();
+    writer.Member("key", key);
+    writer.Key("value");
+    writer.BeginObject();
+    writer.Member("string_value", value);
+    writer.EndObject();
+    writer.EndObject();
+}
+
+void FlexLog::OpenTelemetryFormatter::AppendAttributeString(Buffer& out, const FieldView& value)
+{
+    const auto appendNumber = [&out](auto number)
+    {
+        if constexpr (std::is_floating_point_v<decltype(number)>)
+            Internal::AppendDouble(out, number, JsonWriter::DEFAULT_PRECISION);
+        else
+            Internal::AppendInteger(out, number);
+    };
+
+    std::visit([&](const auto& arg)
+    {
+        using T = std::decay_t<decltype(arg)>;
+
+        if constexpr (std::is_same_v<T, std::nullptr_t>)
+        {
+            // Null values are skipped
+        }
+        else if constexpr (std::is_same_v<T, std::string_view>)
+        {
+            out.Append(arg);
+        }
+        else if constexpr (std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t> || std::is_same_v<T, double>)
+        {
+            appendNumber(arg);
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            out.Append(arg ? std::string_view("true") : std::string_view("false"));
+        }
+        else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
+        {
+            TimestampCache::FormatTo(out, arg, "%FT%T.000Z", TimeZone::Utc);
+        }
+        else
+        {
+            // For array types, serialize to a string representation
+            out.PushBack('[');
 
-        ss << nl;
+            for (size_t i = 0; i < arg.size(); ++i)
+            {
+                if (i > 0)
+                    out.Append(", ");
+
+                if constexpr (std::is_same_v<T, std::span<const std::string>>)
+                {
+                    // Escaped so quotes inside an element can't end it early
+                    out.PushBack('"');
+                    Internal::EscapeJson(out, arg[i]);
+                    out.PushBack('"');
+                }
+                else if constexpr (std::is_same_v<T, BoolSpan>)
+                {
+                    out.Append(arg[i] ? std::string_view("true") : std::string_view("false"));
+                }
+                else
+                {
+                    appendNumber(arg[i]);
+                }
+            }
+
+            out.PushBack(']');
+        }
+    }, value);
+}
+
+void FlexLog::OpenTelemetryFormatter::WriteProtobufRecord(ProtobufWriter& writer, const Message& message) const
+{
+    namespace Otlp = Internal::Otlp;
+
+    const size_t record = writer.BeginMessage(Otlp::SCOPE_LOGS_LOG_RECORDS);
+
+    if (m_options.includeTimestamp)
+        writer.Fixed64(Otlp::LOG_RECORD_TIME_UNIX_NANO, static_cast<uint64_t>(Internal::ToEpochNanos(message.timestamp)));
+
+    writer.Fixed64(Otlp::LOG_RECORD_OBSERVED_TIME_UNIX_NANO, static_cast<uint64_t>(Internal::ToEpochNanos(std::chrono::system_clock::now())));
+
+    if (m_options.includeLevel && m_otelOptions.useOtelSeverityFormat)
+    {
+        writer.Varint(Otlp::LOG_RECORD_SEVERITY_NUMBER, static_cast<uint64_t>(ConvertLevelToOtelSeverity(message.level)));
+        writer.String(Otlp::LOG_RECORD_SEVERITY_TEXT, GetOtelSeverityText(message.level));
+    }
+    else if (m_options.includeLevel)
+    {
+        writer.String(Otlp::LOG_RECORD_SEVERITY_TEXT, LevelToString(message.level));
     }
 
-    ss << "]";
+    if (m_options.includeMessage)
+    {
+        const size_t body = writer.BeginMessage(Otlp::LOG_RECORD_BODY);
+        writer.String(Otlp::ANY_VALUE_STRING, message.message);
+        writer.EndMessage(body);
+    }
 
-    return ss.str();
+    if (m_options.includeLogger)
+        Internal::WriteOtlpStringAttribute(writer, Otlp::LOG_RECORD_ATTRIBUTES, "logger.name", message.name);
+
+    if (m_options.includeSourceLocation)
+    {
+        Internal::WriteOtlpStringAttribute(writer, Otlp::LOG_RECORD_ATTRIBUTES, "code.filepath", GetSourceFileName(message.sourceLocation));
+        Internal::WriteOtlpIntAttribute(writer, Otlp::LOG_RECORD_ATTRIBUTES, "code.lineno", message.sourceLocation.line());
+        Internal::WriteOtlpStringAttribute(writer, Otlp::LOG_RECORD_ATTRIBUTES, "code.function", message.sourceLocation.function_name());
+    }
+
+    if (m_options.includeProcessInfo)
+    {
+        const ProcessInfo::Snapshot& process = ProcessInfo::Get();
+        Internal::WriteOtlpIntAttribute(writer, Otlp::LOG_RECORD_ATTRIBUTES, "process.pid", static_cast<int64_t>(process.pid));
+        Internal::WriteOtlpStringAttribute(writer, Otlp::LOG_RECORD_ATTRIBUTES, "process.executable.name", process.name);
+    }
+
+    if (m_options.includeThreadId)
+    {
+        Internal::WriteOtlpIntAttribute(writer, Otlp::LOG_RECORD_ATTRIBUTES, "thread.id", static_cast<int64_t>(message.threadId));
+
+        if (!message.threadName.empty())
+            Internal::WriteOtlpStringAttribute(writer, Otlp::LOG_RECORD_ATTRIBUTES, "thread.name", message.threadName);
+    }
+
+    FieldSet(message).ForEach([&](std::string_view key, const FieldView& value)
+    {
+        if (!m_options.includeNullValues && std::holds_alternative<std::nullptr_t>(value))
+            return;
+
+        Internal::WriteOtlpAttribute(writer, Otlp::LOG_RECORD_ATTRIBUTES, key, [&](ProtobufWriter& w) { WriteProtobufValue(w, value); });
+    }, m_options.sortKeys);
+
+    // OTLP carries IDs as raw big-endian bytes; configured IDs that aren't valid hex are replaced by generated ones
+    if (m_otelOptions.includeTraceContext)
+    {
+        uint64_t high = 0;
+        uint64_t low = 0;
+        ResolveTraceId(message, high, low);
+
+        char bytes[16];
+        Internal::WriteBigEndian(bytes, high);
+        Internal::WriteBigEndian(bytes + 8, low);
+        writer.Bytes(Otlp::LOG_RECORD_TRACE_ID, std::string_view(bytes, 16));
+
+        Internal::WriteBigEndian(bytes, ResolveSpanId(message));
+        writer.Bytes(Otlp::LOG_RECORD_SPAN_ID, std::string_view(bytes, 8));
+    }
+
+    writer.EndMessage(record);
+}
+
+void FlexLog::OpenTelemetryFormatter::WriteProtobufValue(ProtobufWriter& writer, const FieldView& value) const
+{
+    namespace Otlp = Internal::Otlp;
+
+    std::visit([&](const auto& arg)
+    {
+        using T = std::decay_t<decltype(arg)>;
+
+        if constexpr (std::is_same_v<T, std::nullptr_t>)
+        {
+            // An AnyValue with nothing set
+        }
+        else if constexpr (std::is_same_v<T, std::string_view>)
+        {
+            writer.String(Otlp::ANY_VALUE_STRING, arg);
+        }
+        else if constexpr (std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t>)
+        {
+            writer.Int(Otlp::ANY_VALUE_INT, static_cast<int64_t>(arg));
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            writer.Double(Otlp::ANY_VALUE_DOUBLE, arg);
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            writer.Bool(Otlp::ANY_VALUE_BOOL, arg);
+        }
+        else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
+        {
+            Buffer text;
+            FormatTimestampTo(text, arg);
+            writer.String(Otlp::ANY_VALUE_STRING, text.View());
+        }
+        else
+        {
+            const size_t array = writer.BeginMessage(Otlp::ANY_VALUE_ARRAY);
+
+            for (size_t i = 0; i < arg.size(); ++i)
+            {
+                const size_t element = writer.BeginMessage(Otlp::ARRAY_VALUE_VALUES);
+
+                if constexpr (std::is_same_v<T, std::span<const std::string>>)
+                    writer.String(Otlp::ANY_VALUE_STRING, arg[i]);
+                else if constexpr (std::is_same_v<T, std::span<const int64_t>>)
+                    writer.Int(Otlp::ANY_VALUE_INT, arg[i]);
+                else if constexpr (std::is_same_v<T, std::span<const double>>)
+                    writer.Double(Otlp::ANY_VALUE_DOUBLE, arg[i]);
+                else
+                    writer.Bool(Otlp::ANY_VALUE_BOOL, arg[i]);
+
+                writer.EndMessage(element);
+            }
+
+            writer.EndMessage(array);
+        }
+    }, value);
 }
 
 int FlexLog::OpenTelemetryFormatter::ConvertLevelToOtelSeverity(Level level) const
@@ -539,36 +721,24 @@ std::string FlexLog::OpenTelemetryFormatter::GetOtelSeverityText(Level level) co
     }
 }
 
-std::string FlexLog::OpenTelemetryFormatter::GenerateTraceId() const
+void FlexLog::OpenTelemetryFormatter::ResolveTraceId(const Message& message, uint64_t& high, uint64_t& low) const
 {
-    // Generate a 16-byte (32 hex char) trace ID
-    static thread_local std::mt19937_64 rng(std::random_device{}());
-    static thread_local std::uniform_int_distribution<uint32_t> dist(0, 15);
-    static const char* hexChars = "0123456789abcdef";
+    const TraceIds& ids = message.trace.HasTrace() ? message.trace : m_configuredIds;
 
-    std::string traceId(32, '0');
+    high = ids.traceHigh;
+    low = ids.traceLow;
 
-    for (size_t i = 0; i < 32; ++i)
+    if (!ids.HasTrace())
     {
-        traceId[i] = hexChars[dist(rng)];
+        high = Internal::NextRandom();
+        low = Internal::NextRandomId();
     }
-
-    return traceId;
 }
 
-std::string FlexLog::OpenTelemetryFormatter::GenerateSpanId() const
+uint64_t FlexLog::OpenTelemetryFormatter::ResolveSpanId(const Message& message) const
 {
-    // Generate an 8-byte (16 hex char) span ID
-    static thread_local std::mt19937_64 rng(std::random_device{}());
-    static thread_local std::uniform_int_distribution<uint32_t> dist(0, 15);
-    static const char* hexChars = "0123456789abcdef";
-
-    std::string spanId(16, '0');
-
-    for (size_t i = 0; i < 16; ++i)
-    {
-        spanId[i] = hexChars[dist(rng)];
-    }
+    if (message.trace.HasSpan())
+        return message.trace.span;
 
-    return spanId;
+    return m_configuredIds.HasSpan() ? m_configuredIds.span : Internal::NextRandomId();
 }
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "BaseStructuredFormatter.h"
+#include "Core/TraceContext.h"
+#include "ProtobufWriter.h"
+#include <span>
 #include <string>
 
 namespace FlexLog
@@ -16,8 +19,11 @@ namespace FlexLog
             std::string instrumentationScope = "flex_log-logger";
             std::string instrumentationVersion = "1.0.0";
             bool includeTraceContext = false; // Include trace ID & span ID
-            std::string traceId; // Optional default trace ID
-            std::string spanId;  // Optional default span ID
+            // Optional default trace and span IDs. JSON writes them as given; protobuf needs 32 and 16 hex digits
+            // for the bytes and generates an ID in place of one that isn't.
+            std::string traceId;
+            std::string spanId;
+            bool useProtobuf = false; // OTLP protobuf LogsData rather than JSON
 
             // Builder methods
             Options& SetSchemaUrl(std::string_view url)
@@ -46,6 +52,12 @@ namespace FlexLog
                 spanId = span;
                 return *this;
             }
+
+            Options& SetProtobuf(bool enable)
+            {
+                useProtobuf = enable;
+                return *this;
+            }
         };
 
         explicit OpenTelemetryFormatter(const Options& options = Options());
@@ -53,10 +65,24 @@ namespace FlexLog
         std::string_view GetContentType() const override;
         std::unique_ptr<StructuredFormatter> Clone() const override;
 
+        const Options& GetOtelOptions() const { return m_otelOptions; }
+
+        // With useProtobuf, writes one LogsData message holding every record under a single resource
+        // and scope, ready to POST to an OTLP/HTTP collector. JSON records are written one per line.
+        void FormatBatch(std::span<const Message* const> messages, Buffer& out) const;
+
     protected:
-        void EscapeString(std::ostream& os, std::string_view str) const override;
-        std::string FormatMessageImpl(const Message& message) const override;
-        std::string FormatStructuredDataImpl(const StructuredData& data) const override;
+        void FormatMessageImpl(const Message& message, Buffer& out) const override;
+        void CompileLayout(LayoutBuilder& builder) const override;
+        void WriteLayoutField(JsonWriter& writer, const Message& message, const FieldSet& fields, LayoutSlot slot, std::string_view renderedKey) const override;
+        std::string FormatStructuredDataImpl(const FieldSet& fields) const override;
+        void RebuildLayout() override;
+
+        // Writes a {"key": ..., "value": {"string_value": ...}} attribute object
+        static void WriteStringAttribute(JsonWriter& writer, std::string_view key, std::string_view value);
+
+        // Renders a field value as attribute text; nulls append nothing
+        static void AppendAttributeString(Buffer& out, const FieldView& value);
 
         // Convert FlexLog level to OpenTelemetry severity number (1-24)
         int ConvertLevelToOtelSeverity(Level level) const;
@@ -64,10 +90,49 @@ namespace FlexLog
         // Get OpenTelemetry severity text based on level
         std::string GetOtelSeverityText(Level level) const;
 
-        // Generate random trace ID and span ID if needed
-        std::string GenerateTraceId() const;
-        std::string GenerateSpanId() const;
+        // IDs of the message's trace context, else the configured ones, else freshly generated
+        void ResolveTraceId(const Message& message, uint64_t& high, uint64_t& low) const;
+        uint64_t ResolveSpanId(const Message& message) const;
 
         Options m_otelOptions;
+
+    private:
+        void WriteProtobufRecord(ProtobufWriter& writer, const Message& message) const;
+
+        // Writes the members of an AnyValue; nulls write nothing, which OTLP reads as an empty value
+        void WriteProtobufValue(ProtobufWriter& writer, const FieldView& value) const;
+
+        // Pre-encoded parts of the protobuf output that are the same for every message
+        std::string m_protobufResource;
+        std::string m_protobufSchemaUrl;
+        std::string m_protobufScope;
+
+        // Trace context from the options, for messages logged outside a TraceContext
+        TraceIds m_configuredIds;
+
+        enum class OtelField : uint8_t
+        {
+            TimeUnixNano,
+            ObservedTimeUnixNano,
+            SeverityNumber,
+            SeverityText,
+            TraceId,
+            SpanId,
+            LoggerAttribute,
+            SourceAttributes,
+            ThreadAttribute,
+            ProcessAttributes
+        };
+
+        static constexpr LayoutSlot TIME_UNIX_NANO_FIELD = MakeFormatterField(OtelField::TimeUnixNano);
+        static constexpr LayoutSlot OBSERVED_TIME_UNIX_NANO_FIELD = MakeFormatterField(OtelField::ObservedTimeUnixNano);
+        static constexpr LayoutSlot SEVERITY_NUMBER_FIELD = MakeFormatterField(OtelField::SeverityNumber);
+        static constexpr LayoutSlot SEVERITY_TEXT_FIELD = MakeFormatterField(OtelField::SeverityText);
+        static constexpr LayoutSlot TRACE_ID_FIELD = MakeFormatterField(OtelField::TraceId);
+        static constexpr LayoutSlot SPAN_ID_FIELD = MakeFormatterField(OtelField::SpanId);
+        static constexpr LayoutSlot LOGGER_ATTRIBUTE_FIELD = MakeFormatterField(OtelField::LoggerAttribute);
+        static constexpr LayoutSlot SOURCE_ATTRIBUTES_FIELD = MakeFormatterField(OtelField::SourceAttributes);
+        static constexpr LayoutSlot THREAD_ATTRIBUTE_FIELD = MakeFormatterField(OtelField::ThreadAttribute);
+        static constexpr LayoutSlot PROCESS_ATTRIBUTES_FIELD = MakeFormatterField(OtelField::ProcessAttributes);
     };
 }
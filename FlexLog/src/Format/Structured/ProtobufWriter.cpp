@@ -0,0 +1,30 @@
+#include "ProtobufWriter.h"
+
+#include <cstring>
+
+size_t FlexLog::ProtobufWriter::BeginMessage(uint32_t field)
+{
+    Tag(field, WireType::LengthDelimited);
+
+    const size_t mark = m_out.Size();
+    m_out.Extend(1);
+    return mark;
+}
+
+void FlexLog::ProtobufWriter::EndMessage(size_t mark)
+{
+    const size_t bodyStart = mark + 1;
+    const size_t bodySize = m_out.Size() - bodyStart;
+
+    char length[Internal::MAX_VARINT_LENGTH];
+    const size_t lengthSize = Internal::EncodeVarint(length, bodySize);
+
+    if (lengthSize > 1)
+    {
+        m_out.Extend(lengthSize - 1);
+        char* body = m_out.Data() + bodyStart;
+        std::memmove(body + lengthSize - 1, body, bodySize);
+    }
+
+    std::memcpy(m_out.Data() + mark, length, lengthSize);
+}
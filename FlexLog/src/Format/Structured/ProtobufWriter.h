@@ -0,0 +1,88 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+#include "Core/Buffer.h"
+#include "Format/Binary/BinaryProtocol.h"
+
+namespace FlexLog
+{
+    /**
+    * @brief Protocol Buffers wire-format writer that appends straight into a Buffer.
+    *
+    * Fields are written in the order they are called, tagged with their field
+    * number, so the writer needs no schema. Embedded messages are opened with
+    * BeginMessage() and their length is filled in by EndMessage(): one byte
+    * is reserved up front, which fits most attributes and values, and larger
+    * messages are shifted once to make room for a longer length.
+    */
+    class ProtobufWriter
+    {
+    public:
+        enum class WireType : uint8_t
+        {
+            Varint = 0,
+            Fixed64 = 1,
+            LengthDelimited = 2,
+            Fixed32 = 5
+        };
+
+        explicit ProtobufWriter(Buffer& out) : m_out(out) {}
+
+        void Varint(uint32_t field, uint64_t value)
+        {
+            Tag(field, WireType::Varint);
+            Internal::AppendVarint(m_out, value);
+        }
+
+        // int32/int64 fields; negative values take the full ten bytes, as the spec requires
+        void Int(uint32_t field, int64_t value) { Varint(field, static_cast<uint64_t>(value)); }
+        void Bool(uint32_t field, bool value) { Varint(field, value ? 1 : 0); }
+
+        void Fixed64(uint32_t field, uint64_t value)
+        {
+            Tag(field, WireType::Fixed64);
+            LittleEndian(value);
+        }
+
+        void Fixed32(uint32_t field, uint32_t value)
+        {
+            Tag(field, WireType::Fixed32);
+            LittleEndian(value);
+        }
+
+        void Double(uint32_t field, double value) { Fixed64(field, std::bit_cast<uint64_t>(value)); }
+
+        void Bytes(uint32_t field, std::string_view value)
+        {
+            Tag(field, WireType::LengthDelimited);
+            Internal::AppendBinaryString(m_out, value);
+        }
+
+        void String(uint32_t field, std::string_view value) { Bytes(field, value); }
+
+        // Opens an embedded message; pass the mark to EndMessage() once its fields are written
+        size_t BeginMessage(uint32_t field);
+        void EndMessage(size_t mark);
+
+        // Appends bytes that are already encoded, such as a pre-rendered field
+        void Raw(std::string_view encoded) { m_out.Append(encoded); }
+
+        Buffer& GetBuffer() { return m_out; }
+
+    private:
+        void Tag(uint32_t field, WireType type) { Internal::AppendVarint(m_out, (static_cast<uint64_t>(field) << 3) | static_cast<uint8_t>(type)); }
+
+        template<typename T>
+        void LittleEndian(T value)
+        {
+            char* dst = m_out.Extend(sizeof(T));
+            for (size_t i = 0; i < sizeof(T); ++i)
+                dst[i] = static_cast<char>(value >> (8 * i));
+        }
+
+        Buffer& m_out;
+    };
+}
@@ -1,8 +1,6 @@
 #include "SplunkFormatter.h"
 
-#include <sstream>
-#include <iomanip>
-#include <filesystem>
+#include <chrono>
 
 #include "Level.h"
 
@@ -18,6 +16,8 @@ FlexLog::SplunkFormatter::SplunkFormatter(const Options& options) : BaseStructur
 
     if (m_splunkOptions.sourceType.empty())
         m_splunkOptions.sourceType = "flex_log:log";
+
+    RebuildLayout();
 }
 
 std::string_view FlexLog::SplunkFormatter::GetContentType() const
@@ -30,528 +30,215 @@ std::unique_ptr<FlexLog::StructuredFormatter> FlexLog::SplunkFormatter::Clone()
     return std::make_unique<FlexLog::SplunkFormatter>(m_splunkOptions);
 }
 
-void FlexLog::SplunkFormatter::EscapeString(std::ostream& os, std::string_view str) const
+void FlexLog::SplunkFormatter::FormatBatch(std::span<const Message* const> messages, Buffer& out) const
 {
-    for (char c : str)
+    for (const Message* message : messages)
     {
-        switch (c)
-        {
-            case '"':  os << "\\\""; break;
-            case '\\': os << "\\\\"; break;
-            case '\b': os << "\\b"; break;
-            case '\f': os << "\\f"; break;
-            case '\n': os << "\\n"; break;
-            case '\r': os << "\\r"; break;
-            case '\t': os << "\\t"; break;
-            default:
-                if (static_cast<unsigned char>(c) < 32)
-                {
-                    // Control characters
-                    os << "\\u"
-                        << std::hex << std::setw(4) << std::setfill('0')
-                        << static_cast<int>(c)
-                        << std::dec;
-                }
-                else
-                {
-                    os << c;
-                }
-                break;
-            }
+        JsonWriter writer = MakeJsonWriter(out);
+        WriteLayout(writer, *message);
+        out.PushBack('\n');
     }
 }
 
-std::string FlexLog::SplunkFormatter::FormatMessageImpl(const Message& message) const
+void FlexLog::SplunkFormatter::FormatMessageImpl(const Message& message, Buffer& out) const
 {
-    if (m_splunkOptions.useHEC)
-        return FormatForHEC(message);
-    return FormatForSplunkJson(message);
+    JsonWriter writer = MakeJsonWriter(out);
+    WriteLayout(writer, message);
 }
 
-std::string FlexLog::SplunkFormatter::FormatStructuredDataImpl(const StructuredData& data) const
+void FlexLog::SplunkFormatter::CompileLayout(LayoutBuilder& builder) const
 {
-    if (data.IsEmpty())
-        return "{}";
-
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
-
-    ss << "{" << nl;
-
-    const auto& fields = data.GetFields();
-
-    // Sort keys if needed
-    std::vector<std::string> keys;
-    keys.reserve(fields.size());
-
-    for (const auto& [key, _] : fields)
-    {
-        keys.push_back(key);
-    }
-
-    if (m_options.sortKeys)
-        std::sort(keys.begin(), keys.end());
-
-    // Format fields
-    for (size_t i = 0; i < keys.size(); ++i)
-    {
-        const auto& key = keys[i];
-        const auto& value = fields.at(key);
-
-        if (!m_options.includeNullValues && std::holds_alternative<std::nullptr_t>(value))
-            continue;
+    if (m_splunkOptions.useHEC)
+        CompileHecLayout(builder);
+    else
+        CompileSplunkJsonLayout(builder);
+}
 
-        WriteIndent(ss, 1);
-        ss << "\"" << key << "\": ";
+void FlexLog::SplunkFormatter::WriteLayoutField(JsonWriter& writer, const Message& message, const FieldSet& fields, LayoutSlot slot, std::string_view renderedKey) const
+{
+    if (slot == EPOCH_SECONDS_FIELD)
+        WriteEpochSeconds(writer, message.timestamp);
+    else
+        BaseStructuredFormatter::WriteLayoutField(writer, message, fields, slot, renderedKey);
+}
 
-        std::visit([&](auto&& arg)
-        {
-            using T = std::decay_t<decltype(arg)>;
-
-            if constexpr (std::is_same_v<T, std::nullptr_t>)
-            {
-                ss << "null";
-            }
-            else if constexpr (std::is_same_v<T, std::string>)
-            {
-                ss << "\"";
-                EscapeString(ss, arg);
-                ss << "\"";
-            }
-            else if constexpr (std::is_same_v<T, int64_t> || 
-                std::is_same_v<T, uint64_t>)
-            {
-                ss << arg;
-            }
-            else if constexpr (std::is_same_v<T, double>)
-            {
-                ss << std::fixed << arg;
-            }
-            else if constexpr (std::is_same_v<T, bool>)
-            {
-                ss << (arg ? "true" : "false");
-            }
-            else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
-            {
-                ss << "\"" << FormatTimestamp(arg) << "\"";
-            }
-            else if constexpr (std::is_same_v<T, std::vector<std::string>> || 
-                std::is_same_v<T, std::vector<int64_t>> ||
-                std::is_same_v<T, std::vector<double>> ||
-                std::is_same_v<T, std::vector<bool>>)
-            {
-                ss << "[" << nl;
-
-                for (size_t j = 0; j < arg.size(); ++j)
-                {
-                    WriteIndent(ss, 2);
-
-                    if constexpr (std::is_same_v<T, std::vector<std::string>>)
-                    {
-                        ss << "\"";
-                        EscapeString(ss, arg[j]);
-                        ss << "\"";
-                    }
-                    else if constexpr (std::is_same_v<T, std::vector<bool>>)
-                    {
-                        ss << (arg[j] ? "true" : "false");
-                    }
-                    else
-                    {
-                        ss << arg[j];
-                    }
-
-                    if (j < arg.size() - 1)
-                        ss << ",";
-
-                    ss << nl;
-                }
-
-                WriteIndent(ss, 1);
-                ss << "]";
-            }
-        }, value);
-
-        if (i < keys.size() - 1)
-            ss << ",";
-
-        ss << nl;
-    }
+std::string FlexLog::SplunkFormatter::FormatStructuredDataImpl(const FieldSet& fields) const
+{
+    Buffer buffer;
+    JsonWriter writer = MakeJsonWriter(buffer);
 
-    ss << "}";
+    writer.BeginObject();
+    WriteJsonFields(writer, fields);
+    writer.EndObject();
 
-    return ss.str();
+    return buffer.ToString();
 }
 
-std::string FlexLog::SplunkFormatter::FormatForHEC(const Message& message) const
+void FlexLog::SplunkFormatter::CompileHecLayout(LayoutBuilder& builder) const
 {
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
-
     // Format for Splunk HTTP Event Collector (HEC)
-    ss << "{" << nl;
+    builder.BeginObject();
 
     // Required HEC fields
 
     // Event time in epoch seconds
     if (m_options.includeTimestamp)
-    {
-        WriteIndent(ss, 1);
-        auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-            message.timestamp.time_since_epoch()).count() / 1000.0;
-        ss << "\"time\": " << std::fixed << std::setprecision(3) << timestamp << "," << nl;
-    }
+        builder.Value("time", EPOCH_SECONDS_FIELD);
 
     // Source, sourcetype, and index (optional)
-    WriteIndent(ss, 1);
-    ss << "\"source\": \"" << m_splunkOptions.source << "\"," << nl;
-
-    WriteIndent(ss, 1);
-    ss << "\"sourcetype\": \"" << m_splunkOptions.sourceType << "\"," << nl;
+    builder.Member("source", m_splunkOptions.source);
+    builder.Member("sourcetype", m_splunkOptions.sourceType);
 
     if (!m_splunkOptions.index.empty())
-    {
-        WriteIndent(ss, 1);
-        ss << "\"index\": \"" << m_splunkOptions.index << "\"," << nl;
-    }
+        builder.Member("index", m_splunkOptions.index);
 
     // Host
-    WriteIndent(ss, 1);
-    ss << "\"host\": \"" << m_options.hostname << "\"," << nl;
+    builder.Member("host", m_options.hostname);
 
     // Event data
-    WriteIndent(ss, 1);
-    ss << "\"event\": {" << nl;
+    builder.BeginObject("event");
 
     // Message content
     if (m_options.includeMessage)
-    {
-        WriteIndent(ss, 2);
-        ss << "\"message\": \"";
-        EscapeString(ss, message.message);
-        ss << "\"," << nl;
-    }
+        builder.Value("message", LayoutField::Message);
 
     // Logger name
     if (m_options.includeLogger)
-    {
-        WriteIndent(ss, 2);
-        ss << "\"logger_name\": \"";
-        EscapeString(ss, message.name);
-        ss << "\"," << nl;
-    }
+        builder.Value("logger_name", LayoutField::Logger);
 
     // Log level
     if (m_options.includeLevel)
     {
-        WriteIndent(ss, 2);
-        ss << "\"level\": \"" << LevelToString(message.level) << "\"," << nl;
-        WriteIndent(ss, 2);
-        ss << "\"level_value\": " << static_cast<int>(message.level) << "," << nl;
+        builder.Value("level", LayoutField::Level);
+        builder.Value("level_value", LayoutField::LevelValue);
     }
 
     // Application information
-    WriteIndent(ss, 2);
-    ss << "\"application\": \"" << m_options.applicationName << "\"," << nl;
-
-    WriteIndent(ss, 2);
-    ss << "\"environment\": \"" << m_options.environment << "\"," << nl;
+    builder.Member("application", m_options.applicationName);
+    builder.Member("environment", m_options.environment);
 
     // Source location
     if (m_options.includeSourceLocation)
     {
-        WriteIndent(ss, 2);
-        ss << "\"file\": \"" 
-            << std::filesystem::path(message.sourceLocation.file_name()).filename().string() 
-            << "\"," << nl;
-
-        WriteIndent(ss, 2);
-        ss << "\"line\": " << message.sourceLocation.line() << "," << nl;
-
-        WriteIndent(ss, 2);
-        ss << "\"function\": \"" << message.sourceLocation.function_name() << "\"," << nl;
+        builder.Value("file", LayoutField::SourceFile);
+        builder.Value("line", LayoutField::SourceLine);
+        builder.Value("function", LayoutField::SourceFunction);
     }
 
-    // Process and thread info
+    // Process info
     if (m_options.includeProcessInfo)
     {
-        WriteIndent(ss, 2);
-        ss << "\"process_id\": \"" << GetProcessId() << "\"," << nl;
-
-        WriteIndent(ss, 2);
-        ss << "\"process_name\": \"" << GetProcessName() << "\"," << nl;
+        builder.Value("process_id", LayoutField::ProcessId);
+        builder.Value("process_name", LayoutField::ProcessName);
     }
 
     if (m_options.includeThreadId)
     {
-        WriteIndent(ss, 2);
-        ss << "\"thread_id\": \"" << GetThreadId() << "\"," << nl;
+        builder.Value("thread_id", LayoutField::ThreadId);
+        builder.Dynamic(LayoutField::ThreadName, "thread_name");
     }
 
     // Tags
-    if (!m_options.tags.empty())
-    {
-        WriteIndent(ss, 2);
-        ss << "\"tags\": [" << nl;
-
-        for (size_t i = 0; i < m_options.tags.size(); ++i)
-        {
-            WriteIndent(ss, 3);
-            ss << "\"" << m_options.tags[i] << "\"";
-
-            if (i < m_options.tags.size() - 1)
-                ss << ",";
-
-            ss << nl;
-        }
-
-        WriteIndent(ss, 2);
-        ss << "]," << nl;
-    }
+    builder.StringArray("tags", m_options.tags);
 
     // Structured data
-    if (!message.structuredData.IsEmpty())
-    {
-        const auto& fields = message.structuredData.GetFields();
-
-        for (const auto& [key, value] : fields)
-        {
-            WriteIndent(ss, 2);
-            ss << "\"" << key << "\": ";
-
-            std::visit([&](auto&& arg)
-            {
-                using T = std::decay_t<decltype(arg)>;
-
-                if constexpr (std::is_same_v<T, std::nullptr_t>)
-                {
-                    ss << "null";
-                }
-                else if constexpr (std::is_same_v<T, std::string>)
-                {
-                    ss << "\"";
-                    EscapeString(ss, arg);
-                    ss << "\"";
-                }
-                else if constexpr (std::is_same_v<T, int64_t> || 
-                    std::is_same_v<T, uint64_t>)
-                {
-                    ss << arg;
-                }
-                else if constexpr (std::is_same_v<T, double>)
-                {
-                    ss << std::fixed << arg;
-                }
-                else if constexpr (std::is_same_v<T, bool>)
-                {
-                    ss << (arg ? "true" : "false");
-                }
-                else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
-                {
-                    ss << "\"" << FormatTimestamp(arg) << "\"";
-                }
-                else if constexpr (std::is_same_v<T, std::vector<std::string>> || 
-                    std::is_same_v<T, std::vector<int64_t>>                    ||
-                    std::is_same_v<T, std::vector<double>>                     ||
-                    std::is_same_v<T, std::vector<bool>>)
-                {
-                    ss << "[" << nl;
-
-                    for (size_t i = 0; i < arg.size(); ++i)
-                    {
-                        WriteIndent(ss, 3);
-
-                        if constexpr (std::is_same_v<T, std::vector<std::string>>)
-                        {
-                            ss << "\"";
-                            EscapeString(ss, arg[i]);
-                            ss << "\"";
-                        }
-                        else if constexpr (std::is_same_v<T, std::vector<bool>>)
-                        {
-                            ss << (arg[i] ? "true" : "false");
-                        }
-                        else
-                        {
-                            ss << arg[i];
-                        }
-
-                        if (i < arg.size() - 1)
-                            ss << ",";
-
-                        ss << nl;
-                    }
-
-                    WriteIndent(ss, 2);
-                    ss << "]";
-                }
-            }, value);
-
-            ss << "," << nl;
-        }
-    }
+    builder.Dynamic(LayoutField::Fields);
 
     // Additional fields
-    for (auto it = m_options.userData.begin(); it != m_options.userData.end(); ++it)
-    {
-        WriteIndent(ss, 2);
-        ss << "\"" << it->first << "\": \"" << it->second << "\"";
-
-        if (std::next(it) != m_options.userData.end())
-            ss << ",";
-
-        ss << nl;
-    }
+    for (const auto& [key, value] : m_options.userData)
+        builder.Member(key, value);
 
     // Close the event object
-    WriteIndent(ss, 1);
-    ss << "}" << nl;
+    builder.EndObject();
 
     // Close the main object
-    ss << "}";
-
-    return ss.str();
+    builder.EndObject();
 }
 
-std::string FlexLog::SplunkFormatter::FormatForSplunkJson(const Message& message) const
+void FlexLog::SplunkFormatter::CompileSplunkJsonLayout(LayoutBuilder& builder) const
 {
     // Regular JSON format - similar to regular JSON formatter but with Splunk-specific fields
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
-
-    ss << "{" << nl;
+    builder.BeginObject();
 
     // Timestamp
     if (m_options.includeTimestamp)
     {
-        WriteIndent(ss, 1);
-        ss << "\"timestamp\": \"" << FormatTimestamp(message.timestamp) << "\"," << nl;
+        builder.Value("timestamp", LayoutField::Timestamp);
 
         // Also include Splunk-friendly epoch time
-        WriteIndent(ss, 1);
-        auto epochTime = std::chrono::duration_cast<std::chrono::milliseconds>(message.timestamp.time_since_epoch()).count() / 1000.0;
-        ss << "\"time\": " << std::fixed << std::setprecision(3) << epochTime << "," << nl;
+        builder.Value("time", EPOCH_SECONDS_FIELD);
     }
 
     // Message content
     if (m_options.includeMessage)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"message\": \"";
-        EscapeString(ss, message.message);
-        ss << "\"," << nl;
-    }
+        builder.Value("message", LayoutField::Message);
 
     // Splunk metadata
-    WriteIndent(ss, 1);
-    ss << "\"source\": \"" << m_splunkOptions.source << "\"," << nl;
-
-    WriteIndent(ss, 1);
-    ss << "\"sourcetype\": \"" << m_splunkOptions.sourceType << "\"," << nl;
+    builder.Member("source", m_splunkOptions.source);
+    builder.Member("sourcetype", m_splunkOptions.sourceType);
 
     if (!m_splunkOptions.index.empty())
-    {
-        WriteIndent(ss, 1);
-        ss << "\"index\": \"" << m_splunkOptions.index << "\"," << nl;
-    }
+        builder.Member("index", m_splunkOptions.index);
 
-    WriteIndent(ss, 1);
-    ss << "\"host\": \"" << m_options.hostname << "\"," << nl;
+    builder.Member("host", m_options.hostname);
 
     // Logger and level
     if (m_options.includeLogger)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"logger\": \"";
-        EscapeString(ss, message.name);
-        ss << "\"," << nl;
-    }
+        builder.Value("logger", LayoutField::Logger);
 
     if (m_options.includeLevel)
     {
-        WriteIndent(ss, 1);
-        ss << "\"level\": \"" << LevelToString(message.level) << "\"," << nl;
-        WriteIndent(ss, 1);
-        ss << "\"severity\": " << static_cast<int>(message.level) << "," << nl;
+        builder.Value("level", LayoutField::Level);
+        builder.Value("severity", LayoutField::LevelValue);
     }
 
     // Application information
-    WriteIndent(ss, 1);
-    ss << "\"application\": \"" << m_options.applicationName << "\"," << nl;
-
-    WriteIndent(ss, 1);
-    ss << "\"environment\": \"" << m_options.environment << "\"," << nl;
+    builder.Member("application", m_options.applicationName);
+    builder.Member("environment", m_options.environment);
 
     // Source location
     if (m_options.includeSourceLocation)
     {
-        WriteIndent(ss, 1);
-        ss << "\"location\": {" << nl;
-        WriteIndent(ss, 2);
-        ss << "\"file\": \"" 
-            << std::filesystem::path(message.sourceLocation.file_name()).filename().string() 
-            << "\"," << nl;
-        WriteIndent(ss, 2);
-        ss << "\"line\": " << message.sourceLocation.line() << "," << nl;
-        WriteIndent(ss, 2);
-        ss << "\"function\": \"" << message.sourceLocation.function_name() << "\"" << nl;
-        WriteIndent(ss, 1);
-        ss << "}," << nl;
+        builder.BeginObject("location");
+        builder.Value("file", LayoutField::SourceFile);
+        builder.Value("line", LayoutField::SourceLine);
+        builder.Value("function", LayoutField::SourceFunction);
+        builder.EndObject();
     }
 
     // Process and thread info
     if (m_options.includeProcessInfo || m_options.includeThreadId)
     {
-        WriteIndent(ss, 1);
-        ss << "\"process\": {" << nl;
+        builder.BeginObject("process");
 
         if (m_options.includeProcessInfo)
         {
-            WriteIndent(ss, 2);
-            ss << "\"pid\": \"" << GetProcessId() << "\"," << nl;
-            WriteIndent(ss, 2);
-            ss << "\"name\": \"" << GetProcessName() << "\"";
-
-            if (m_options.includeThreadId)
-                ss << ",";
-
-            ss << nl;
+            builder.Value("pid", LayoutField::ProcessId);
+            builder.Value("name", LayoutField::ProcessName);
         }
 
         if (m_options.includeThreadId)
         {
-            WriteIndent(ss, 2);
-            ss << "\"thread_id\": \"" << GetThreadId() << "\"" << nl;
+            builder.Value("thread_id", LayoutField::ThreadId);
+            builder.Dynamic(LayoutField::ThreadName, "thread_name");
         }
 
-        WriteIndent(ss, 1);
-        ss << "}," << nl;
+        builder.EndObject();
     }
 
     // Structured data
-    if (!message.structuredData.IsEmpty())
-    {
-        WriteIndent(ss, 1);
-        ss << "\"data\": " << FormatStructuredDataImpl(message.structuredData) << "," << nl;
-    }
+    builder.Dynamic(LayoutField::Fields, "data");
 
     // Additional fields
-    for (auto it = m_options.userData.begin(); it != m_options.userData.end(); ++it)
-    {
-        WriteIndent(ss, 1);
-        ss << "\"" << it->first << "\": \"" << it->second << "\"";
-
-        if (std::next(it) != m_options.userData.end())
-            ss << ",";
-
-        ss << nl;
-    }
+    for (const auto& [key, value] : m_options.userData)
+        builder.Member(key, value);
 
     // Close main object
-    ss << "}";
+    builder.EndObject();
+}
 
-    return ss.str();
+void FlexLog::SplunkFormatter::WriteEpochSeconds(JsonWriter& writer, const std::chrono::system_clock::time_point& timestamp)
+{
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()).count();
+    writer.Double(ms / 1000.0, 3);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BaseStructuredFormatter.h"
+#include <span>
 #include <string>
 
 namespace FlexLog
@@ -46,17 +47,33 @@ namespace FlexLog
         std::string_view GetContentType() const override;
         std::unique_ptr<StructuredFormatter> Clone() const override;
 
+        // Writes one HEC request body: the events back to back, one per line, which the collector
+        // indexes as a batch. Without HEC the records are simply written one per line.
+        void FormatBatch(std::span<const Message* const> messages, Buffer& out) const;
+
     protected:
-        void EscapeString(std::ostream& os, std::string_view str) const override;
-        std::string FormatMessageImpl(const Message& message) const override;
-        std::string FormatStructuredDataImpl(const StructuredData& data) const override;
+        void FormatMessageImpl(const Message& message, Buffer& out) const override;
+        std::string FormatStructuredDataImpl(const FieldSet& fields) const override;
+        void CompileLayout(LayoutBuilder& builder) const override;
+        void WriteLayoutField(JsonWriter& writer, const Message& message, const FieldSet& fields, LayoutSlot slot, std::string_view renderedKey) const override;
+
+        // Layout for HTTP Event Collector
+        void CompileHecLayout(LayoutBuilder& builder) const;
 
-        // Format for HTTP Event Collector
-        std::string FormatForHEC(const Message& message) const;
+        // Layout for standard Splunk JSON format
+        void CompileSplunkJsonLayout(LayoutBuilder& builder) const;
 
-        // Format for standard Splunk JSON format
-        std::string FormatForSplunkJson(const Message& message) const;
+        // Splunk's epoch time field: seconds with millisecond precision
+        static void WriteEpochSeconds(JsonWriter& writer, const std::chrono::system_clock::time_point& timestamp);
 
         Options m_splunkOptions;
+
+    private:
+        enum class SplunkField : uint8_t
+        {
+            EpochSeconds
+        };
+
+        static constexpr LayoutSlot EPOCH_SECONDS_FIELD = MakeFormatterField(SplunkField::EpochSeconds);
     };
 }
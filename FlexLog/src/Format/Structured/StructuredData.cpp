@@ -118,6 +118,7 @@ bool FlexLog::StructuredData::Remove(std::string_view key)
 void FlexLog::StructuredData::Clear()
 {
     m_fields.clear();
+    m_hasDeferred = false;
 }
 
 const std::unordered_map<std::string, FlexLog::StructuredData::FieldValue>& FlexLog::StructuredData::GetFields() const
@@ -131,6 +132,7 @@ FlexLog::StructuredData& FlexLog::StructuredData::Merge(const StructuredData& ot
     {
         m_fields[key] = value;
     }
+    m_hasDeferred |= other.m_hasDeferred;
     return *this;
 }
 
@@ -138,3 +140,34 @@ bool FlexLog::StructuredData::IsEmpty() const
 {
     return m_fields.empty();
 }
+
+void FlexLog::StructuredData::ResolveDeferred()
+{
+    if (!m_hasDeferred)
+        return;
+
+    m_hasDeferred = false;
+
+    for (auto& [key, value] : m_fields)
+    {
+        auto* deferred = std::get_if<DeferredValue>(&value);
+        if (!deferred)
+            continue;
+
+        // Keep the producer alive while it overwrites its own slot
+        std::shared_ptr<const DeferredField> producer = std::move(deferred->producer);
+        value = nullptr;
+
+        if (!producer)
+            continue;
+
+        try
+        {
+            producer->Resolve(*this, key);
+        }
+        catch (...)
+        {
+            // A throwing producer leaves the field null rather than losing the message
+        }
+    }
+}
@@ -10,14 +10,33 @@
 #include <variant>
 #include <optional>
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
 
 namespace FlexLog
 {
     class StructuredData;
 
+    // Produces a field value on the logging worker; see StructuredData::AddDeferred
+    class DeferredField
+    {
+    public:
+        virtual ~DeferredField() = default;
+        virtual void Resolve(StructuredData& data, std::string_view key) const = 0;
+    };
+
    class StructuredData
     {
     public:
+        struct DeferredValue
+        {
+            std::shared_ptr<const DeferredField> producer;
+
+            bool operator==(const DeferredValue& other) const { return producer == other.producer; }
+        };
+
         using FieldValue = std::variant
         <
             std::nullptr_t,
@@ -30,7 +49,8 @@ namespace FlexLog
             std::vector<std::string>,
             std::vector<int64_t>,
             std::vector<double>,
-            std::vector<bool>
+            std::vector<bool>,
+            DeferredValue
         >;
 
         StructuredData() = default;
@@ -55,6 +75,15 @@ namespace FlexLog
         StructuredData& Add(std::string_view key, const std::vector<double>& values);
         StructuredData& Add(std::string_view key, const std::vector<bool>& values);
 
+        // The producer runs on the worker thread, and only if some sink is going to emit
+        // the message. It must capture by value anything that may not outlive the call site.
+        // Copies of this StructuredData share the producer, which runs at most once for all of them.
+        template<typename Fn>
+        StructuredData& AddDeferred(std::string_view key, Fn&& producer);
+
+        bool HasDeferred() const { return m_hasDeferred; }
+        void ResolveDeferred();
+
         std::optional<FieldValue> Get(std::string_view key) const;
 
         bool HasField(std::string_view key) const;
@@ -71,5 +100,41 @@ namespace FlexLog
 
     private:
         std::unordered_map<std::string, FieldValue> m_fields;
+        bool m_hasDeferred = false;
     };
+
+    namespace Internal
+    {
+        template<typename Fn>
+        class DeferredFieldImpl final : public DeferredField
+        {
+        public:
+            explicit DeferredFieldImpl(Fn fn) : m_fn(std::move(fn)) {}
+
+            void Resolve(StructuredData& data, std::string_view key) const override
+            {
+                std::call_once(m_once, [this]() { m_value.emplace(m_fn()); });
+                data.Add(key, *m_value);
+            }
+
+        private:
+            using Result = std::decay_t<std::invoke_result_t<Fn&>>;
+
+            // Copies of a StructuredData, and the context frames a scope is merged into, share one
+            // producer. Whichever worker resolves it first runs it; the rest wait for and reuse its
+            // value. A producer that throws is tried again by the next one.
+            mutable Fn m_fn;
+            mutable std::once_flag m_once;
+            mutable std::optional<Result> m_value;
+        };
+    }
+
+    template<typename Fn>
+    StructuredData& StructuredData::AddDeferred(std::string_view key, Fn&& producer)
+    {
+        auto deferred = std::make_shared<const Internal::DeferredFieldImpl<std::decay_t<Fn>>>(std::forward<Fn>(producer));
+        m_fields[std::string(key)] = DeferredValue{ std::move(deferred) };
+        m_hasDeferred = true;
+        return *this;
+    }
 }
@@ -4,6 +4,7 @@
 #include <string_view>
 #include <memory>
 
+#include "Core/Buffer.h"
 #include "Message.h"
 #include "StructuredData.h"
 
@@ -17,6 +18,9 @@ namespace FlexLog
         // Format the entire message including structured data
         virtual std::string FormatMessage(const Message& message) const = 0;
 
+        // Append the formatted message to a caller-owned buffer
+        virtual void FormatTo(const Message& message, Buffer& out) const { out.Append(FormatMessage(message)); }
+
         // Format only the structured data portion
         virtual std::string FormatStructuredData(const StructuredData& data) const = 0;
 
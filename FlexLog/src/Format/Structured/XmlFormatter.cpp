@@ -1,19 +1,31 @@
 #include "XmlFormatter.h"
 
-#include <sstream>
-#include <iomanip>
-#include <filesystem>
 #include <chrono>
+#include <type_traits>
+#include <variant>
 
+#include "Core/NumberFormat.h"
+#include "Core/ProcessInfo.h"
+#include "Core/ThreadInfo.h"
 #include "Level.h"
 #include "Platform.h"
 
+namespace FlexLog::Internal
+{
+    // Fraction digits of <double> elements; attribute values use the shortest round-trip form
+    constexpr int XML_DOUBLE_PRECISION = 6;
+
+    constexpr std::string_view XML_DECLARATION = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
+}
+
 FlexLog::XmlFormatter::XmlFormatter(const Options& options) :
     BaseStructuredFormatter(options),
     m_xmlOptions(options)
 {
     if (m_options.hostname.empty())
         m_options.hostname = GetHostname();
+
+    RebuildLayout();
 }
 
 std::string_view FlexLog::XmlFormatter::GetContentType() const
@@ -26,424 +38,346 @@ std::unique_ptr<FlexLog::StructuredFormatter> FlexLog::XmlFormatter::Clone() con
     return std::make_unique<XmlFormatter>(m_xmlOptions);
 }
 
-void FlexLog::XmlFormatter::EscapeString(std::ostream& os, std::string_view str) const
+void FlexLog::XmlFormatter::FormatMessageImpl(const Message& message, Buffer& out) const
 {
-    for (char c : str)
-    {
-        switch (c)
-        {
-            case '<':  os << "&lt;"; break;
-            case '>':  os << "&gt;"; break;
-            case '&':  os << "&amp;"; break;
-            case '\'': os << "&apos;"; break;
-            case '"':  os << "&quot;"; break;
-            default:
-                if (static_cast<unsigned char>(c) < 32 && c != '\t' && c != '\n' && c != '\r')
-                {
-                    // Control characters (except tabs, newlines and carriage returns)
-                    os << "&#" << static_cast<int>(c) << ";";
-                }
-                else
-                {
-                    os << c;
-                }
-                break;
-            }
-    }
+    FormatXml(message, out);
 }
 
-std::string FlexLog::XmlFormatter::FormatMessageImpl(const Message& message) const
+std::string FlexLog::XmlFormatter::FormatStructuredDataImpl(const FieldSet& fields) const
 {
-    return FormatXml(message);
-}
-
-std::string FlexLog::XmlFormatter::FormatStructuredDataImpl(const StructuredData& data) const
-{
-    if (data.IsEmpty())
+    if (fields.IsEmpty())
         return "<data/>";
 
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
+    Buffer buffer;
+    XmlWriter writer = MakeXmlWriter(buffer);
+    WriteFields(writer, fields, 0);
+    return buffer.ToString();
+}
 
-    ss << "<data>" << nl;
+void FlexLog::XmlFormatter::RebuildLayout()
+{
+    BaseStructuredFormatter::RebuildLayout();
 
-    const auto& fields = data.GetFields();
+    Buffer buffer;
+    XmlWriter writer = MakeXmlWriter(buffer);
 
-    // Sort keys if needed
-    std::vector<std::string> keys;
-    keys.reserve(fields.size());
+    const auto take = [&buffer]()
+    {
+        std::string rendered = buffer.ToString();
+        buffer.Clear();
+        return rendered;
+    };
 
-    for (const auto& [key, _] : fields)
+    const auto escaped = [](std::string_view text)
     {
-        keys.push_back(key);
-    }
+        return [text](XmlWriter& w) { w.Escaped(text); };
+    };
 
-    if (m_options.sortKeys)
-        std::sort(keys.begin(), keys.end());
+    // Root element, left open so the per-record attributes can follow
+    if (m_xmlOptions.includeXmlDeclaration)
+        writer.Line(0, Internal::XML_DECLARATION);
+
+    writer.Raw("<");
+    writer.Raw(m_xmlOptions.rootElementName);
+    m_rootOpen = take();
+
+    writer.Raw("</");
+    writer.Raw(m_xmlOptions.rootElementName);
+    writer.Raw(">");
+    m_rootClose = take();
+
+    // Application, environment and host, as attributes or as elements
+    writer.Raw(" application=\"");
+    writer.Escaped(m_options.applicationName);
+    writer.Raw("\" environment=\"");
+    writer.Escaped(m_options.environment);
+    writer.Raw("\" host=\"");
+    writer.Escaped(m_options.hostname);
+    writer.Raw("\"");
+    m_staticAttributes = take();
+
+    writer.Element(1, "<application>", "</application>", escaped(m_options.applicationName));
+    writer.Element(1, "<environment>", "</environment>", escaped(m_options.environment));
+    writer.Element(1, "<host>", "</host>", escaped(m_options.hostname));
+    m_staticElements = take();
 
-    // Format fields
-    for (size_t i = 0; i < keys.size(); ++i)
+    // Tags
+    if (!m_options.tags.empty())
     {
-        const auto& key = keys[i];
-        const auto& value = fields.at(key);
-
-        if (!m_options.includeNullValues && std::holds_alternative<std::nullptr_t>(value))
-            continue;
+        writer.Line(1, "<tags>");
 
-        if (m_xmlOptions.useAttributes && 
-            (std::holds_alternative<std::string>(value) ||
-                std::holds_alternative<int64_t>(value)  ||
-                std::holds_alternative<uint64_t>(value) ||
-                std::holds_alternative<double>(value)   ||
-                std::holds_alternative<bool>(value)))
-        {
-            WriteIndent(ss, 1);
-            ss << "<" << m_xmlOptions.fieldElementName << " name=\"" << key << "\" value=\"";
+        for (const auto& tag : m_options.tags)
+            writer.Element(2, "<tag>", "</tag>", escaped(tag));
 
-            std::visit([&](auto&& arg)
-            {
-                using T = std::decay_t<decltype(arg)>;
+        writer.Line(1, "</tags>");
+    }
+    m_tagElements = take();
 
-                if constexpr (std::is_same_v<T, std::string>)
-                {
-                    EscapeString(ss, arg);
-                }
-                else if constexpr (std::is_same_v<T, int64_t> || 
-                    std::is_same_v<T, uint64_t> ||
-                    std::is_same_v<T, double>)
-                {
-                    ss << arg;
-                }
-                else if constexpr (std::is_same_v<T, bool>)
-                {
-                    ss << (arg ? "true" : "false");
-                }
-            }, value);
+    // User data, one element per key
+    if (!m_options.userData.empty())
+    {
+        writer.Line(1, "<user_data>");
 
-            ss << "\"/>" << nl;
-        }
-        else
+        for (const auto& [key, value] : m_options.userData)
         {
-            WriteIndent(ss, 1);
-            ss << "<" << m_xmlOptions.fieldElementName << " name=\"" << key << "\">" << nl;
-
-            WriteValue(ss, value, 2);
-
-            WriteIndent(ss, 1);
-            ss << "</" << m_xmlOptions.fieldElementName << ">" << nl;
+            writer.BeginLine(2);
+            writer.Raw("<");
+            writer.Raw(key);
+            writer.Raw(">");
+            writer.Escaped(value);
+            writer.Raw("</");
+            writer.Raw(key);
+            writer.Raw(">");
+            writer.EndLine();
         }
-    }
 
-    ss << "</data>";
-
-    return ss.str();
+        writer.Line(1, "</user_data>");
+    }
+    m_userDataElements = take();
+
+    // Structured data fields
+    writer.Raw("<");
+    writer.Raw(m_xmlOptions.fieldElementName);
+    writer.Raw(" name=\"");
+    m_fieldOpen = take();
+
+    writer.Raw("</");
+    writer.Raw(m_xmlOptions.fieldElementName);
+    writer.Raw(">");
+    m_fieldClose = take();
 }
 
-std::string FlexLog::XmlFormatter::FormatXml(const Message& message) const
+void FlexLog::XmlFormatter::FormatXml(const Message& message, Buffer& out) const
 {
-    std::stringstream ss;
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
+    XmlWriter writer = MakeXmlWriter(out);
 
-    // XML declaration
-    if (m_xmlOptions.includeXmlDeclaration)
-        ss << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << nl;
+    const auto timestamp = [this, &message](XmlWriter& w) { FormatTimestampTo(w.GetBuffer(), message.timestamp); };
+    const auto level = [&message](XmlWriter& w) { w.Raw(LevelToString(message.level)); };
+    const auto levelValue = [&message](XmlWriter& w) { w.Int(static_cast<int>(message.level)); };
 
     // Root element
-    ss << "<" << m_xmlOptions.rootElementName;
+    writer.Raw(m_rootOpen);
 
     // Add attributes if using attribute style
     if (m_xmlOptions.useAttributes)
     {
         if (m_options.includeTimestamp)
-            ss << " timestamp=\"" << FormatTimestamp(message.timestamp) << "\"";
+        {
+            writer.Raw(" timestamp=\"");
+            timestamp(writer);
+            writer.Raw("\"");
+        }
 
         if (m_options.includeLevel)
         {
-            ss << " level=\"" << LevelToString(message.level) << "\"";
-            ss << " level_value=\"" << static_cast<int>(message.level) << "\"";
+            writer.Raw(" level=\"");
+            level(writer);
+            writer.Raw("\" level_value=\"");
+            levelValue(writer);
+            writer.Raw("\"");
         }
 
-        ss << " application=\"" << m_options.applicationName << "\"";
-        ss << " environment=\"" << m_options.environment << "\"";
-        ss << " host=\"" << m_options.hostname << "\"";
+        writer.Raw(m_staticAttributes);
     }
 
-    ss << ">" << nl;
+    writer.Raw(">");
+    writer.EndLine();
 
     // Elements for each field
     if (!m_xmlOptions.useAttributes || !m_options.includeTimestamp)
-    {
-        WriteIndent(ss, 1);
-        ss << "<timestamp>" << FormatTimestamp(message.timestamp) << "</timestamp>" << nl;
-    }
+        writer.Element(1, "<timestamp>", "</timestamp>", timestamp);
 
     if (m_options.includeMessage)
-    {
-        WriteIndent(ss, 1);
-        ss << "<message>";
-
-        if (m_xmlOptions.useCDATA)
-            ss << WrapInCDATA(message.message);
-        else
-            EscapeString(ss, message.message);
-
-        ss << "</message>" << nl;
-    }
+        writer.Element(1, "<message>", "</message>", [&message](XmlWriter& w) { w.Text(message.message); });
 
     if (m_options.includeLogger)
-    {
-        WriteIndent(ss, 1);
-        ss << "<logger>";
-        EscapeString(ss, message.name);
-        ss << "</logger>" << nl;
-    }
+        writer.Element(1, "<logger>", "</logger>", [&message](XmlWriter& w) { w.Escaped(message.name); });
 
     if (!m_xmlOptions.useAttributes || !m_options.includeLevel)
     {
-        WriteIndent(ss, 1);
-        ss << "<level>" << LevelToString(message.level) << "</level>" << nl;
-        WriteIndent(ss, 1);
-        ss << "<level_value>" << static_cast<int>(message.level) << "</level_value>" << nl;
+        writer.Element(1, "<level>", "</level>", level);
+        writer.Element(1, "<level_value>", "</level_value>", levelValue);
     }
 
     if (!m_xmlOptions.useAttributes)
-    {
-        WriteIndent(ss, 1);
-        ss << "<application>" << m_options.applicationName << "</application>" << nl;
-        WriteIndent(ss, 1);
-        ss << "<environment>" << m_options.environment << "</environment>" << nl;
-        WriteIndent(ss, 1);
-        ss << "<host>" << m_options.hostname << "</host>" << nl;
-    }
+        writer.Raw(m_staticElements);
 
     // Source location
     if (m_options.includeSourceLocation)
     {
-        WriteIndent(ss, 1);
-        ss << "<location>" << nl;
-
-        WriteIndent(ss, 2);
-        ss << "<file>" << std::filesystem::path(message.sourceLocation.file_name()).filename().string() << "</file>" << nl;
+        const SourceLocation& location = message.sourceLocation;
 
-        WriteIndent(ss, 2);
-        ss << "<line>" << message.sourceLocation.line() << "</line>" << nl;
-
-        WriteIndent(ss, 2);
-        ss << "<function>" << message.sourceLocation.function_name() << "</function>" << nl;
-
-        WriteIndent(ss, 1);
-        ss << "</location>" << nl;
+        writer.Line(1, "<location>");
+        writer.Element(2, "<file>", "</file>", [&location](XmlWriter& w) { w.Escaped(GetSourceFileName(location)); });
+        writer.Element(2, "<line>", "</line>", [&location](XmlWriter& w) { w.UInt(location.line()); });
+        writer.Element(2, "<function>", "</function>", [&location](XmlWriter& w) { w.Escaped(location.function_name()); });
+        writer.Line(1, "</location>");
     }
 
-    // Process info
+    // Process info, read per record so a forked child reports its own pid
     if (m_options.includeProcessInfo)
     {
-        WriteIndent(ss, 1);
-        ss << "<process>" << nl;
-
-        WriteIndent(ss, 2);
-        ss << "<id>" << GetProcessId() << "</id>" << nl;
+        const ProcessInfo::Snapshot& process = ProcessInfo::Get();
 
-        WriteIndent(ss, 2);
-        ss << "<name>" << GetProcessName() << "</name>" << nl;
-
-        WriteIndent(ss, 1);
-        ss << "</process>" << nl;
+        writer.Line(1, "<process>");
+        writer.Element(2, "<id>", "</id>", [&process](XmlWriter& w) { w.Raw(process.pidText); });
+        writer.Element(2, "<name>", "</name>", [&process](XmlWriter& w) { w.Escaped(process.name); });
+        writer.Line(1, "</process>");
     }
 
     // Thread ID
     if (m_options.includeThreadId)
     {
-        WriteIndent(ss, 1);
-        ss << "<thread_id>" << GetThreadId() << "</thread_id>" << nl;
+        writer.Element(1, "<thread_id>", "</thread_id>", [&message](XmlWriter& w) { w.UInt(message.threadId); });
+
+        if (!message.threadName.empty())
+            writer.Element(1, "<thread_name>", "</thread_name>", [&message](XmlWriter& w) { w.Escaped(message.threadName); });
     }
 
     // Tags
-    if (!m_options.tags.empty())
-    {
-        WriteIndent(ss, 1);
-        ss << "<tags>" << nl;
-
-        for (const auto& tag : m_options.tags)
-        {
-            WriteIndent(ss, 2);
-            ss << "<tag>" << tag << "</tag>" << nl;
-        }
-
-        WriteIndent(ss, 1);
-        ss << "</tags>" << nl;
-    }
+    writer.Raw(m_tagElements);
 
     // Structured data
-    if (!message.structuredData.IsEmpty())
+    const FieldSet fields(message);
+    if (!fields.IsEmpty())
     {
-        WriteIndent(ss, 1);
-        ss << FormatStructuredDataImpl(message.structuredData) << nl;
+        WriteFields(writer, fields, 1);
+        writer.EndLine();
     }
 
     // User data
-    if (!m_options.userData.empty())
+    writer.Raw(m_userDataElements);
+
+    // Close root element
+    writer.Raw(m_rootClose);
+}
+
+void FlexLog::XmlFormatter::WriteFields(XmlWriter& writer, const FieldSet& fields, int depth) const
+{
+    writer.Line(depth, "<data>");
+
+    fields.ForEach([&](std::string_view key, const FieldView& value)
     {
-        WriteIndent(ss, 1);
-        ss << "<user_data>" << nl;
+        if (!m_options.includeNullValues && std::holds_alternative<std::nullptr_t>(value))
+            return;
 
-        for (const auto& [key, value] : m_options.userData)
+        writer.BeginLine(depth + 1);
+        writer.Raw(m_fieldOpen);
+        writer.Escaped(key);
+
+        if (m_xmlOptions.useAttributes &&
+            (std::holds_alternative<std::string_view>(value) ||
+                std::holds_alternative<int64_t>(value)  ||
+                std::holds_alternative<uint64_t>(value) ||
+                std::holds_alternative<double>(value)   ||
+                std::holds_alternative<bool>(value)))
         {
-            WriteIndent(ss, 2);
-            ss << "<" << key << ">" << value << "</" << key << ">" << nl;
+            writer.Raw("\" value=\"");
+
+            std::visit([&](auto&& arg)
+            {
+                using T = std::decay_t<decltype(arg)>;
+
+                if constexpr (std::is_same_v<T, std::string_view>)
+                    writer.Escaped(arg);
+                else if constexpr (std::is_same_v<T, int64_t>)
+                    writer.Int(arg);
+                else if constexpr (std::is_same_v<T, uint64_t>)
+                    writer.UInt(arg);
+                else if constexpr (std::is_same_v<T, double>)
+                    writer.Double(arg, SHORTEST_PRECISION);
+                else if constexpr (std::is_same_v<T, bool>)
+                    writer.Bool(arg);
+            }, value);
+
+            writer.Raw("\"/>");
+            writer.EndLine();
         }
+        else
+        {
+            writer.Raw("\">");
+            writer.EndLine();
 
-        WriteIndent(ss, 1);
-        ss << "</user_data>" << nl;
-    }
+            WriteValue(writer, value, depth + 2);
 
-    // Close root element
-    ss << "</" << m_xmlOptions.rootElementName << ">";
+            writer.Line(depth + 1, m_fieldClose);
+        }
+    }, m_options.sortKeys);
 
-    return ss.str();
+    // The caller ends the line, so a standalone <data> element has no trailing newline
+    writer.BeginLine(depth);
+    writer.Raw("</data>");
 }
 
-void FlexLog::XmlFormatter::WriteValue(std::ostream& os, const StructuredData::FieldValue& value, int indentLevel) const
+void FlexLog::XmlFormatter::WriteValue(XmlWriter& writer, const FieldView& value, int depth) const
 {
-    const bool pretty = m_options.prettyPrint;
-    const std::string nl = pretty ? "\n" : "";
-
     std::visit([&](auto&& arg)
     {
         using T = std::decay_t<decltype(arg)>;
 
         if constexpr (std::is_same_v<T, std::nullptr_t>)
         {
-            WriteIndent(os, indentLevel);
-            os << "<null/>" << nl;
+            writer.Line(depth, "<null/>");
         }
-        else if constexpr (std::is_same_v<T, std::string>)
+        else if constexpr (std::is_same_v<T, std::string_view>)
         {
-            WriteIndent(os, indentLevel);
-            os << "<string>";
-
-            if (m_xmlOptions.useCDATA)
-                os << WrapInCDATA(arg);
-            else
-                EscapeString(os, arg);
-
-            os << "</string>" << nl;
+            writer.Element(depth, "<string>", "</string>", [&arg](XmlWriter& w) { w.Text(arg); });
         }
         else if constexpr (std::is_same_v<T, int64_t>)
         {
-            WriteIndent(os, indentLevel);
-            os << "<int>" << arg << "</int>" << nl;
+            writer.Element(depth, "<int>", "</int>", [&arg](XmlWriter& w) { w.Int(arg); });
         }
         else if constexpr (std::is_same_v<T, uint64_t>)
         {
-            WriteIndent(os, indentLevel);
-            os << "<uint>" << arg << "</uint>" << nl;
+            writer.Element(depth, "<uint>", "</uint>", [&arg](XmlWriter& w) { w.UInt(arg); });
         }
         else if constexpr (std::is_same_v<T, double>)
         {
-            WriteIndent(os, indentLevel);
-            os << "<double>" << std::fixed << arg << "</double>" << nl;
+            writer.Element(depth, "<double>", "</double>", [&arg](XmlWriter& w) { w.Double(arg, Internal::XML_DOUBLE_PRECISION); });
         }
         else if constexpr (std::is_same_v<T, bool>)
         {
-            WriteIndent(os, indentLevel);
-            os << "<bool>" << (arg ? "true" : "false") << "</bool>" << nl;
+            writer.Element(depth, "<bool>", "</bool>", [&arg](XmlWriter& w) { w.Bool(arg); });
         }
         else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
         {
-            WriteIndent(os, indentLevel);
-            os << "<datetime>" << FormatTimestamp(arg) << "</datetime>" << nl;
+            writer.Element(depth, "<datetime>", "</datetime>", [this, &arg](XmlWriter& w) { FormatTimestampTo(w.GetBuffer(), arg); });
         }
-        else if constexpr (std::is_same_v<T, std::vector<std::string>>)
+        else if constexpr (std::is_same_v<T, std::span<const std::string>>)
         {
-            WriteIndent(os, indentLevel);
-            os << "<array type=\"string\">" << nl;
+            writer.Line(depth, "<array type=\"string\">");
 
             for (const auto& item : arg)
-            {
-                WriteIndent(os, indentLevel + 1);
-                os << "<item>";
-
-                if (m_xmlOptions.useCDATA)
-                    os << WrapInCDATA(item);
-                else
-                    EscapeString(os, item);
+                writer.Element(depth + 1, "<item>", "</item>", [&item](XmlWriter& w) { w.Text(item); });
 
-                os << "</item>" << nl;
-            }
-
-            WriteIndent(os, indentLevel);
-            os << "</array>" << nl;
+            writer.Line(depth, "</array>");
         }
-        else if constexpr (std::is_same_v<T, std::vector<int64_t>>)
+        else if constexpr (std::is_same_v<T, std::span<const int64_t>>)
         {
-            WriteIndent(os, indentLevel);
-            os << "<array type=\"int\">" << nl;
+            writer.Line(depth, "<array type=\"int\">");
 
-            for (const auto& item : arg)
-            {
-                WriteIndent(os, indentLevel + 1);
-                os << "<item>" << item << "</item>" << nl;
-            }
+            for (const int64_t item : arg)
+                writer.Element(depth + 1, "<item>", "</item>", [item](XmlWriter& w) { w.Int(item); });
 
-            WriteIndent(os, indentLevel);
-            os << "</array>" << nl;
+            writer.Line(depth, "</array>");
         }
-        else if constexpr (std::is_same_v<T, std::vector<double>>)
+        else if constexpr (std::is_same_v<T, std::span<const double>>)
         {
-            WriteIndent(os, indentLevel);
-            os << "<array type=\"double\">" << nl;
+            writer.Line(depth, "<array type=\"double\">");
 
-            for (const auto& item : arg)
-            {
-                WriteIndent(os, indentLevel + 1);
-                os << "<item>" << std::fixed << item << "</item>" << nl;
-            }
+            for (const double item : arg)
+                writer.Element(depth + 1, "<item>", "</item>", [item](XmlWriter& w) { w.Double(item, Internal::XML_DOUBLE_PRECISION); });
 
-            WriteIndent(os, indentLevel);
-            os << "</array>" << nl;
+            writer.Line(depth, "</array>");
         }
-        else if constexpr (std::is_same_v<T, std::vector<bool>>)
+        else if constexpr (std::is_same_v<T, BoolSpan>)
         {
-            WriteIndent(os, indentLevel);
-            os << "<array type=\"bool\">" << nl;
+            writer.Line(depth, "<array type=\"bool\">");
 
-            for (const auto& item : arg)
-            {
-                WriteIndent(os, indentLevel + 1);
-                os << "<item>" << (item ? "true" : "false") << "</item>" << nl;
-            }
+            for (const bool item : arg)
+                writer.Element(depth + 1, "<item>", "</item>", [item](XmlWriter& w) { w.Bool(item); });
 
-            WriteIndent(os, indentLevel);
-            os << "</array>" << nl;
+            writer.Line(depth, "</array>");
         }
     }, value);
 }
-
-std::string FlexLog::XmlFormatter::WrapInCDATA(std::string_view text) const
-{
-    std::string result = "<![CDATA[";
-    result += text;
-
-    // CDATA sections cannot contain the sequence "]]>", so we need to split it
-    // if it appears in the text
-    size_t pos = 0;
-    while ((pos = result.find("]]>", pos)) != std::string::npos)
-    {
-        // Replace "]]>" with "]]]]><![CDATA[>"
-        result.replace(pos, 3, "]]]]><![CDATA[>");
-        pos += 13; // Move past the replacement
-    }
-
-    result += "]]>";
-    return result;
-}
-
-std::string FlexLog::XmlFormatter::EscapeXml(std::string_view text) const
-{
-    std::stringstream ss;
-    EscapeString(ss, text);
-    return ss.str();
-}
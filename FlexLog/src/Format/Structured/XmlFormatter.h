@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BaseStructuredFormatter.h"
+#include "XmlWriter.h"
 #include <string>
 
 namespace FlexLog
@@ -54,16 +55,31 @@ namespace FlexLog
         std::unique_ptr<StructuredFormatter> Clone() const override;
 
     protected:
-        void EscapeString(std::ostream& os, std::string_view str) const override;
-        std::string FormatMessageImpl(const Message& message) const override;
-        std::string FormatStructuredDataImpl(const StructuredData& data) const override;
+        void FormatMessageImpl(const Message& message, Buffer& out) const override;
+        std::string FormatStructuredDataImpl(const FieldSet& fields) const override;
+
+        // Renders the option-dependent markup below once, so records only copy it
+        void RebuildLayout() override;
 
     private:
-        std::string FormatXml(const Message& message) const;
-        void WriteValue(std::ostream& os, const StructuredData::FieldValue& value, int indentLevel) const;
-        std::string WrapInCDATA(std::string_view text) const;
-        std::string EscapeXml(std::string_view text) const;
+        XmlWriter MakeXmlWriter(Buffer& out) const { return XmlWriter(out, m_options.prettyPrint, m_options.indentSize, m_xmlOptions.useCDATA); }
+
+        void FormatXml(const Message& message, Buffer& out) const;
+
+        // Writes fields as a <data> element whose tags sit at depth
+        void WriteFields(XmlWriter& writer, const FieldSet& fields, int depth) const;
+        void WriteValue(XmlWriter& writer, const FieldView& value, int depth) const;
 
         Options m_xmlOptions;
+
+        // Pre-rendered by RebuildLayout()
+        std::string m_rootOpen;             // Declaration and "<root", left open for the attributes
+        std::string m_rootClose;            // "</root>"
+        std::string m_staticAttributes;     // application, environment and host attributes, escaped
+        std::string m_staticElements;       // The same as elements, laid out at depth 1
+        std::string m_tagElements;          // <tags> block, empty without tags
+        std::string m_userDataElements;     // <user_data> block, empty without user data
+        std::string m_fieldOpen;            // "<field name=\""
+        std::string m_fieldClose;           // "</field>"
     };
 }
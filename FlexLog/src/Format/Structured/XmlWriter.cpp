@@ -0,0 +1,120 @@
+#include "XmlWriter.h"
+
+#include <array>
+#include <cstring>
+
+#include "Core/TextScan.h"
+
+namespace FlexLog::Internal
+{
+    // Entity for each character the XML scan reports; empty for tabs, line breaks and other controls
+    constexpr std::array<std::string_view, 256> XML_ENTITIES = []
+    {
+        std::array<std::string_view, 256> table{};
+
+        table['<'] = "&lt;";
+        table['>'] = "&gt;";
+        table['&'] = "&amp;";
+        table['\''] = "&apos;";
+        table['"'] = "&quot;";
+
+        return table;
+    }();
+
+    constexpr std::string_view CDATA_OPEN = "<![CDATA[";
+    constexpr std::string_view CDATA_CLOSE = "]]>";
+
+    // "]]>" inside a section: the "]]" ends this one and the '>' starts the next
+    constexpr std::string_view CDATA_SPLIT = "]]]]><![CDATA[>";
+
+    bool IsLineCharacter(char c)
+    {
+        return c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // EscapeXml() for text already known to be valid UTF-8
+    void EscapeValidXml(Buffer& out, const char* data, size_t size)
+    {
+        size_t i = 0;
+
+        while (i < size)
+        {
+            // Copy the clean run found by the vector scan in one go
+            const size_t run = FindXmlEscape(data + i, size - i);
+            out.Append(data + i, run);
+            i += run;
+
+            if (i == size)
+                break;
+
+            const unsigned char c = static_cast<unsigned char>(data[i++]);
+            const std::string_view entity = XML_ENTITIES[c];
+
+            if (!entity.empty())
+                out.Append(entity);
+            else if (IsLineCharacter(static_cast<char>(c)))
+                out.PushBack(static_cast<char>(c));
+            else
+                out.Append(UTF8_REPLACEMENT_CHARACTER); // XML 1.0 can't hold most control characters, even as references
+        }
+    }
+
+    // The body of a CDATA section, for text already known to be valid UTF-8. An invalid byte between
+    // two runs can't be part of a "]]>", so each run is split on its own.
+    void AppendValidCData(Buffer& out, const char* data, size_t size)
+    {
+        size_t i = 0;
+
+        while (i < size)
+        {
+            const size_t run = FindCDataBreak(data + i, size - i);
+            out.Append(data + i, run);
+            i += run;
+
+            if (i == size)
+                break;
+
+            const char c = data[i];
+            if (c == ']' && size - i >= 3 && data[i + 1] == ']' && data[i + 2] == '>')
+            {
+                out.Append(CDATA_SPLIT);
+                i += 3;
+                continue;
+            }
+
+            if (c == ']' || IsLineCharacter(c))
+                out.PushBack(c);
+            else
+                out.Append(UTF8_REPLACEMENT_CHARACTER);
+
+            ++i;
+        }
+    }
+
+    void EscapeXml(Buffer& out, std::string_view str)
+    {
+        ForEachValidUtf8Run(out, str, [&out](const char* data, size_t size) { EscapeValidXml(out, data, size); });
+    }
+
+    void AppendCData(Buffer& out, std::string_view str)
+    {
+        out.Append(CDATA_OPEN);
+        ForEachValidUtf8Run(out, str, [&out](const char* data, size_t size) { AppendValidCData(out, data, size); });
+        out.Append(CDATA_CLOSE);
+    }
+}
+
+void FlexLog::XmlWriter::BeginLine(int depth)
+{
+    const size_t width = static_cast<size_t>(depth) * static_cast<size_t>(m_indentSize);
+    if (width > 0)
+        std::memset(m_out.Extend(width), ' ', width);
+}
+
+void FlexLog::XmlWriter::Text(std::string_view text)
+{
+    if (m_useCDATA)
+        Internal::AppendCData(m_out, text);
+    else
+        Internal::EscapeXml(m_out, text);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "Common.h"
+#include "Core/Buffer.h"
+#include "Core/NumberFormat.h"
+
+namespace FlexLog
+{
+    namespace Internal
+    {
+        // Appends str with XML entities applied (no surrounding quotes). Control characters other
+        // than tabs and line breaks can't be written in XML 1.0 at all, so they become U+FFFD, as
+        // do bytes that aren't valid UTF-8.
+        void EscapeXml(Buffer& out, std::string_view str);
+
+        // Appends str as a CDATA section. "]]>" is split across two sections; control characters
+        // other than tabs and line breaks, and invalid UTF-8, become U+FFFD as in EscapeXml().
+        void AppendCData(Buffer& out, std::string_view str);
+    }
+
+    /**
+    * @brief Streaming XML writer that appends straight into a Buffer.
+    *
+    * Tags are passed in already rendered, typically from tables a formatter
+    * builds once from its options, so the writer only lays out lines and
+    * renders text. Escaping and CDATA splitting copy clean runs found by the
+    * vector scans in TextScan; numbers go through std::to_chars.
+    */
+    class XmlWriter
+    {
+    public:
+        explicit XmlWriter(Buffer& out, bool prettyPrint = false, int indentSize = 2, bool useCDATA = true) :
+            m_out(out),
+            m_indentSize(prettyPrint ? indentSize : 0),
+            m_prettyPrint(prettyPrint),
+            m_useCDATA(useCDATA)
+        {}
+
+        // Indents to depth when pretty printing; nothing otherwise
+        void BeginLine(int depth);
+
+        // Ends the line when pretty printing; nothing otherwise
+        void EndLine()
+        {
+            if (m_prettyPrint)
+                m_out.PushBack('\n');
+        }
+
+        // Writes markup that is already valid XML, such as a pre-rendered tag
+        void Raw(std::string_view xml) { m_out.Append(xml); }
+
+        // Writes element content: a CDATA section when the writer uses them, escaped text otherwise
+        void Text(std::string_view text);
+
+        // Writes escaped text; attribute values always take this form
+        void Escaped(std::string_view text) { Internal::EscapeXml(m_out, text); }
+
+        void Int(int64_t value) { Internal::AppendInteger(m_out, value); }
+        void UInt(uint64_t value) { Internal::AppendInteger(m_out, value); }
+        void Double(double value, int precision) { Internal::AppendDouble(m_out, value, precision); }
+        void Bool(bool value) { m_out.Append(value ? std::string_view("true") : std::string_view("false")); }
+
+        // Writes a line holding markup only, such as an opening or closing tag
+        void Line(int depth, std::string_view xml)
+        {
+            BeginLine(depth);
+            m_out.Append(xml);
+            EndLine();
+        }
+
+        // Writes open, the content written by writeContent(XmlWriter&), then close on a line of their own
+        template<typename ContentFn>
+        void Element(int depth, std::string_view open, std::string_view close, ContentFn&& writeContent)
+        {
+            BeginLine(depth);
+            m_out.Append(open);
+            writeContent(*this);
+            m_out.Append(close);
+            EndLine();
+        }
+
+        bool IsPrettyPrint() const { return m_prettyPrint; }
+        Buffer& GetBuffer() { return m_out; }
+
+    private:
+        Buffer& m_out;
+        int m_indentSize;
+        bool m_prettyPrint;
+        bool m_useCDATA;
+    };
+}
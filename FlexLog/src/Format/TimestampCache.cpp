@@ -0,0 +1,392 @@
+#include "TimestampCache.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <mutex>
+
+#include "Platform.h"
+
+namespace
+{
+    constexpr std::time_t SECONDS_PER_DAY = 86400;
+
+    // How far ahead a zone window looks for the next DST transition
+    constexpr int MAX_SCAN_DAYS = 366;
+
+    // Distinct zone windows kept alive; past this, lookups fall back to the C library
+    constexpr size_t MAX_ZONE_WINDOWS = 64;
+
+    constexpr uint32_t POWERS_OF_TEN[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+    // Days since 1970-01-01 for a proleptic Gregorian date
+    int64_t DaysFromCivil(int64_t year, unsigned month, unsigned day)
+    {
+        year -= month <= 2;
+        const int64_t era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+        const unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+    }
+
+    void CivilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day)
+    {
+        days += 719468;
+        const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        const unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+        const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        const unsigned monthPrime = (5 * dayOfYear + 2) / 153;
+
+        day = dayOfYear - (153 * monthPrime + 2) / 5 + 1;
+        month = monthPrime < 10 ? monthPrime + 3 : monthPrime - 9;
+        year = static_cast<int64_t>(yearOfEra) + era * 400 + (month <= 2);
+    }
+
+    // Fills the calendar fields of reference for the given wall-clock seconds. The reference
+    // supplies tm_isdst and any platform extras (tm_gmtoff, tm_zone) used by %z and %Z.
+    std::tm BreakDown(int64_t wallClock, const std::tm& reference)
+    {
+        int64_t days = wallClock / SECONDS_PER_DAY;
+        int64_t seconds = wallClock % SECONDS_PER_DAY;
+        if (seconds < 0)
+        {
+            seconds += SECONDS_PER_DAY;
+            --days;
+        }
+
+        int64_t year;
+        unsigned month;
+        unsigned day;
+        CivilFromDays(days, year, month, day);
+
+        std::tm tm = reference;
+        tm.tm_year = static_cast<int>(year - 1900);
+        tm.tm_mon = static_cast<int>(month - 1);
+        tm.tm_mday = static_cast<int>(day);
+        tm.tm_hour = static_cast<int>(seconds / 3600);
+        tm.tm_min = static_cast<int>(seconds / 60 % 60);
+        tm.tm_sec = static_cast<int>(seconds % 60);
+        tm.tm_wday = static_cast<int>(((days + 4) % 7 + 7) % 7); // 1970-01-01 was a Thursday
+        tm.tm_yday = static_cast<int>(days - DaysFromCivil(year, 1, 1));
+        return tm;
+    }
+
+    std::tm SystemLocalTime(std::time_t time)
+    {
+        std::tm tm{};
+#if defined(FLOG_PLATFORM_WINDOWS)
+        localtime_s(&tm, &time);
+#else
+        localtime_r(&time, &tm);
+#endif
+        return tm;
+    }
+
+    const std::tm& GetUtcReference()
+    {
+        static const std::tm s_reference = []
+        {
+            const std::time_t epoch = 0;
+            std::tm tm{};
+#if defined(FLOG_PLATFORM_WINDOWS)
+            gmtime_s(&tm, &epoch);
+#else
+            gmtime_r(&epoch, &tm);
+#endif
+            return tm;
+        }();
+
+        return s_reference;
+    }
+
+    long ComputeUtcOffset(std::time_t time, std::tm* localTime = nullptr)
+    {
+        const std::tm tm = SystemLocalTime(time);
+        if (localTime)
+            *localTime = tm;
+
+        const int64_t wallClock = DaysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday) * SECONDS_PER_DAY +
+            tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+        return static_cast<long>(wallClock - time);
+    }
+
+    // Span of instants sharing one UTC offset: [validFrom, validUntil)
+    struct ZoneWindow
+    {
+        std::time_t validFrom;
+        std::time_t validUntil;
+        long offset;
+        std::tm reference;
+
+        bool Contains(std::time_t time) const { return time >= validFrom && time < validUntil; }
+    };
+
+    // First instant in (low, high] whose offset match differs from low's; low and high must differ
+    std::time_t FindBoundary(std::time_t low, std::time_t high, long offset)
+    {
+        const bool lowMatches = ComputeUtcOffset(low) == offset;
+
+        while (high - low > 1)
+        {
+            const std::time_t mid = low + (high - low) / 2;
+            if ((ComputeUtcOffset(mid) == offset) == lowMatches)
+                low = mid;
+            else
+                high = mid;
+        }
+
+        return high;
+    }
+
+    ZoneWindow BuildZoneWindow(std::time_t time)
+    {
+        ZoneWindow window{};
+        window.offset = ComputeUtcOffset(time, &window.reference);
+
+        // DST transitions are months apart, so probing a day at a time cannot step over a pair
+        window.validUntil = time + MAX_SCAN_DAYS * SECONDS_PER_DAY;
+        for (int day = 1; day <= MAX_SCAN_DAYS; ++day)
+        {
+            const std::time_t probe = time + day * SECONDS_PER_DAY;
+            if (ComputeUtcOffset(probe) != window.offset)
+            {
+                window.validUntil = FindBoundary(probe - SECONDS_PER_DAY, probe, window.offset);
+                break;
+            }
+        }
+
+        // Records arrive roughly in order, so a day of history is enough
+        window.validFrom = time - SECONDS_PER_DAY;
+        if (ComputeUtcOffset(window.validFrom) != window.offset)
+            window.validFrom = FindBoundary(window.validFrom, time, window.offset);
+
+        return window;
+    }
+
+    struct ZoneState
+    {
+        std::mutex mutex;
+        std::deque<ZoneWindow> windows; // Never shrinks, so published pointers stay valid
+    };
+
+    ZoneState& GetZoneState()
+    {
+        static ZoneState s_state;
+        return s_state;
+    }
+
+    std::atomic<const ZoneWindow*> s_currentZone{nullptr};
+
+    // Returns the window covering time, or nullptr once the window budget is spent
+    const ZoneWindow* FindZoneWindow(std::time_t time)
+    {
+        const ZoneWindow* window = s_currentZone.load(std::memory_order_acquire);
+        if (window && window->Contains(time))
+            return window;
+
+        ZoneState& state = GetZoneState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        window = nullptr;
+        for (const ZoneWindow& candidate : state.windows)
+        {
+            if (candidate.Contains(time))
+            {
+                window = &candidate;
+                break;
+            }
+        }
+
+        if (!window)
+        {
+            if (state.windows.size() >= MAX_ZONE_WINDOWS)
+                return nullptr;
+
+            window = &state.windows.emplace_back(BuildZoneWindow(time));
+        }
+
+        s_currentZone.store(window, std::memory_order_release);
+        return window;
+    }
+
+    struct RenderedSecond
+    {
+        struct Fraction
+        {
+            uint8_t offset;
+            uint8_t digits;
+        };
+
+        std::string format;
+        std::time_t second = 0;
+        FlexLog::TimeZone zone = FlexLog::TimeZone::Utc;
+        bool valid = false;
+        size_t length = 0;
+        size_t fractionCount = 0;
+        std::array<Fraction, FlexLog::TimestampCache::MAX_FRACTIONS> fractions{};
+        char text[FlexLog::TimestampCache::MAX_RENDERED_LENGTH];
+    };
+
+    struct ThreadTimestampCache
+    {
+        std::array<RenderedSecond, FlexLog::TimestampCache::ENTRIES_PER_THREAD> entries;
+        size_t nextVictim = 0;
+    };
+
+    thread_local ThreadTimestampCache t_timestampCache;
+
+    void AppendStrftime(RenderedSecond& entry, std::string_view format, const std::tm& tm)
+    {
+        if (format.empty() || format.size() >= FlexLog::TimestampCache::MAX_RENDERED_LENGTH)
+            return;
+
+        // strftime needs a terminated format
+        char pattern[FlexLog::TimestampCache::MAX_RENDERED_LENGTH];
+        std::memcpy(pattern, format.data(), format.size());
+        pattern[format.size()] = '\0';
+
+        entry.length += std::strftime(entry.text + entry.length, sizeof(entry.text) - entry.length, pattern, &tm);
+    }
+
+    void RenderSecond(RenderedSecond& entry, std::time_t second)
+    {
+        const std::string_view format = entry.format;
+        const std::tm tm = FlexLog::TimestampCache::ToCalendarTime(second, entry.zone);
+
+        entry.second = second;
+        entry.length = 0;
+        entry.fractionCount = 0;
+        entry.valid = true;
+
+        // Split the format around sub-second fields; strftime renders the pieces in between
+        size_t segmentStart = 0;
+        size_t i = 0;
+        while (i + 1 < format.size())
+        {
+            if (format[i] != '%')
+            {
+                ++i;
+                continue;
+            }
+
+            const char next = format[i + 1];
+            size_t digits = 0;
+            size_t tokenLength = 0;
+
+            if (next == 'f')
+            {
+                digits = 6;
+                tokenLength = 2;
+            }
+            else if ((next == '3' || next == '6' || next == '9') && i + 2 < format.size() && format[i + 2] == 'f')
+            {
+                digits = static_cast<size_t>(next - '0');
+                tokenLength = 3;
+            }
+            else
+            {
+                // Any other conversion, including %%, is left to strftime
+                i += 2;
+                continue;
+            }
+
+            AppendStrftime(entry, format.substr(segmentStart, i - segmentStart), tm);
+
+            if (entry.fractionCount < entry.fractions.size() && entry.length + digits <= sizeof(entry.text))
+            {
+                entry.fractions[entry.fractionCount++] = { static_cast<uint8_t>(entry.length), static_cast<uint8_t>(digits) };
+                std::memset(entry.text + entry.length, '0', digits);
+                entry.length += digits;
+            }
+
+            i += tokenLength;
+            segmentStart = i;
+        }
+
+        AppendStrftime(entry, format.substr(segmentStart), tm);
+    }
+
+    const RenderedSecond& LookupSecond(std::time_t second, std::string_view format, FlexLog::TimeZone zone)
+    {
+        ThreadTimestampCache& cache = t_timestampCache;
+
+        RenderedSecond* sameFormat = nullptr;
+        for (RenderedSecond& entry : cache.entries)
+        {
+            if (!entry.valid || entry.zone != zone || entry.format != format)
+                continue;
+
+            if (entry.second == second)
+                return entry;
+
+            sameFormat = &entry;
+            break;
+        }
+
+        // Re-render a slot already holding this format so the format string is not reallocated
+        if (!sameFormat)
+        {
+            sameFormat = &cache.entries[cache.nextVictim];
+            cache.nextVictim = (cache.nextVictim + 1) % cache.entries.size();
+
+            sameFormat->format.assign(format);
+            sameFormat->zone = zone;
+        }
+
+        RenderSecond(*sameFormat, second);
+        return *sameFormat;
+    }
+}
+
+void FlexLog::TimestampCache::FormatTo(Buffer& out, TimePoint timestamp, std::string_view format, TimeZone zone)
+{
+    const auto sinceEpoch = timestamp.time_since_epoch();
+    const auto seconds = std::chrono::floor<std::chrono::seconds>(sinceEpoch);
+    const uint32_t nanoseconds = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch - seconds).count());
+
+    const RenderedSecond& entry = LookupSecond(static_cast<std::time_t>(seconds.count()), format, zone);
+
+    char* dst = out.Extend(entry.length);
+    std::memcpy(dst, entry.text, entry.length);
+
+    // Patch the sub-second digits, right to left
+    for (size_t i = 0; i < entry.fractionCount; ++i)
+    {
+        const auto& fraction = entry.fractions[i];
+        uint32_t value = nanoseconds / POWERS_OF_TEN[9 - fraction.digits];
+
+        for (size_t digit = fraction.digits; digit > 0; --digit)
+        {
+            dst[fraction.offset + digit - 1] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+}
+
+std::string FlexLog::TimestampCache::Format(TimePoint timestamp, std::string_view format, TimeZone zone)
+{
+    Buffer buffer;
+    FormatTo(buffer, timestamp, format, zone);
+    return buffer.ToString();
+}
+
+std::tm FlexLog::TimestampCache::ToCalendarTime(std::time_t time, TimeZone zone)
+{
+    if (zone == TimeZone::Utc)
+        return BreakDown(time, GetUtcReference());
+
+    const ZoneWindow* window = FindZoneWindow(time);
+    if (!window)
+        return SystemLocalTime(time);
+
+    return BreakDown(static_cast<int64_t>(time) + window->offset, window->reference);
+}
+
+long FlexLog::TimestampCache::GetUtcOffset(std::time_t time)
+{
+    const ZoneWindow* window = FindZoneWindow(time);
+    return window ? window->offset : ComputeUtcOffset(time);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+#include "Core/Buffer.h"
+
+namespace FlexLog
+{
+    enum class TimeZone : uint8_t
+    {
+        Local,
+        Utc
+    };
+
+    /**
+    * @brief Renders timestamps through a per-thread, per-second cache.
+    *
+    * The strftime part of a format is rendered once per second per thread and
+    * reused; only sub-second fields are patched in for each record. Local time
+    * is derived from a UTC offset shared by all threads and cached until the
+    * next DST transition, so the C library's timezone lock is only taken when
+    * that window is rebuilt.
+    *
+    * Formats follow strftime, plus sub-second fields: %f (microseconds) and
+    * %3f, %6f, %9f for milli-, micro- and nanoseconds.
+    */
+    class TimestampCache
+    {
+    public:
+        using TimePoint = std::chrono::system_clock::time_point;
+
+        static constexpr size_t MAX_RENDERED_LENGTH = 128;
+        static constexpr size_t MAX_FRACTIONS = 4;
+        static constexpr size_t ENTRIES_PER_THREAD = 4;
+
+        // Appends timestamp rendered with format
+        static void FormatTo(Buffer& out, TimePoint timestamp, std::string_view format, TimeZone zone = TimeZone::Local);
+        static std::string Format(TimePoint timestamp, std::string_view format, TimeZone zone = TimeZone::Local);
+
+        // Broken-down time without going through localtime/gmtime
+        static std::tm ToCalendarTime(std::time_t time, TimeZone zone = TimeZone::Local);
+
+        // Offset of local time from UTC at the given instant, in seconds
+        static long GetUtcOffset(std::time_t time);
+    };
+}
@@ -349,7 +349,7 @@ FlexLog::Logger& FlexLog::LogManager::RegisterLogger(std::string_view name)
     EnsureThreadPoolInitialized();
 
     auto logger = std::make_unique<Logger>(std::string(name), m_defaultLevel.load(std::memory_order_acquire));
-    logger->GetFormat().SetLogFormat(m_defaultFormat.load(std::memory_order_acquire));
+    logger->SetFormat(Format::Create(m_defaultFormat.load(std::memory_order_acquire)));
 
     auto sinkHandle = m_globalSinks.GetReadHandle();
     for (const auto& sink : sinkHandle.Items())
@@ -570,7 +570,7 @@ void FlexLog::LogManager::CreateDefaultLogger()
     auto logger = std::make_unique<Logger>(name, m_defaultLevel.load(std::memory_order_acquire));
     logger->SetLevel(m_defaultLevel.load(std::memory_order_acquire));
     logger->EmplaceSink<ConsoleSink>();
-    logger->GetFormat().SetLogFormat(m_defaultFormat.load(std::memory_order_acquire));
+    logger->SetFormat(Format::Create(m_defaultFormat.load(std::memory_order_acquire)));
 
     // Insert into map (will replace any existing logger with same name)
     m_loggerMap->Insert(name, std::move(logger));
@@ -2,15 +2,19 @@
 
 #include <chrono>
 
+#include "Core/LogContext.h"
 #include "Core/LoggerThreadPool.h"
 #include "Core/MessagePool.h"
+#include "Core/ThreadInfo.h"
+#include "Core/TraceContext.h"
 #include "LogManager.h"
 #include "Message.h"
 #include "Sink/Sink.h"
 
 FlexLog::Logger::Logger(std::string name, Level level) :
     m_name(std::move(name)),
-    m_level(level)
+    m_level(level),
+    m_format(std::make_shared<const Format>())
 {}
 
 bool FlexLog::Logger::Log(std::string_view msg, Level level, const std::source_location& location)
@@ -61,6 +65,15 @@ void FlexLog::Logger::RegisterSinks(std::span<std::shared_ptr<Sink>> sinks)
         m_sinkList.AddRange(sinks);
 }
 
+void FlexLog::Logger::SetFormat(std::shared_ptr<const Format> format)
+{
+    if (!format)
+        format = std::make_shared<const Format>();
+
+    // Messages already being formatted hold on to the previous format until they are done with it
+    m_format.store(std::move(format), std::memory_order_release);
+}
+
 std::vector<std::shared_ptr<FlexLog::Sink>> FlexLog::Logger::GetSinks()
 {
     auto handle = m_sinkList.GetReadHandle();
@@ -80,9 +93,17 @@ FlexLog::Message* FlexLog::Logger::CreateMessage(std::string_view message, Level
     poolMessage->name = m_name;
     poolMessage->level = level;
     poolMessage->sourceLocation = location;
+
+    const ThreadInfo::Identity& thread = ThreadInfo::Current();
+    poolMessage->threadId = thread.id;
+    poolMessage->threadIndex = thread.index;
+    poolMessage->threadName = thread.name;
+
     poolMessage->messageStorage = StringStorage::Create(message);
     poolMessage->message = poolMessage->messageStorage.View();
     poolMessage->logger = this;
+    poolMessage->context = LogContext::Current();
+    poolMessage->trace = TraceContext::Current();
 
     return poolMessage;
 }
@@ -100,9 +121,17 @@ FlexLog::Message* FlexLog::Logger::CreateStructuredMessage(std::string_view mess
     poolMessage->name = m_name;
     poolMessage->level = level;
     poolMessage->sourceLocation = location;
+
+    const ThreadInfo::Identity& thread = ThreadInfo::Current();
+    poolMessage->threadId = thread.id;
+    poolMessage->threadIndex = thread.index;
+    poolMessage->threadName = thread.name;
+
     poolMessage->messageStorage = StringStorage::Create(message);
     poolMessage->message = poolMessage->messageStorage.View();
     poolMessage->logger = this;
+    poolMessage->context = LogContext::Current();
+    poolMessage->trace = TraceContext::Current();
     poolMessage->structuredData = data;  // Copy the structured data
 
     return poolMessage;
@@ -119,6 +148,12 @@ void FlexLog::Logger::EnqueueMessage(Message* message)
     m_totalProcessed.fetch_add(1, std::memory_order_relaxed);
 }
 
+void FlexLog::Logger::DiscardMessage(Message* message)
+{
+    if (message)
+        LogManager::GetInstance().GetMessagePool().Release(message);
+}
+
 void FlexLog::Logger::ProcessMessage(Message* logMessage)
 {
     if (!logMessage || !logMessage->IsActive())
@@ -126,10 +161,46 @@ void FlexLog::Logger::ProcessMessage(Message* logMessage)
 
     auto handle = m_sinkList.GetReadHandle();
 
+    // Deferred fields are only worth evaluating when some sink is going to emit the message
+    bool willEmit = false;
     for (const auto& sink : handle.Items())
     {
-        if (sink)
-            sink->Output(*logMessage, m_format);
+        if (sink && sink->ShouldLog(logMessage->level))
+        {
+            willEmit = true;
+            break;
+        }
+    }
+
+    if (willEmit)
+    {
+        logMessage->structuredData.ResolveDeferred();
+
+        // Sinks sharing a format share one formatted record instead of each formatting the message
+        FormattedRecordSet records(*logMessage);
+
+        // Loaded once, and only if a sink without a format of its own needs it
+        std::shared_ptr<const Format> loggerFormat;
+
+        for (const auto& sink : handle.Items())
+        {
+            if (sink && sink->ShouldLog(logMessage->level))
+            {
+                std::shared_ptr<const Format> sinkFormat = sink->GetFormat();
+                if (!sinkFormat)
+                {
+                    if (!loggerFormat)
+                        loggerFormat = m_format.load(std::memory_order_acquire);
+                    sinkFormat = loggerFormat;
+                }
+
+                // Pinned for the whole fan-out: a format swapped out by SetFormat meanwhile can't be freed and have
+                // its address handed to the next sink's format while it is still a cache key
+                const Format& format = *sinkFormat;
+                records.Pin(std::move(sinkFormat));
+                sink->Output(*logMessage, format, records);
+            }
+        }
     }
 
     LogManager::GetInstance().GetMessagePool().Release(logMessage);
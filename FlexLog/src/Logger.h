@@ -6,6 +6,7 @@
 #include <span>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <vector>
 
 #include "Common.h"
@@ -29,6 +30,14 @@ namespace FlexLog
         FLOG_FORCE_INLINE bool Log(std::string_view msg, Level level, const std::source_location& location = std::source_location::current()) override;
         FLOG_FORCE_INLINE bool Log(std::string_view msg, const StructuredData& data, Level level, const std::source_location& location = std::source_location::current()) override;
 
+        // Typed fields are encoded into the message payload instead of a StructuredData map
+        template<typename... Ts> requires (sizeof...(Ts) > 0)
+        bool Log(std::string_view msg, Level level, const std::source_location& location, const Field<Ts>&... fields);
+
+        // The builder fills the message's StructuredData in place, and only runs once the level check has passed
+        template<typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+        bool Log(std::string_view msg, Level level, Builder&& builder, const std::source_location& location = std::source_location::current());
+
         void Flush();
 
         void RegisterSink(std::shared_ptr<Sink> sink);
@@ -44,9 +53,11 @@ namespace FlexLog
         void SetLevel(Level level) { m_level.store(level, std::memory_order_relaxed); }
         [[nodiscard]] bool IsLevelEnabled(Level level) const noexcept { return level >= m_level.load(std::memory_order_acquire) && level < Level::Off; }
 
-        Format& GetFormat() { return m_format; }
-        const Format& GetFormat() const { return m_format; }
-        void SetFormat(const Format& format) { m_format = format; }
+        // Format for sinks without one of their own. Workers may be formatting with it at any time, so it is never
+        // changed in place: configure a copy and publish that with SetFormat. A null format restores the default.
+        [[nodiscard]] std::shared_ptr<const Format> GetFormat() const { return m_format.load(std::memory_order_acquire); }
+        void SetFormat(std::shared_ptr<const Format> format);
+        void SetFormat(const Format& format) { SetFormat(std::make_shared<const Format>(format)); }
 
         std::vector<std::shared_ptr<Sink>> GetSinks();
 
@@ -60,15 +71,55 @@ namespace FlexLog
         Message* CreateStructuredMessage(std::string_view message, const StructuredData& data, Level level, std::source_location location);
 
         void EnqueueMessage(Message* message);
+        void DiscardMessage(Message* message);
         void ProcessMessage(Message* logMessage);
 
         std::string m_name;
         std::atomic<Level> m_level;
-        Format m_format;
+        std::atomic<std::shared_ptr<const Format>> m_format;
         SinkList m_sinkList;
         std::atomic<uint64_t> m_droppedMessages{0};
         std::atomic<uint64_t> m_totalProcessed{0};
 
         friend class LoggerThreadPool;
     };
+
+    template<typename... Ts> requires (sizeof...(Ts) > 0)
+    bool Logger::Log(std::string_view msg, Level level, const std::source_location& location, const Field<Ts>&... fields)
+    {
+        if (level < m_level || level >= Level::Off)
+            return false;
+
+        Message* logMessage = CreateMessage(msg, level, location);
+        if (!logMessage)
+            return false;
+
+        logMessage->fields.Encode(fields...);
+        EnqueueMessage(logMessage);
+        return true;
+    }
+
+    template<typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    bool Logger::Log(std::string_view msg, Level level, Builder&& builder, const std::source_location& location)
+    {
+        if (level < m_level || level >= Level::Off)
+            return false;
+
+        Message* logMessage = CreateMessage(msg, level, location);
+        if (!logMessage)
+            return false;
+
+        try
+        {
+            builder(logMessage->structuredData);
+        }
+        catch (...)
+        {
+            DiscardMessage(logMessage);
+            throw;
+        }
+
+        EnqueueMessage(logMessage);
+        return true;
+    }
 }
@@ -2,6 +2,7 @@
 
 #include <format>
 #include <source_location>
+#include <type_traits>
 #include <utility>
 
 #include "Common.h"
@@ -21,6 +22,8 @@
 #include "Format/Structured/BaseStructuredFormatter.h"
 #include "Format/Structured/CloudWatchFormatter.h"
 #include "Format/Structured/ElasticsearchFormatter.h"
+#include "Format/Structured/Field.h"
+#include "Format/Structured/FieldSet.h"
 #include "Format/Structured/GelfFormatter.h"
 #include "Format/Structured/JsonFormatter.h"
 #include "Format/Structured/LogstashFormatter.h"
@@ -458,4 +461,217 @@ namespace FlexLog::Log
         if (logger.IsLevelEnabled(Level::Fatal))
             logger.Fatal(msg, location);
     }
+
+    //=============================================================================
+    // Typed field API - Log::Info("payment", Field("amount", 12.5), Field("user", id))
+    //=============================================================================
+
+    // Captures the call site together with the message so a trailing field pack can still be deduced
+    struct LocatedMessage
+    {
+        template<typename T> requires std::is_convertible_v<const T&, std::string_view>
+        LocatedMessage(const T& msg, std::source_location loc = std::source_location::current()) :
+            message(msg),
+            location(loc)
+        {}
+
+        std::string_view message;
+        std::source_location location;
+    };
+
+    template <typename... Ts> requires (sizeof...(Ts) > 0)
+    FLOG_FORCE_INLINE void Trace(LocatedMessage msg, const Field<Ts>&... fields)
+    {
+        auto& logger = LogManager::GetInstance().GetDefaultLogger();
+        if (logger.IsLevelEnabled(Level::Trace))
+            logger.Log(msg.message, Level::Trace, msg.location, fields...);
+    }
+
+    template <typename... Ts> requires (sizeof...(Ts) > 0)
+    FLOG_FORCE_INLINE void Debug(LocatedMessage msg, const Field<Ts>&... fields)
+    {
+        auto& logger = LogManager::GetInstance().GetDefaultLogger();
+        if (logger.IsLevelEnabled(Level::Debug))
+            logger.Log(msg.message, Level::Debug, msg.location, fields...);
+    }
+
+    template <typename... Ts> requires (sizeof...(Ts) > 0)
+    FLOG_FORCE_INLINE void Info(LocatedMessage msg, const Field<Ts>&... fields)
+    {
+        auto& logger = LogManager::GetInstance().GetDefaultLogger();
+        if (logger.IsLevelEnabled(Level::Info))
+            logger.Log(msg.message, Level::Info, msg.location, fields...);
+    }
+
+    template <typename... Ts> requires (sizeof...(Ts) > 0)
+    FLOG_FORCE_INLINE void Warn(LocatedMessage msg, const Field<Ts>&... fields)
+    {
+        auto& logger = LogManager::GetInstance().GetDefaultLogger();
+        if (logger.IsLevelEnabled(Level::Warn))
+            logger.Log(msg.message, Level::Warn, msg.location, fields...);
+    }
+
+    template <typename... Ts> requires (sizeof...(Ts) > 0)
+    FLOG_FORCE_INLINE void Error(LocatedMessage msg, const Field<Ts>&... fields)
+    {
+        auto& logger = LogManager::GetInstance().GetDefaultLogger();
+        if (logger.IsLevelEnabled(Level::Error))
+            logger.Log(msg.message, Level::Error, msg.location, fields...);
+    }
+
+    template <typename... Ts> requires (sizeof...(Ts) > 0)
+    FLOG_FORCE_INLINE void Fatal(LocatedMessage msg, const Field<Ts>&... fields)
+    {
+        auto& logger = LogManager::GetInstance().GetDefaultLogger();
+        if (logger.IsLevelEnabled(Level::Fatal))
+            logger.Log(msg.message, Level::Fatal, msg.location, fields...);
+    }
+
+    template <typename... Ts> requires (sizeof...(Ts) > 0)
+    FLOG_FORCE_INLINE void Trace(std::string_view loggerName, LocatedMessage msg, const Field<Ts>&... fields)
+    {
+        auto& logger = LogManager::GetInstance().GetLogger(loggerName);
+        if (logger.IsLevelEnabled(Level::Trace))
+            logger.Log(msg.message, Level::Trace, msg.location, fields...);
+    }
+
+    template <typename... Ts> requires (sizeof...(Ts) > 0)
+    FLOG_FORCE_INLINE void Debug(std::string_view loggerName, LocatedMessage msg, const Field<Ts>&... fields)
+    {
+        auto& logger = LogManager::GetInstance().GetLogger(loggerName);
+        if (logger.IsLevelEnabled(Level::Debug))
+            logger.Log(msg.message, Level::Debug, msg.location, fields...);
+    }
+
+    template <typename... Ts> requires (sizeof...(Ts) > 0)
+    FLOG_FORCE_INLINE void Info(std::string_view loggerName, LocatedMessage msg, const Field<Ts>&... fields)
+    {
+        auto& logger = LogManager::GetInstance().GetLogger(loggerName);
+        if (logger.IsLevelEnabled(Level::Info))
+            logger.Log(msg.message, Level::Info, msg.location, fields...);
+    }
+
+    template <typename... Ts> requires (sizeof...(Ts) > 0)
+    FLOG_FORCE_INLINE void Warn(std::string_view loggerName, LocatedMessage msg, const Field<Ts>&... fields)
+    {
+        auto& logger = LogManager::GetInstance().GetLogger(loggerName);
+        if (logger.IsLevelEnabled(Level::Warn))
+            logger.Log(msg.message, Level::Warn, msg.location, fields...);
+    }
+
+    template <typename... Ts> requires (sizeof...(Ts) > 0)
+    FLOG_FORCE_INLINE void Error(std::string_view loggerName, LocatedMessage msg, const Field<Ts>&... fields)
+    {
+        auto& logger = LogManager::GetInstance().GetLogger(loggerName);
+        if (logger.IsLevelEnabled(Level::Error))
+            logger.Log(msg.message, Level::Error, msg.location, fields...);
+    }
+
+    template <typename... Ts> requires (sizeof...(Ts) > 0)
+    FLOG_FORCE_INLINE void Fatal(std::string_view loggerName, LocatedMessage msg, const Field<Ts>&... fields)
+    {
+        auto& logger = LogManager::GetInstance().GetLogger(loggerName);
+        if (logger.IsLevelEnabled(Level::Fatal))
+            logger.Log(msg.message, Level::Fatal, msg.location, fields...);
+    }
+
+    //=============================================================================
+    // Builder API - the callback only runs when the level is enabled
+    //=============================================================================
+
+    template <typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    FLOG_FORCE_INLINE void Trace(LocatedMessage msg, Builder&& builder)
+    {
+        auto& logger = LogManager::GetInstance().GetDefaultLogger();
+        if (logger.IsLevelEnabled(Level::Trace))
+            logger.Log(msg.message, Level::Trace, std::forward<Builder>(builder), msg.location);
+    }
+
+    template <typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    FLOG_FORCE_INLINE void Debug(LocatedMessage msg, Builder&& builder)
+    {
+        auto& logger = LogManager::GetInstance().GetDefaultLogger();
+        if (logger.IsLevelEnabled(Level::Debug))
+            logger.Log(msg.message, Level::Debug, std::forward<Builder>(builder), msg.location);
+    }
+
+    template <typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    FLOG_FORCE_INLINE void Info(LocatedMessage msg, Builder&& builder)
+    {
+        auto& logger = LogManager::GetInstance().GetDefaultLogger();
+        if (logger.IsLevelEnabled(Level::Info))
+            logger.Log(msg.message, Level::Info, std::forward<Builder>(builder), msg.location);
+    }
+
+    template <typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    FLOG_FORCE_INLINE void Warn(LocatedMessage msg, Builder&& builder)
+    {
+        auto& logger = LogManager::GetInstance().GetDefaultLogger();
+        if (logger.IsLevelEnabled(Level::Warn))
+            logger.Log(msg.message, Level::Warn, std::forward<Builder>(builder), msg.location);
+    }
+
+    template <typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    FLOG_FORCE_INLINE void Error(LocatedMessage msg, Builder&& builder)
+    {
+        auto& logger = LogManager::GetInstance().GetDefaultLogger();
+        if (logger.IsLevelEnabled(Level::Error))
+            logger.Log(msg.message, Level::Error, std::forward<Builder>(builder), msg.location);
+    }
+
+    template <typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    FLOG_FORCE_INLINE void Fatal(LocatedMessage msg, Builder&& builder)
+    {
+        auto& logger = LogManager::GetInstance().GetDefaultLogger();
+        if (logger.IsLevelEnabled(Level::Fatal))
+            logger.Log(msg.message, Level::Fatal, std::forward<Builder>(builder), msg.location);
+    }
+
+    template <typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    FLOG_FORCE_INLINE void Trace(std::string_view loggerName, LocatedMessage msg, Builder&& builder)
+    {
+        auto& logger = LogManager::GetInstance().GetLogger(loggerName);
+        if (logger.IsLevelEnabled(Level::Trace))
+            logger.Log(msg.message, Level::Trace, std::forward<Builder>(builder), msg.location);
+    }
+
+    template <typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    FLOG_FORCE_INLINE void Debug(std::string_view loggerName, LocatedMessage msg, Builder&& builder)
+    {
+        auto& logger = LogManager::GetInstance().GetLogger(loggerName);
+        if (logger.IsLevelEnabled(Level::Debug))
+            logger.Log(msg.message, Level::Debug, std::forward<Builder>(builder), msg.location);
+    }
+
+    template <typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    FLOG_FORCE_INLINE void Info(std::string_view loggerName, LocatedMessage msg, Builder&& builder)
+    {
+        auto& logger = LogManager::GetInstance().GetLogger(loggerName);
+        if (logger.IsLevelEnabled(Level::Info))
+            logger.Log(msg.message, Level::Info, std::forward<Builder>(builder), msg.location);
+    }
+
+    template <typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    FLOG_FORCE_INLINE void Warn(std::string_view loggerName, LocatedMessage msg, Builder&& builder)
+    {
+        auto& logger = LogManager::GetInstance().GetLogger(loggerName);
+        if (logger.IsLevelEnabled(Level::Warn))
+            logger.Log(msg.message, Level::Warn, std::forward<Builder>(builder), msg.location);
+    }
+
+    template <typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    FLOG_FORCE_INLINE void Error(std::string_view loggerName, LocatedMessage msg, Builder&& builder)
+    {
+        auto& logger = LogManager::GetInstance().GetLogger(loggerName);
+        if (logger.IsLevelEnabled(Level::Error))
+            logger.Log(msg.message, Level::Error, std::forward<Builder>(builder), msg.location);
+    }
+
+    template <typename Builder> requires std::is_invocable_v<Builder&, StructuredData&>
+    FLOG_FORCE_INLINE void Fatal(std::string_view loggerName, LocatedMessage msg, Builder&& builder)
+    {
+        auto& logger = LogManager::GetInstance().GetLogger(loggerName);
+        if (logger.IsLevelEnabled(Level::Fatal))
+            logger.Log(msg.message, Level::Fatal, std::forward<Builder>(builder), msg.location);
+    }
 } // namespace FlexLog::Log
@@ -12,7 +12,7 @@ int main()
     {
         auto& logger = logManager.RegisterLogger("logger" + std::to_string(i));
         logger.SetLevel(FlexLog::Level::Trace);
-        logger.GetFormat().SetLogFormat(FlexLog::LogFormat::Splunk);
+        logger.SetFormat(FlexLog::Format::Create(FlexLog::LogFormat::Splunk));
         logger.RegisterSink(sink);
 
         loggers.push_back(&logger);
@@ -3,13 +3,18 @@
 #include <array>
 #include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <memory>
 #include <source_location>
 #include <string>
 #include <string_view>
 
 #include "Common.h"
 #include "Level.h"
+#include "Core/LogContext.h"
 #include "Core/StringStorage.h"
+#include "Core/TraceContext.h"
+#include "Format/Structured/Field.h"
 #include "Format/Structured/StructuredData.h"
 
 namespace FlexLog
@@ -17,6 +22,42 @@ namespace FlexLog
     class MessagePool;
     class Logger;
 
+    /**
+    * @brief Call site of a message.
+    *
+    * Mirrors std::source_location's accessors, but can also be built from
+    * plain values, which lets decoded records (see BinaryReader) carry the
+    * call site they were logged from.
+    */
+    class SourceLocation
+    {
+    public:
+        constexpr SourceLocation() = default;
+        constexpr SourceLocation(const std::source_location& location) :
+            m_file(location.file_name()),
+            m_function(location.function_name()),
+            m_line(location.line()),
+            m_column(location.column())
+        {}
+        constexpr SourceLocation(const char* file, const char* function, uint32_t line, uint32_t column = 0) :
+            m_file(file),
+            m_function(function),
+            m_line(line),
+            m_column(column)
+        {}
+
+        constexpr const char* file_name() const { return m_file; }
+        constexpr const char* function_name() const { return m_function; }
+        constexpr uint32_t line() const { return m_line; }
+        constexpr uint32_t column() const { return m_column; }
+
+    private:
+        const char* m_file = "";
+        const char* m_function = "";
+        uint32_t m_line = 0;
+        uint32_t m_column = 0;
+    };
+
     enum class MessageState : uint8_t
     {
         Pooled,     // In pool, not in use
@@ -30,12 +71,21 @@ namespace FlexLog
         std::string_view name;
         Level level = Level::Info;
         std::string_view message;
-        std::source_location sourceLocation;
+        SourceLocation sourceLocation;
+
+        // Producer thread, captured when the message is created rather than where it is formatted
+        uint64_t threadId = 0;
+        uint32_t threadIndex = 0;
+        std::string_view threadName;    // Interned by ThreadInfo::SetCurrentName; empty if unnamed
+
+        TraceIds trace;                 // TraceContext current on the producer thread
 
         StringStorage messageStorage;
         Logger* logger = nullptr;
 
         StructuredData structuredData;
+        FieldPayload fields;
+        ContextFramePtr context;
 
         std::atomic<uint32_t> refCount{0};
         std::atomic<MessageState> state{MessageState::Pooled};
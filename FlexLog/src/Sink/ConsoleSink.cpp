@@ -2,13 +2,13 @@
 
 #include <algorithm>
 #include <array>
-#include <cctype>
 #include <cstring>
 #include <iostream>
 #include <locale>
 #include <regex>
 #include <sstream>
 
+#include "Core/TextScan.h"
 #include "Message.h"
 #include "Platform.h"
 
@@ -47,22 +47,52 @@ namespace
         return ISATTY(FILENO(file)) != 0;
     }
 
-    std::string SanitizeText(std::string_view text, bool preserveNewlines = true)
+    // Filters in place; the output is never longer than the input. Clean runs are located by the
+    // vector scan and only moved when something before them has been dropped.
+    void SanitizeText(FlexLog::Buffer& text, bool preserveNewlines = true)
     {
-        std::string result;
-        result.reserve(text.size());
+        char* data = text.Data();
+        const size_t length = text.Size();
+        size_t size = 0;
+        size_t i = 0;
 
-        for (char c : text)
+        while (i < length)
         {
-            if (c == '\n' && preserveNewlines)
-                result.push_back(c);
-            else if (std::iscntrl(static_cast<unsigned char>(c)) && c != '\t')
-                continue; // Skip control characters except tabs
-            else
-                result.push_back(c);
+            const size_t run = FlexLog::Internal::FindNonPrintable(data + i, length - i);
+            if (size != i)
+                std::memmove(data + size, data + i, run);
+            size += run;
+            i += run;
+
+            if (i == length)
+                break;
+
+            const unsigned char c = static_cast<unsigned char>(data[i]);
+            if (c >= 0x80)
+            {
+                // Keep well-formed UTF-8 sequences, replace anything the terminal would mangle
+                const size_t sequence = FlexLog::Internal::GetUtf8SequenceLength(data + i, length - i);
+                if (sequence == 0)
+                {
+                    data[size++] = '?';
+                    ++i;
+                }
+                else
+                {
+                    std::memmove(data + size, data + i, sequence);
+                    size += sequence;
+                    i += sequence;
+                }
+                continue;
+            }
+
+            if ((c == '\n' && preserveNewlines) || c == '\t')
+                data[size++] = static_cast<char>(c);
+
+            ++i; // Skip control characters except tabs
         }
 
-        return result;
+        text.Truncate(size);
     }
 }
 
@@ -81,41 +111,75 @@ void FlexLog::ConsoleSink::Output(const Message& msg, const Format& format)
 
     try
     {
-        std::string formattedMessage = format(msg);
-        if (formattedMessage.empty())
-            return;
-
-        if (formattedMessage.length() > m_options.maxMessageLength)
-            formattedMessage = formattedMessage.substr(0, m_options.maxMessageLength - 4) + "...";
-
-        formattedMessage = SanitizeForTerminal(formattedMessage);
+        Buffer& formattedMessage = GetThreadBuffer();
+        format.FormatTo(msg, formattedMessage);
+        WriteMessage(msg, formattedMessage);
+    }
+    catch (const std::exception& e)
+    {
+        ReportError(e);
+    }
+}
 
-        if (!formattedMessage.empty() && formattedMessage.back() != '\n')
-            formattedMessage += FLOG_NEWLINE;
+void FlexLog::ConsoleSink::Output(const Message& msg, const Format& format, FormattedRecordSet& records)
+{
+    if (!m_outputStream)
+        return;
 
-        std::ostream* targetStream = m_outputStream;
-        if (msg.level >= Level::Error && m_errorStream)
-            targetStream = m_errorStream;
+    try
+    {
+        const std::string_view record = records.Get(format);
 
-        std::lock_guard<std::mutex> lock(m_outputMutex);
-        WriteToStream(*targetStream, formattedMessage);
+        // The record is shared with other sinks; sanitizing works on a copy of what can be shown
+        Buffer& formattedMessage = GetThreadBuffer();
+        formattedMessage.Append(record.data(), std::min(record.size(), m_options.maxMessageLength + 1));
+        WriteMessage(msg, formattedMessage);
     }
     catch (const std::exception& e)
     {
-        m_errorCount.fetch_add(1, std::memory_order_relaxed);
+        ReportError(e);
+    }
+}
 
-        try
-        {
-            std::string errorMsg = "ConsoleSink error: ";
-            errorMsg += e.what();
-            errorMsg += FLOG_NEWLINE;
+void FlexLog::ConsoleSink::WriteMessage(const Message& msg, Buffer& formattedMessage)
+{
+    if (formattedMessage.IsEmpty())
+        return;
 
-            std::cerr << errorMsg;
-        }
-        catch (...) 
-        {
-            // Last resort, if even this fails, we can't do much
-        }
+    if (formattedMessage.Size() > m_options.maxMessageLength)
+    {
+        formattedMessage.Truncate(m_options.maxMessageLength - 4);
+        formattedMessage.Append("...");
+    }
+
+    SanitizeForTerminal(formattedMessage);
+
+    if (!formattedMessage.IsEmpty() && formattedMessage.Back() != '\n')
+        formattedMessage.Append(FLOG_NEWLINE);
+
+    std::ostream* targetStream = m_outputStream;
+    if (msg.level >= Level::Error && m_errorStream)
+        targetStream = m_errorStream;
+
+    std::lock_guard<std::mutex> lock(m_outputMutex);
+    WriteToStream(*targetStream, formattedMessage.View());
+}
+
+void FlexLog::ConsoleSink::ReportError(const std::exception& e)
+{
+    m_errorCount.fetch_add(1, std::memory_order_relaxed);
+
+    try
+    {
+        std::string errorMsg = "ConsoleSink error: ";
+        errorMsg += e.what();
+        errorMsg += FLOG_NEWLINE;
+
+        std::cerr << errorMsg;
+    }
+    catch (...) 
+    {
+        // Last resort, if even this fails, we can't do much
     }
 }
 
@@ -275,25 +339,38 @@ void FlexLog::ConsoleSink::InitializeWindowsTerminal()
 #endif
 }
 
-std::string FlexLog::ConsoleSink::SanitizeForTerminal(std::string_view text) const
+void FlexLog::ConsoleSink::SanitizeForTerminal(Buffer& text) const
 {
     if (!m_terminalCapabilities.supportsUnicode || !m_options.unicodeEnabled)
     {
-        std::string result;
-        result.reserve(text.size());
+        char* data = text.Data();
+        const size_t length = text.Size();
+        size_t size = 0;
+        size_t i = 0;
 
-        for (char c : text)
+        while (i < length)
         {
-            if ((c >= 32 && c < 127) || c == '\n' || c == '\r' || c == '\t')
-                result.push_back(c);
+            const size_t run = Internal::FindNonPrintable(data + i, length - i);
+            if (size != i)
+                std::memmove(data + size, data + i, run);
+            size += run;
+            i += run;
+
+            if (i == length)
+                break;
+
+            const char c = data[i++];
+            if (c == '\n' || c == '\r' || c == '\t')
+                data[size++] = c;
             else if (static_cast<unsigned char>(c) >= 128) // Unicode replacement
-                result.append("?");
+                data[size++] = '?';
         }
-        return result;
+
+        text.Truncate(size);
     }
     else
     {
-        return SanitizeText(text);
+        SanitizeText(text);
     }
 }
 
@@ -50,6 +50,7 @@ namespace FlexLog
         ~ConsoleSink() override = default;
 
         void Output(const Message& msg, const Format& format) override;
+        void Output(const Message& msg, const Format& format, FormattedRecordSet& records) override;
         void Flush() override;
 
         [[nodiscard]] const TerminalCapabilities& GetTerminalCapabilities() const { return m_terminalCapabilities; }
@@ -69,7 +70,10 @@ namespace FlexLog
         
         void InitializeWindowsTerminal();
 
-        std::string SanitizeForTerminal(std::string_view text) const;
+        void SanitizeForTerminal(Buffer& text) const;
+
+        void WriteMessage(const Message& msg, Buffer& formattedMessage);
+        void ReportError(const std::exception& e);
 
         void WriteToStream(std::ostream& stream, std::string_view text);
 
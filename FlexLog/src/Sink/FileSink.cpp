@@ -1,21 +1,70 @@
 #include "FileSink.h"
 
 #include <algorithm>
-#include <iomanip>
-#include <sstream>
+#include <cstring>
 #include <stdexcept>
 
+#include "Core/Deflater.h"
+#include "Format/TimestampCache.h"
+
 #ifdef FLOG_PLATFORM_WINDOWS
     #include <Windows.h>
 #else
+    #include <cerrno>
     #include <fcntl.h>
     #include <unistd.h>
     #include <sys/file.h>
+    #include <sys/mman.h>
     #include <sys/stat.h>
+    #include <sys/uio.h>
 #endif
 
-#ifdef FLOG_ENABLE_LOGGER_FILE_COMPRESSION
-    #include <zlib.h>
+#ifdef FLOG_PLATFORM_POSIX
+namespace FlexLog::Internal
+{
+    // Writes every byte the vectors describe, resuming after short writes and signals; false on any other error
+    bool WriteFully(int fd, iovec* vectors, int count)
+    {
+        while (count > 0)
+        {
+            const ssize_t written = writev(fd, vectors, count);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+
+            size_t remaining = static_cast<size_t>(written);
+            while (count > 0 && remaining >= vectors->iov_len)
+            {
+                remaining -= vectors->iov_len;
+                ++vectors;
+                --count;
+            }
+
+            if (count > 0)
+            {
+                vectors->iov_base = static_cast<char*>(vectors->iov_base) + remaining;
+                vectors->iov_len -= remaining;
+            }
+        }
+
+        return true;
+    }
+
+    size_t PageSize()
+    {
+        static const size_t s_pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return s_pageSize;
+    }
+
+    uint64_t RoundUpToPage(uint64_t size)
+    {
+        const uint64_t page = PageSize();
+        return (size + page - 1) / page * page;
+    }
+}
 #endif
 
 FlexLog::FileSink::FileSink(const Options& options) : m_options(options)
@@ -23,16 +72,37 @@ FlexLog::FileSink::FileSink(const Options& options) : m_options(options)
     // Initialize state
     m_lastRotationTime = std::chrono::system_clock::now();
 
-    if (m_options.enableRotation && m_options.rotationRule == RotationRule::Time || m_options.rotationRule == RotationRule::SizeAndTime)
+    if (m_options.enableRotation && (m_options.rotationRule == RotationRule::Time || m_options.rotationRule == RotationRule::SizeAndTime))
         m_nextRotationTime = CalculateNextRotationTime();
 
+#ifdef FLOG_PLATFORM_POSIX
+    // Segments are mapped at page aligned offsets
+    m_options.mappedSegmentSize = Internal::RoundUpToPage(m_options.mappedSegmentSize);
+#else
+    m_options.mappedSegmentSize = 0;
+#endif
+
     if (!m_options.filePath.empty())
         m_initialized = OpenFile();
+
+    if (m_options.enableRotation || m_options.flushInterval.count() > 0 || m_options.mappedSegmentSize > 0)
+        m_maintenanceThread = std::thread(&FileSink::MaintenanceThread, this);
 }
 
 FlexLog::FileSink::~FileSink()
 {
-    CloseFile();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CloseFile();
+        m_maintenanceStop = true;
+    }
+
+    // The thread finishes the rotated files and segments still queued on its way out
+    if (m_maintenanceThread.joinable())
+    {
+        m_maintenanceWake.notify_one();
+        m_maintenanceThread.join();
+    }
 }
 
 void FlexLog::FileSink::Output(const Message& msg, const Format& format)
@@ -42,53 +112,405 @@ void FlexLog::FileSink::Output(const Message& msg, const Format& format)
 
     try
     {
-        std::string formattedMessage = format(msg);
-        if (formattedMessage.empty())
+        if (format.IsStreamed())
+        {
+            WriteStreamed(msg, format);
             return;
+        }
+
+        Buffer& formattedMessage = GetThreadBuffer();
+        format.FormatTo(msg, formattedMessage);
+        Write(formattedMessage.View(), format.IsBinary(), msg.level);
+    }
+    catch (const std::exception&)
+    {
+        // Log writing failed - we could add fallback behavior here
+    }
+}
+
+void FlexLog::FileSink::Output(const Message& msg, const Format& format, FormattedRecordSet& records)
+{
+    if (!m_initialized)
+        return;
+
+    try
+    {
+        if (format.IsStreamed())
+            WriteStreamed(msg, format);
+        else
+            Write(records.Get(format), format.IsBinary(), msg.level);
+    }
+    catch (const std::exception&)
+    {
+        // Log writing failed - we could add fallback behavior here
+    }
+}
+
+void FlexLog::FileSink::Write(std::string_view text, bool binary, Level level)
+{
+    if (text.empty())
+        return;
+
+    // Make sure the message ends with a line break
+    const std::string_view lineEnding = !binary && text.back() != '\n' ? std::string_view(m_options.lineEnding) : std::string_view();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (PrepareWrite())
+        CommitRecord(text, lineEnding, level);
+}
+
+void FlexLog::FileSink::WriteStreamed(const Message& msg, const Format& format)
+{
+    Buffer& record = GetThreadBuffer();
 
-        // Make sure the message ends with a line break
-        if (formattedMessage.back() != '\n')
-            formattedMessage += m_options.lineEnding;
+    std::lock_guard<std::mutex> lock(m_mutex);
 
-        // Check rotation before writing
-        bool needsReopen = false;
+    if (!PrepareWrite())
+        return;
 
+    auto formatRecord = [&]()
+    {
+        if (m_newFile)
+        {
+            format.BeginFile();
+            m_newFile = false;
+        }
+
+        record.Clear();
+        format.FormatTo(msg, record);
+    };
+
+    formatRecord();
+
+#ifdef FLOG_PLATFORM_POSIX
+    // A record that fills a mapped file's segment is written to the next file, so it is formatted for that one
+    if (m_options.mappedSegmentSize > 0 && IsMappedRotationDue(record.Size()))
+    {
+        RotateFile();
+        if (!IsFileOpen() && !OpenFile())
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
+            m_errorCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        formatRecord();
+    }
+#endif
+
+    if (!record.IsEmpty())
+        CommitRecord(record.View(), std::string_view(), msg.level);
+}
+
+bool FlexLog::FileSink::PrepareWrite()
+{
+    if (m_options.enableRotation && ShouldRotate())
+    {
+        RotateFile();
+        if (!IsFileOpen() && !OpenFile())
+            return false;
+    }
+
+    return IsFileOpen();
+}
+
+void FlexLog::FileSink::CommitRecord(std::string_view text, std::string_view lineEnding, Level level)
+{
+    WriteRecord(text, lineEnding);
+    m_currentFileSize += text.size() + lineEnding.size();
+
+    if (m_options.autoFlush || level >= m_options.flushLevel)
+    {
+        FlushBuffer();
+    }
+    else if (m_options.flushInterval.count() > 0 && m_flushDeadline == std::chrono::steady_clock::time_point::max())
+    {
+        // The first record into an empty buffer starts the clock; the maintenance thread flushes when it runs out
+        m_flushDeadline = std::chrono::steady_clock::now() + m_options.flushInterval;
+        m_maintenanceWake.notify_one();
+    }
+}
+
+void FlexLog::FileSink::WriteRecord(std::string_view text, std::string_view lineEnding)
+{
+#ifdef FLOG_PLATFORM_POSIX
+    if (m_options.mappedSegmentSize > 0)
+    {
+        WriteMapped(text, lineEnding);
+        return;
+    }
+
+    const size_t recordSize = text.size() + lineEnding.size();
+
+    if (m_buffer.Size() + recordSize <= m_options.bufferSize)
+    {
+        char* dst = m_buffer.Extend(recordSize);
+        std::memcpy(dst, text.data(), text.size());
+        std::memcpy(dst + text.size(), lineEnding.data(), lineEnding.size());
+        return;
+    }
+
+    // Doesn't fit: the buffer and the record leave together without copying the record
+    iovec vectors[3];
+    vectors[0] = { m_buffer.Data(), m_buffer.Size() };
+    vectors[1] = { const_cast<char*>(text.data()), text.size() };
+    vectors[2] = { const_cast<char*>(lineEnding.data()), lineEnding.size() };
 
-            if (m_options.enableRotation && ShouldRotate())
+    if (!Internal::WriteFully(m_fd, vectors, 3))
+        m_errorCount.fetch_add(1, std::memory_order_relaxed);
+
+    m_buffer.Clear();
+    m_flushDeadline = std::chrono::steady_clock::time_point::max();
+#else
+    m_file.write(text.data(), text.size());
+    m_file.write(lineEnding.data(), lineEnding.size());
+
+    if (!m_file)
+    {
+        m_errorCount.fetch_add(1, std::memory_order_relaxed);
+        m_file.clear();
+    }
+#endif
+}
+
+#ifdef FLOG_PLATFORM_POSIX
+void FlexLog::FileSink::WriteMapped(std::string_view text, std::string_view lineEnding)
+{
+    const size_t recordSize = text.size() + lineEnding.size();
+
+    if (m_segmentUsed + recordSize > m_segment.size)
+    {
+        if (IsMappedRotationDue(recordSize))
+        {
+            RotateFile();
+            if (!IsFileOpen() && !OpenFile())
             {
-                RotateFile();
-                needsReopen = true;
+                m_errorCount.fetch_add(1, std::memory_order_relaxed);
+                return;
             }
+        }
 
-            if (needsReopen && !m_file.is_open())
+        // Records bigger than a segment get a larger one of their own
+        if (m_segmentUsed + recordSize > m_segment.size)
+        {
+            RetireSegment();
+            if (!MapSegment(m_currentFileSize, recordSize))
             {
-                if (!OpenFile())
-                    return;
+                m_errorCount.fetch_add(1, std::memory_order_relaxed);
+                CloseFile();
+                return;
             }
+        }
+    }
 
-            if (m_file.is_open())
-            {
-                m_file.write(formattedMessage.data(), formattedMessage.size());
-                m_currentFileSize += formattedMessage.size();
+    char* dst = m_segment.data + m_segmentUsed;
+    std::memcpy(dst, text.data(), text.size());
+    std::memcpy(dst + text.size(), lineEnding.data(), lineEnding.size());
+    m_segmentUsed += recordSize;
+}
+
+bool FlexLog::FileSink::IsMappedRotationDue(size_t recordSize) const
+{
+    // A full segment is the unit of size rotation; an empty file has nothing to rotate
+    const bool rotateBySize = m_options.enableRotation &&
+        (m_options.rotationRule == RotationRule::Size || m_options.rotationRule == RotationRule::SizeAndTime);
+
+    return rotateBySize && m_currentFileSize > 0 && m_segmentUsed + recordSize > m_segment.size;
+}
 
-                if (m_options.autoFlush)
-                    m_file.flush();
+bool FlexLog::FileSink::MapSegment(uint64_t position, size_t room)
+{
+    const uint64_t start = position / Internal::PageSize() * Internal::PageSize();
+    const size_t lead = static_cast<size_t>(position - start);
+    const size_t size = static_cast<size_t>(std::max(m_options.mappedSegmentSize, Internal::RoundUpToPage(lead + room)));
+
+    // Normally the maintenance thread has reserved this already
+    if (start + size > m_allocatedSize && !AllocateFile(start + size))
+        return false;
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, static_cast<off_t>(start));
+    if (data == MAP_FAILED)
+        return false;
+
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    m_segment = { static_cast<char*>(data), start, size };
+    m_segmentUsed = lead;
+    m_segmentReleased = 0;
+    return true;
+}
+
+void FlexLog::FileSink::RetireSegment()
+{
+    if (m_segment.data == nullptr)
+        return;
+
+    m_retiredSegments.push_back(m_segment);
+    m_segment = {};
+    m_segmentUsed = 0;
+    m_segmentReleased = 0;
+    m_maintenanceWake.notify_one();
+}
+
+bool FlexLog::FileSink::AllocateFile(uint64_t end)
+{
+    if (end <= m_allocatedSize)
+        return true;
+
+#ifdef FLOG_PLATFORM_LINUX
+    // Allocating the blocks up front keeps page faults in the segment from stalling on the filesystem
+    const uint64_t start = m_allocatedSize;
+    if (fallocate(m_fd, 0, static_cast<off_t>(start), static_cast<off_t>(end - start)) == 0)
+    {
+        m_allocatedSize = end;
+        return true;
+    }
+
+    // Out of space or quota: mapping the range anyway would turn the first write past the allocated
+    // blocks into SIGBUS. A fallocate that stopped partway may have grown the file, so cut it back.
+    if (errno != EOPNOTSUPP && errno != ENOSYS)
+    {
+        if (ftruncate(m_fd, static_cast<off_t>(start)) != 0)
+            m_errorCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+#endif
+
+    // Where fallocate isn't supported, the mapping only needs the file to be long enough. The file is
+    // sparse then, so a filesystem that fills up later raises SIGBUS on a write instead of an error.
+    if (ftruncate(m_fd, static_cast<off_t>(end)) != 0)
+        return false;
+
+    m_allocatedSize = end;
+    return true;
+}
+#endif
+
+void FlexLog::FileSink::MaintenanceThread()
+{
+#ifdef FLOG_PLATFORM_POSIX
+    const size_t page = Internal::PageSize();
+#endif
+    const bool timeRotation = m_options.enableRotation &&
+        (m_options.rotationRule == RotationRule::Time || m_options.rotationRule == RotationRule::SizeAndTime);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        bool idle = !m_maintenanceStop && m_rotatedFiles.empty();
+#ifdef FLOG_PLATFORM_POSIX
+        idle = idle && m_retiredSegments.empty();
+#endif
+        // Sleep until the flush deadline, a notification or the next rotation check
+        if (idle)
+            m_maintenanceWake.wait_until(lock, std::min(m_flushDeadline, std::chrono::steady_clock::now() + MAINTENANCE_INTERVAL));
+
+        const bool stopping = m_maintenanceStop;
+
+        if (std::chrono::steady_clock::now() >= m_flushDeadline)
+            FlushBuffer();
+
+        // Writers never look at the clock for rotation; this check is only as fine as the thread's wake-ups
+        if (timeRotation && !stopping && IsTimeToRotate())
+        {
+            if (IsFileOpen() && m_currentFileSize > 0)
+                RotateFile();
+            else
+                m_nextRotationTime = CalculateNextRotationTime();
+        }
+
+        std::vector<std::string> rotated;
+        rotated.swap(m_rotatedFiles);
+
+#ifdef FLOG_PLATFORM_POSIX
+        std::vector<Segment> retired;
+        retired.swap(m_retiredSegments);
+
+        // Reserve the next segment while this one still has room, so rolling over only has to map it
+        if (m_segment.data != nullptr && m_segmentUsed > m_segment.size / 2)
+        {
+            const uint64_t nextEnd = m_segment.fileOffset + m_segment.size + m_options.mappedSegmentSize;
+            if (!AllocateFile(nextEnd))
+                m_errorCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Only whole pages below the write position are finished with
+        const Segment current = m_segment;
+        const size_t begin = m_segmentReleased / page * page;
+        const size_t end = m_segmentUsed / page * page;
+#endif
+
+        lock.unlock();
+
+#ifdef FLOG_PLATFORM_POSIX
+        // Writers never unmap, so the segments stay valid without the lock
+        for (const Segment& segment : retired)
+        {
+            msync(segment.data, segment.size, MS_ASYNC);
+            munmap(segment.data, segment.size);
+        }
+
+        if (current.data != nullptr && end > begin)
+        {
+            msync(current.data + begin, end - begin, MS_ASYNC);
+#ifdef FLOG_PLATFORM_LINUX
+            // Shared mappings keep dirty pages in the page cache, so this only trims the process' resident set
+            madvise(current.data + begin, end - begin, MADV_DONTNEED);
+#endif
+        }
+#endif
+
+        if (!rotated.empty())
+        {
+            if (m_options.compressRotatedFiles)
+            {
+                for (const std::string& path : rotated)
+                    CompressFile(path);
             }
+
+            PruneOldFiles();
         }
+
+        lock.lock();
+
+        bool drained = m_rotatedFiles.empty();
+#ifdef FLOG_PLATFORM_POSIX
+        if (m_segment.data == current.data && end > m_segmentReleased)
+            m_segmentReleased = end;
+
+        drained = drained && m_retiredSegments.empty();
+#endif
+        if (stopping && drained)
+            break;
     }
-    catch (const std::exception&)
+}
+
+void FlexLog::FileSink::FlushBuffer()
+{
+    m_flushDeadline = std::chrono::steady_clock::time_point::max();
+
+#ifdef FLOG_PLATFORM_POSIX
+    if (m_fd < 0 || m_buffer.Size() == 0)
+        return;
+
+    iovec vector = { m_buffer.Data(), m_buffer.Size() };
+    if (!Internal::WriteFully(m_fd, &vector, 1))
+        m_errorCount.fetch_add(1, std::memory_order_relaxed);
+
+    m_buffer.Clear();
+#else
+    if (m_file.is_open() && !m_file.flush())
     {
-        // Log writing failed - we could add fallback behavior here
+        m_errorCount.fetch_add(1, std::memory_order_relaxed);
+        m_file.clear();
     }
+#endif
 }
 
 void FlexLog::FileSink::Flush()
 {
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_file.is_open())
-        m_file.flush();
+    FlushBuffer();
 }
 
 bool FlexLog::FileSink::ReOpen()
@@ -107,7 +529,16 @@ void FlexLog::FileSink::Close()
 bool FlexLog::FileSink::IsOpen()
 {
     std::lock_guard<std::mutex> lock(m_mutex);
+    return IsFileOpen();
+}
+
+bool FlexLog::FileSink::IsFileOpen() const
+{
+#ifdef FLOG_PLATFORM_POSIX
+    return m_fd >= 0;
+#else
     return m_file.is_open();
+#endif
 }
 
 bool FlexLog::FileSink::OpenFile()
@@ -118,7 +549,22 @@ bool FlexLog::FileSink::OpenFile()
             return false;
     }
 
-    std::ios::openmode mode = std::ios::out;
+#ifdef FLOG_PLATFORM_POSIX
+    // O_APPEND keeps every write at the end, even with other processes appending to the same file.
+    // A mapped file is only written through its mapping, which needs read access.
+    int flags = O_CREAT | O_CLOEXEC;
+    flags |= m_options.mappedSegmentSize > 0 ? O_RDWR : O_WRONLY | O_APPEND;
+    if (m_options.truncateOnOpen)
+        flags |= O_TRUNC;
+
+    m_fd = open(m_options.filePath.c_str(), flags, 0644);
+    if (m_fd < 0)
+        return false;
+
+    m_buffer.Reserve(m_options.bufferSize);
+#else
+    // Line endings are written explicitly, and binary records must not be translated
+    std::ios::openmode mode = std::ios::out | std::ios::binary;
     if (m_options.truncateOnOpen)
         mode |= std::ios::trunc;
     else
@@ -129,12 +575,14 @@ bool FlexLog::FileSink::OpenFile()
     if (!m_file)
         return false;
 
+    // MSVC's filebuf passes the buffer to setvbuf() on its FILE, so it only takes effect once the
+    // file is open and before anything is written
     if (m_options.bufferSize > 0)
     {
-        static std::vector<char> buffer;
-        buffer.resize(m_options.bufferSize);
-        m_file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+        m_streamBuffer.resize(m_options.bufferSize);
+        m_file.rdbuf()->pubsetbuf(m_streamBuffer.data(), static_cast<std::streamsize>(m_streamBuffer.size()));
     }
+#endif
 
     if (m_options.enableFileLock && !AcquireFileLock())
     {
@@ -142,19 +590,48 @@ bool FlexLog::FileSink::OpenFile()
         return false;
     }
 
+#ifdef FLOG_PLATFORM_POSIX
+    struct stat status;
+    m_currentFileSize = fstat(m_fd, &status) == 0 ? static_cast<uint64_t>(status.st_size) : 0;
+
+    if (m_options.mappedSegmentSize > 0)
+    {
+        m_allocatedSize = m_currentFileSize;
+        if (!MapSegment(m_currentFileSize, 0))
+        {
+            CloseFile();
+            return false;
+        }
+    }
+#else
     m_file.seekp(0, std::ios::end);
     m_currentFileSize = static_cast<uint64_t>(m_file.tellp());
+#endif
 
+    m_newFile = true;
     return true;
 }
 
 void FlexLog::FileSink::CloseFile()
 {
-    if (m_file.is_open())
+    FlushBuffer();
+
+#ifdef FLOG_PLATFORM_POSIX
+    if (m_fd >= 0)
     {
-        m_file.flush();
-        m_file.close();
+        // Cut the reserved tail of a mapped file back to what was written
+        RetireSegment();
+        if (m_allocatedSize > m_currentFileSize && ftruncate(m_fd, static_cast<off_t>(m_currentFileSize)) != 0)
+            m_errorCount.fetch_add(1, std::memory_order_relaxed);
+
+        close(m_fd);
+        m_fd = -1;
+        m_allocatedSize = 0;
     }
+#else
+    if (m_file.is_open())
+        m_file.close();
+#endif
 
     if (m_options.enableFileLock)
         ReleaseFileLock();
@@ -167,27 +644,27 @@ bool FlexLog::FileSink::ShouldRotate() const
     if (!m_options.enableRotation)
         return false;
 
+    // Time rotation is left to the maintenance thread, and mapped files rotate when a segment fills
     switch (m_options.rotationRule)
     {
-        case RotationRule::Size:        return m_currentFileSize >= m_options.maxFileSize;
-        case RotationRule::Time:        return IsTimeToRotate();
-        case RotationRule::SizeAndTime: return m_currentFileSize >= m_options.maxFileSize || IsTimeToRotate();
+        case RotationRule::Size:
+        case RotationRule::SizeAndTime: return m_options.mappedSegmentSize == 0 && m_currentFileSize >= m_options.maxFileSize;
         default:                        return false;
     }
 }
 
 void FlexLog::FileSink::RotateFile()
 {
-    m_file.close();
-
-    if (m_options.enableFileLock)
-        ReleaseFileLock();
+    // Whatever is buffered belongs to the file being rotated out
+    CloseFile();
 
     std::string rotatedFilename = FormatRotatedFilename();
+    bool rotated = false;
 
     try
     {
         std::filesystem::rename(m_options.filePath, rotatedFilename);
+        rotated = true;
     }
     catch (const std::filesystem::filesystem_error&)
     {
@@ -203,6 +680,7 @@ void FlexLog::FileSink::RotateFile()
 
             // If successful, truncate the original
             std::ofstream truncateFile(m_options.filePath, std::ios::trunc);
+            rotated = true;
         }
         catch (const std::filesystem::filesystem_error&)
         {
@@ -210,17 +688,19 @@ void FlexLog::FileSink::RotateFile()
         }
     }
 
-    if (m_options.compressRotatedFiles)
-        CompressFile(rotatedFilename);
+    // Compressing and pruning can take a while; the maintenance thread does both without the lock. A failed rotation
+    // left the records in the live file, so there is no rotated file to hand it
+    if (rotated)
+    {
+        m_rotatedFiles.push_back(std::move(rotatedFilename));
+        m_maintenanceWake.notify_one();
+    }
 
     m_lastRotationTime = std::chrono::system_clock::now();
 
     if (m_options.rotationRule == RotationRule::Time || m_options.rotationRule == RotationRule::SizeAndTime)
         m_nextRotationTime = CalculateNextRotationTime();
 
-    // Clean up old files if needed
-    PruneOldFiles();
-
     // Reopen file
     OpenFile();
 }
@@ -232,10 +712,7 @@ std::string FlexLog::FileSink::FormatRotatedFilename() const
     std::string extension = originalPath.extension().string();
 
     // Generate timestamp string
-    auto now = std::chrono::system_clock::now();
-    auto time_t_now = std::chrono::system_clock::to_time_t(now);
-    std::stringstream timestamp;
-    timestamp << std::put_time(std::localtime(&time_t_now), "%Y%m%d-%H%M%S");
+    const std::string timestamp = TimestampCache::Format(std::chrono::system_clock::now(), "%Y%m%d-%H%M%S");
 
     // Format the filename using the pattern
     std::string result = m_options.rotationPattern;
@@ -246,7 +723,7 @@ std::string FlexLog::FileSink::FormatRotatedFilename() const
         result.replace(pos, 10, basename);
 
     if ((pos = result.find("{timestamp}")) != std::string::npos)
-        result.replace(pos, 11, timestamp.str());
+        result.replace(pos, 11, timestamp);
 
     if ((pos = result.find("{ext}")) != std::string::npos)
         result.replace(pos, 5, extension.empty() ? "" : extension.substr(1)); // Remove leading dot
@@ -322,14 +799,47 @@ void FlexLog::FileSink::PruneOldFiles()
 
 bool FlexLog::FileSink::CompressFile(const std::filesystem::path& filePath)
 {
-#ifdef ENABLE_COMPRESSION
-    // Implementation using zlib or similar
-    // This is a placeholder - you'll need to implement actual compression
+    std::filesystem::path compressedPath = filePath;
+    compressedPath += ".gz";
+
+    std::ifstream in(filePath, std::ios::binary);
+    std::ofstream out(compressedPath, std::ios::binary | std::ios::trunc);
+    if (!in || !out)
+        return false;
+
+    // Rotated files can be large, so they are compressed a chunk at a time
+    Deflater& deflater = Deflater::GetThreadDeflater();
+    std::vector<char> chunk(DEFAULT_BUFFER_SIZE);
+    Buffer compressed;
+
+    bool succeeded = deflater.Begin(CompressionFormat::Gzip);
+    while (succeeded && in)
+    {
+        in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        const size_t count = static_cast<size_t>(in.gcount());
+
+        if (count > 0)
+            succeeded = deflater.Append(std::string_view(chunk.data(), count), compressed);
+
+        out.write(compressed.Data(), static_cast<std::streamsize>(compressed.Size()));
+        compressed.Clear();
+    }
+
+    succeeded = succeeded && !in.bad() && deflater.Finish(compressed);
+    out.write(compressed.Data(), static_cast<std::streamsize>(compressed.Size()));
+    out.close();
+    in.close();
+
+    // Only the complete .gz replaces the original
+    std::error_code error;
+    if (!succeeded || !out)
+    {
+        std::filesystem::remove(compressedPath, error);
+        return false;
+    }
+
+    std::filesystem::remove(filePath, error);
     return true;
-#else
-    // Compression not available
-    return false;
-#endif
 }
 
 std::chrono::system_clock::time_point FlexLog::FileSink::CalculateNextRotationTime() const
@@ -1,14 +1,18 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <filesystem>
 #include <fstream>
 #include <mutex>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 #include "Common.h"
+#include "Core/Buffer.h"
 #include "Sink.h"
 
 namespace FlexLog
@@ -31,9 +35,36 @@ namespace FlexLog
         Year
     };
 
+    /**
+    * @brief Writes records to a file, with optional size and time based rotation.
+    *
+    * On POSIX systems the file is opened with O_APPEND and written through a
+    * raw descriptor. Records collect in a per-sink buffer that goes to the file
+    * in one write when it fills, when the oldest record in it is flushInterval
+    * old, or when a record at flushLevel or above arrives. A record that doesn't
+    * fit goes out together with the buffer in a single writev(). Elsewhere the
+    * file is a std::ofstream with a buffer of the same size.
+    *
+    * A maintenance thread keeps the slow work off the write path. It flushes
+    * the buffer once the flush interval runs out, even when no more records
+    * arrive, and does time rotation. A rotation on the write path only closes,
+    * renames and reopens the file; the maintenance thread then compresses the
+    * rotated file and prunes old ones.
+    *
+    * With mappedSegmentSize set, POSIX builds instead map the file a segment at
+    * a time: the segment is fallocated and mmap'd, and records are copied
+    * straight into it. The maintenance thread msyncs the filled part, drops it
+    * from memory, unmaps full segments and allocates the next segment before
+    * it is needed. The file is cut back to its real length when it is closed,
+    * so until then it ends in zeros. With size rotation, a full segment is
+    * what rotates the file, and maxFileSize is not used.
+    */
     class FileSink : public Sink
     {
     public:
+        static constexpr size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+        static constexpr uint64_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+
         struct Options
         {
             std::string filePath;
@@ -41,7 +72,10 @@ namespace FlexLog
             bool createDir = true;         // Create directory if it doesn't exist
             bool truncateOnOpen = false;   // Truncate file when opening
             bool autoFlush = false;        // Flush after every write
-            size_t bufferSize = 8192;      // Buffer size for file writing
+            size_t bufferSize = DEFAULT_BUFFER_SIZE; // Bytes buffered before they are written; 0 writes every record at once
+            std::chrono::milliseconds flushInterval{1000}; // Longest a record stays buffered; 0 disables it
+            Level flushLevel = Level::Error; // Records at this level or above are flushed at once
+            uint64_t mappedSegmentSize = 0; // Non-zero writes through mmap'd segments of this size (POSIX only)
             std::string lineEnding = FLOG_NEWLINE; // Line ending to use
 
             bool enableRotation = false;   // Whether to enable file rotation
@@ -51,7 +85,7 @@ namespace FlexLog
             uint32_t timeValue = 1;        // Rotate every N time units
             uint32_t maxFiles = 5;         // Maximum number of rotated files to keep
             std::string rotationPattern = "{basename}.{timestamp}.{ext}"; // Pattern for rotated files
-            bool compressRotatedFiles = false; // Compress rotated files
+            bool compressRotatedFiles = false; // Gzip rotated files, replacing each with a .gz
 
             bool enableFileLock = false;
 
@@ -60,6 +94,9 @@ namespace FlexLog
             Options& SetTruncateOnOpen(bool value) { truncateOnOpen = value; return *this; }
             Options& SetAutoFlush(bool value) { autoFlush = value; return *this; }
             Options& SetBufferSize(size_t size) { bufferSize = size; return *this; }
+            Options& SetFlushInterval(std::chrono::milliseconds interval) { flushInterval = interval; return *this; }
+            Options& SetFlushLevel(Level level) { flushLevel = level; return *this; }
+            Options& EnableMemoryMapping(uint64_t segmentSize = DEFAULT_SEGMENT_SIZE) { mappedSegmentSize = segmentSize; return *this; }
             Options& SetLineEnding(std::string_view ending) { lineEnding = ending; return *this; }
 
             Options& EnableRotation(bool enable = true) { enableRotation = enable; return *this; }
@@ -77,6 +114,7 @@ namespace FlexLog
         ~FileSink() override;
 
         void Output(const Message& msg, const Format& format) override;
+        void Output(const Message& msg, const Format& format, FormattedRecordSet& records) override;
         void Flush() override;
 
         bool ReOpen(); // Reopen the file (useful after rotation)
@@ -86,13 +124,71 @@ namespace FlexLog
         bool IsOpen();
         uint64_t GetCurrentFileSize() const { return m_currentFileSize; }
 
+        // Writes that failed; the bytes they carried are lost
+        [[nodiscard]] uint64_t GetErrorCount() const { return m_errorCount.load(std::memory_order_relaxed); }
+
     private:
+        // How often the maintenance thread checks the rotation time when nothing else wakes it
+        static constexpr std::chrono::milliseconds MAINTENANCE_INTERVAL{1000};
+
+        // Writes text, followed by lineEnding when text doesn't already end a line; binary records are written as is.
+        // level decides, with the options, whether the buffer is flushed straight after.
+        void Write(std::string_view text, bool binary, Level level);
+
+        // Formats and writes a record of a streamed format (see Format::IsStreamed) under m_mutex, so no record
+        // formatted against one file's definitions is written to the next
+        void WriteStreamed(const Message& msg, const Format& format);
+
+        // Rotates by size and reopens the file as needed before a write; false when there is no file to write to.
+        // Caller holds m_mutex.
+        bool PrepareWrite();
+
+        // Writes a record to the open file, then flushes or starts the flush clock as level and the options ask
+        void CommitRecord(std::string_view text, std::string_view lineEnding, Level level);
+
+        // Appends a record to the buffer, or writes it straight through with the buffer when it doesn't fit
+        void WriteRecord(std::string_view text, std::string_view lineEnding);
+
+        // Hands everything buffered to the file; caller holds m_mutex
+        void FlushBuffer();
+
+#ifdef FLOG_PLATFORM_POSIX
+        struct Segment
+        {
+            char* data = nullptr;
+            uint64_t fileOffset = 0;    // Page aligned
+            size_t size = 0;
+        };
+
+        // Copies a record into the mapped segment, rotating or mapping the next segment when it doesn't fit
+        void WriteMapped(std::string_view text, std::string_view lineEnding);
+
+        // Whether a record of recordSize bytes fills the mapped segment and rotates the file before it is written
+        bool IsMappedRotationDue(size_t recordSize) const;
+
+        // Maps the segment holding file position onward, at least room bytes past it; caller holds m_mutex
+        bool MapSegment(uint64_t position, size_t room);
+
+        // Hands the current segment to the maintenance thread to unmap
+        void RetireSegment();
+
+        // Reserves the file's blocks up to end
+        bool AllocateFile(uint64_t end);
+
+#endif
+
+        // Flushes on time, rotates on time and compresses and prunes rotated files; shares m_mutex
+        void MaintenanceThread();
+
+        bool IsFileOpen() const;
         bool OpenFile();
         void CloseFile();
         bool ShouldRotate() const;
         void RotateFile();
         std::string FormatRotatedFilename() const;
         bool CreateDirectoryIfNeeded();
+
+        // Run on the maintenance thread without m_mutex; they only read the options
         void PruneOldFiles();
         bool CompressFile(const std::filesystem::path& filePath);
 
@@ -103,10 +199,33 @@ namespace FlexLog
         void ReleaseFileLock();
 
         Options m_options;
-        std::ofstream m_file;
         std::mutex m_mutex;
 
+#ifdef FLOG_PLATFORM_POSIX
+        int m_fd = -1;
+        Buffer m_buffer;
+
+        Segment m_segment;              // Mapped window records are copied into; data is null when not mapping
+        size_t m_segmentUsed = 0;       // Bytes of m_segment holding file data
+        size_t m_segmentReleased = 0;   // Bytes of m_segment already msync'd and dropped from memory
+        uint64_t m_allocatedSize = 0;   // File length reserved so far
+        std::vector<Segment> m_retiredSegments; // The maintenance thread is the only one to unmap segments
+#else
+        std::ofstream m_file;
+        std::vector<char> m_streamBuffer;   // Installed in m_file's filebuf; each sink has its own
+#endif
+
+        // When the buffered records must be flushed by; max() while nothing is buffered
+        std::chrono::steady_clock::time_point m_flushDeadline = std::chrono::steady_clock::time_point::max();
+        std::atomic<uint64_t> m_errorCount{0};
+
+        std::vector<std::string> m_rotatedFiles;    // Renamed files waiting to be compressed and pruned around
+        std::condition_variable m_maintenanceWake;
+        std::thread m_maintenanceThread;
+        bool m_maintenanceStop = false;
+
         uint64_t m_currentFileSize = 0;
+        bool m_newFile = false;     // Set by OpenFile; the next streamed record starts its format over
         std::chrono::system_clock::time_point m_lastRotationTime;
         std::chrono::system_clock::time_point m_nextRotationTime;
 
@@ -0,0 +1,321 @@
+#include "GelfUdpSink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "Core/NumberFormat.h"
+#include "Core/TraceContext.h"
+
+#ifdef FLOG_PLATFORM_WINDOWS
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #ifdef _MSC_VER
+        #pragma comment(lib, "Ws2_32.lib")
+    #endif
+#else
+    #include <netdb.h>
+    #include <sys/socket.h>
+    #include <sys/types.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+#endif
+
+namespace FlexLog::Internal
+{
+    constexpr char GELF_CHUNK_MAGIC[2] = { 0x1e, 0x0f };
+
+    // Datagrams handed to one sendmmsg() call
+    constexpr size_t GELF_SEND_BATCH = 64;
+
+#ifdef FLOG_PLATFORM_WINDOWS
+    bool StartWinsock()
+    {
+        static const bool s_started = []()
+        {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        return s_started;
+    }
+#endif
+}
+
+FlexLog::GelfUdpSink::GelfUdpSink(const Options& options) : m_options(options)
+{
+    m_options.chunkSize = std::max(m_options.chunkSize, CHUNK_HEADER_SIZE + 1);
+    m_options.batchSize = std::max<size_t>(m_options.batchSize, 1);
+
+    auto format = Format::Create(LogFormat::GELF);
+    format->GetGelfFormatter() = GelfFormatter(GelfFormatter::Options()
+        .SetCompression(m_options.useCompression)
+        .SetCompressionFormat(m_options.compressionFormat, m_options.compressionLevel));
+    SetFormat(std::move(format));
+
+    OpenSocket();
+
+    // Without batching every record is sent as it comes, so there is never anything to wait for
+    if (m_options.batchSize > 1 && m_options.flushInterval.count() > 0)
+        m_flushThread = std::thread(&GelfUdpSink::FlushThread, this);
+}
+
+FlexLog::GelfUdpSink::~GelfUdpSink()
+{
+    if (m_flushThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_flushStop = true;
+        }
+        m_flushWake.notify_one();
+        m_flushThread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SendPending();
+    CloseSocket();
+}
+
+void FlexLog::GelfUdpSink::Output(const Message& msg, const Format& format)
+{
+    Buffer& record = GetThreadBuffer();
+    format.FormatTo(msg, record);
+    Enqueue(record.View());
+}
+
+void FlexLog::GelfUdpSink::Output(const Message&, const Format& format, FormattedRecordSet& records)
+{
+    Enqueue(records.Get(format));
+}
+
+void FlexLog::GelfUdpSink::Flush()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SendPending();
+}
+
+bool FlexLog::GelfUdpSink::IsOpen() const
+{
+#ifdef FLOG_PLATFORM_WINDOWS
+    return m_socket != INVALID_SOCKET;
+#else
+    return m_socket >= 0;
+#endif
+}
+
+bool FlexLog::GelfUdpSink::OpenSocket()
+{
+#ifdef FLOG_PLATFORM_WINDOWS
+    if (!Internal::StartWinsock())
+        return false;
+#endif
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    const std::string port(NumberText(m_options.port).View());
+
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(m_options.host.c_str(), port.c_str(), &hints, &addresses) != 0)
+    {
+        m_errorCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Connected, so sends need no address and ICMP errors are reported back
+    for (addrinfo* address = addresses; address; address = address->ai_next)
+    {
+        const auto fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+
+#ifdef FLOG_PLATFORM_WINDOWS
+        if (fd == INVALID_SOCKET)
+            continue;
+
+        if (connect(fd, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0)
+        {
+            m_socket = fd;
+            break;
+        }
+
+        closesocket(fd);
+#else
+        if (fd < 0)
+            continue;
+
+        if (connect(fd, address->ai_addr, address->ai_addrlen) == 0)
+        {
+            m_socket = fd;
+            break;
+        }
+
+        close(fd);
+#endif
+    }
+
+    freeaddrinfo(addresses);
+
+    if (!IsOpen())
+    {
+        m_errorCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+void FlexLog::GelfUdpSink::CloseSocket()
+{
+    if (!IsOpen())
+        return;
+
+#ifdef FLOG_PLATFORM_WINDOWS
+    closesocket(m_socket);
+    m_socket = INVALID_SOCKET;
+#else
+    close(m_socket);
+    m_socket = -1;
+#endif
+}
+
+void FlexLog::GelfUdpSink::Enqueue(std::string_view record)
+{
+    if (record.empty())
+        return;
+
+    const size_t payloadSize = m_options.chunkSize - CHUNK_HEADER_SIZE;
+    const size_t chunkCount = record.size() <= m_options.chunkSize ? 1 : (record.size() + payloadSize - 1) / payloadSize;
+
+    if (chunkCount > MAX_CHUNKS)
+    {
+        m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (chunkCount == 1)
+    {
+        AddDatagram(nullptr, 0, record.data(), record.size());
+    }
+    else
+    {
+        char header[CHUNK_HEADER_SIZE];
+        std::memcpy(header, Internal::GELF_CHUNK_MAGIC, sizeof(Internal::GELF_CHUNK_MAGIC));
+        Internal::WriteBigEndian(header + 2, Internal::NextRandom());
+        header[11] = static_cast<char>(chunkCount);
+
+        for (size_t i = 0; i < chunkCount; ++i)
+        {
+            const size_t offset = i * payloadSize;
+            header[10] = static_cast<char>(i);
+            AddDatagram(header, sizeof(header), record.data() + offset, std::min(payloadSize, record.size() - offset));
+        }
+    }
+
+    if (++m_pendingRecords >= m_options.batchSize)
+    {
+        SendPending();
+    }
+    else if (m_flushThread.joinable() && m_flushDeadline == std::chrono::steady_clock::time_point::max())
+    {
+        // The first record of a batch starts the clock; the flush thread sends the batch when it runs out
+        m_flushDeadline = std::chrono::steady_clock::now() + m_options.flushInterval;
+        m_flushWake.notify_one();
+    }
+}
+
+void FlexLog::GelfUdpSink::AddDatagram(const char* header, size_t headerSize, const char* payload, size_t payloadSize)
+{
+    const size_t offset = m_pending.Size();
+    char* dst = m_pending.Extend(headerSize + payloadSize);
+
+    if (headerSize > 0)
+        std::memcpy(dst, header, headerSize);
+    std::memcpy(dst + headerSize, payload, payloadSize);
+
+    m_datagrams.push_back({ offset, headerSize + payloadSize });
+}
+
+void FlexLog::GelfUdpSink::SendPending()
+{
+    m_flushDeadline = std::chrono::steady_clock::time_point::max();
+
+    if (m_datagrams.empty())
+        return;
+
+    if (!IsOpen() && !OpenSocket())
+    {
+        m_droppedCount.fetch_add(m_pendingRecords, std::memory_order_relaxed);
+    }
+    else
+    {
+#if defined(FLOG_PLATFORM_LINUX) || defined(FLOG_PLATFORM_ANDROID)
+        mmsghdr messages[Internal::GELF_SEND_BATCH];
+        iovec vectors[Internal::GELF_SEND_BATCH];
+
+        size_t sent = 0;
+        while (sent < m_datagrams.size())
+        {
+            const size_t count = std::min(Internal::GELF_SEND_BATCH, m_datagrams.size() - sent);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const Datagram& datagram = m_datagrams[sent + i];
+                vectors[i].iov_base = m_pending.Data() + datagram.offset;
+                vectors[i].iov_len = datagram.size;
+
+                std::memset(&messages[i], 0, sizeof(mmsghdr));
+                messages[i].msg_hdr.msg_iov = &vectors[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            const int result = sendmmsg(m_socket, messages, static_cast<unsigned int>(count), 0);
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                // A datagram the kernel refused (no buffer space, ICMP unreachable) is lost either way
+                m_errorCount.fetch_add(1, std::memory_order_relaxed);
+                ++sent;
+                continue;
+            }
+
+            sent += static_cast<size_t>(result);
+        }
+#else
+        for (const Datagram& datagram : m_datagrams)
+        {
+    #ifdef FLOG_PLATFORM_WINDOWS
+            const int result = send(m_socket, m_pending.Data() + datagram.offset, static_cast<int>(datagram.size), 0);
+    #else
+            const ssize_t result = send(m_socket, m_pending.Data() + datagram.offset, datagram.size, 0);
+    #endif
+            if (result < 0)
+                m_errorCount.fetch_add(1, std::memory_order_relaxed);
+        }
+#endif
+    }
+
+    m_pending.Clear();
+    m_datagrams.clear();
+    m_pendingRecords = 0;
+}
+
+void FlexLog::GelfUdpSink::FlushThread()
+{
+    // Waiting on m_mutex itself, so the send below runs exactly as a writer's would
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_flushStop)
+    {
+        if (m_flushDeadline == std::chrono::steady_clock::time_point::max())
+            m_flushWake.wait(lock);
+        else
+            m_flushWake.wait_until(lock, m_flushDeadline);
+
+        if (std::chrono::steady_clock::now() >= m_flushDeadline)
+            SendPending();
+    }
+}
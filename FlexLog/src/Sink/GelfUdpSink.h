@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Common.h"
+#include "Core/Buffer.h"
+#include "Core/Deflater.h"
+#include "Sink.h"
+
+namespace FlexLog
+{
+    /**
+    * @brief Sends GELF records to Graylog over UDP, chunked when they don't fit one datagram.
+    *
+    * The sink binds its own GELF format, compressed unless disabled. Records
+    * larger than a chunk are split with the GELF chunking protocol: each chunk
+    * carries the magic bytes, a random 8-byte message ID and its sequence
+    * number and count. Graylog drops messages of more than 128 chunks, so the
+    * sink drops them first and counts them.
+    *
+    * Datagrams are queued until batchSize records are pending, then go out in
+    * one sendmmsg() call on Linux; Flush() sends whatever is queued. When
+    * batching, a timer thread also sends a batch once its first record has
+    * waited flushInterval, so a quiet logger's records aren't held back.
+    */
+    class GelfUdpSink : public Sink
+    {
+    public:
+        static constexpr uint16_t DEFAULT_PORT = 12201;
+        static constexpr size_t DEFAULT_CHUNK_SIZE = 8192;
+        static constexpr size_t CHUNK_HEADER_SIZE = 12;
+        static constexpr size_t MAX_CHUNKS = 128;
+
+        struct Options
+        {
+            std::string host = "127.0.0.1";
+            uint16_t port = DEFAULT_PORT;
+            size_t chunkSize = DEFAULT_CHUNK_SIZE;  // Largest datagram sent, chunk header included
+            size_t batchSize = 1;                   // Records queued before a send; 1 sends every record at once
+            std::chrono::milliseconds flushInterval{1000}; // Longest a record waits for its batch; 0 disables it and the timer thread
+
+            bool useCompression = true;
+            CompressionFormat compressionFormat = CompressionFormat::Gzip;
+            int compressionLevel = Deflater::DEFAULT_LEVEL;
+
+            Options& SetHost(std::string_view value) { host = value; return *this; }
+            Options& SetPort(uint16_t value) { port = value; return *this; }
+            Options& SetChunkSize(size_t size) { chunkSize = size; return *this; }
+            Options& SetBatchSize(size_t size) { batchSize = size; return *this; }
+            Options& SetFlushInterval(std::chrono::milliseconds interval) { flushInterval = interval; return *this; }
+            Options& SetCompression(bool compress, CompressionFormat format = CompressionFormat::Gzip, int level = Deflater::DEFAULT_LEVEL)
+            {
+                useCompression = compress;
+                compressionFormat = format;
+                compressionLevel = level;
+                return *this;
+            }
+        };
+
+        explicit GelfUdpSink(const Options& options = Options());
+        ~GelfUdpSink() override;
+
+        void Output(const Message& msg, const Format& format) override;
+        void Output(const Message& msg, const Format& format, FormattedRecordSet& records) override;
+        void Flush() override;
+
+        const Options& GetOptions() const { return m_options; }
+        bool IsOpen() const;
+
+        [[nodiscard]] uint64_t GetErrorCount() const { return m_errorCount.load(std::memory_order_relaxed); }
+        [[nodiscard]] uint64_t GetDroppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+    private:
+        struct Datagram
+        {
+            size_t offset;  // Into m_pending, which may move as it grows
+            size_t size;
+        };
+
+        bool OpenSocket();
+        void CloseSocket();
+
+        // Queues record as one datagram, or as GELF chunks when it is larger than chunkSize
+        void Enqueue(std::string_view record);
+        void AddDatagram(const char* header, size_t headerSize, const char* payload, size_t payloadSize);
+
+        // Sends every queued datagram; caller holds m_mutex
+        void SendPending();
+
+        // Sends the pending batch once m_flushDeadline passes
+        void FlushThread();
+
+        Options m_options;
+        std::mutex m_mutex;
+
+        Buffer m_pending;
+        std::vector<Datagram> m_datagrams;
+        size_t m_pendingRecords = 0;
+
+        // When the pending batch must be sent by; max() while nothing is queued
+        std::chrono::steady_clock::time_point m_flushDeadline = std::chrono::steady_clock::time_point::max();
+        std::condition_variable m_flushWake;
+        std::thread m_flushThread;
+        bool m_flushStop = false;
+
+#ifdef FLOG_PLATFORM_WINDOWS
+        uintptr_t m_socket = ~static_cast<uintptr_t>(0);
+#else
+        int m_socket = -1;
+#endif
+
+        std::atomic<uint64_t> m_errorCount{0};
+        std::atomic<uint64_t> m_droppedCount{0};
+    };
+}
@@ -0,0 +1,628 @@
+#include "IoUringFileSink.h"
+
+#ifdef FLOG_PLATFORM_POSIX
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef FLOG_PLATFORM_LINUX
+    #include <atomic>
+
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <sys/uio.h>
+#endif
+
+namespace FlexLog::Internal
+{
+    // One write SQE is limited to a 32-bit length
+    constexpr size_t MAX_URING_BUFFER_SIZE = 1024 * 1024 * 1024;
+
+    // Registered buffers are addressed by a 16-bit index; far more than a sink would want anyway
+    constexpr size_t MAX_URING_BUFFER_COUNT = 1024;
+
+    // Operations in flight per slot: its write and a linked fdatasync
+    constexpr unsigned URING_OPS_PER_SLOT = 2;
+
+    // Low bit of an SQE's user data: set on the fdatasync, clear on the write; the slot index is above it
+    constexpr uint64_t URING_SYNC_TAG = 1;
+
+    int SyncData(int fd)
+    {
+#ifdef FLOG_PLATFORM_APPLE
+        return fsync(fd);
+#else
+        return fdatasync(fd);
+#endif
+    }
+}
+
+#ifdef FLOG_PLATFORM_LINUX
+/**
+* @brief Minimal io_uring: one submission and one completion queue, mapped with the raw syscalls.
+*
+* Only the sink's m_mutex holder touches the queues, so the head and tail
+* indices need no more than acquire/release ordering against the kernel.
+*/
+class FlexLog::IoUringFileSink::Ring
+{
+public:
+    ~Ring()
+    {
+        if (m_sqes != nullptr)
+            munmap(m_sqes, m_sqesSize);
+        if (m_ringMemory != nullptr)
+            munmap(m_ringMemory, m_ringSize);
+        if (m_ringFd >= 0)
+            close(m_ringFd);
+    }
+
+    // Sets up a ring for slots writing to fd; null when io_uring is missing, disabled or too old
+    static std::unique_ptr<Ring> Create(int fd, const std::vector<Slot>& slots, size_t bufferSize)
+    {
+        const unsigned entries = static_cast<unsigned>(slots.size()) * Internal::URING_OPS_PER_SLOT;
+
+        std::unique_ptr<Ring> ring(new Ring());
+        ring->m_fd = fd;
+
+        io_uring_params params{};
+        ring->m_ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ring->m_ringFd < 0)
+            return nullptr;
+
+        // Kernels with a single ring mapping (5.4+) also support linked operations
+        if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0)
+            return nullptr;
+
+        const size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        const size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        ring->m_ringSize = std::max(sqSize, cqSize);
+
+        void* ringMemory = mmap(nullptr, ring->m_ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->m_ringFd, IORING_OFF_SQ_RING);
+        if (ringMemory == MAP_FAILED)
+            return nullptr;
+        ring->m_ringMemory = ringMemory;
+
+        ring->m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, ring->m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->m_ringFd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+            return nullptr;
+        ring->m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+        char* base = static_cast<char*>(ringMemory);
+        ring->m_sqHead = reinterpret_cast<uint32_t*>(base + params.sq_off.head);
+        ring->m_sqTail = reinterpret_cast<uint32_t*>(base + params.sq_off.tail);
+        ring->m_sqMask = *reinterpret_cast<uint32_t*>(base + params.sq_off.ring_mask);
+        ring->m_sqEntries = params.sq_entries;
+        ring->m_sqArray = reinterpret_cast<uint32_t*>(base + params.sq_off.array);
+        ring->m_cqHead = reinterpret_cast<uint32_t*>(base + params.cq_off.head);
+        ring->m_cqTail = reinterpret_cast<uint32_t*>(base + params.cq_off.tail);
+        ring->m_cqMask = *reinterpret_cast<uint32_t*>(base + params.cq_off.ring_mask);
+        ring->m_cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+
+        // Registered buffers skip the page pinning on every write, but count against RLIMIT_MEMLOCK
+        std::vector<iovec> buffers(slots.size());
+        for (size_t i = 0; i < slots.size(); ++i)
+            buffers[i] = { slots[i].data, bufferSize };
+
+        ring->m_registered = syscall(__NR_io_uring_register, ring->m_ringFd, IORING_REGISTER_BUFFERS, buffers.data(), static_cast<unsigned>(buffers.size())) == 0;
+
+        // Without them, plain writes need IORING_OP_WRITE (5.6+)
+        if (!ring->m_registered && !ring->Supports(IORING_OP_WRITE))
+            return nullptr;
+
+        return ring;
+    }
+
+    // Queues a write of slot index's data at offset, with a linked fdatasync when sync is set; false if the queue is full
+    bool QueueWrite(size_t index, const char* data, size_t size, uint64_t offset, bool sync)
+    {
+        const unsigned needed = sync ? 2 : 1;
+        uint32_t tail = *m_sqTail;
+        const uint32_t head = std::atomic_ref<uint32_t>(*m_sqHead).load(std::memory_order_acquire);
+
+        if (tail - head + needed > m_sqEntries)
+            return false;
+
+        io_uring_sqe* write = NextSqe(tail++);
+        write->opcode = m_registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        write->fd = m_fd;
+        write->addr = reinterpret_cast<uint64_t>(data);
+        write->len = static_cast<uint32_t>(size);
+        write->off = offset;
+        write->user_data = static_cast<uint64_t>(index) << 1;
+        if (m_registered)
+            write->buf_index = static_cast<uint16_t>(index);
+
+        if (sync)
+        {
+            // Drain makes the write wait for every earlier one, so the fdatasync covers the whole file up to here
+            write->flags = IOSQE_IO_LINK | IOSQE_IO_DRAIN;
+
+            io_uring_sqe* fsync = NextSqe(tail++);
+            fsync->opcode = IORING_OP_FSYNC;
+            fsync->fd = m_fd;
+            fsync->fsync_flags = IORING_FSYNC_DATASYNC;
+            fsync->user_data = (static_cast<uint64_t>(index) << 1) | Internal::URING_SYNC_TAG;
+        }
+
+        std::atomic_ref<uint32_t>(*m_sqTail).store(tail, std::memory_order_release);
+        m_unsubmitted += needed;
+        return true;
+    }
+
+    // Submits queued operations, then blocks until at least minComplete have completed
+    bool Enter(unsigned minComplete)
+    {
+        const unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+        while (true)
+        {
+            const long result = syscall(__NR_io_uring_enter, m_ringFd, m_unsubmitted, minComplete, flags, nullptr, 0);
+            if (result >= 0)
+            {
+                m_unsubmitted -= static_cast<unsigned>(result);
+                return true;
+            }
+
+            if (errno != EINTR)
+                return false;
+        }
+    }
+
+    // Calls fn(userData, result) for every completion waiting in the queue; fn must not reap again
+    template<typename Fn>
+    void ForEachCompletion(Fn&& fn)
+    {
+        uint32_t head = *m_cqHead;
+        const uint32_t tail = std::atomic_ref<uint32_t>(*m_cqTail).load(std::memory_order_acquire);
+
+        while (head != tail)
+        {
+            const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+            fn(cqe.user_data, cqe.res);
+            ++head;
+        }
+
+        std::atomic_ref<uint32_t>(*m_cqHead).store(head, std::memory_order_release);
+    }
+
+private:
+    Ring() = default;
+
+    io_uring_sqe* NextSqe(uint32_t tail)
+    {
+        const uint32_t index = tail & m_sqMask;
+        io_uring_sqe* sqe = &m_sqes[index];
+        std::memset(sqe, 0, sizeof(io_uring_sqe));
+        m_sqArray[index] = index;
+        return sqe;
+    }
+
+    bool Supports(uint8_t opcode) const
+    {
+        constexpr unsigned PROBE_OPS = 256;
+        std::vector<char> storage(sizeof(io_uring_probe) + PROBE_OPS * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+
+        if (syscall(__NR_io_uring_register, m_ringFd, IORING_REGISTER_PROBE, probe, PROBE_OPS) != 0)
+            return false;
+
+        return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+
+    int m_ringFd = -1;
+    int m_fd = -1;
+    bool m_registered = false;
+    unsigned m_unsubmitted = 0;
+
+    void* m_ringMemory = nullptr;
+    size_t m_ringSize = 0;
+    io_uring_sqe* m_sqes = nullptr;
+    size_t m_sqesSize = 0;
+
+    uint32_t* m_sqHead = nullptr;
+    uint32_t* m_sqTail = nullptr;
+    uint32_t* m_sqArray = nullptr;
+    uint32_t m_sqMask = 0;
+    uint32_t m_sqEntries = 0;
+
+    uint32_t* m_cqHead = nullptr;
+    uint32_t* m_cqTail = nullptr;
+    uint32_t m_cqMask = 0;
+    io_uring_cqe* m_cqes = nullptr;
+};
+#else
+// io_uring is Linux only; everywhere else the writer thread does the writes
+class FlexLog::IoUringFileSink::Ring
+{
+public:
+    static std::unique_ptr<Ring> Create(int, const std::vector<Slot>&, size_t) { return nullptr; }
+    bool QueueWrite(size_t, const char*, size_t, uint64_t, bool) { return false; }
+    bool Enter(unsigned) { return false; }
+
+    template<typename Fn>
+    void ForEachCompletion(Fn&&) {}
+};
+#endif
+
+FlexLog::IoUringFileSink::IoUringFileSink(const Options& options) : m_options(options)
+{
+    m_options.bufferSize = std::clamp<size_t>(m_options.bufferSize, 1, Internal::MAX_URING_BUFFER_SIZE);
+    m_options.bufferCount = std::clamp<size_t>(m_options.bufferCount, 2, Internal::MAX_URING_BUFFER_COUNT);
+
+    if (m_options.createDir)
+    {
+        std::error_code error;
+        const std::filesystem::path dir = std::filesystem::path(m_options.filePath).parent_path();
+        if (!dir.empty())
+            std::filesystem::create_directories(dir, error);
+    }
+
+    // No O_APPEND: Linux ignores pwrite offsets on append-mode files, and each write carries its own offset
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+    if (m_options.truncateOnOpen)
+        flags |= O_TRUNC;
+
+    m_fd = open(m_options.filePath.c_str(), flags, 0644);
+    if (m_fd < 0)
+        return;
+
+    struct stat status;
+    m_fileOffset = fstat(m_fd, &status) == 0 ? static_cast<uint64_t>(status.st_size) : 0;
+
+    m_storage = std::make_unique<char[]>(m_options.bufferSize * m_options.bufferCount);
+    m_slots.resize(m_options.bufferCount);
+    m_freeSlots.reserve(m_options.bufferCount);
+
+    for (size_t i = 0; i < m_slots.size(); ++i)
+    {
+        m_slots[i].data = m_storage.get() + i * m_options.bufferSize;
+        m_freeSlots.push_back(m_slots.size() - 1 - i);
+    }
+
+    if (m_options.useIoUring)
+        m_ring = Ring::Create(m_fd, m_slots, m_options.bufferSize);
+
+    if (!m_ring)
+        m_writer = std::thread(&IoUringFileSink::WriterThread, this);
+
+    if (m_options.flushInterval.count() > 0)
+        m_flushThread = std::thread(&IoUringFileSink::FlushThread, this);
+}
+
+FlexLog::IoUringFileSink::~IoUringFileSink()
+{
+    if (m_flushThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_flushStop = true;
+        }
+        m_flushWake.notify_one();
+        m_flushThread.join();
+    }
+
+    Flush();
+
+    if (m_writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> slotLock(m_slotMutex);
+            m_stopping = true;
+        }
+        m_submitted.notify_one();
+        m_writer.join();
+    }
+
+    m_ring.reset();
+
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+void FlexLog::IoUringFileSink::Output(const Message& msg, const Format& format)
+{
+    Buffer& record = GetThreadBuffer();
+    format.FormatTo(msg, record);
+    Write(record.View(), format.IsBinary(), msg.level);
+}
+
+void FlexLog::IoUringFileSink::Output(const Message& msg, const Format& format, FormattedRecordSet& records)
+{
+    Write(records.Get(format), format.IsBinary(), msg.level);
+}
+
+void FlexLog::IoUringFileSink::Flush()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0)
+        return;
+
+    SubmitCurrent(false);
+    WaitForWrites();
+}
+
+void FlexLog::IoUringFileSink::Write(std::string_view text, bool binary, Level level)
+{
+    if (text.empty())
+        return;
+
+    const std::string_view lineEnding = !binary && text.back() != '\n' ? std::string_view(m_options.lineEnding) : std::string_view();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0)
+        return;
+
+    // Records larger than a buffer simply continue into the next one
+    for (std::string_view bytes : { text, lineEnding })
+    {
+        while (!bytes.empty())
+        {
+            // A full slot is only submitted once more bytes arrive, so the last one of a record can carry its sync
+            if (m_current != NO_SLOT && m_slots[m_current].size == m_options.bufferSize)
+                SubmitCurrent(false);
+
+            if (m_current == NO_SLOT && !AcquireSlot())
+            {
+                m_errorCount.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            Slot& slot = m_slots[m_current];
+            const size_t count = std::min(bytes.size(), m_options.bufferSize - slot.size);
+            std::memcpy(slot.data + slot.size, bytes.data(), count);
+            slot.size += count;
+            bytes.remove_prefix(count);
+        }
+    }
+
+    if (level >= m_options.syncLevel)
+    {
+        SubmitCurrent(true);
+    }
+    else if (level >= m_options.flushLevel)
+    {
+        SubmitCurrent(false);
+    }
+    else if (m_current != NO_SLOT && m_options.flushInterval.count() > 0 && m_flushDeadline == std::chrono::steady_clock::time_point::max())
+    {
+        // The first record into an empty buffer starts the clock; the flush thread submits the buffer when it runs out
+        m_flushDeadline = std::chrono::steady_clock::now() + m_options.flushInterval;
+        m_flushWake.notify_one();
+    }
+}
+
+void FlexLog::IoUringFileSink::SubmitCurrent(bool sync)
+{
+    m_flushDeadline = std::chrono::steady_clock::time_point::max();
+
+    if (m_current == NO_SLOT)
+        return;
+
+    const size_t index = m_current;
+    m_current = NO_SLOT;
+
+    // Each slot reserves its range of the file up front, so writes can land in any order
+    Slot& slot = m_slots[index];
+    slot.offset = m_fileOffset;
+    slot.written = 0;
+    slot.sync = sync;
+    slot.failed = false;
+    m_fileOffset += slot.size;
+
+    {
+        std::lock_guard<std::mutex> slotLock(m_slotMutex);
+        ++m_inFlight;
+    }
+
+    StartWrite(index);
+
+    // Picks up whatever finished meanwhile, so slots come back without anyone waiting for them
+    if (m_ring)
+        ReapCompletions(false);
+}
+
+bool FlexLog::IoUringFileSink::AcquireSlot()
+{
+    std::unique_lock<std::mutex> slotLock(m_slotMutex);
+
+    while (m_freeSlots.empty())
+    {
+        if (m_ring)
+        {
+            // Completions are reaped with m_mutex held, which the caller already has
+            slotLock.unlock();
+            const bool reaped = ReapCompletions(true);
+            slotLock.lock();
+
+            if (!reaped)
+                return false;
+        }
+        else
+        {
+            m_completed.wait(slotLock);
+        }
+    }
+
+    m_current = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    return true;
+}
+
+void FlexLog::IoUringFileSink::WaitForWrites()
+{
+    std::unique_lock<std::mutex> slotLock(m_slotMutex);
+
+    while (m_inFlight > 0)
+    {
+        if (m_ring)
+        {
+            slotLock.unlock();
+            const bool reaped = ReapCompletions(true);
+            slotLock.lock();
+
+            if (!reaped)
+                return;
+        }
+        else
+        {
+            m_completed.wait(slotLock);
+        }
+    }
+}
+
+void FlexLog::IoUringFileSink::StartWrite(size_t index)
+{
+    Slot& slot = m_slots[index];
+
+    if (!m_ring)
+    {
+        {
+            std::lock_guard<std::mutex> slotLock(m_slotMutex);
+            m_queue.push_back(index);
+        }
+        m_submitted.notify_one();
+        return;
+    }
+
+    // The queue holds two entries per slot, so it has room for whatever is in flight
+    if (!m_ring->QueueWrite(index, slot.data + slot.written, slot.size - slot.written, slot.offset + slot.written, slot.sync))
+    {
+        std::lock_guard<std::mutex> slotLock(m_slotMutex);
+        CompleteSlot(index, true);
+        return;
+    }
+
+    slot.pending = slot.sync ? 2 : 1;
+
+    // Should the submit fail, the entries stay queued and go with the next one
+    m_ring->Enter(0);
+}
+
+bool FlexLog::IoUringFileSink::ReapCompletions(bool wait)
+{
+    if (wait && !m_ring->Enter(1))
+        return false;
+
+    m_ring->ForEachCompletion([this](uint64_t userData, int32_t result) { HandleCompletion(userData, result); });
+    return true;
+}
+
+void FlexLog::IoUringFileSink::HandleCompletion(uint64_t userData, int32_t result)
+{
+    const size_t index = static_cast<size_t>(userData >> 1);
+    Slot& slot = m_slots[index];
+    --slot.pending;
+
+    if ((userData & Internal::URING_SYNC_TAG) != 0)
+    {
+        // A short write cancels its linked fdatasync; both are queued again below
+        if (result < 0 && result != -ECANCELED)
+            slot.failed = true;
+    }
+    else if (result > 0)
+    {
+        slot.written += static_cast<size_t>(result);
+    }
+    else if (result != -EINTR && result != -EAGAIN)
+    {
+        slot.failed = true;
+    }
+
+    if (slot.pending > 0)
+        return;
+
+    if (!slot.failed && slot.written < slot.size)
+    {
+        StartWrite(index);
+        return;
+    }
+
+    std::lock_guard<std::mutex> slotLock(m_slotMutex);
+    CompleteSlot(index, slot.failed);
+}
+
+void FlexLog::IoUringFileSink::CompleteSlot(size_t index, bool failed)
+{
+    if (failed)
+        m_errorCount.fetch_add(1, std::memory_order_relaxed);
+
+    Slot& slot = m_slots[index];
+    slot.size = 0;
+    slot.written = 0;
+    slot.pending = 0;
+    slot.sync = false;
+    slot.failed = false;
+
+    m_freeSlots.push_back(index);
+    --m_inFlight;
+    m_completed.notify_all();
+}
+
+void FlexLog::IoUringFileSink::WriterThread()
+{
+    std::unique_lock<std::mutex> slotLock(m_slotMutex);
+
+    while (true)
+    {
+        m_submitted.wait(slotLock, [this]() { return !m_queue.empty() || m_stopping; });
+        if (m_queue.empty())
+            return;
+
+        const size_t index = m_queue.front();
+        m_queue.pop_front();
+        slotLock.unlock();
+
+        // Slots are written in submission order, so an fdatasync covers every earlier record too
+        Slot& slot = m_slots[index];
+        bool failed = false;
+
+        while (slot.written < slot.size)
+        {
+            const ssize_t written = pwrite(m_fd, slot.data + slot.written, slot.size - slot.written, static_cast<off_t>(slot.offset + slot.written));
+            if (written < 0 && errno == EINTR)
+                continue;
+
+            if (written <= 0)
+            {
+                failed = true;
+                break;
+            }
+
+            slot.written += static_cast<size_t>(written);
+        }
+
+        if (!failed && slot.sync && Internal::SyncData(m_fd) != 0)
+            failed = true;
+
+        slotLock.lock();
+        CompleteSlot(index, failed);
+    }
+}
+
+void FlexLog::IoUringFileSink::FlushThread()
+{
+    // Waiting on m_mutex itself, so the submit below runs exactly as a writer's would
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_flushStop)
+    {
+        if (m_flushDeadline == std::chrono::steady_clock::time_point::max())
+            m_flushWake.wait(lock);
+        else
+            m_flushWake.wait_until(lock, m_flushDeadline);
+
+        if (std::chrono::steady_clock::now() >= m_flushDeadline)
+            SubmitCurrent(false);
+    }
+}
+
+#endif
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "Common.h"
+
+#ifdef FLOG_PLATFORM_POSIX
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Sink.h"
+
+namespace FlexLog
+{
+    /**
+    * @brief Appends records to a file with asynchronous writes that overlap with formatting.
+    *
+    * Records are copied into one of a fixed set of buffers. A full buffer is
+    * submitted as a write at the file offset it reserved and the worker moves
+    * on to the next free one; a buffer is only reused once its write has
+    * completed. Writes may complete out of order, since each has its own offset.
+    *
+    * On Linux the writes go through io_uring, set up with raw syscalls. The
+    * buffers are registered with the ring when the memlock limit allows it, and
+    * a record at syncLevel or above links an fdatasync behind its buffer's
+    * write. Where io_uring is unavailable, a writer thread issues the same
+    * writes with pwrite(). Workers only block when every buffer is in flight.
+    * With a flushInterval, a timer thread submits a partly filled buffer once
+    * its first record has waited that long, even if no other record arrives.
+    *
+    * The sink doesn't rotate its file; POSIX only.
+    */
+    class IoUringFileSink : public Sink
+    {
+    public:
+        static constexpr size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+        static constexpr size_t DEFAULT_BUFFER_COUNT = 8;
+
+        struct Options
+        {
+            std::string filePath;
+
+            bool createDir = true;          // Create directory if it doesn't exist
+            bool truncateOnOpen = false;    // Truncate file when opening
+            size_t bufferSize = DEFAULT_BUFFER_SIZE;    // Bytes per buffer, and per write
+            size_t bufferCount = DEFAULT_BUFFER_COUNT;  // Buffers filling or in flight at once
+            std::chrono::milliseconds flushInterval{1000}; // Longest a record stays buffered; 0 disables it and the timer thread
+            Level flushLevel = Level::Error;    // Records at this level or above are submitted at once
+            Level syncLevel = Level::Off;       // Records at this level or above are made durable with fdatasync
+            bool useIoUring = true;             // false always uses the writer thread
+            std::string lineEnding = FLOG_NEWLINE;
+
+            Options& SetFilePath(std::string_view path) { filePath = path; return *this; }
+            Options& SetCreateDir(bool value) { createDir = value; return *this; }
+            Options& SetTruncateOnOpen(bool value) { truncateOnOpen = value; return *this; }
+            Options& SetBuffers(size_t size, size_t count) { bufferSize = size; bufferCount = count; return *this; }
+            Options& SetFlushInterval(std::chrono::milliseconds interval) { flushInterval = interval; return *this; }
+            Options& SetFlushLevel(Level level) { flushLevel = level; return *this; }
+            Options& SetSyncLevel(Level level) { syncLevel = level; return *this; }
+            Options& SetUseIoUring(bool use) { useIoUring = use; return *this; }
+            Options& SetLineEnding(std::string_view ending) { lineEnding = ending; return *this; }
+        };
+
+        explicit IoUringFileSink(const Options& options = Options());
+        ~IoUringFileSink() override;
+
+        IoUringFileSink(const IoUringFileSink&) = delete;
+        IoUringFileSink& operator=(const IoUringFileSink&) = delete;
+
+        void Output(const Message& msg, const Format& format) override;
+        void Output(const Message& msg, const Format& format, FormattedRecordSet& records) override;
+
+        // Submits the partly filled buffer and waits until every write has completed
+        void Flush() override;
+
+        const Options& GetOptions() const { return m_options; }
+        bool IsOpen() const { return m_fd >= 0; }
+
+        // Whether writes go through io_uring rather than the writer thread
+        bool IsUsingIoUring() const { return m_ring != nullptr; }
+
+        [[nodiscard]] uint64_t GetErrorCount() const { return m_errorCount.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr size_t NO_SLOT = ~static_cast<size_t>(0);
+
+        struct Slot
+        {
+            char* data = nullptr;
+            size_t size = 0;        // Bytes filled, then bytes to write
+            size_t written = 0;     // Bytes completed, which can take several writes
+            uint64_t offset = 0;    // File offset reserved when the slot was submitted
+            unsigned pending = 0;   // Ring operations not completed yet
+            bool sync = false;      // fdatasync once the write is done
+            bool failed = false;
+        };
+
+        class Ring;
+
+        void Write(std::string_view text, bool binary, Level level);
+
+        // Submits the slot being filled, if any; caller holds m_mutex
+        void SubmitCurrent(bool sync);
+
+        // Makes m_current a free slot, waiting for a write to complete when all are in flight; caller holds m_mutex
+        bool AcquireSlot();
+
+        // Waits until no write is in flight; caller holds m_mutex
+        void WaitForWrites();
+
+        // Hands what is left of a submitted slot to the ring or the writer thread; caller holds m_mutex
+        void StartWrite(size_t index);
+
+        // Reaps ring completions, first blocking for one when wait is set; caller holds m_mutex
+        bool ReapCompletions(bool wait);
+        void HandleCompletion(uint64_t userData, int32_t result);
+
+        // Returns a slot whose write has finished to the free list; caller holds m_slotMutex
+        void CompleteSlot(size_t index, bool failed);
+
+        void WriterThread();
+
+        // Submits the slot being filled once m_flushDeadline passes
+        void FlushThread();
+
+        Options m_options;
+        int m_fd = -1;
+
+        // Guards the slot being filled, the file offset and the ring; held for a whole record, so records never interleave
+        std::mutex m_mutex;
+        size_t m_current = NO_SLOT;
+        uint64_t m_fileOffset = 0;
+        std::chrono::steady_clock::time_point m_flushDeadline = std::chrono::steady_clock::time_point::max();
+        std::condition_variable m_flushWake;
+        std::thread m_flushThread;
+        bool m_flushStop = false;
+        std::unique_ptr<Ring> m_ring;
+
+        std::unique_ptr<char[]> m_storage;
+        std::vector<Slot> m_slots;
+
+        // Guards what is shared with the writer thread
+        std::mutex m_slotMutex;
+        std::condition_variable m_completed;
+        std::condition_variable m_submitted;
+        std::vector<size_t> m_freeSlots;
+        std::deque<size_t> m_queue;
+        size_t m_inFlight = 0;
+        bool m_stopping = false;
+        std::thread m_writer;
+
+        std::atomic<uint64_t> m_errorCount{0};
+    };
+}
+
+#endif
@@ -1 +1,8 @@
 #include "Sink.h"
+
+FlexLog::Buffer& FlexLog::Sink::GetThreadBuffer()
+{
+    thread_local Buffer buffer;
+    buffer.Clear();
+    return buffer;
+}
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+
 #include "Common.h"
+#include "Core/Buffer.h"
 #include "Format/Format.h"
+#include "Format/FormattedRecord.h"
+#include "Level.h"
 #include "Message.h"
 
 namespace FlexLog
@@ -13,6 +19,28 @@ namespace FlexLog
         virtual ~Sink() = default;
 
         virtual void Output(const Message& msg, const Format& format) = 0;
+
+        // Fan-out entry point used by Logger. Sinks that only need the formatted bytes override this and take
+        // the bytes shared by every sink with the same format from records; the default formats again.
+        virtual void Output(const Message& msg, const Format& format, FormattedRecordSet&) { Output(msg, format); }
         virtual void Flush() {}
+
+        // Messages below the sink's level are skipped before they are formatted
+        [[nodiscard]] Level GetLevel() const { return m_level.load(std::memory_order_relaxed); }
+        void SetLevel(Level level) { m_level.store(level, std::memory_order_relaxed); }
+        [[nodiscard]] bool ShouldLog(Level level) const noexcept { return level >= m_level.load(std::memory_order_relaxed); }
+
+        // Format used for this sink instead of the logger's; null means the logger's format. Formats are shared and
+        // immutable once bound, sinks bound to the same instance share one formatted record per message.
+        [[nodiscard]] std::shared_ptr<const Format> GetFormat() const { return m_format.load(std::memory_order_acquire); }
+        void SetFormat(std::shared_ptr<const Format> format) { m_format.store(std::move(format), std::memory_order_release); }
+
+    protected:
+        // Scratch buffer owned by the calling worker thread, returned empty; its capacity is kept between messages
+        static Buffer& GetThreadBuffer();
+
+    private:
+        std::atomic<Level> m_level{Level::Trace};
+        std::atomic<std::shared_ptr<const Format>> m_format;
     };
 }
@@ -0,0 +1,178 @@
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Format/Binary/BinaryReader.h"
+#include "Format/Format.h"
+
+namespace
+{
+    constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+
+    constexpr std::array<std::pair<std::string_view, FlexLog::LogFormat>, 10> FORMAT_NAMES =
+    {{
+        { "pattern", FlexLog::LogFormat::Pattern },
+        { "cloudwatch", FlexLog::LogFormat::CloudWatch },
+        { "elasticsearch", FlexLog::LogFormat::Elasticsearch },
+        { "gelf", FlexLog::LogFormat::GELF },
+        { "json", FlexLog::LogFormat::JSON },
+        { "logstash", FlexLog::LogFormat::Logstash },
+        { "msgpack", FlexLog::LogFormat::MessagePack },
+        { "otel", FlexLog::LogFormat::OpenTelemetry },
+        { "splunk", FlexLog::LogFormat::Splunk },
+        { "xml", FlexLog::LogFormat::XML }
+    }};
+
+    std::optional<FlexLog::LogFormat> ParseFormatName(std::string_view name)
+    {
+        for (const auto& [formatName, logFormat] : FORMAT_NAMES)
+        {
+            if (formatName == name)
+                return logFormat;
+        }
+        return std::nullopt;
+    }
+
+    void PrintUsage()
+    {
+        std::cerr <<
+            "Usage: FlexLogDecode [options] <file>...\n"
+            "Renders files written with LogFormat::Binary; pass a rotated set oldest first.\n"
+            "\n"
+            "  -f, --format <name>    pattern (default), cloudwatch, elasticsearch, gelf, json,\n"
+            "                         logstash, msgpack, otel, splunk or xml\n"
+            "  -p, --pattern <text>   pattern used by --format pattern\n"
+            "  -o, --output <path>    write to a file instead of stdout\n";
+    }
+
+    bool ReadFile(const std::string& path, std::string& contents)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if (!file)
+            return false;
+
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return !file.bad();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    FlexLog::Format format;
+    std::string outputPath;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if ((arg == "-f" || arg == "--format") && hasValue)
+        {
+            const auto logFormat = ParseFormatName(argv[++i]);
+            if (!logFormat)
+            {
+                std::cerr << "Unknown format: " << argv[i] << "\n";
+                return 1;
+            }
+            format.SetLogFormat(*logFormat);
+        }
+        else if ((arg == "-p" || arg == "--pattern") && hasValue)
+        {
+            format.GetPatternFormatter().SetPattern(argv[++i]);
+        }
+        else if ((arg == "-o" || arg == "--output") && hasValue)
+        {
+            outputPath = argv[++i];
+        }
+        else if (arg == "-h" || arg == "--help")
+        {
+            PrintUsage();
+            return 0;
+        }
+        else if (!arg.empty() && arg.front() == '-')
+        {
+            PrintUsage();
+            return 1;
+        }
+        else
+        {
+            inputs.emplace_back(arg);
+        }
+    }
+
+    if (inputs.empty())
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    std::ofstream outputFile;
+    if (!outputPath.empty())
+    {
+        outputFile.open(outputPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!outputFile)
+        {
+            std::cerr << "Cannot open " << outputPath << " for writing\n";
+            return 1;
+        }
+    }
+
+    std::ostream& output = outputPath.empty() ? std::cout : outputFile;
+    FlexLog::Buffer buffer;
+
+    auto render = [&](const FlexLog::Message& message)
+    {
+        format.FormatTo(message, buffer);
+        if (!format.IsBinary() && (buffer.IsEmpty() || buffer.Back() != '\n'))
+            buffer.PushBack('\n');
+
+        if (buffer.Size() >= FLUSH_THRESHOLD)
+        {
+            output.write(buffer.Data(), static_cast<std::streamsize>(buffer.Size()));
+            buffer.Clear();
+        }
+    };
+
+    FlexLog::BinaryReader reader;
+    int status = 0;
+    std::string contents;
+
+    for (const std::string& input : inputs)
+    {
+        if (!ReadFile(input, contents))
+        {
+            std::cerr << "Cannot read " << input << "\n";
+            status = 1;
+            continue;
+        }
+
+        const size_t consumed = reader.Read(contents, render);
+        if (consumed < contents.size())
+        {
+            std::cerr << input << ": " << (contents.size() - consumed) << " trailing bytes form an incomplete record\n";
+            status = 1;
+        }
+    }
+
+    reader.Finish(render);
+    output.write(buffer.Data(), static_cast<std::streamsize>(buffer.Size()));
+    output.flush();
+
+    if (reader.GetUnresolvedCount() > 0)
+        std::cerr << reader.GetUnresolvedCount() << " records refer to definitions missing from the input\n";
+
+    if (reader.GetMalformedCount() > 0)
+    {
+        std::cerr << reader.GetMalformedCount() << " malformed records were skipped\n";
+        status = 1;
+    }
+
+    return status;
+}
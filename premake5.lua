@@ -8,6 +8,16 @@ workspace "FlexLog"
 
 	IncludeDir = {}
 	IncludeDir["FlexLog"] = "FlexLog/src"
+	IncludeDir["zlib"] = "Vendor/zlib/include"
+
+	-- The parts of zlib FlexLog uses: deflate and the checksums its containers need
+	ZlibSources = {
+		"%{IncludeDir.zlib}/zlib/adler32.c",
+		"%{IncludeDir.zlib}/zlib/crc32.c",
+		"%{IncludeDir.zlib}/zlib/deflate.c",
+		"%{IncludeDir.zlib}/zlib/trees.c",
+		"%{IncludeDir.zlib}/zlib/zutil.c"
+	}
 
 project "FlexLog"
 	location "FlexLog"
@@ -22,11 +32,54 @@ project "FlexLog"
 	files {
 		"%{IncludeDir.FlexLog}/**.h",
 		"%{IncludeDir.FlexLog}/**.cpp",
-		"%{IncludeDir.FlexLog}/**.hpp"
+		"%{IncludeDir.FlexLog}/**.hpp",
+		ZlibSources
+	}
+
+	includedirs {
+		"%{IncludeDir.FlexLog}",
+		"%{IncludeDir.zlib}"
+	}
+
+	defines { "_CRT_SECURE_NO_WARNINGS" }
+
+	filter "configurations:Debug"
+		defines { "LOGGER_DEBUG" }
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines { "LOGGER_RELEASE" }
+		runtime "Release"
+		optimize "on"
+
+project "FlexLogDecode"
+	location "FlexLogDecode"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++20"
+	staticruntime "Off"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files {
+		"%{prj.name}/src/**.h",
+		"%{prj.name}/src/**.cpp",
+		"%{IncludeDir.FlexLog}/**.h",
+		"%{IncludeDir.FlexLog}/**.cpp",
+		"%{IncludeDir.FlexLog}/**.hpp",
+		ZlibSources
+	}
+
+	-- Shares the library sources with FlexLog, minus its demo entry point
+	removefiles {
+		"%{IncludeDir.FlexLog}/Main.cpp"
 	}
 
 	includedirs {
-		"%{IncludeDir.FlexLog}"
+		"%{IncludeDir.FlexLog}",
+		"%{IncludeDir.zlib}"
 	}
 
 	defines { "_CRT_SECURE_NO_WARNINGS" }